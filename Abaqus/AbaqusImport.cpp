@@ -170,6 +170,45 @@ bool szicmp(const char* sz1, const char* sz2)
 	return true;
 }
 
+//-----------------------------------------------------------------------------
+// Parse up to nmax comma-separated integers from a data line and returns the 
+// number of values read. This is used instead of sscanf for the bulk data lines.
+static int parse_int_list(const char* sz, int* n, int nmax)
+{
+	int nr = 0;
+	while (nr < nmax)
+	{
+		while ((*sz == ',') || isspace((unsigned char)*sz)) ++sz;
+		if (*sz == 0) break;
+
+		char* end = nullptr;
+		long v = strtol(sz, &end, 10);
+		if (end == sz) break;
+		n[nr++] = (int)v;
+		sz = end;
+	}
+	return nr;
+}
+
+//-----------------------------------------------------------------------------
+// Same as parse_int_list, but for floating point values.
+static int parse_double_list(const char* sz, double* v, int nmax)
+{
+	int nr = 0;
+	while (nr < nmax)
+	{
+		while ((*sz == ',') || isspace((unsigned char)*sz)) ++sz;
+		if (*sz == 0) break;
+
+		char* end = nullptr;
+		double d = strtod(sz, &end);
+		if (end == sz) break;
+		v[nr++] = d;
+		sz = end;
+	}
+	return nr;
+}
+
 //-----------------------------------------------------------------------------
 //! Load an Abaqus model file
 bool AbaqusImport::Load(const char* szfile)
@@ -488,28 +527,18 @@ bool AbaqusImport::read_nodes(char* szline, FILE* fp)
 	AbaqusModel::NODE n;
 	n.x = n.y = n.z = 0;
 	read_line(szline, fp);
-	char* ch;
-	int nc = 0;
 	while (!feof(fp) && (szline[0] != '*'))
 	{
 		// parse the line
-		ch = szline;
-		sscanf(ch, "%d", &n.id);
+		char* ch = nullptr;
+		n.id = (int)strtol(szline, &ch, 10);
+		if (ch == szline) return false;
 
-		ch = strchr(ch, ',');
-		if (ch == 0) return false;
-		++ch;
-		sscanf(ch, "%lg", &n.x);
-
-		ch = strchr(ch, ','); 
-		if (ch==0) return false;
-		++ch;
-		sscanf(ch, "%lg", &n.y);
-
-		ch = strchr(ch, ','); 
-		if (ch==0) return false;
-		++ch;
-		sscanf(ch, "%lg", &n.z);
+		double r[3];
+		if (parse_double_list(ch, r, 3) != 3) return false;
+		n.x = r[0];
+		n.y = r[1];
+		n.z = r[2];
 
 		// add the node to the list
 		part.AddNode(n);
@@ -518,9 +547,6 @@ bool AbaqusImport::read_nodes(char* szline, FILE* fp)
 		read_line(szline, fp);
 	}
 
-	// build the node-look up table
-	part.BuildNLT();
-
 	return true;
 }
 
@@ -557,8 +583,16 @@ bool AbaqusImport::read_ngen(char* szline, FILE* fp)
 	{
 		// parse the line
 		sscanf(szline, "%d,%d,%d,%d", &l1, &l2, &linc, &lc);
+
+		// Adding nodes invalidates iterators into the node list, so copy the
+		// end node positions before generating the new nodes.
 		AbaqusModel::Tnode_itr pn1 = part.FindNode(l1);
+		if (pn1 == part.m_Node.end()) return errf("Unknown node %d in NGEN (line %d)", l1, m_nline);
 		AbaqusModel::Tnode_itr pn2 = part.FindNode(l2);
+		if (pn2 == part.m_Node.end()) return errf("Unknown node %d in NGEN (line %d)", l2, m_nline);
+		vec3d r1(pn1->x, pn1->y, pn1->z);
+		vec3d r2(pn2->x, pn2->y, pn2->z);
+		if (linc <= 0) linc = 1;
 
 		// generate the nodes
 		AbaqusModel::NODE n;
@@ -569,9 +603,9 @@ bool AbaqusImport::read_ngen(char* szline, FILE* fp)
 			{
 				t = (double) (i-l1)/(double) (l2 - l1);
 
-				n.x = (1.0-t)*pn1->x + t*(pn2->x);
-				n.y = (1.0-t)*pn1->y + t*(pn2->y);
-				n.z = (1.0-t)*pn1->z + t*(pn2->z);
+				n.x = (1.0-t)*r1.x + t*(r2.x);
+				n.y = (1.0-t)*r1.y + t*(r2.y);
+				n.z = (1.0-t)*r1.z + t*(r2.z);
 
 				n.id = i;
 				part.AddNode(n);
@@ -580,9 +614,11 @@ bool AbaqusImport::read_ngen(char* szline, FILE* fp)
 		else if (nline==1)
 		{
 			AbaqusModel::Tnode_itr pc = part.FindNode(lc);
+			if (pc == part.m_Node.end()) return errf("Unknown node %d in NGEN (line %d)", lc, m_nline);
+			vec3d rc(pc->x, pc->y, pc->z);
 
-			vec3d m1(pn1->x - pc->x, pn1->y - pc->y, pn1->z - pc->z);
-			vec3d m2(pn2->x - pc->x, pn2->y - pc->y, pn2->z - pc->z);
+			vec3d m1 = r1 - rc;
+			vec3d m2 = r2 - rc;
 			double L1 = m1.Length();
 			double L2 = m2.Length();
 			m1.Normalize();
@@ -599,9 +635,9 @@ bool AbaqusImport::read_ngen(char* szline, FILE* fp)
 				r = m1;
 				q.RotateVector(r);
 
-				n.x = pc->x + L*r.x;
-				n.y = pc->y + L*r.y;
-				n.z = pc->z + L*r.z;
+				n.x = rc.x + L*r.x;
+				n.y = rc.y + L*r.y;
+				n.z = rc.z + L*r.z;
 	
 				n.id = i;
 				part.AddNode(n);
@@ -643,18 +679,20 @@ bool AbaqusImport::read_nfill(char* szline, FILE* fp)
 		double t;
 		for (int l=1; l<nl; ++l)
 		{
-			list<AbaqusModel::Tnode_itr>::iterator n1 = ns1->node.begin();
-			list<AbaqusModel::Tnode_itr>::iterator n2 = ns2->node.begin();
-
 			t = (double) l / (double) nl;
 
-			for (int i=0; i<N; ++i, ++n1, ++n2)
+			for (int i=0; i<N; ++i)
 			{
-				n.id = (*n1)->id + l*ni + i;
+				// (adding nodes can invalidate the iterators, so look them up each time)
+				AbaqusModel::Tnode_itr n1 = part.FindNode(ns1->node[i]);
+				AbaqusModel::Tnode_itr n2 = part.FindNode(ns2->node[i]);
+				if ((n1 == part.m_Node.end()) || (n2 == part.m_Node.end())) return false;
 
-				n.x = (*n1)->x*(1.0 - t) + (*n2)->x;
-				n.y = (*n1)->y*(1.0 - t) + (*n2)->y;
-				n.z = (*n1)->z*(1.0 - t) + (*n2)->z;
+				n.id = n1->id + l*ni + i;
+
+				n.x = n1->x*(1.0 - t) + n2->x;
+				n.y = n1->y*(1.0 - t) + n2->y;
+				n.z = n1->z*(1.0 - t) + n2->z;
 
 				part.AddNode(n);
 			}
@@ -773,42 +811,31 @@ bool AbaqusImport::read_elements(char* szline, FILE* fp)
 		return false;
 	};
 
-	int nc = 0;
+	int nn[AbaqusModel::Max_Nodes + 1];
 	while (!feof(fp) && (szline[0] != '*'))
 	{
 		// set the element type
 		el.type = ntype;
 
-		// parse the line
-		char* ch = szline;
+		// parse the element id and the node numbers
+		int nr = parse_int_list(szline, nn, N + 1);
+		if (nr < 2) return false;
 
-		// get the element id
-		sscanf(ch, "%d", &el.id);
-		ch = strchr(ch, ',');
-		if (ch == 0) return false; else ++ch;
-
-		// read the node numbers
-		for (int i=0; i<N; ++i)
+		// if we've reached the end of the line
+		// then the node numbers continue on the next line
+		while (nr < N + 1)
 		{
-			sscanf(ch, "%d", &el.n[i]);
-
-			if (i!=N-1)
-			{
-				// find the next comma
-				ch = strchr(ch, ',');
-				if (ch == 0) return false;
+			if (read_line(szline, fp) == false) return false;
+			if (szline[0] == '*') return false;
 
-				// if we've reached at the end of the line
-				// then we load the next line
-				if (strlen(ch) == 1 || strcmp(ch,", ") == 0)
-				{
-					read_line(szline, fp);
-					ch = szline;
-				}
-				else ++ch;
-			}
+			int m = parse_int_list(szline, nn + nr, N + 1 - nr);
+			if (m == 0) return false;
+			nr += m;
 		}
 
+		el.id = nn[0];
+		for (int i=0; i<N; ++i) el.n[i] = nn[i + 1];
+
 		// make sure to copy the last node for triangles
 		if (ntype == FE_TRI3) el.n[3] = el.n[2];
 
@@ -1016,8 +1043,12 @@ bool AbaqusImport::read_element_sets(char* szline, FILE* fp)
 		while (!feof(fp) && (szline[0] != '*'))
 		{
 			// parse the line
-			int nread = sscanf(szline, "%d,%d,%d", &n1, &n2, &n);
-			if (nread == 2) n = 1;
+			int v[3];
+			int nread = parse_int_list(szline, v, 3);
+			if (nread < 2) return false;
+			n1 = v[0]; n2 = v[1];
+			n = (nread == 3 ? v[2] : 1);
+			if (n <= 0) return false;
 	
 			// add the elements to the list
 			for (int i=n1; i<=n2; i += n)
@@ -1037,7 +1068,7 @@ bool AbaqusImport::read_element_sets(char* szline, FILE* fp)
 		AbaqusModel::Telem_itr it;
 		while (!feof(fp) && (szline[0] != '*'))
 		{
-			nr = sscanf(szline, "%d,%d,%d,%d,%d,%d,%d,%d,%d,%d,%d,%d,%d,%d,%d,%d", &n[0],&n[1],&n[2],&n[3],&n[4],&n[5],&n[6],&n[7],&n[8],&n[9],&n[10],&n[11],&n[12],&n[13],&n[14],&n[15]);
+			nr = parse_int_list(szline, n, 16);
 			for (int i=0; i<nr; ++i)
 			{
 				it = part.FindElement(n[i]);
@@ -1100,16 +1131,18 @@ bool AbaqusImport::read_node_sets(char* szline, FILE* fp)
 		while (!feof(fp) && (szline[0] != '*'))
 		{
 			// parse the line
-			int nread = sscanf(szline, "%d,%d,%d", &n1, &n2, &n);
-			if (nread == 2) n = 1;
+			int v[3];
+			int nread = parse_int_list(szline, v, 3);
+			if (nread < 2) return false;
+			n1 = v[0]; n2 = v[1];
+			n = (nread == 3 ? v[2] : 1);
+			if (n <= 0) return false;
 	
-			// add the elements to the list
-			AbaqusModel::Tnode_itr it;
+			// add the nodes to the list
 			for (int i=n1; i<=n2; i += n)
 			{
-				it = part.FindNode(i);
-				if (it == part.m_Node.end()) return false;
-				pset->node.push_back(it);
+				if (part.FindNode(i) == part.m_Node.end()) return false;
+				pset->node.push_back(i);
 			}
 
 			// read the next line
@@ -1119,7 +1152,6 @@ bool AbaqusImport::read_node_sets(char* szline, FILE* fp)
 	else
 	{
 		int i, nr, n[16];
-		AbaqusModel::Tnode_itr it;
 
 		// get/create the node set
 //		list<AbaqusModel::NODE_SET>::iterator pset = part.FindNodeSet(szname);
@@ -1130,14 +1162,13 @@ bool AbaqusImport::read_node_sets(char* szline, FILE* fp)
 		while (!feof(fp) && (szline[0] != '*'))
 		{
 			// read the nodes
-			nr = sscanf(szline, "%d,%d,%d,%d,%d,%d,%d,%d,%d,%d,%d,%d,%d,%d,%d,%d",&n[0],&n[1],&n[2],&n[3],&n[4],&n[5],&n[6],&n[7],&n[8],&n[9],&n[10],&n[11],&n[12],&n[13],&n[14],&n[15]);
+			nr = parse_int_list(szline, n, 16);
 
-			// add the elements to the list
+			// add the nodes to the list
 			for (i=0; i<nr; ++i)
 			{
-				it = part.FindNode(n[i]);
-				if (it == part.m_Node.end()) return false;
-				pset->node.push_back(it);
+				if (part.FindNode(n[i]) == part.m_Node.end()) return false;
+				pset->node.push_back(n[i]);
 			}
 
 			// read the next line
@@ -1894,12 +1925,15 @@ GObject* AbaqusImport::build_part(AbaqusModel::PART* pg)
 	AbaqusModel::PART& part = *pg;
 	assert(part.m_po == 0);
 
+	// the mesh nodes and elements are ordered by their IDs
+	vector<int> nodeOrder = part.m_NLT.sorted_indices();
+	vector<int> elemOrder = part.m_ELT.sorted_indices();
+
 	// count nodes
-	int nodes = part.Nodes();
+	int nodes = (int)nodeOrder.size();
 
 	// count elements
-	int elems = 0;
-	for (AbaqusModel::Telem_itr it = pg->m_Elem.begin(); it != pg->m_Elem.end(); ++it) if (it->id != -1) elems++;
+	int elems = (int)elemOrder.size();
 
 	if ((nodes == 0) || (elems == 0)) return 0;
 
@@ -1907,47 +1941,43 @@ GObject* AbaqusImport::build_part(AbaqusModel::PART* pg)
 	pm->Create(nodes, elems);
 
 	// copy nodes
-	int i, j, n;
-	int imin = 0, imax = 0;
-	AbaqusModel::Tnode_itr pn = part.m_Node.begin();
-	for (i=0; i<nodes; ++i, ++pn)
+	int i, j;
+	for (AbaqusModel::NODE& nd : part.m_Node) nd.n = -1;
+#pragma omp parallel for
+	for (i=0; i<nodes; ++i)
 	{
+		AbaqusModel::NODE& nd = part.m_Node[nodeOrder[i]];
 		FSNode& node = pm->Node(i);
-		pn->n = i;
-		node.r.x = pn->x;
-		node.r.y = pn->y;
-		node.r.z = pn->z;
-
-		if (i==0 || (pn->id < imin)) imin = pn->id;
-		if (i==0 || (pn->id > imax)) imax = pn->id;
+		nd.n = i;
+		node.r.x = nd.x;
+		node.r.y = nd.y;
+		node.r.z = nd.z;
 	}
 
 	// copy elements
-	int *en;
-	i = 0;
-	for (AbaqusModel::Telem_itr pe = part.m_Elem.begin(); pe != part.m_Elem.end(); ++pe)
+	bool bok = true;
+#pragma omp parallel for shared(bok)
+	for (i=0; i<elems; ++i)
 	{
-		if (pe->id != -1)
+		AbaqusModel::ELEMENT& ae = part.m_Elem[elemOrder[i]];
+		FSElement& el = pm->Element(i);
+		ae.lid = i;
+		el.SetType(ae.type);
+		el.m_gid = 0;
+		int n = el.Nodes();
+		for (int j=0; j<n; ++j) 
 		{
-			FSElement& el = pm->Element(i);
-			pe->lid = i++;
-			int etype = pe->type;
-			el.SetType(etype);
-			el.m_gid = 0;
-			n = el.Nodes();
-			en = pe->n;
-			pn = part.m_Node.begin();
-			for (j=0; j<n; ++j) 
-			{
-				AbaqusModel::Tnode_itr pn = part.FindNode(en[j]);
-				el.m_node[j] = pn->n;
-			}
+			int m = part.m_NLT.find(ae.n[j]);
+			if (m < 0) { bok = false; el.m_node[j] = 0; }
+			else el.m_node[j] = part.m_Node[m].n;
 		}
 	}
-
-	// reset nodal ID's
-	pn = part.m_Node.begin();
-	for (i=0; i<nodes; ++i, ++pn) pn->id = i;
+	if (bok == false)
+	{
+		delete pm;
+		errf("Part %s has elements with undefined nodes.", part.GetName());
+		return 0;
+	}
 
 	// auto-partition
 	int elsets = (int)part.m_ESet.size();
@@ -2178,9 +2208,8 @@ GObject* AbaqusImport::build_part(AbaqusModel::PART* pg)
 			{
 				FSNodeSet* pg = new FSNodeSet(po);
 				pg->SetName(ns->second->szname);
-				list<AbaqusModel::Tnode_itr>::iterator pn = ns->second->node.begin();
 				nn = (int) ns->second->node.size();
-				for (j=0; j<nn; ++j, ++pn) pg->add((*pn)->id);
+				for (j=0; j<nn; ++j) pg->add(part.FindNode(ns->second->node[j])->n);
 				po->AddFENodeSet(pg);
 			}
 		}
@@ -2374,10 +2403,10 @@ FSNodeSet* AbaqusImport::build_nodeset(AbaqusModel::NODE_SET* ns)
 	FSMesh* pm = part->m_po->GetFEMesh();
 
 	FSNodeSet* nset = new FSNodeSet(po);
-	list<AbaqusModel::Tnode_itr>::iterator it = ns->node.begin();
-	for (it; it != ns->node.end(); ++it)
+	for (int nid : ns->node)
 	{
-		nset->add((*it)->n);
+		AbaqusModel::Tnode_itr it = part->FindNode(nid);
+		if (it != part->m_Node.end()) nset->add(it->n);
 	}
 	return nset;
 }
@@ -2495,7 +2524,8 @@ bool AbaqusImport::read_boundary(char* szline, FILE* fp)
 				if (part == nullptr) return false;
 
 				AbaqusModel::NODE_SET* dummy = part->AddNodeSet(szset);
-				dummy->node.push_back(part->FindNode(nid));
+				if (part->FindNode(nid) == part->m_Node.end()) return false;
+				dummy->node.push_back(nid);
 				BC.add(dummy, ndof, val);
 			}
 			else BC.add(ns, ndof, val);
@@ -25,6 +25,8 @@ OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
 SOFTWARE.*/
 
 #include "AbaqusModel.h"
+#include <algorithm>
+#include <climits>
 
 #ifdef LINUX // same for Linux and Mac OS X
 #define stricmp strcasecmp
@@ -39,6 +41,127 @@ SOFTWARE.*/
 // in AbaqusImport.cpp
 bool szicmp(const char* sz1, const char* sz2);
 
+//-----------------------------------------------------------------------------
+AbaqusModel::LABEL_INDEX::LABEL_INDEX()
+{
+	m_ioff = 0;
+	m_count = 0;
+	m_sparse = false;
+}
+
+//-----------------------------------------------------------------------------
+void AbaqusModel::LABEL_INDEX::clear()
+{
+	m_table.clear();
+	m_map.clear();
+	m_ioff = 0;
+	m_count = 0;
+	m_sparse = false;
+}
+
+//-----------------------------------------------------------------------------
+void AbaqusModel::LABEL_INDEX::add(int id, int index)
+{
+	if (m_sparse)
+	{
+		auto it = m_map.find(id);
+		if (it == m_map.end()) { m_map[id] = index; m_count++; }
+		else it->second = index;
+		return;
+	}
+
+	if (m_table.empty())
+	{
+		m_ioff = id;
+		m_table.assign(1, -1);
+	}
+	else
+	{
+		// The dense table may not get much larger than the number of entries. Decide this
+		// before growing the table, since sparse IDs would require a huge allocation.
+		long long maxSize = 8 * ((long long)m_count + 1) + 1000000;
+		long long lo = m_ioff;
+		long long hi = (long long)m_ioff + (long long)m_table.size() - 1;
+		if (id < lo) lo = id;
+		if (id > hi) hi = id;
+		if (hi - lo + 1 > maxSize)
+		{
+			// switch to the hash map
+			make_sparse();
+			m_map[id] = index;
+			m_count++;
+			return;
+		}
+
+		if (id < m_ioff)
+		{
+			// grow the table at the front (by at least doubling it, if possible)
+			long long newOff = (long long)id - (long long)m_table.size();
+			if (hi - newOff + 1 > maxSize) newOff = hi - maxSize + 1;
+			if (newOff < INT_MIN) newOff = INT_MIN;
+			m_table.insert(m_table.begin(), (size_t)(m_ioff - newOff), -1);
+			m_ioff = (int)newOff;
+		}
+		else if ((size_t)((long long)id - m_ioff) >= m_table.size())
+		{
+			// grow the table at the back (by at least doubling it, if possible)
+			long long newSize = (long long)id - m_ioff + 1;
+			long long size2 = 2 * (long long)m_table.size();
+			if (size2 > maxSize) size2 = maxSize;
+			if (newSize < size2) newSize = size2;
+			m_table.resize((size_t)newSize, -1);
+		}
+	}
+
+	int& n = m_table[(size_t)((long long)id - m_ioff)];
+	if (n == -1) m_count++;
+	n = index;
+}
+
+//-----------------------------------------------------------------------------
+void AbaqusModel::LABEL_INDEX::make_sparse()
+{
+	m_map.reserve(m_count);
+	for (size_t i = 0; i < m_table.size(); ++i)
+	{
+		if (m_table[i] != -1) m_map[(int)(m_ioff + (long long)i)] = m_table[i];
+	}
+	vector<int>().swap(m_table);
+	m_sparse = true;
+}
+
+//-----------------------------------------------------------------------------
+int AbaqusModel::LABEL_INDEX::find(int id) const
+{
+	if (m_sparse)
+	{
+		auto it = m_map.find(id);
+		return (it != m_map.end() ? it->second : -1);
+	}
+
+	long long n = (long long)id - m_ioff;
+	if ((n < 0) || (n >= (long long)m_table.size())) return -1;
+	return m_table[(size_t)n];
+}
+
+//-----------------------------------------------------------------------------
+vector<int> AbaqusModel::LABEL_INDEX::sorted_indices() const
+{
+	vector<int> index;
+	index.reserve(m_count);
+	if (m_sparse)
+	{
+		vector<pair<int, int> > tmp(m_map.begin(), m_map.end());
+		std::sort(tmp.begin(), tmp.end());
+		for (auto& it : tmp) index.push_back(it.second);
+	}
+	else
+	{
+		for (int n : m_table) if (n != -1) index.push_back(n);
+	}
+	return index;
+}
+
 //-----------------------------------------------------------------------------
 AbaqusModel::ASSEMBLY::ASSEMBLY()
 {
@@ -268,7 +391,6 @@ AbaqusModel::PART::PART()
 { 
 	m_po = nullptr; 
 	m_szname[0] = 0;
-	m_ioff = 0;
 }
 
 AbaqusModel::PART::~PART()
@@ -287,49 +409,17 @@ void AbaqusModel::PART::SetName(const char* sz)
 //-----------------------------------------------------------------------------
 AbaqusModel::Tnode_itr AbaqusModel::PART::AddNode(AbaqusModel::NODE& n)
 {
-	if (m_Node.size() == 0)
-	{
-		m_Node.push_back(n);
-		return m_Node.begin();
-	}
-	else
-	{
-		Tnode_itr p1 = m_Node.begin();
-		Tnode_itr p2 = --m_Node.end();
-
-		if (n.id < p1->id)
-		{
-			m_Node.insert(m_Node.begin(), n);
-			return m_Node.begin();
-		}
-		else if (n.id > p2->id)
-		{
-			m_Node.push_back(n);
-			return --m_Node.end();
-		}
-		else
-		{
-			if (n.id - p1->id < p2->id - n.id)
-			{
-				do { ++p1; } while (p1->id < n.id);
-				return m_Node.insert(p1, n);
-			}
-			else
-			{
-				do { --p2; } while (p2->id > n.id); ++p2;
-				return m_Node.insert(p2, n);
-			}
-		}
-	}
-
-	return m_Node.end();
+	m_NLT.add(n.id, (int)m_Node.size());
+	m_Node.push_back(n);
+	return --m_Node.end();
 }
 
 //-----------------------------------------------------------------------------
 AbaqusModel::Tnode_itr AbaqusModel::PART::FindNode(int id)
 {
-	assert(!m_NLT.empty());
-	return m_NLT[id - m_ioff];
+	int n = m_NLT.find(id);
+	if (n < 0) return m_Node.end();
+	return m_Node.begin() + n;
 }
 
 list<AbaqusModel::SPRING>::iterator AbaqusModel::PART::AddSpring(AbaqusModel::SPRING& s)
@@ -342,24 +432,23 @@ list<AbaqusModel::SPRING>::iterator AbaqusModel::PART::AddSpring(AbaqusModel::SP
 
 void AbaqusModel::PART::AddElement(AbaqusModel::ELEMENT& newElem)
 {
-	int nid = newElem.id;
-	if (nid >= (int)m_Elem.size())
+	// elements that are defined again replace the previous definition
+	int n = m_ELT.find(newElem.id);
+	if (n >= 0) m_Elem[n] = newElem;
+	else
 	{
-		int oldSize = (int)m_Elem.size();
-		int newSize = nid + 1000;
-		m_Elem.resize(newSize);
-		for (int i = oldSize; i < newSize; ++i) m_Elem[i].id = -1;
+		m_ELT.add(newElem.id, (int)m_Elem.size());
+		m_Elem.push_back(newElem);
 	}
-
-	m_Elem[nid] = newElem;
 }
 
 //-----------------------------------------------------------------------------
 
 vector<AbaqusModel::ELEMENT>::iterator AbaqusModel::PART::FindElement(int id)
 {
-	if ((id < 0) || (id >= m_Elem.size())) return m_Elem.end();
-	return m_Elem.begin() + id;
+	int n = m_ELT.find(id);
+	if (n < 0) return m_Elem.end();
+	return m_Elem.begin() + n;
 }
 
 //-----------------------------------------------------------------------------
@@ -445,42 +534,6 @@ AbaqusModel::SURFACE* AbaqusModel::PART::AddSurface(const char* szname)
 	return surf;
 }
 
-//-----------------------------------------------------------------------------
-bool AbaqusModel::PART::BuildNLT()
-{
-	// make sure the NLT is empty
-	if (!m_NLT.empty()) m_NLT.clear();
-	m_ioff = 0;
-
-	if (m_Node.empty())
-	{
-		assert(false);
-		return false;
-	}
-
-	// find the lowest and highest node index
-	int imin, imax;
-	Tnode_itr it = m_Node.begin();
-	imin = imax = it->id;
-	for (++it; it != m_Node.end(); ++it)
-	{
-		if (it->id < imin) imin = it->id;
-		if (it->id > imax) imax = it->id;
-	}
-
-	// allocate NLT
-	m_NLT.assign(imax - imin + 1, m_Node.end());
-
-	// fill the NLT
-	for (it = m_Node.begin(); it != m_Node.end(); ++it)
-	{
-		m_NLT[it->id - imin] = it;
-	}
-	m_ioff = imin;
-
-	return true;
-}
-
 //-----------------------------------------------------------------------------
 void AbaqusModel::PART::AddOrientation(const char* szname, const char* szdist)
 {
@@ -29,6 +29,7 @@ SOFTWARE.*/
 #include <list>
 #include <vector>
 #include <map>
+#include <unordered_map>
 //using namespace std;
 
 using std::vector;
@@ -47,6 +48,36 @@ public:
 	enum { ST_ELEMENT };
 
 public:
+	// Maps node and element IDs (as read from file) to an index in the 
+	// corresponding array. A dense table is used when the IDs are reasonably
+	// compact, otherwise this falls back to a hash map.
+	class LABEL_INDEX
+	{
+	public:
+		LABEL_INDEX();
+
+		void clear();
+
+		// add (or replace) an entry
+		void add(int id, int index);
+
+		// find the index for an ID. Returns -1 if not found.
+		int find(int id) const;
+
+		// returns all indices, sorted by ID
+		vector<int> sorted_indices() const;
+
+	private:
+		void make_sparse();
+
+	private:
+		vector<int>		m_table;	// dense table (m_table[id - m_ioff] = index)
+		int				m_ioff;		// offset of dense table
+		int				m_count;	// number of entries
+		bool			m_sparse;	// use the hash map instead of the table
+		std::unordered_map<int, int>	m_map;	// sparse table
+	};
+
 
 	// Node
 	struct NODE
@@ -90,7 +121,7 @@ public:
 	{
 		char		szname[Max_Name + 1];
 		PART*		part;
-		list<Tnode_itr>	node;
+		vector<int>	node;	// node IDs
 	};
 
 	// Element set
@@ -233,9 +264,6 @@ public:
 		// number of springs
 		int Springs() { return (int)m_Spring.size(); }
 
-		// build the node-look-up table
-		bool BuildNLT();
-
 		void AddOrientation(const char* szname, const char* szdist);
 
 		Orientation* FindOrientation(const char* szname);
@@ -244,8 +272,8 @@ public:
 
 	public:
 		char m_szname[256];
-		vector<NODE>				m_Node;		// list of nodes
-		vector<ELEMENT>				m_Elem;		// list of elements
+		vector<NODE>				m_Node;		// list of nodes (in the order they were read)
+		vector<ELEMENT>				m_Elem;		// list of elements (in the order they were read)
 		list<SPRING>				m_Spring;	// list of springs
 		map<string, NODE_SET*>		m_NSet;		// node sets
 		map<string, ELEMENT_SET*>	m_ESet;		// element sets
@@ -255,8 +283,8 @@ public:
 		list<Orientation>			m_Orient;
 		list<Distribution>			m_Distr;
 
-		vector<Tnode_itr>	m_NLT;	// Node look-up table
-		int					m_ioff;	// node id offset (min node id)
+		LABEL_INDEX			m_NLT;	// node look-up table
+		LABEL_INDEX			m_ELT;	// element look-up table
 
 		GObject*			m_po;	// object created based on this part
 	};
@@ -39,6 +39,8 @@ SOFTWARE.*/
 #include <FEBioLink/FEBioModule.h>
 #include <memory>
 #include <sstream>
+#include <algorithm>
+#include <cstdlib>
 #include <FECore/FETransform.h>
 #include <GeomLib/GPartSection.h>
 #include <FEMLib/FEElementFormulation.h>
@@ -55,6 +57,46 @@ FSNodeList* BuildNodeList(GEdge* pe);
 FEFaceList* BuildFaceList(GFace* face);
 const char* ElementTypeString(int ntype);
 
+//-----------------------------------------------------------------------------
+// The Nodes and Elements sections are formatted in blocks of BULK_BLOCK_SIZE
+// items. Each block is formatted in parallel into a preallocated text buffer
+// and then streamed to the file in order.
+static const int BULK_BLOCK_SIZE = 16384;
+static const int NODE_TEXT_SIZE = 80;								// three doubles and separators
+static const int ELEM_TEXT_SIZE = FSElement::MAX_NODES * 12;		// up to 27 node IDs and separators
+
+// Print the shortest of %.15g, %.16g, %.17g that reads back to the same value.
+static int format_double(char* sz, double g)
+{
+	int n = sprintf(sz, "%.15lg", g);
+	if (strtod(sz, nullptr) == g) return n;
+	n = sprintf(sz, "%.16lg", g);
+	if (strtod(sz, nullptr) == g) return n;
+	return sprintf(sz, "%.17lg", g);
+}
+
+static void format_vec3d(char* sz, const vec3d& r)
+{
+	sz += format_double(sz, r.x); *sz++ = ',';
+	sz += format_double(sz, r.y); *sz++ = ',';
+	format_double(sz, r.z);
+}
+
+static void format_int_list(char* sz, const int* n, int m)
+{
+	for (int i = 0; i < m; ++i)
+	{
+		if (i > 0) *sz++ = ',';
+		// write digits in reverse, then flip them
+		unsigned int v = (n[i] < 0 ? -(unsigned int)n[i] : (unsigned int)n[i]);
+		if (n[i] < 0) *sz++ = '-';
+		char* s0 = sz;
+		do { *sz++ = (char)('0' + v % 10); v /= 10; } while (v);
+		std::reverse(s0, sz);
+	}
+	*sz = 0;
+}
+
 //////////////////////////////////////////////////////////////////////
 // Construction/Destruction
 //////////////////////////////////////////////////////////////////////
@@ -1626,16 +1668,32 @@ void FEBioExport4::WriteGeometryNodes()
 
 		m_xml.add_branch(tagNodes);
 		{
+			const Transform& T = po->GetTransform();
 			XMLElement el("node");
 			int nid = el.add_attribute("id", 0);
-			for (int j = 0; j < pm->Nodes(); ++j)
+
+			// the coordinates are formatted in parallel, one block at a time,
+			// and then streamed to the file in order.
+			int NN = pm->Nodes();
+			vector<char> buf((size_t)BULK_BLOCK_SIZE * NODE_TEXT_SIZE);
+			for (int j0 = 0; j0 < NN; j0 += BULK_BLOCK_SIZE)
 			{
-				FSNode& node = pm->Node(j);
-				el.set_attribute(nid, node.m_nid);
-				if (node.m_nid > n) n = node.m_nid + 1;
-				vec3d r = po->GetTransform().LocalToGlobal(node.r);
-				el.value(r);
-				m_xml.add_leaf(el, false);
+				int nb = (NN - j0 < BULK_BLOCK_SIZE ? NN - j0 : BULK_BLOCK_SIZE);
+#pragma omp parallel for
+				for (int k = 0; k < nb; ++k)
+				{
+					vec3d r = T.LocalToGlobal(pm->Node(j0 + k).r);
+					format_vec3d(&buf[(size_t)k * NODE_TEXT_SIZE], r);
+				}
+
+				for (int k = 0; k < nb; ++k)
+				{
+					FSNode& node = pm->Node(j0 + k);
+					el.set_attribute(nid, node.m_nid);
+					if (node.m_nid > n) n = node.m_nid + 1;
+					el.value(&buf[(size_t)k * NODE_TEXT_SIZE]);
+					m_xml.add_leaf(el, false);
+				}
 			}
 		}
 		m_xml.close_branch();
@@ -1772,8 +1830,8 @@ void FEBioExport4::WriteGeometryPart(Part* part, GPart* pg, bool writeMats, bool
 	// loop over unprocessed elements
 	int nset = 0;
 	int ncount = 0;
-	int nn[FSElement::MAX_NODES];
 	char szname[128] = { 0 };
+	vector<char> elemBuf((size_t)BULK_BLOCK_SIZE * ELEM_TEXT_SIZE);
 	for (int i = 0; ncount < NEP; ++i)
 	{
 		FEElement_& el = pm->ElementRef(i);
@@ -1814,31 +1872,50 @@ void FEBioExport4::WriteGeometryPart(Part* part, GPart* pg, bool writeMats, bool
 				dom->m_elemType = ntype;
 			}
 
+			// collect the elements of this set
+			int lastElemID = 0;
+			for (int j = i; j < NE; ++j)
+			{
+				FEElement_& ej = pm->ElementRef(j);
+				if ((ej.m_ntag == 1) && (ej.Type() == ntype))
+				{
+					if (ej.m_nid <= lastElemID) throw FEBioExportError();
+					lastElemID = ej.m_nid;
+					assert(ej.Nodes() == el.Nodes());
+					ej.m_ntag = -1;	// mark as processed
+					ncount++;
+
+					es.m_elem.push_back(j);
+				}
+			}
+
 			xe.add_attribute("name", szname);
 			m_xml.add_branch(xe);
 			{
 				XMLElement xej("elem");
 				int n1 = xej.add_attribute("id", (int)0);
-				int lastElemID = 0;
 
-				for (int j = i; j < NE; ++j)
+				// format the node lists in parallel, one block at a time
+				int ne = el.Nodes();
+				int NES = (int)es.m_elem.size();
+				for (int j0 = 0; j0 < NES; j0 += BULK_BLOCK_SIZE)
 				{
-					FEElement_& ej = pm->ElementRef(j);
-					if ((ej.m_ntag == 1) && (ej.Type() == ntype))
+					int nb = (NES - j0 < BULK_BLOCK_SIZE ? NES - j0 : BULK_BLOCK_SIZE);
+#pragma omp parallel for
+					for (int k = 0; k < nb; ++k)
 					{
-						if (ej.m_nid <= lastElemID) throw FEBioExportError();
-						lastElemID = ej.m_nid;
+						FEElement_& ej = pm->ElementRef(es.m_elem[j0 + k]);
+						int nn[FSElement::MAX_NODES];
+						for (int l = 0; l < ne; ++l) nn[l] = pm->Node(ej.m_node[l]).m_nid;
+						format_int_list(&elemBuf[(size_t)k * ELEM_TEXT_SIZE], nn, ne);
+					}
 
+					for (int k = 0; k < nb; ++k)
+					{
+						FEElement_& ej = pm->ElementRef(es.m_elem[j0 + k]);
 						xej.set_attribute(n1, ej.m_nid);
-						int ne = ej.Nodes();
-						assert(ne == el.Nodes());
-						for (int k = 0; k < ne; ++k) nn[k] = pm->Node(ej.m_node[k]).m_nid;
-						xej.value(nn, ne);
+						xej.value(&elemBuf[(size_t)k * ELEM_TEXT_SIZE]);
 						m_xml.add_leaf(xej, false);
-						ej.m_ntag = -1;	// mark as processed
-						ncount++;
-
-						es.m_elem.push_back(j);
 					}
 				}
 			}
@@ -27,25 +27,76 @@ SOFTWARE.*/
 #include "stdafx.h"
 #include "DlgExportXPLT.h"
 #include <QBoxLayout>
+#include <QFormLayout>
 #include <QPushButton>
 #include <QCheckBox>
+#include <QSpinBox>
+#include <QLineEdit>
+#include <QValidator>
+#include <QListWidget>
+#include <QGroupBox>
+#include <PostLib/FEPostModel.h>
 
 //-----------------------------------------------------------------------------
 class Ui::CDlgExportXPLT
 {
 public:
 	QCheckBox*	pc;
+	QSpinBox*	stride;
+	QCheckBox*	timeRange;
+	QLineEdit*	tmin;
+	QLineEdit*	tmax;
+	QListWidget*	fields;
 
 public:
-	void setupUi(::CDlgExportXPLT* pwnd)
+	void setupUi(::CDlgExportXPLT* pwnd, Post::FEPostModel& fem)
 	{
 		QVBoxLayout* pg = new QVBoxLayout(pwnd);
 
 		pc = new QCheckBox("Data compression");
 
 		pg->addWidget(pc);
-		pg->addStretch();
-	
+
+		// state selection
+		double t0 = 0.0, t1 = 0.0;
+		int NS = fem.GetStates();
+		if (NS > 0)
+		{
+			t0 = fem.GetState(0)->m_time;
+			t1 = fem.GetState(NS - 1)->m_time;
+		}
+
+		QGroupBox* states = new QGroupBox("States");
+		QFormLayout* form = new QFormLayout;
+		form->addRow("Export every n-th state:", stride = new QSpinBox); stride->setRange(1, (NS > 1 ? NS : 1)); stride->setValue(1);
+		form->addRow("", timeRange = new QCheckBox("Restrict time range"));
+		form->addRow("Start time:", tmin = new QLineEdit); tmin->setValidator(new QDoubleValidator); tmin->setText(QString::number(t0));
+		form->addRow("End time:", tmax = new QLineEdit); tmax->setValidator(new QDoubleValidator); tmax->setText(QString::number(t1));
+		tmin->setEnabled(false);
+		tmax->setEnabled(false);
+		states->setLayout(form);
+		pg->addWidget(states);
+
+		// data fields
+		QGroupBox* data = new QGroupBox("Data fields");
+		QVBoxLayout* l = new QVBoxLayout;
+		l->addWidget(fields = new QListWidget);
+		data->setLayout(l);
+		pg->addWidget(data);
+
+		Post::FEDataManager& DM = *fem.GetDataManager();
+		Post::FEDataFieldPtr pd = DM.FirstDataField();
+		for (int i = 0; i < DM.DataFields(); ++i, ++pd)
+		{
+			Post::ModelDataField& f = *(*pd);
+			if (f.Flags() & Post::EXPORT_DATA)
+			{
+				QListWidgetItem* item = new QListWidgetItem(QString::fromStdString(f.GetName()), fields);
+				item->setData(Qt::UserRole, i);
+				item->setCheckState(Qt::Checked);
+			}
+		}
+
 		QHBoxLayout* ph = new QHBoxLayout;
 		QPushButton* pb1 = new QPushButton("OK");
 		QPushButton* pb2 = new QPushButton("Cancel");
@@ -56,20 +107,37 @@ public:
 		ph->addStretch();
 		pg->addLayout(ph);
 
+		QObject::connect(timeRange, SIGNAL(toggled(bool)), tmin, SLOT(setEnabled(bool)));
+		QObject::connect(timeRange, SIGNAL(toggled(bool)), tmax, SLOT(setEnabled(bool)));
 		QObject::connect(pb1, SIGNAL(clicked()), pwnd, SLOT(accept()));
 		QObject::connect(pb2, SIGNAL(clicked()), pwnd, SLOT(reject()));
 	}
 };
 
 
-CDlgExportXPLT::CDlgExportXPLT(CMainWindow* pwnd) : ui(new Ui::CDlgExportXPLT)
+CDlgExportXPLT::CDlgExportXPLT(CMainWindow* pwnd, Post::FEPostModel& fem) : ui(new Ui::CDlgExportXPLT)
 {
 	m_bcompress = false;
-	ui->setupUi(this);
+	m_stride = 1;
+	m_btime = false;
+	m_tmin = m_tmax = 0.0;
+	ui->setupUi(this, fem);
 }
 
 void CDlgExportXPLT::accept()
 {
 	m_bcompress = ui->pc->isChecked();
+	m_stride = ui->stride->value();
+	m_btime = ui->timeRange->isChecked();
+	m_tmin = ui->tmin->text().toDouble();
+	m_tmax = ui->tmax->text().toDouble();
+
+	m_fields.clear();
+	for (int i = 0; i < ui->fields->count(); ++i)
+	{
+		QListWidgetItem* item = ui->fields->item(i);
+		if (item->checkState() == Qt::Checked) m_fields.push_back(item->data(Qt::UserRole).toInt());
+	}
+
 	QDialog::accept();
 }
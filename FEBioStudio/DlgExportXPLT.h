@@ -26,6 +26,7 @@ SOFTWARE.*/
 
 #pragma once
 #include <QDialog>
+#include <vector>
 
 namespace Ui {
 	class CDlgExportXPLT;
@@ -33,15 +34,23 @@ namespace Ui {
 
 class CMainWindow;
 
+namespace Post {
+	class FEPostModel;
+}
+
 class CDlgExportXPLT : public QDialog
 {
 public:
-	CDlgExportXPLT(CMainWindow* pwnd);
+	CDlgExportXPLT(CMainWindow* pwnd, Post::FEPostModel& fem);
 
 	void accept() override;
 
 public:
 	bool	m_bcompress;
+	int		m_stride;		// export every n-th state
+	bool	m_btime;		// only export states in time range
+	double	m_tmin, m_tmax;	// time range
+	std::vector<int>	m_fields;	// data fields to export
 
 protected:
 	Ui::CDlgExportXPLT*	ui;
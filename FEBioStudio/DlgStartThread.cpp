@@ -128,7 +128,7 @@ void CDlgStartThread::checkProgress()
 {
 	if (ui->m_bdone)
 	{
-		if (ui->m_breturn == false)
+		if ((ui->m_breturn == false) && (ui->m_cancelled == false))
 		{
 			QString err = ui->m_thread->GetErrorString();
 			if (err.isEmpty()) err = "An unknown error has occurred.";
@@ -139,9 +139,10 @@ void CDlgStartThread::checkProgress()
 		if (ui->m_cancelled) ui->m_breturn = false;
 		if (ui->m_breturn) accept(); else reject();
 	}
-	else if (ui->m_cancelled == false)
+	else
 	{
-		if (ui->m_thread->hasProgress())
+		// keep polling after a cancel so that the dialog closes once the thread has stopped
+		if ((ui->m_cancelled == false) && ui->m_thread->hasProgress())
 		{
 			ui->m_progress->setRange(0.0, 100.0);
 			double p = ui->m_thread->progress();
@@ -101,6 +101,7 @@ CDocument::CDocument(CMainWindow* wnd) : m_wnd(wnd)
 	// set document as not modified
 	m_bModified = false;
 	m_bValid = true;
+	m_modCounter = 0;
 
 	// reset the filename
 	m_filePath.clear();
@@ -180,6 +181,7 @@ bool CDocument::IsModified()
 void CDocument::SetModifiedFlag(bool bset)
 {
 	m_bModified = bset;
+	if (bset) m_modCounter++;
 }
 
 //-----------------------------------------------------------------------------
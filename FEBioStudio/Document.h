@@ -155,6 +155,9 @@ public:
 	virtual void SetModifiedFlag(bool bset = true);
 	bool IsValid();
 
+	// incremented each time the document is flagged as modified
+	unsigned int ModificationCounter() const { return m_modCounter; }
+
 public:
 	// --- I/O-routines ---
 	// Save the document
@@ -215,6 +218,7 @@ protected:
 	// Modified flag
 	bool	m_bModified;	// is document modified since last saved ?
 	bool	m_bValid;		// is the current document in a valid state for rendering
+	unsigned int	m_modCounter;	// modification counter
 
 	// title
 	std::string		m_title;
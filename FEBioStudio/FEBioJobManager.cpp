@@ -40,7 +40,12 @@ SOFTWARE.*/
 #include <QPushButton>
 #include <QPlainTextEdit>
 #include <QFormLayout>
+#include <QFileInfo>
+#include <QThread>
 #include "MainWindow.h"
+#include "ModelDocument.h"
+#include <FEMLib/FSModel.h>
+#include <deque>
 
 #ifdef WIN32
 #include <Windows.h>
@@ -48,11 +53,31 @@ SOFTWARE.*/
 
 class CFEBioJobManager::Impl
 {
+public:
+	struct QueuedRun
+	{
+		CFEBioJob*	job;
+		QObject*	runner;	// the process or thread running the job
+		bool		inProcess;
+	};
+
 public:
 	CMainWindow*	wnd;
 	QProcess*		process;
 	CFEBioThread*	febThread;
 	bool			bkillJob;
+
+	// job queue
+	std::deque<CFEBioJob*>	queue;		// jobs waiting to run
+	std::vector<QueuedRun>	running;	// queued jobs that are running
+	int						maxJobs;	// max nr of concurrent queued jobs
+
+	bool IsRunningInProcess() const
+	{
+		for (const QueuedRun& r : running)
+			if (r.inProcess) return true;
+		return false;
+	}
 };
 
 CFEBioJobManager::CFEBioJobManager(CMainWindow* wnd) : im(new CFEBioJobManager::Impl)
@@ -61,6 +86,10 @@ CFEBioJobManager::CFEBioJobManager(CMainWindow* wnd) : im(new CFEBioJobManager::
 	im->process = nullptr;
 	im->bkillJob = false;
 	im->febThread = nullptr;
+
+	// by default, we give each job four threads
+	int cores = QThread::idealThreadCount();
+	im->maxJobs = (cores > 4 ? cores / 4 : 1);
 }
 
 bool CFEBioJobManager::StartJob(CFEBioJob* job)
@@ -68,6 +97,9 @@ bool CFEBioJobManager::StartJob(CFEBioJob* job)
 	// make sure no model is running
 	if (CFEBioJob::GetActiveJob() != nullptr) return false;
 
+	// FEBio can only run one model in-process at a time
+	if (job && (job->GetLaunchConfig()->type == launchTypes::DEFAULT) && im->IsRunningInProcess()) return false;
+
 	// set this as the active job
 	CFEBioJob::SetActiveJob(job);
 
@@ -152,8 +184,190 @@ void CFEBioJobManager::KillJob()
 	}
 }
 
+void CFEBioJobManager::QueueJob(CFEBioJob* job)
+{
+	if (job == nullptr) return;
+	job->SetStatus(CFEBioJob::NONE);
+	job->ClearProgress();
+	im->queue.push_back(job);
+	im->wnd->AddLogEntry(QString("FEBio job \"%1\" queued.\n").arg(QString::fromStdString(job->GetName())));
+	StartQueuedJobs();
+}
+
+int CFEBioJobManager::QueueParameterSweep(CModelDocument* doc, CFEBioJob* baseJob, const std::string& paramName, const std::vector<double>& values)
+{
+	if ((doc == nullptr) || (baseJob == nullptr) || values.empty()) return 0;
+
+	FSModel* fem = doc->GetFSModel();
+	Param* p = fem->GetParam(paramName.c_str());
+	if ((p == nullptr) || (p->GetParamType() != Param_FLOAT)) return 0;
+
+	// the jobs are created in the same folder as the base job
+	QFileInfo fi(QString::fromStdString(baseJob->GetFEBFileName(true)));
+	std::string jobDir = fi.path().toStdString();
+	std::string baseName = fi.completeBaseName().toStdString();
+
+	double v0 = p->GetFloatValue();
+	int njobs = 0;
+	for (int i = 0; i < (int)values.size(); ++i)
+	{
+		// create the job
+		QString jobName = QString("%1_%2_%3").arg(QString::fromStdString(baseName)).arg(QString::fromStdString(paramName)).arg(i + 1, 3, 10, QChar('0'));
+		CFEBioJob* job = doc->FindFEBioJob(jobName.toStdString());
+		if (job == nullptr)
+		{
+			job = new CFEBioJob(doc, jobName.toStdString(), jobDir, *baseJob->GetLaunchConfig());
+			doc->AddFEbioJob(job);
+		}
+		else job->UpdateLaunchConfig(*baseJob->GetLaunchConfig());
+		job->m_febVersion = baseJob->m_febVersion;
+		job->m_writeNotes = baseJob->m_writeNotes;
+		job->m_cmd = baseJob->m_cmd;
+		job->SetConfigFileName(baseJob->GetConfigFileName());
+
+		// write the model with this parameter value
+		p->SetFloatValue(values[i]);
+		if (im->wnd->ExportFEBioFile(doc, job->GetFEBFileName(false), job->m_febVersion) == false) break;
+
+		QueueJob(job);
+		njobs++;
+	}
+	p->SetFloatValue(v0);
+
+	// show the new jobs in the model viewer
+	im->wnd->UpdateModel();
+
+	return njobs;
+}
+
+void CFEBioJobManager::CancelQueue()
+{
+	for (CFEBioJob* job : im->queue) job->SetStatus(CFEBioJob::CANCELLED);
+	im->queue.clear();
+
+	for (Impl::QueuedRun& r : im->running)
+	{
+		r.job->SetStatus(CFEBioJob::CANCELLED);
+		if (r.inProcess) dynamic_cast<CFEBioThread*>(r.runner)->KillThread();
+		else dynamic_cast<QProcess*>(r.runner)->kill();
+	}
+}
+
+int CFEBioJobManager::QueuedJobs() const { return (int)im->queue.size(); }
+int CFEBioJobManager::RunningQueuedJobs() const { return (int)im->running.size(); }
+
+void CFEBioJobManager::SetMaxConcurrentJobs(int n) 
+{ 
+	im->maxJobs = (n < 1 ? 1 : n);
+	StartQueuedJobs();
+}
+
+int CFEBioJobManager::MaxConcurrentJobs() const { return im->maxJobs; }
+
+int CFEBioJobManager::ThreadsPerJob() const
+{
+	int n = QThread::idealThreadCount() / im->maxJobs;
+	return (n < 1 ? 1 : n);
+}
+
+void CFEBioJobManager::StartQueuedJobs()
+{
+	while (((int)im->running.size() < im->maxJobs) && (im->queue.empty() == false))
+	{
+		CFEBioJob* job = im->queue.front();
+		int launchType = job->GetLaunchConfig()->type;
+
+		Impl::QueuedRun r = { job, nullptr, false };
+		if (launchType == launchTypes::DEFAULT)
+		{
+			// FEBio can only run one model in-process at a time, so wait 
+			// for the other model to finish (we don't skip it to keep the order)
+			if (im->IsRunningInProcess() || (im->febThread != nullptr)) break;
+
+			CFEBioThread* thread = new CFEBioThread(im->wnd, job, this);
+			QObject::connect(thread, &QThread::finished, thread, &QObject::deleteLater);
+			r.runner = thread;
+			r.inProcess = true;
+		}
+		else if (launchType == LOCAL)
+		{
+			CLocalJobProcess* process = new CLocalJobProcess(im->wnd, job, this);
+			process->SetThreadCount(ThreadsPerJob());
+			r.runner = process;
+		}
+		else
+		{
+			// remote jobs are not managed by the queue
+			im->queue.pop_front();
+			job->SetStatus(CFEBioJob::FAILED);
+			im->wnd->AddLogEntry(QString("FEBio job \"%1\" cannot be queued: only local jobs are supported.\n").arg(QString::fromStdString(job->GetName())));
+			continue;
+		}
+
+		im->queue.pop_front();
+		im->running.push_back(r);
+
+		job->ClearProgress();
+		job->StartTimer();
+		if (r.inProcess) dynamic_cast<CFEBioThread*>(r.runner)->start();
+		else dynamic_cast<CLocalJobProcess*>(r.runner)->run();
+
+		im->wnd->UpdateModel(job, false);
+	}
+}
+
+bool CFEBioJobManager::IsQueuedRunner(QObject* runner) const
+{
+	if (runner == nullptr) return false;
+	for (const Impl::QueuedRun& r : im->running)
+		if (r.runner == runner) return true;
+	return false;
+}
+
+void CFEBioJobManager::FinishQueuedJob(QObject* runner, int status)
+{
+	for (size_t i = 0; i < im->running.size(); ++i)
+	{
+		Impl::QueuedRun r = im->running[i];
+		if (r.runner == runner)
+		{
+			im->running.erase(im->running.begin() + i);
+
+			CFEBioJob* job = r.job;
+			job->StopTimer();
+			if (job->GetStatus() != CFEBioJob::CANCELLED) job->SetStatus((CFEBioJob::JOB_STATUS)status);
+
+			QString sret;
+			switch (job->GetStatus())
+			{
+			case CFEBioJob::COMPLETED: sret = "NORMAL TERMINATION"; break;
+			case CFEBioJob::CANCELLED: sret = "CANCELLED"; break;
+			default:
+				sret = "ERROR TERMINATION";
+			}
+			QString jobName = QString::fromStdString(job->GetName());
+			im->wnd->AddLogEntry(QString("FEBio job \"%1 \" has finished: %2 (%3 jobs remaining)\n").arg(jobName).arg(sret).arg(im->queue.size() + im->running.size()));
+
+			// threads delete themselves when they finish
+			if (r.inProcess == false) runner->deleteLater();
+
+			im->wnd->UpdateModel(job, false);
+			break;
+		}
+	}
+
+	StartQueuedJobs();
+}
+
 void CFEBioJobManager::onRunFinished(int exitCode, QProcess::ExitStatus es)
 {
+	// see if this is one of the queued jobs
+	if (IsQueuedRunner(sender()))
+	{
+		FinishQueuedJob(sender(), (exitCode == 0 ? CFEBioJob::COMPLETED : CFEBioJob::FAILED));
+		return;
+	}
+
 	CFEBioJob* job = CFEBioJob::GetActiveJob();
 	if (job)
 	{
@@ -185,10 +399,24 @@ void CFEBioJobManager::onRunFinished(int exitCode, QProcess::ExitStatus es)
 	im->febThread = nullptr;
 	delete im->process;
 	im->process = nullptr;
+
+	// queued in-process jobs may have been waiting for this job
+	StartQueuedJobs();
 }
 
 void CFEBioJobManager::onReadyRead()
 {
+	// The output of queued jobs is not shown since several jobs can be running.
+	// (FEBio writes it to the job's log file anyway.)
+	QObject* runner = sender();
+	if (IsQueuedRunner(runner))
+	{
+		CFEBioThread* thread = dynamic_cast<CFEBioThread*>(runner);
+		if (thread) thread->GetOutput();
+		else dynamic_cast<QProcess*>(runner)->readAll();
+		return;
+	}
+
 	if (im->process)
 	{
 		QByteArray output = im->process->readAll();
@@ -204,6 +432,13 @@ void CFEBioJobManager::onReadyRead()
 
 void CFEBioJobManager::onErrorOccurred(QProcess::ProcessError err)
 {
+	// for queued jobs, onRunFinished is called, unless the process failed to start
+	if (IsQueuedRunner(sender()))
+	{
+		if (err == QProcess::FailedToStart) FinishQueuedJob(sender(), CFEBioJob::FAILED);
+		return;
+	}
+
 	// make sure we don't have an active job since onRunFinished will not be called!
 	CFEBioJob::SetActiveJob(nullptr);
 
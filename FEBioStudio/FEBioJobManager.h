@@ -27,9 +27,12 @@ SOFTWARE.*/
 #include <QObject>
 #include <QProcess>
 #include <QDialog>
+#include <vector>
+#include <string>
 
 class CMainWindow;
 class CFEBioJob;
+class CModelDocument;
 
 class CFEBioJobManager : public QObject
 {
@@ -45,6 +48,37 @@ public:
 
 	void KillJob();
 
+public:
+	// Queue a job. Queued jobs run in the background, up to the maximum number
+	// of concurrent jobs. Jobs that run in-process are executed one at a time.
+	void QueueJob(CFEBioJob* job);
+
+	// Create a job for each value of a model parameter and queue them.
+	// The settings of the base job are copied to each new job. Returns the number of queued jobs.
+	int QueueParameterSweep(CModelDocument* doc, CFEBioJob* baseJob, const std::string& paramName, const std::vector<double>& values);
+
+	// cancel all queued jobs, including the ones that are running
+	void CancelQueue();
+
+	// number of jobs waiting in the queue
+	int QueuedJobs() const;
+
+	// number of queued jobs that are running
+	int RunningQueuedJobs() const;
+
+	// set/get the max number of queued jobs that can run concurrently
+	void SetMaxConcurrentJobs(int n);
+	int MaxConcurrentJobs() const;
+
+	// The number of threads each queued job gets, so that the concurrent jobs
+	// together don't use more threads than the machine has cores.
+	int ThreadsPerJob() const;
+
+private:
+	void StartQueuedJobs();
+	bool IsQueuedRunner(QObject* runner) const;
+	void FinishQueuedJob(QObject* runner, int status);
+
 public slots:
 	void onRunFinished(int exitCode, QProcess::ExitStatus es);
 	void onReadyRead();
@@ -38,6 +38,7 @@ SOFTWARE.*/
 #include <QDebug>
 #include <QPainter>
 #include <FEBioLink/FEBioInit.h>
+#include <PostLib/FEBatchPostProcessor.h>
 
 #ifdef __APPLE__
 #include <QFileOpenEvent>
@@ -139,6 +140,19 @@ int main(int argc, char* argv[])
 	// initialize the FEBio library
 	FEBio::InitFEBioLibrary();
 
+	// In batch mode, the post-processing jobs are run without creating the GUI
+	if ((argc > 1) && (strcmp(argv[1], "-batch") == 0))
+	{
+		Post::FEBatchPostProcessor batch;
+		if (batch.ParseCommandLine(argc - 2, argv + 2) == false)
+		{
+			fprintf(stderr, "ERROR: %s\n\n", batch.GetErrorString().c_str());
+			Post::FEBatchPostProcessor::PrintUsage();
+			return 1;
+		}
+		return (batch.Run() ? 0 : 1);
+	}
+
 	// create the application object
 	FBSApplication app(argc, argv);
 
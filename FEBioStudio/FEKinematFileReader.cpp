@@ -75,13 +75,13 @@ bool FEKinematFileReader::Load(const char* szfile)
 	// a new model is created when the doc is initialized
 	CGLModel* glm = m_doc->GetGLModel();
 
-	// update displacements on all states
+	// update displacements of the current state
+	// (other states are updated when they become active)
 	if (glm->GetDisplacementMap() == nullptr)
 	{
 		glm->AddDisplacementMap("Displacement");
 	}
-	int nstates = glm->GetFSModel()->GetStates();
-	for (int i = 0; i < nstates; ++i) glm->UpdateDisplacements(i, true);
+	glm->UpdateDisplacements(glm->GetFSModel()->CurrentTimeIndex(), true);
 
 	return true;
 }
@@ -61,7 +61,6 @@ public:
 
 	QLineEdit*	m_maxIters;
 	QLineEdit*	m_tol;
-	QLineEdit*	m_sor;
 
 	QLineEdit* m_normal;
 
@@ -93,7 +92,6 @@ public:
 		f->addRow("Material:", m_matList = new QComboBox);
 		f->addRow("Max iterations:", m_maxIters = new QLineEdit); m_maxIters->setText(QString::number(1000));
 		f->addRow("Tolerance:", m_tol = new QLineEdit); m_tol->setText(QString::number(1e-4));
-		f->addRow("SOR parameter:", m_sor = new QLineEdit); m_sor->setText(QString::number(1.8));
 		f->addRow("Generate mat axes:", m_matAxes = new QCheckBox);
 		f->addRow("Generate cross product:", m_cross = new QCheckBox);
 		f->addRow("Normal vector:", m_normal = new QLineEdit);
@@ -107,7 +105,6 @@ public:
 
 		m_maxIters->setValidator(new QIntValidator());
 		m_tol->setValidator(new QDoubleValidator());
-		m_sor->setValidator(new QDoubleValidator());
 
 		l->addLayout(f);
 
@@ -318,17 +315,14 @@ void CFiberGeneratorTool::OnApply()
 	// get parameters
 	int maxIter = ui->m_maxIters->text().toInt();
 	double tol = ui->m_tol->text().toDouble();
-	double w = ui->m_sor->text().toDouble();
 
 	wnd->AddLogEntry(QString("max iters     = %1\n").arg(maxIter));
 	wnd->AddLogEntry(QString("tolerance     = %1\n").arg(tol));
-	wnd->AddLogEntry(QString("SOR parameter = %1\n").arg(w));
 
 	// solve Laplace equation
 	LaplaceSolver L;
 	L.SetMaxIterations(maxIter);
 	L.SetTolerance(tol);
-	L.SetRelaxation(w);
 	bool b = L.Solve(pm, val, bn, 1);
 	int niters = L.GetIterationCount();
 	wnd->AddLogEntry(QString("%1").arg(b ? "Converged!\n" : "NOT converged!\n"));
@@ -32,12 +32,14 @@ SOFTWARE.*/
 #include <GeomLib/GGroup.h>
 #include <GLLib/glx.h>
 #include <GLLib/GLMeshRender.h>
+#include <GLLib/GLGlyphMesh.h>
 #include <FEMLib/FEModelConstraint.h>
 #include <GeomLib/GSurfaceMeshObject.h>
 #include <FEMLib/FELoad.h>
 #include <MeshLib/MeshMetrics.h>
 #include <ImageLib/RGBImage.h>
 #include <QImageReader>
+#include <FSCore/CallTracer.h>
 
 const int HEX_NT[8] = { 0, 1, 2, 3, 4, 5, 6, 7 };
 const int PEN_NT[8] = { 0, 1, 2, 2, 3, 4, 5, 5 };
@@ -73,6 +75,12 @@ CGLModelScene::CGLModelScene(CModelDocument* doc) : m_doc(doc)
 {
 }
 
+CGLModelScene::~CGLModelScene()
+{
+	for (auto& it : m_fiberCache) delete it.second;
+	for (auto& it : m_axesCache) delete it.second;
+}
+
 GLMeshRender& CGLModelScene::GetMeshRenderer() { return m_renderer; }
 
 BOX CGLModelScene::GetBoundingBox()
@@ -98,6 +106,8 @@ BOX CGLModelScene::GetSelectionBox()
 
 void CGLModelScene::Render(CGLContext& rc)
 {
+	TRACE("CGLModelScene::Render");
+
 	if ((m_doc == nullptr) || (m_doc->IsValid() == false)) return;
 
 	CGLView* glview = rc.m_view; assert(glview);
@@ -948,212 +958,329 @@ void CGLModelScene::RenderRigidConnectors(CGLContext& rc)
 	glPopAttrib();
 }
 
-class GLFiberRenderer
+//=============================================================================
+// Cached geometry of the material fibers or the local material axes of an object.
+// The glyph mesh stores the line or cylinder geometry once, and only a transformation 
+// and color per fiber. The geometry is rebuilt only when the signature of the data it 
+// was built from changes (see GLFiberSignature).
+class GLFiberCache
 {
 public:
-	GLFiberRenderer() {}
-	void RenderFiber(GObject* po, FSMaterial* pmat, FEElementRef& rel, const vec3d& c, mat3d Q = mat3d::identity());
-	void RenderFiber(GObject* po, FSMaterialProperty* pmat, FEElementRef& rel, const vec3d& c, mat3d Q = mat3d::identity());
+	bool		m_bvalid = false;
+	uint64_t	m_signature = 0;
+	GLGlyphMesh	m_glyph;
+};
 
-	void Init();
+//-----------------------------------------------------------------------------
+// FNV-1a hash of the data that the fiber or axes geometry of an object depends on. 
+// Element data (e.g. user fibers and orientations) is not hashed. It is covered
+// by the mesh and document modification counters instead.
+class GLFiberSignature
+{
+public:
+	template <typename T> void add(const T& v) { add(&v, sizeof(T)); }
+	template <typename T> void add(const std::vector<T>& v) { add(v.size()); if (!v.empty()) add(&v[0], v.size() * sizeof(T)); }
+	void add(const std::string& s) { add(s.size()); add(s.c_str(), s.size()); }
 
-	void Finish();
+	void add(const void* pd, size_t n)
+	{
+		const unsigned char* p = (const unsigned char*)pd;
+		for (size_t i = 0; i < n; ++i) { m_h ^= p[i]; m_h *= 1099511628211ull; }
+	}
 
-public:
-	void SetColorOption(int n) { m_colorOption = n; }
-	void SetDefaultColor(GLColor c) { m_defaultCol = c; }
-	void SetScaleFactor(double s) { m_scale = s; }
-	void SetLineStyle(int n) { m_lineStyle = n; }
-	void SetLineWidth(double l) { m_lineWidth = l; }
+	uint64_t value() const { return m_h; }
 
 private:
-	int		m_colorOption = 0;
-	int		m_lineStyle = 0;
-	double	m_lineWidth = 1.0;
-	GLColor	m_defaultCol;
-	double	m_scale = 1.0;
-	GLUquadricObj* m_glyph = nullptr;
+	uint64_t	m_h = 14695981039346656037ull;
 };
 
-void GLFiberRenderer::Init()
+// add the parameters of a material (component) and all its properties to the signature
+static void addMaterialSignature(GLFiberSignature& sig, FSCoreBase* pc)
 {
-	glPushAttrib(GL_ENABLE_BIT);
-	glEnable(GL_COLOR_MATERIAL);
-	if (m_lineStyle == 0)
+	sig.add(pc);
+	if (pc == nullptr) return;
+
+	for (int i = 0; i < pc->Parameters(); ++i)
 	{
-		glDisable(GL_LIGHTING);
-		glDisable(GL_DEPTH_TEST);
-		glBegin(GL_LINES);
+		const Param& p = pc->GetParam(i);
+		switch (p.GetParamType())
+		{
+		case Param_INT   :
+		case Param_CHOICE: sig.add(p.GetIntValue()); break;
+		case Param_FLOAT : sig.add(p.GetFloatValue()); break;
+		case Param_BOOL  : sig.add(p.GetBoolValue()); break;
+		case Param_VEC3D : sig.add(p.GetVec3dValue()); break;
+		case Param_VEC2I : sig.add(p.GetVec2iValue()); break;
+		case Param_MAT3D : sig.add(p.GetMat3dValue()); break;
+		case Param_MAT3DS: sig.add(p.GetMat3dsValue()); break;
+		case Param_STRING: sig.add(p.GetStringValue()); break;
+		case Param_MATH  : sig.add(p.GetMathString()); break;
+		case Param_COLOR : sig.add(p.GetColorValue()); break;
+		case Param_STD_VECTOR_INT   : sig.add(p.GetVectorIntValue()); break;
+		case Param_STD_VECTOR_DOUBLE: sig.add(p.GetVectorDoubleValue()); break;
+		case Param_ARRAY_INT   : sig.add(p.GetArrayIntValue()); break;
+		case Param_ARRAY_DOUBLE: sig.add(p.GetArrayDoubleValue()); break;
+		default:
+			break;
+		}
 	}
-	else
+
+	for (int i = 0; i < pc->Properties(); ++i)
 	{
-		m_glyph = gluNewQuadric();
-		gluQuadricNormals(m_glyph, GLU_SMOOTH);
+		FSProperty& prop = pc->GetProperty(i);
+		for (int j = 0; j < prop.Size(); ++j) addMaterialSignature(sig, prop.GetComponent(j));
 	}
+
+	// the axes and the fibers of the old-style materials are not stored as properties
+	FSMaterial* pmat = dynamic_cast<FSMaterial*>(pc);
+	if (pmat && pmat->m_axes) addMaterialSignature(sig, pmat->m_axes);
+
+	FSTransverselyIsotropic* ptiso = dynamic_cast<FSTransverselyIsotropic*>(pc);
+	if (ptiso) addMaterialSignature(sig, ptiso->GetFiberMaterial());
 }
 
-void GLFiberRenderer::Finish()
+// add the mesh, transform, part visibility and part materials of an object to the signature
+static void addObjectSignature(GLFiberSignature& sig, GObject* po, FSModel* fem)
 {
-	if (m_lineStyle == 0)
+	FSMesh* pm = po->GetFEMesh();
+	sig.add(pm);
+	sig.add(pm->ModificationCounter());
+
+	const Transform& T = po->GetTransform();
+	sig.add(T.GetPosition());
+	sig.add(T.GetRotation());
+	sig.add(T.GetScale());
+
+	for (int i = 0; i < po->Parts(); ++i)
 	{
-		glEnd(); // GL_LINES
+		GPart* pg = po->Part(i);
+		sig.add(pg->IsVisible());
+
+		GMaterial* pgm = fem->GetMaterialFromID(pg->GetMaterialID());
+		sig.add(pgm);
+		if (pgm)
+		{
+			sig.add(pgm->Diffuse());
+			addMaterialSignature(sig, pgm->GetMaterialProperties());
+		}
 	}
-	else
+}
+
+// look up the material and visibility of all parts of an object
+static void getPartMaterials(GObject* po, FSModel* fem, std::vector<GMaterial*>& partMat, std::vector<char>& partVisible)
+{
+	int NP = po->Parts();
+	partMat.assign(NP, nullptr);
+	partVisible.assign(NP, 0);
+	for (int i = 0; i < NP; ++i)
 	{
-		gluDeleteQuadric(m_glyph);
+		GPart* pg = po->Part(i);
+		partMat[i] = fem->GetMaterialFromID(pg->GetMaterialID());
+		partVisible[i] = (pg->IsVisible() ? 1 : 0);
 	}
-	glPopAttrib();
 }
 
-void GLFiberRenderer::RenderFiber(GObject* po, FSMaterial* pmat, FEElementRef& rel, const vec3d& c, mat3d Q)
+// remove the cached geometry of objects that are no longer in the model
+static void pruneFiberCache(std::map<GObject*, GLFiberCache*>& cache, GModel& model)
 {
-	if (pmat->HasFibers())
+	for (auto it = cache.begin(); it != cache.end();)
 	{
-		vec3d q0 = pmat->GetFiber(rel);
-
-		vec3d q = Q * q0;
-
-		// This vector is defined in global coordinates, except for user-defined fibers, which
-		// are assumed to be in local coordinates
-		FSTransverselyIsotropic* ptiso = dynamic_cast<FSTransverselyIsotropic*>(pmat);
-		if (ptiso && (ptiso->GetFiberMaterial()->m_naopt == FE_FIBER_USER))
+		if (model.FindObjectIndex(it->first) == -1)
 		{
-			q = po->GetTransform().LocalToGlobalNormal(q);
-		}
-
-		GLColor col = m_defaultCol;
-		if (m_colorOption == 0)
-		{
-			uint8_t r = (uint8_t)(255 * fabs(q.x));
-			uint8_t g = (uint8_t)(255 * fabs(q.y));
-			uint8_t b = (uint8_t)(255 * fabs(q.z));
-			col = GLColor(r, g, b);
+			delete it->second;
+			it = cache.erase(it);
 		}
+		else ++it;
+	}
+}
 
-		vec3d p0 = c - q * (m_scale * 0.5);
-		vec3d p1 = c + q * (m_scale * 0.5);
+//-----------------------------------------------------------------------------
+// Evaluates the fibers of an element (and of the element's material properties)
+// and adds them as glyph instances. The builder keeps state while it walks the 
+// material tree, so each thread needs its own builder.
+class GLFiberBuilder
+{
+public:
+	GLFiberBuilder(GObject* po, std::vector<GLGlyphMesh::Instance>& fibers) : m_po(po), m_fibers(fibers) {}
+	void AddFiber(FSMaterial* pmat, FEElementRef& rel, const vec3d& c, mat3d Q = mat3d::identity());
+	void AddFiber(FSMaterialProperty* pmat, FEElementRef& rel, const vec3d& c, mat3d Q = mat3d::identity());
 
-		glColor3ub(col.r, col.g, col.b);
-		if (m_lineStyle == 0)
-		{
-			glVertex3d(p0.x, p0.y, p0.z);
-			glVertex3d(p1.x, p1.y, p1.z);
-		}
-		else
-		{
-			glPushMatrix();
+public:
+	void SetColorOption(int n) { m_colorOption = n; }
+	void SetDefaultColor(GLColor c) { m_defaultCol = c; }
+	void SetScaleFactor(double s) { m_scale = s; }
+	void SetLineStyle(int n) { m_lineStyle = n; }
+	void SetLineWidth(double l) { m_lineWidth = l; }
 
-			glx::translate(p0);
-			quatd Q(vec3d(0, 0, 1), q);
-			glx::rotate(Q);
+private:
+	void AddFiberVector(FSCoreBase* pmat, vec3d q, const vec3d& c);
+	void AddProperties(FSCoreBase* pmat, FEElementRef& rel, const vec3d& c, const mat3d& Q);
 
-			gluCylinder(m_glyph, m_lineWidth, m_lineWidth, m_scale, 10, 1);
+private:
+	GObject*	m_po;
+	std::vector<GLGlyphMesh::Instance>&	m_fibers;
+	int		m_colorOption = 0;
+	int		m_lineStyle = 0;
+	double	m_lineWidth = 1.0;
+	GLColor	m_defaultCol;
+	double	m_scale = 1.0;
+};
 
-			glPopMatrix();
-		}
+void GLFiberBuilder::AddFiberVector(FSCoreBase* pmat, vec3d q, const vec3d& c)
+{
+	// This vector is defined in global coordinates, except for user-defined fibers, which
+	// are assumed to be in local coordinates
+	FSTransverselyIsotropic* ptiso = dynamic_cast<FSTransverselyIsotropic*>(pmat);
+	if (ptiso && (ptiso->GetFiberMaterial()->m_naopt == FE_FIBER_USER))
+	{
+		q = m_po->GetTransform().LocalToGlobalNormal(q);
 	}
 
-	if (pmat->HasMaterialAxes())
+	double L = q.Length();
+	if (L == 0.0) return;
+
+	GLColor col = m_defaultCol;
+	if (m_colorOption == 0)
 	{
-		Q = Q*pmat->GetMatAxes(rel);
+		uint8_t r = (uint8_t)(255 * fabs(q.x));
+		uint8_t g = (uint8_t)(255 * fabs(q.y));
+		uint8_t b = (uint8_t)(255 * fabs(q.z));
+		col = GLColor(r, g, b);
 	}
+	col.a = 255;
+
+	// lines run from c - q*s/2 to c + q*s/2, cylinders have length s
+	GLGlyphMesh::Instance g;
+	g.r = to_vec3f(c - q * (m_scale * 0.5));
+	g.SetZAxis(to_vec3f(q));
+	g.s[0] = g.s[1] = (float)m_lineWidth;
+	g.s[2] = (float)(m_lineStyle == 0 ? m_scale * L : m_scale);
+	g.c = col;
+	m_fibers.push_back(g);
+}
 
+void GLFiberBuilder::AddProperties(FSCoreBase* pmat, FEElementRef& rel, const vec3d& c, const mat3d& Q)
+{
 	int index = 0;
 	for (int i = 0; i < pmat->Properties(); ++i)
 	{
 		FSProperty& prop = pmat->GetProperty(i);
 		for (int j = 0; j < prop.Size(); ++j, ++index)
 		{
-			FSMaterial* matj = pmat->GetMaterialProperty(i, j);
+			FSMaterial* matj = dynamic_cast<FSMaterial*>(prop.GetComponent(j));
 			if (matj)
 			{
 				if (m_colorOption == 2) m_defaultCol = fiberColorPalette[index % GMaterial::MAX_COLORS];
-				RenderFiber(po, matj, rel, c, Q);
+				AddFiber(matj, rel, c, Q);
 			}
 			else
 			{
-				FSMaterialProperty* matProp = dynamic_cast<FSMaterialProperty*>(pmat->GetProperty(i).GetComponent(j));
+				FSMaterialProperty* matProp = dynamic_cast<FSMaterialProperty*>(prop.GetComponent(j));
 				if (matProp)
 				{
 					if (m_colorOption == 2) m_defaultCol = fiberColorPalette[index % GMaterial::MAX_COLORS];
-					RenderFiber(po, matProp, rel, c, Q);
+					AddFiber(matProp, rel, c, Q);
 				}
 			}
 		}
 	}
 }
 
-void GLFiberRenderer::RenderFiber(GObject* po, FSMaterialProperty* pmat, FEElementRef& rel, const vec3d& c, mat3d Q)
+void GLFiberBuilder::AddFiber(FSMaterial* pmat, FEElementRef& rel, const vec3d& c, mat3d Q)
 {
 	if (pmat->HasFibers())
 	{
 		vec3d q0 = pmat->GetFiber(rel);
+		AddFiberVector(pmat, Q * q0, c);
+	}
 
-		vec3d q = Q * q0;
+	if (pmat->HasMaterialAxes())
+	{
+		Q = Q*pmat->GetMatAxes(rel);
+	}
 
-		// This vector is defined in global coordinates, except for user-defined fibers, which
-		// are assumed to be in local coordinates
-		FSTransverselyIsotropic* ptiso = dynamic_cast<FSTransverselyIsotropic*>(pmat);
-		if (ptiso && (ptiso->GetFiberMaterial()->m_naopt == FE_FIBER_USER))
-		{
-			q = po->GetTransform().LocalToGlobalNormal(q);
-		}
+	AddProperties(pmat, rel, c, Q);
+}
 
-		GLColor col = m_defaultCol;
-		if (m_colorOption == 0)
-		{
-			uint8_t r = (uint8_t)(255 * fabs(q.x));
-			uint8_t g = (uint8_t)(255 * fabs(q.y));
-			uint8_t b = (uint8_t)(255 * fabs(q.z));
-			col = GLColor(r, g, b);
-		}
+void GLFiberBuilder::AddFiber(FSMaterialProperty* pmat, FEElementRef& rel, const vec3d& c, mat3d Q)
+{
+	if (pmat->HasFibers())
+	{
+		vec3d q0 = pmat->GetFiber(rel);
+		AddFiberVector(pmat, Q * q0, c);
+	}
 
-		vec3d p0 = c - q * (m_scale * 0.5);
-		vec3d p1 = c + q * (m_scale * 0.5);
+	AddProperties(pmat, rel, c, Q);
+}
 
-		glColor3ub(col.r, col.g, col.b);
-		if (m_lineStyle == 0)
-		{
-			glVertex3d(p0.x, p0.y, p0.z);
-			glVertex3d(p1.x, p1.y, p1.z);
-		}
-		else
-		{
-			glPushMatrix();
+// Evaluates the fibers of all elements of an object and builds the glyph mesh
+static void buildMaterialFibers(GObject* po, FSModel* fem, GLViewSettings& view, double h, GLGlyphMesh& glyph)
+{
+	FSMesh* pm = po->GetFEMesh();
+	const Transform& T = po->GetTransform();
 
-			glx::translate(p0);
-			quatd Q(vec3d(0, 0, 1), q);
-			glx::rotate(Q);
+	vector<GMaterial*> partMat;
+	vector<char> partVisible;
+	getPartMaterials(po, fem, partMat, partVisible);
+	int NP = (int)partMat.size();
 
-			gluCylinder(m_glyph, m_lineWidth, m_lineWidth, m_scale, 10, 1);
+	// The fibers are evaluated in parallel. Since an element can have any number of 
+	// fibers, each thread collects its own list, and the lists are merged at the end.
+	vector<GLGlyphMesh::Instance> fibers;
+	int NE = pm->Elements();
+#pragma omp parallel
+	{
+		vector<GLGlyphMesh::Instance> threadFibers;
+		GLFiberBuilder fiberBuilder(po, threadFibers);
+		fiberBuilder.SetScaleFactor(h * view.m_fiber_scale);
+		fiberBuilder.SetLineWidth(h * view.m_fiber_width * 0.1);
+		fiberBuilder.SetColorOption(view.m_fibColor);
+		fiberBuilder.SetLineStyle(view.m_fibLineStyle);
 
-			glPopMatrix();
-		}
-	}
+		FEElementRef rel;
+		rel.m_pmesh = pm;
 
-	int index = 0;
-	for (int i = 0; i < pmat->Properties(); ++i)
-	{
-		FSProperty& prop = pmat->GetProperty(i);
-		for (int j = 0; j < prop.Size(); ++j, ++index)
+#pragma omp for schedule(dynamic, 1024)
+		for (int j = 0; j < NE; ++j)
 		{
-			FSMaterial* matj = dynamic_cast<FSMaterial*>(pmat->GetProperty(i).GetComponent(j));
-			if (matj)
-			{
-				if (m_colorOption == 2) m_defaultCol = fiberColorPalette[index % GMaterial::MAX_COLORS];
-				RenderFiber(po, matj, rel, c, Q);
-			}
-			else
+			FSElement& el = pm->Element(j);
+			int gid = el.m_gid;
+			if ((gid < 0) || (gid >= NP)) continue;
+
+			bool showFiber = (partVisible[gid] && el.IsVisible()) || view.m_showHiddenFibers;
+
+			GMaterial* pgm = partMat[gid];
+			FSMaterial* pmat = (pgm ? pgm->GetMaterialProperties() : nullptr);
+			if (showFiber && pmat)
 			{
-				FSMaterialProperty* matProp = dynamic_cast<FSMaterialProperty*>(pmat->GetProperty(i).GetComponent(j));
-				if (matProp)
-				{
-					if (m_colorOption == 2) m_defaultCol = fiberColorPalette[index % GMaterial::MAX_COLORS];
-					RenderFiber(po, matProp, rel, c, Q);
-				}
+				fiberBuilder.SetDefaultColor(pgm->Diffuse());
+
+				// element center
+				vec3d c(0, 0, 0);
+				for (int k = 0; k < el.Nodes(); ++k) c += pm->Node(el.m_node[k]).r;
+				c /= el.Nodes();
+
+				// to global coordinates
+				c = T.LocalToGlobal(c);
+
+				rel.m_nelem = j;
+				fiberBuilder.AddFiber(pmat, rel, c);
 			}
 		}
+
+#pragma omp critical
+		{
+			fibers.insert(fibers.end(), threadFibers.begin(), threadFibers.end());
+			vector<GLGlyphMesh::Instance>().swap(threadFibers);
+		}
 	}
+
+	glyph.ClearGlyph();
+	if (view.m_fibLineStyle == 0)
+		glyph.AddLine(vec3f(0.f, 0.f, 0.f), vec3f(0.f, 0.f, 1.f));
+	else
+		glyph.AddCylinder(1.f, 1.f, 0.f, 1.f, 10);
+	glyph.Build(fibers);
 }
 
 void CGLModelScene::RenderMaterialFibers(CGLContext& rc)
@@ -1170,74 +1297,140 @@ void CGLModelScene::RenderMaterialFibers(CGLContext& rc)
 	FSModel* ps = pdoc->GetFSModel();
 	GModel& model = ps->GetModel();
 
-	FEElementRef rel;
-
 	BOX box = model.GetBoundingBox();
 	double h = 0.05 * box.GetMaxExtent();
 
-	GLFiberRenderer fiberRender;
-	fiberRender.SetScaleFactor(h * view.m_fiber_scale);
-	fiberRender.SetLineWidth(h * view.m_fiber_width * 0.1);
-	fiberRender.SetColorOption(view.m_fibColor);
-	fiberRender.SetLineStyle(view.m_fibLineStyle);
-
-	fiberRender.Init();
+	glPushAttrib(GL_ENABLE_BIT);
+	glEnable(GL_COLOR_MATERIAL);
+	if (view.m_fibLineStyle == 0)
+	{
+		glDisable(GL_LIGHTING);
+		glDisable(GL_DEPTH_TEST);
+	}
 
-	GMaterial* pgm = nullptr;
-	int matId = -1;
-	int index = 0;
 	for (int i = 0; i < model.Objects(); ++i)
 	{
 		GObject* po = model.Object(i);
-		if (po->IsVisible() && po->IsValid() && (po->IsSelected() || (view.m_showSelectFibersOnly == false)))
+		if (po->IsVisible() && po->IsValid() && (po->IsSelected() || (view.m_showSelectFibersOnly == false)) && po->GetFEMesh())
 		{
-			FSMesh* pm = po->GetFEMesh();
-			if (pm)
+			GLFiberSignature sig;
+			sig.add(pdoc->ModificationCounter());
+			addObjectSignature(sig, po, ps);
+			sig.add(h);
+			sig.add(view.m_fiber_scale);
+			sig.add(view.m_fiber_width);
+			sig.add(view.m_fibColor);
+			sig.add(view.m_fibLineStyle);
+			sig.add(view.m_showHiddenFibers);
+
+			GLFiberCache*& cache = m_fiberCache[po];
+			if (cache == nullptr) cache = new GLFiberCache;
+			if ((cache->m_bvalid == false) || (cache->m_signature != sig.value()))
 			{
-				rel.m_pmesh = pm;
-				for (int j = 0; j < pm->Elements(); ++j)
-				{
-					FSElement& el = pm->Element(j);
-					GPart* pg = po->Part(el.m_gid);
+				buildMaterialFibers(po, ps, view, h, cache->m_glyph);
+				cache->m_signature = sig.value();
+				cache->m_bvalid = true;
+			}
 
-					bool showFiber = (pg->IsVisible() && el.IsVisible()) || view.m_showHiddenFibers;
+			cache->m_glyph.Render();
+		}
+	}
 
-					if (showFiber)
-					{
-						int partMatID = po->Part(el.m_gid)->GetMaterialID();
-						if (partMatID != matId)
-						{
-							matId = partMatID;
-							pgm = ps->GetMaterialFromID(matId);
-						}
-						FSMaterial* pmat = 0;
-						if (pgm)
-						{
-							pmat = pgm->GetMaterialProperties();
-							fiberRender.SetDefaultColor(pgm->Diffuse());
-						}
+	glPopAttrib();
 
-						rel.m_nelem = j;
-						if (pmat)
-						{
-							// element center
-							vec3d c(0, 0, 0);
-							for (int k = 0; k < el.Nodes(); ++k) c += pm->Node(el.m_node[k]).r;
-							c /= el.Nodes();
+	pruneFiberCache(m_fiberCache, model);
+}
 
-							// to global coordinates
-							c = po->GetTransform().LocalToGlobal(c);
+// add a line from c to c + v to the axes
+static void addAxis(vector<GLGlyphMesh::Instance>& axes, const vec3d& c, const vec3d& v, const GLColor& col)
+{
+	double L = v.Length();
+	if (L == 0.0) return;
+
+	GLGlyphMesh::Instance g;
+	g.r = to_vec3f(c);
+	g.SetZAxis(to_vec3f(v));
+	g.s[0] = g.s[1] = 1.f;
+	g.s[2] = (float)L;
+	g.c = col;
+	axes.push_back(g);
+}
 
-							// render the fiber
-							fiberRender.RenderFiber(po, pmat, rel, c);
-						}
-					}
+// Evaluates the local material axes of all elements of an object and builds the glyph mesh
+static void buildLocalMaterialAxes(GObject* po, FSModel* fem, bool showHidden, double h, GLGlyphMesh& glyph)
+{
+	FSMesh* pm = po->GetFEMesh();
+	const Transform& T = po->GetTransform();
+
+	vector<GMaterial*> partMat;
+	vector<char> partVisible;
+	getPartMaterials(po, fem, partMat, partVisible);
+	int NP = (int)partMat.size();
+
+	const GLColor axisColor[3] = { GLColor(255, 0, 0), GLColor(0, 255, 0), GLColor(0, 0, 255) };
+
+	vector<GLGlyphMesh::Instance> axes;
+	int NE = pm->Elements();
+#pragma omp parallel
+	{
+		vector<GLGlyphMesh::Instance> threadAxes;
+
+		FEElementRef rel;
+		rel.m_pmesh = pm;
+
+#pragma omp for schedule(dynamic, 1024)
+		for (int j = 0; j < NE; ++j)
+		{
+			FSElement& el = pm->Element(j);
+			int gid = el.m_gid;
+			if ((gid < 0) || (gid >= NP)) continue;
+
+			bool showAxes = (partVisible[gid] && el.IsVisible()) || showHidden;
+			if (showAxes == false) continue;
+
+			GMaterial* pgm = partMat[gid];
+			FSMaterial* pmat = (pgm ? pgm->GetMaterialProperties() : nullptr);
+
+			rel.m_nelem = j;
+			if (el.m_Qactive)
+			{
+				vec3d c(0, 0, 0);
+				for (int k = 0; k < el.Nodes(); ++k) c += pm->NodePosition(el.m_node[k]);
+				c /= el.Nodes();
+
+				mat3d Q = el.m_Q;
+				for (int k = 0; k < 3; ++k)
+				{
+					vec3d q = vec3d(Q[0][k], Q[1][k], Q[2][k]);
+					q = T.LocalToGlobalNormal(q);
+					addAxis(threadAxes, c, q * h, axisColor[k]);
+				}
+			}
+			else if (pmat && pmat->HasMaterialAxes())
+			{
+				vec3d c(0, 0, 0);
+				for (int k = 0; k < el.Nodes(); ++k) c += pm->NodePosition(el.m_node[k]);
+				c /= el.Nodes();
+
+				mat3d Q = pmat->GetMatAxes(rel);
+				for (int k = 0; k < 3; ++k)
+				{
+					vec3d q = vec3d(Q[0][k], Q[1][k], Q[2][k]);
+					addAxis(threadAxes, c, q * h, axisColor[k]);
 				}
 			}
 		}
+
+#pragma omp critical
+		{
+			axes.insert(axes.end(), threadAxes.begin(), threadAxes.end());
+			vector<GLGlyphMesh::Instance>().swap(threadAxes);
+		}
 	}
 
-	fiberRender.Finish();
+	glyph.ClearGlyph();
+	glyph.AddLine(vec3f(0.f, 0.f, 0.f), vec3f(0.f, 0.f, 1.f));
+	glyph.Build(axes);
 }
 
 void CGLModelScene::RenderLocalMaterialAxes(CGLContext& rc)
@@ -1252,8 +1445,6 @@ void CGLModelScene::RenderLocalMaterialAxes(CGLContext& rc)
 	FSModel* ps = pdoc->GetFSModel();
 	GModel& model = ps->GetModel();
 
-	FEElementRef rel;
-
 	glPushAttrib(GL_ENABLE_BIT);
 	glDisable(GL_LIGHTING);
 
@@ -1261,74 +1452,33 @@ void CGLModelScene::RenderLocalMaterialAxes(CGLContext& rc)
 	BOX box = model.GetBoundingBox();
 	double h = 0.05 * box.GetMaxExtent() * view.m_fiber_scale;
 
-	double rgb[3][3] = { 255, 0, 0, 0, 255, 0, 0, 0, 255 };
-
 	for (int i = 0; i < model.Objects(); ++i)
 	{
 		GObject* po = model.Object(i);
-		if (po->IsVisible())
+		if (po->IsVisible() && po->GetFEMesh())
 		{
-			FSMesh* pm = po->GetFEMesh();
-			if (pm)
-			{
-				Transform& T = po->GetTransform();
-				rel.m_pmesh = pm;
-				for (int j = 0; j < pm->Elements(); ++j)
-				{
-					FSElement& el = pm->Element(j);
-
-					GPart* pg = po->Part(el.m_gid);
-
-					bool showAxes = (pg->IsVisible() && el.IsVisible()) || view.m_showHiddenFibers;
-
-					if (showAxes)
-					{
-						GMaterial* pgm = ps->GetMaterialFromID(po->Part(el.m_gid)->GetMaterialID());
-						FSMaterial* pmat = 0;
-						if (pgm) pmat = pgm->GetMaterialProperties();
-
-						rel.m_nelem = j;
-						if (el.m_Qactive)
-						{
-							vec3d c(0, 0, 0);
-							for (int k = 0; k < el.Nodes(); ++k) c += pm->NodePosition(el.m_node[k]);
-							c /= el.Nodes();
-
-							mat3d Q = el.m_Q;
-							vec3d q;
-							for (int k = 0; k < 3; ++k) {
-								q = vec3d(Q[0][k], Q[1][k], Q[2][k]);
+			GLFiberSignature sig;
+			sig.add(pdoc->ModificationCounter());
+			addObjectSignature(sig, po, ps);
+			sig.add(h);
+			sig.add(view.m_showHiddenFibers);
 
-								q = T.LocalToGlobalNormal(q);
-
-								glColor3ub(rgb[0][k], rgb[1][k], rgb[2][k]);
-
-								glx::drawLine(c, c + q * h);
-							}
-						}
-						else if (pmat && pmat->HasMaterialAxes())
-						{
-							vec3d c(0, 0, 0);
-							for (int k = 0; k < el.Nodes(); ++k) c += pm->NodePosition(el.m_node[k]);
-							c /= el.Nodes();
-
-							mat3d Q = pmat->GetMatAxes(rel);
-							vec3d q;
-							for (int k = 0; k < 3; ++k) {
-								q = vec3d(Q[0][k], Q[1][k], Q[2][k]);
-
-								glColor3ub(rgb[0][k], rgb[1][k], rgb[2][k]);
-
-								glx::drawLine(c, c + q * h);
-							}
-						}
-					}
-				}
+			GLFiberCache*& cache = m_axesCache[po];
+			if (cache == nullptr) cache = new GLFiberCache;
+			if ((cache->m_bvalid == false) || (cache->m_signature != sig.value()))
+			{
+				buildLocalMaterialAxes(po, ps, view.m_showHiddenFibers, h, cache->m_glyph);
+				cache->m_signature = sig.value();
+				cache->m_bvalid = true;
 			}
+
+			cache->m_glyph.Render();
 		}
 	}
 
 	glPopAttrib();
+
+	pruneFiberCache(m_axesCache, model);
 }
 
 void RenderLine(GNode& n0, GNode& n1)
@@ -26,14 +26,17 @@ SOFTWARE.*/
 #pragma once
 #include "Document.h"
 #include <GLLib/GLMeshRender.h>
+#include <map>
 
 class CModelDocument;
 class GPart;
+class GLFiberCache;
 
 class CGLModelScene : public CGLScene
 {
 public:
 	CGLModelScene(CModelDocument* doc);
+	~CGLModelScene();
 
 	void Render(CGLContext& rc) override;
 
@@ -104,4 +107,8 @@ private:
 private:
 	CModelDocument* m_doc;
 	GLMeshRender	m_renderer;
+
+	// cached geometry of the material fibers and local material axes of each object
+	std::map<GObject*, GLFiberCache*>	m_fiberCache;
+	std::map<GObject*, GLFiberCache*>	m_axesCache;
 };
@@ -30,6 +30,7 @@ SOFTWARE.*/
 #include <PostGL/GLPlaneCutPlot.h>
 #include <GLLib/glx.h>
 #include "PostObject.h"
+#include <FSCore/CallTracer.h>
 
 CGLPostScene::CGLPostScene(CPostDocument* doc) : m_doc(doc)
 {
@@ -60,6 +61,8 @@ BOX CGLPostScene::GetSelectionBox()
 
 void CGLPostScene::Render(CGLContext& rc)
 {
+	TRACE("CGLPostScene::Render");
+
 	if ((m_doc == nullptr) || (m_doc->IsValid() == false)) return;
 
 	CGLView* glview = rc.m_view; assert(glview);
@@ -27,11 +27,102 @@ SOFTWARE.*/
 #include "GLScreenRecorder.h"
 #include "GLView.h"
 #include "Animation.h"
+#include <QThread>
+#include <QMutex>
+#include <QWaitCondition>
+#include <QImage>
+#include <deque>
+#include <vector>
+#include <string.h>
 
-GLScreenRecorder::GLScreenRecorder() : m_glview(nullptr), m_video(nullptr)
+//-----------------------------------------------------------------------------
+// Worker thread that passes the captured frames to the video stream. The queue is
+// bounded so that a slow encoder throttles the render loop instead of buffering
+// an unlimited number of frames.
+class GLFrameWriter : public QThread
+{
+public:
+	enum { MAX_QUEUED_FRAMES = 8 };
+
+public:
+	GLFrameWriter(CAnimation* video) : m_video(video), m_done(false), m_error(false) {}
+
+	// add a frame to the queue (blocks when the queue is full)
+	bool Push(const QImage& im)
+	{
+		QMutexLocker lock(&m_mutex);
+		while ((m_queue.size() >= MAX_QUEUED_FRAMES) && !m_error) m_notFull.wait(&m_mutex);
+		if (m_error) return false;
+		m_queue.push_back(im);
+		m_notEmpty.wakeOne();
+		return true;
+	}
+
+	// write the remaining frames and stop the thread
+	void Finish()
+	{
+		m_mutex.lock();
+		m_done = true;
+		m_notEmpty.wakeOne();
+		m_mutex.unlock();
+		wait();
+	}
+
+	bool HasError()
+	{
+		QMutexLocker lock(&m_mutex);
+		return m_error;
+	}
+
+protected:
+	void run() override
+	{
+		while (true)
+		{
+			m_mutex.lock();
+			while (m_queue.empty() && !m_done) m_notEmpty.wait(&m_mutex);
+			if (m_queue.empty())
+			{
+				m_mutex.unlock();
+				break;
+			}
+			QImage im = m_queue.front();
+			m_queue.pop_front();
+			m_notFull.wakeOne();
+			m_mutex.unlock();
+
+			if (m_video->Write(im) == 0)
+			{
+				m_mutex.lock();
+				m_error = true;
+				m_queue.clear();
+				m_notFull.wakeAll();
+				m_mutex.unlock();
+				break;
+			}
+		}
+	}
+
+private:
+	CAnimation*			m_video;
+	std::deque<QImage>	m_queue;
+	QMutex				m_mutex;
+	QWaitCondition		m_notEmpty;
+	QWaitCondition		m_notFull;
+	bool				m_done;
+	bool				m_error;
+};
+
+//-----------------------------------------------------------------------------
+GLScreenRecorder::GLScreenRecorder() : m_glview(nullptr), m_video(nullptr), m_writer(nullptr)
 {
 	m_videoFormat = GL_RGB;
 	m_state = RECORDING_STATE::STOPPED;
+
+	m_pbo[0] = m_pbo[1] = 0;
+	m_pboIndex = 0;
+	m_pending = false;
+	m_pboWidth = m_pboHeight = 0;
 }
 
 void GLScreenRecorder::AttachToView(CGLView* glview)
@@ -64,6 +155,9 @@ bool GLScreenRecorder::SetVideoStream(CAnimation* video)
 	m_video = video;
 	m_state = RECORDING_STATE::STOPPED;
 
+	m_writer = new GLFrameWriter(m_video);
+	m_writer->start();
+
 	return true;
 }
 
@@ -77,14 +171,37 @@ void GLScreenRecorder::Start()
 }
 
 void GLScreenRecorder::Stop()
+{
+	if (m_video && m_glview && (m_pbo[0] != 0))
+	{
+		m_glview->makeCurrent();
+		StopCurrent();
+		m_glview->doneCurrent();
+	}
+	else StopCurrent();
+}
+
+void GLScreenRecorder::StopCurrent()
 {
 	if (m_video)
 	{
 		// stop the animation
 		m_state = RECORDING_STATE::STOPPED;
 
-		// get the nr of frames before we close
-		int nframes = m_video->Frames();
+		// the last frame is still in a pixel buffer
+		if (m_pbo[0] != 0)
+		{
+			FlushPendingFrame();
+			FreePixelBuffers();
+		}
+
+		// wait for the encoder to finish
+		if (m_writer)
+		{
+			m_writer->Finish();
+			delete m_writer;
+			m_writer = nullptr;
+		}
 
 		// close the stream
 		m_video->Close();
@@ -120,6 +237,93 @@ bool GLScreenRecorder::IsStopped() const
 
 bool GLScreenRecorder::AddFrame(QImage& im)
 {
-	if (m_video == nullptr) return false;
-	return m_video->Write(im);
+	if ((m_video == nullptr) || (m_writer == nullptr)) return false;
+	return m_writer->Push(im);
+}
+
+bool GLScreenRecorder::AllocPixelBuffers(int w, int h)
+{
+	FreePixelBuffers();
+	if (glGenBuffers == nullptr) return false;
+
+	glGenBuffers(2, m_pbo);
+	for (int i = 0; i < 2; ++i)
+	{
+		glBindBuffer(GL_PIXEL_PACK_BUFFER, m_pbo[i]);
+		glBufferData(GL_PIXEL_PACK_BUFFER, 4 * w * h, nullptr, GL_STREAM_READ);
+	}
+	glBindBuffer(GL_PIXEL_PACK_BUFFER, 0);
+
+	m_pboWidth = w;
+	m_pboHeight = h;
+	m_pboIndex = 0;
+	m_pending = false;
+	return true;
+}
+
+void GLScreenRecorder::FreePixelBuffers()
+{
+	if (m_pbo[0] != 0) glDeleteBuffers(2, m_pbo);
+	m_pbo[0] = m_pbo[1] = 0;
+	m_pboWidth = m_pboHeight = 0;
+	m_pending = false;
+}
+
+// map the buffer that holds the previous read back and send it to the writer
+bool GLScreenRecorder::FlushPendingFrame()
+{
+	if (m_pending == false) return true;
+	m_pending = false;
+
+	int w = m_pboWidth;
+	int h = m_pboHeight;
+	QImage im(w, h, QImage::Format_RGB32);
+
+	glBindBuffer(GL_PIXEL_PACK_BUFFER, m_pbo[1 - m_pboIndex]);
+	const unsigned char* src = (const unsigned char*)glMapBuffer(GL_PIXEL_PACK_BUFFER, GL_READ_ONLY);
+	if (src)
+	{
+		// GL rows start at the bottom
+		for (int j = 0; j < h; ++j) memcpy(im.scanLine(j), src + 4 * w * (h - j - 1), 4 * w);
+		glUnmapBuffer(GL_PIXEL_PACK_BUFFER);
+	}
+	glBindBuffer(GL_PIXEL_PACK_BUFFER, 0);
+	if (src == nullptr) return false;
+
+	return AddFrame(im);
+}
+
+bool GLScreenRecorder::CaptureFrame(unsigned int fbo, int x, int y, int w, int h)
+{
+	if ((m_video == nullptr) || (m_writer == nullptr)) return false;
+	if (m_writer->HasError()) return false;
+	if ((w <= 0) || (h <= 0)) return true;
+
+	glBindFramebuffer(GL_READ_FRAMEBUFFER, fbo);
+	glPixelStorei(GL_PACK_ALIGNMENT, 4);
+
+	if ((w != m_pboWidth) || (h != m_pboHeight) || (m_pbo[0] == 0))
+	{
+		if (FlushPendingFrame() == false) return false;
+		if (AllocPixelBuffers(w, h) == false)
+		{
+			// no pixel buffer objects, so read back synchronously
+			QImage im(w, h, QImage::Format_RGB32);
+			std::vector<unsigned char> buf(4 * w * h);
+			glReadPixels(x, y, w, h, GL_BGRA, GL_UNSIGNED_BYTE, &buf[0]);
+			for (int j = 0; j < h; ++j) memcpy(im.scanLine(j), &buf[0] + 4 * w * (h - j - 1), 4 * w);
+			return AddFrame(im);
+		}
+	}
+
+	// start the transfer of this frame
+	glBindBuffer(GL_PIXEL_PACK_BUFFER, m_pbo[m_pboIndex]);
+	glReadPixels(x, y, w, h, GL_BGRA, GL_UNSIGNED_BYTE, nullptr);
+	glBindBuffer(GL_PIXEL_PACK_BUFFER, 0);
+
+	// and collect the previous one, which should be done by now
+	bool bret = FlushPendingFrame();
+	m_pboIndex = 1 - m_pboIndex;
+	m_pending = true;
+	return bret;
 }
@@ -28,6 +28,7 @@ class CGLView;
 
 class CAnimation;
 class QImage;
+class GLFrameWriter;
 
 // Video recording states
 enum class RECORDING_STATE {
@@ -54,16 +55,37 @@ public:
 	void Stop();
 	void Pause();
 
+	// Same as Stop, but assumes the view's GL context is already current (e.g. inside paintGL).
+	void StopCurrent();
+
 	bool AddFrame(QImage& im);
 
+	// Read back the (x, y, w, h) region (in device pixels, lower-left origin) of the given
+	// framebuffer. The pixels are transferred through a pixel buffer object so that the
+	// frame is only mapped on the next call, and the frames are encoded on a worker thread.
+	// This must be called while the view's GL context is current.
+	bool CaptureFrame(unsigned int fbo, int x, int y, int w, int h);
+
 	bool IsRecording() const;
 	bool IsPaused() const;
 	bool IsStopped() const;
 
+private:
+	bool AllocPixelBuffers(int w, int h);
+	void FreePixelBuffers();
+	bool FlushPendingFrame();
+
 private:
 	unsigned int	m_videoFormat;
 	RECORDING_STATE	m_state;
 	CAnimation*		m_video;
 
 	CGLView*	m_glview;
+
+	// asynchronous read back
+	GLFrameWriter*	m_writer;		// encodes frames on a worker thread
+	unsigned int	m_pbo[2];		// pixel buffer objects (double buffered)
+	int				m_pboIndex;		// buffer that receives the next read back
+	bool			m_pending;		// the other buffer holds a frame that wasn't mapped yet
+	int				m_pboWidth, m_pboHeight;
 };
@@ -48,6 +48,7 @@ SOFTWARE.*/
 #include <GLLib/GLContext.h>
 #include <QMenu>
 #include <QMessageBox>
+#include <QTimer>
 #include <PostGL/GLPlaneCutPlot.h>
 #include "Commands.h"
 #include <MeshTools/FEExtrudeFaces.h>
@@ -1312,12 +1313,28 @@ void CGLView::RenderScene()
 
 	if (m_recorder.IsRecording())
 	{
-		glFlush();
-		QImage im = CaptureScreen();
-		if (m_recorder.AddFrame(im) == false)
+		// region to capture in device pixels (GL origin is the lower-left corner)
+		double dpr = devicePixelRatio();
+		int W = (int)(dpr*width());
+		int H = (int)(dpr*height());
+		int x = 0, y = 0, w = W, h = H;
+		if (m_pframe && m_pframe->visible())
 		{
-			m_recorder.Stop();
-			QMessageBox::critical(this, "FEBio Studio", "An error occurred while writing frame to video stream.");
+			x = (int)(dpr*m_pframe->x());
+			w = (int)(dpr*m_pframe->w());
+			h = (int)(dpr*m_pframe->h());
+			y = H - (int)(dpr*m_pframe->y()) - h;
+		}
+
+		if (m_recorder.CaptureFrame(defaultFramebufferObject(), x, y, w, h) == false)
+		{
+			// we're inside paintGL, so the context is already current
+			m_recorder.StopCurrent();
+
+			// don't open a modal dialog from within paintGL
+			QTimer::singleShot(0, this, [this]() {
+				QMessageBox::critical(this, "FEBio Studio", "An error occurred while writing frame to video stream.");
+			});
 		}
 	}
 }
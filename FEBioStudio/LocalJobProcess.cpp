@@ -32,6 +32,8 @@ SOFTWARE.*/
 
 CLocalJobProcess::CLocalJobProcess(CMainWindow* wnd, CFEBioJob* job, QObject* parent) : m_wnd(wnd), m_job(job)
 {
+	m_threads = 0;
+
 	setProcessChannelMode(QProcess::MergedChannels);
 
 	QObject::connect(this, SIGNAL(finished(int, QProcess::ExitStatus)), parent, SLOT(onRunFinished(int, QProcess::ExitStatus)));
@@ -73,6 +75,14 @@ void CLocalJobProcess::run()
 	// get ready ...
 	m_wnd->AddLogEntry(QString("Starting FEBio: %1\n").arg(args.join(" ")));
 
+	// limit the number of threads FEBio can use
+	if (m_threads > 0)
+	{
+		QProcessEnvironment env = QProcessEnvironment::systemEnvironment();
+		env.insert("OMP_NUM_THREADS", QString::number(m_threads));
+		setProcessEnvironment(env);
+	}
+
 	// set ...
 	m_job->SetStatus(CFEBioJob::RUNNING);
 
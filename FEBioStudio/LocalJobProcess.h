@@ -36,7 +36,11 @@ public:
 
 	void run();
 
+	// set the number of threads the job can use (0 = use the default)
+	void SetThreadCount(int n) { m_threads = n; }
+
 private:
 	CMainWindow*	m_wnd;
 	CFEBioJob*		m_job;
+	int				m_threads;
 };
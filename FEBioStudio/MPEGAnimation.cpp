@@ -38,6 +38,8 @@ CMPEGAnimation::CMPEGAnimation()
     rgb_frame = NULL;
     yuv_frame = NULL;
     av_format_context = NULL;
+    sws_context = NULL;
+    buffer = NULL;
 }
 
 int CMPEGAnimation::Create(const char *szfile, int cx, int cy, float fps)
@@ -90,6 +92,9 @@ int CMPEGAnimation::Create(const char *szfile, int cx, int cy, float fps)
     av_codec_context->gop_size = 10;
     av_codec_context->max_b_frames = 1;
     av_codec_context->pix_fmt = AV_PIX_FMT_YUV420P;
+
+    // let the encoder pick the number of threads
+    av_codec_context->thread_count = 0;
     
     // open the codec
     if (avcodec_open2(av_codec_context, av_codec, NULL))
@@ -182,11 +187,9 @@ int CMPEGAnimation::Write(QImage &im)
 
 bool CMPEGAnimation::Rgb24ToYuv420p(QImage &im)
 {
-    struct SwsContext *converted_format = NULL;
-    
-	converted_format = sws_getCachedContext(converted_format, av_codec_context->width, av_codec_context->height, AV_PIX_FMT_BGRA, av_codec_context->width, av_codec_context->height, AV_PIX_FMT_YUV420P, SWS_BICUBIC, NULL, NULL, NULL);
+    sws_context = sws_getCachedContext(sws_context, av_codec_context->width, av_codec_context->height, AV_PIX_FMT_BGRA, av_codec_context->width, av_codec_context->height, AV_PIX_FMT_YUV420P, SWS_BICUBIC, NULL, NULL, NULL);
     
-    if (!converted_format)
+    if (!sws_context)
     {
         return false;
     }
@@ -194,7 +197,7 @@ bool CMPEGAnimation::Rgb24ToYuv420p(QImage &im)
 	int linesize[] = { (int)im.bytesPerLine(), 0, 0, 0, 0, 0, 0, 0 };
 	const uint8_t* p = im.bits();
     
-    sws_scale(converted_format, &p, linesize, 0, av_codec_context->height, yuv_frame->data, yuv_frame->linesize);
+    sws_scale(sws_context, &p, linesize, 0, av_codec_context->height, yuv_frame->data, yuv_frame->linesize);
     
     //sws_scale(converted_format, (const uint8_t* const*)rgb_frame->data, rgb_frame->linesize, 0, av_codec_context->height, yuv_frame->data, yuv_frame->linesize);
     
@@ -219,6 +222,8 @@ void CMPEGAnimation::Close()
     av_free(av_codec_context);
     if (file) fclose(file);
 	av_frame_free(&yuv_frame);
+    if (buffer) av_free(buffer);
+    if (sws_context) sws_freeContext(sws_context);
 
     file = NULL;
     av_codec_context = NULL;
@@ -226,5 +231,7 @@ void CMPEGAnimation::Close()
     rgb_frame = NULL;
     yuv_frame = NULL;
     av_format_context = NULL;
+    buffer = NULL;
+    sws_context = NULL;
 }
 #endif
@@ -60,6 +60,7 @@ protected:
     AVFrame *yuv_frame; // save the yuv frame data
     AVFormatContext *av_format_context;
     uint8_t *buffer;
+    SwsContext *sws_context; // color conversion context (reused for all frames)
 	int		m_nframe;	// frame index
     
 private:
@@ -299,6 +299,10 @@ CMainWindow::CMainWindow(bool reset, QWidget* parent) : QMainWindow(parent), ui(
 		ui->m_autoSaveTimer->start(ui->m_settings.autoSaveInterval * 1000);
 	}
 
+	// Timer for following plot files (started when needed)
+	ui->m_followTimer = new QTimer(this);
+	QObject::connect(ui->m_followTimer, &QTimer::timeout, this, &CMainWindow::followPlotFiles);
+
 	// Auto Update Check
 	if(ui->m_updaterPresent)
 	{
@@ -1440,6 +1444,40 @@ void CMainWindow::autosave()
 	}
 }
 
+// Reads the new states of all followed plot files. Only the time line, the post
+// toolbar, and the plots of the active document are refreshed. 
+void CMainWindow::followPlotFiles()
+{
+	// don't interfere with files that are being (re)loaded
+	if (m_fileThread) return;
+
+	bool following = false;
+	for (int i = 0; i < m_DocManager->Documents(); i++)
+	{
+		CPostDocument* doc = dynamic_cast<CPostDocument*>(m_DocManager->GetDocument(i));
+		if ((doc == nullptr) || (doc->IsFollowing() == false)) continue;
+
+		int n = doc->ReadNewStates();
+		if (n < 0)
+		{
+			AddLogEntry(QString("Stopped following %1\n").arg(QString::fromStdString(doc->GetDocFilePath())));
+			if (doc == GetPostDocument()) ui->postToolBar->CheckFollow(false);
+			continue;
+		}
+
+		following = true;
+		if ((n > 0) && (doc == GetPostDocument()))
+		{
+			UpdatePostToolbar();
+			if (ui->timePanel && ui->timePanel->isVisible()) ui->timePanel->Update(true);
+			UpdateGraphs(false);
+			RedrawGL();
+		}
+	}
+
+	if (following == false) ui->m_followTimer->stop();
+}
+
 void CMainWindow::autoUpdateCheck(bool update)
 {
 	ui->m_updateAvailable = update;
@@ -422,8 +422,12 @@ public slots:
 	void on_actionUnitConverter_triggered();
 	void on_actionKinemat_triggered();
 	void on_actionPlotMix_triggered();
+	void on_actionProfiler_toggled(bool b);
+	void on_actionSaveProfile_triggered();
 	void on_actionFEBioRun_triggered();
 	void on_actionFEBioStop_triggered();
+	void on_actionFEBioSweep_triggered();
+	void on_actionFEBioCancelQueue_triggered();
 	void on_actionFEBioOptimize_triggered();
 	void on_actionFEBioTangent_triggered();
 	void on_actionFEBioInfo_triggered();
@@ -544,6 +548,7 @@ public slots:
 	void on_selectData_currentValueChanged(int i);
 	void on_actionPlay_toggled(bool bchecked);
 	void on_actionRefresh_triggered();
+	void on_actionFollow_toggled(bool bchecked);
 	void on_actionFirst_triggered();
 	void on_actionPrev_triggered();
 	void on_actionNext_triggered();
@@ -663,6 +668,8 @@ public slots:
 
 	void autosave();
 
+	void followPlotFiles();
+
 	void autoUpdateCheck(bool update);
 
 	void updateOutput(const QString& txt);
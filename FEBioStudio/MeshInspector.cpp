@@ -40,6 +40,13 @@ CMeshInspector::CMeshInspector(CMainWindow* wnd) : m_wnd(wnd), QMainWindow(wnd),
 	ui->plot->setChartStyle(ChartStyle::BARCHART_PLOT);
 
 	ui->m_map = Post::ColorMapManager::GetDefaultMap();
+
+	m_eval = nullptr;
+}
+
+CMeshInspector::~CMeshInspector()
+{
+	delete m_eval;
 }
 
 void CMeshInspector::Update(bool reset)
@@ -150,7 +157,14 @@ void CMeshInspector::UpdateFEMeshData(FSMesh* pm, int ndata)
 		}
 	}
 
-	FEMeshValuator eval(*pm);
+	// The valuator caches the fields it evaluated (until the mesh is modified),
+	// so we hang on to it as long as we are looking at the same mesh.
+	if ((m_eval == nullptr) || (&m_eval->GetMesh() != pm))
+	{
+		delete m_eval;
+		m_eval = new FEMeshValuator(*pm);
+	}
+	FEMeshValuator& eval = *m_eval;
 
 	int curvatureLevels = ui->curvatureLevels->value();
 	int curvatureMaxIters = ui->curvatureMaxIters->value();
@@ -162,6 +176,19 @@ void CMeshInspector::UpdateFEMeshData(FSMesh* pm, int ndata)
 	int NE = pm->Elements();
 	vector<double> v; v.reserve(NE*FSElement::MAX_NODES);
 	double vmax = -1e99, vmin = 1e99, vavg = 0;
+
+	// Evaluate all element metrics in one pass, so that switching between 
+	// them only uses the cache. (The curvatures are only evaluated when requested.)
+	if ((ndata >= 0) && (ndata < FEMeshValuator::MAX_DEFAULT_FIELDS))
+	{
+		vector<int> fields;
+		for (int i = 0; i < FEMeshValuator::MAX_DEFAULT_FIELDS; ++i)
+		{
+			if ((i != FEMeshValuator::PRINC_CURVE_1) && (i != FEMeshValuator::PRINC_CURVE_2)) fields.push_back(i);
+		}
+		if ((ndata == FEMeshValuator::PRINC_CURVE_1) || (ndata == FEMeshValuator::PRINC_CURVE_2)) fields.push_back(ndata);
+		eval.UpdateCache(fields);
+	}
 	eval.Evaluate(ndata);
 	Mesh_Data& data = pm->GetMeshData();
 	if (data.IsValid())
@@ -36,6 +36,7 @@ class CMainWindow;
 class FSMesh;
 class FSSurfaceMesh;
 class GObject;
+class FEMeshValuator;
 
 class CMeshInspector : public QMainWindow
 {
@@ -43,6 +44,7 @@ class CMeshInspector : public QMainWindow
 
 public:
 	CMeshInspector(CMainWindow* wnd);
+	~CMeshInspector();
 
 	void Update(bool reset);
 
@@ -67,4 +69,5 @@ private:
 private:
 	Ui::CMeshInspector*	ui;
 	CMainWindow*	m_wnd;
+	FEMeshValuator*	m_eval;	// keeps the evaluated fields of the current mesh
 };
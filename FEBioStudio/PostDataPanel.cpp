@@ -60,6 +60,7 @@ SOFTWARE.*/
 #include <PostLib/FEDistanceMap.h>
 #include <PostLib/FEAreaCoverage.h>
 #include "DlgAddEquation.h"
+#include "DlgStartThread.h"
 
 class CCurvatureProps : public CPropertyList
 {
@@ -1065,6 +1066,46 @@ void CPostDataPanel::on_DeleteButton_clicked()
 	}
 }
 
+//-----------------------------------------------------------------------------
+// Runs a data filter on a separate thread so that its progress can be shown
+// and the user can cancel it.
+template <class F> class CDataFilterThread : public CustomThread
+{
+public:
+	CDataFilterThread(F f, bool* pret) : m_f(f), m_pret(pret) {}
+
+	void run() Q_DECL_OVERRIDE
+	{
+		// the filter's return value is passed back through m_pret so that
+		// a filter that cannot be applied is not reported as a thread error.
+		*m_pret = m_f(&m_task);
+		emit resultReady(true);
+	}
+
+	bool hasProgress() override { return m_task.GetProgress().valid; }
+
+	double progress() override { return m_task.GetProgress().percent; }
+
+	const char* currentTask() override { return "Applying filter"; }
+
+	void stop() override { m_task.Terminate(); }
+
+private:
+	F		m_f;
+	bool*	m_pret;
+	Post::DataFilterTask	m_task;
+};
+
+// Returns the return value of the filter, or false if the user canceled it.
+template <class F> static bool runDataFilter(QWidget* parent, F f, bool& bcanceled)
+{
+	bool bret = false;
+	CDlgStartThread dlg(parent, new CDataFilterThread<F>(f, &bret));
+	dlg.setTask("Applying filter");
+	bcanceled = (dlg.exec() == 0);
+	return (bcanceled ? false : bret);
+}
+
 void CPostDataPanel::on_AddFilter_triggered()
 {
 	CMainWindow* wnd = GetMainWindow();
@@ -1111,29 +1152,43 @@ void CPostDataPanel::on_AddFilter_triggered()
 
 				Post::ModelDataField* newData = 0;
 				bool bret = true;
+				bool bcanceled = false;
 				int nfield = pdf->GetFieldID();
 				switch (dlg.m_nflt)
 				{
 				case 0:
 				{
 					newData = fem.CreateCachedCopy(pdf, sname.c_str());
+					int ndata = newData->GetFieldID();
 					if (pdf->Type() == DATA_VEC3)
-						bret = DataScaleVec3(fem, newData->GetFieldID(), dlg.GetVecScaleFactor());
+					{
+						vec3d s = dlg.GetVecScaleFactor();
+						bret = runDataFilter(this, [&](Post::DataFilterTask* task) { return DataScaleVec3(fem, ndata, s, task); }, bcanceled);
+					}
 					else
-						bret = DataScale(fem, newData->GetFieldID(), dlg.GetScaleFactor());
+					{
+						double s = dlg.GetScaleFactor();
+						bret = runDataFilter(this, [&](Post::DataFilterTask* task) { return DataScale(fem, ndata, s, task); }, bcanceled);
+					}
 				}
 				break;
 				case 1:
 				{
 					newData = fem.CreateCachedCopy(pdf, sname.c_str());
-					bret = DataSmooth(fem, newData->GetFieldID(), dlg.m_theta, dlg.m_iters);
+					int ndata = newData->GetFieldID();
+					double theta = dlg.m_theta;
+					int niters = dlg.m_iters;
+					bret = runDataFilter(this, [&](Post::DataFilterTask* task) { return DataSmooth(fem, ndata, theta, niters, task); }, bcanceled);
 				}
 				break;
 				case 2:
 				{
 					newData = fem.CreateCachedCopy(pdf, sname.c_str());
 					Post::FEDataFieldPtr p = fem.GetDataManager()->DataField(dataIds[dlg.m_ndata]);
-					bret = DataArithmetic(fem, newData->GetFieldID(), dlg.m_nop, (*p)->GetFieldID());
+					int ndata = newData->GetFieldID();
+					int nop = dlg.m_nop;
+					int noperand = (*p)->GetFieldID();
+					bret = runDataFilter(this, [&](Post::DataFilterTask* task) { return DataArithmetic(fem, ndata, nop, noperand, task); }, bcanceled);
 				}
 				break;
 				case 3:
@@ -1146,7 +1201,8 @@ void CPostDataPanel::on_AddFilter_triggered()
 					int config = dlg.GetGradientConfiguration();
 
 					// now, calculate gradient from scalar field
-					bret = DataGradient(fem, newData->GetFieldID(), nfield, config);
+					int ndata = newData->GetFieldID();
+					bret = runDataFilter(this, [&](Post::DataFilterTask* task) { return DataGradient(fem, ndata, nfield, config, task); }, bcanceled);
 				}
 				break;
 				case 4:
@@ -1170,8 +1226,14 @@ void CPostDataPanel::on_AddFilter_triggered()
 				{
 					int newformat = dlg.getNewDataFormat();
 					int newClass  = dlg.getNewDataClass();
-					newData = DataConvert(fem, pdf, newClass, newformat, sname);
-					bret = (newData != nullptr);
+					// the field is created here, only the evaluation runs on the worker thread
+					newData = DataConvertField(fem, pdf, newClass, newformat);
+					if (newData)
+					{
+						fem.AddDataField(newData, sname);
+						bret = runDataFilter(this, [&](Post::DataFilterTask* task) { return DataConvert(fem, pdf, newData, task); }, bcanceled);
+					}
+					else bret = false;
 				}
 				break;
 				case 7: // eigen tensor
@@ -1182,8 +1244,13 @@ void CPostDataPanel::on_AddFilter_triggered()
 				break;
 				case 8: // time derivative
 				{
-					newData = DataTimeRate(fem, pdf, sname);
-					bret = (newData != nullptr);
+					newData = DataTimeRateField(fem, pdf);
+					if (newData)
+					{
+						fem.AddDataField(newData, sname);
+						bret = runDataFilter(this, [&](Post::DataFilterTask* task) { return DataTimeRate(fem, pdf, newData, task); }, bcanceled);
+					}
+					else bret = false;
 				}
 				break;
 				default:
@@ -1193,7 +1260,29 @@ void CPostDataPanel::on_AddFilter_triggered()
 				if (bret == false)
 				{
 					if (newData) fem.DeleteDataField(newData);
-					QMessageBox::critical(this, "Data Filter", "Cannot apply this filter.");
+					if (bcanceled == false) QMessageBox::critical(this, "Data Filter", "Cannot apply this filter.");
+				}
+				else if (newData)
+				{
+					// store a description of the filter so that the data can be cached
+					QString def = QString("filter=%1;source=%2").arg(dlg.m_nflt).arg(name);
+					switch (dlg.m_nflt)
+					{
+					case 0:
+						if (pdf->Type() == DATA_VEC3)
+						{
+							vec3d s = dlg.GetVecScaleFactor();
+							def += QString(";scale=%1,%2,%3").arg(s.x, 0, 'g', 17).arg(s.y, 0, 'g', 17).arg(s.z, 0, 'g', 17);
+						}
+						else def += QString(";scale=%1").arg(dlg.GetScaleFactor(), 0, 'g', 17);
+						break;
+					case 1: def += QString(";theta=%1;iters=%2").arg(dlg.m_theta, 0, 'g', 17).arg(dlg.m_iters); break;
+					case 2: def += QString(";op=%1;operand=%2").arg(dlg.m_nop).arg(dataNames[dlg.m_ndata]); break;
+					case 3: def += QString(";config=%1").arg(dlg.GetGradientConfiguration()); break;
+					case 4: def += QString(";component=%1").arg(dlg.getArrayComponent()); break;
+					case 6: def += QString(";class=%1;format=%2").arg(dlg.getNewDataClass()).arg(dlg.getNewDataFormat()); break;
+					}
+					newData->SetFilterDefinition(def.toStdString());
 				}
 
 				wnd->UpdatePostToolbar();
@@ -551,6 +551,44 @@ void CPostDocument::UpdateFEModel(bool breset)
 	if (m_glm) m_glm->Update(breset);
 }
 
+bool CPostDocument::SetFollowMode(bool b)
+{
+	xpltFileReader* reader = dynamic_cast<xpltFileReader*>(GetFileReader());
+	if (reader == nullptr) return false;
+	if (b) reader->SetFollowMode(true);
+	else reader->StopFollowing();
+	return true;
+}
+
+bool CPostDocument::IsFollowing()
+{
+	xpltFileReader* reader = dynamic_cast<xpltFileReader*>(GetFileReader());
+	return (reader && reader->IsFollowing());
+}
+
+int CPostDocument::ReadNewStates()
+{
+	xpltFileReader* reader = dynamic_cast<xpltFileReader*>(GetFileReader());
+	if ((reader == nullptr) || !IsValid()) return -1;
+
+	int N0 = GetStates();
+	int ntime = GetActiveState();
+
+	int n = reader->ReadNewStates();
+	if (n <= 0) return n;
+
+	// extend the time range if it included the last state
+	int N = GetStates();
+	if (m_timeSettings.m_end == N0 - 1) m_timeSettings.m_end = N - 1;
+
+	// if we were looking at the last state, we move on to the new last state. 
+	// Otherwise, only the plots need to be updated for the new state count.
+	if (ntime == N0 - 1) SetActiveState(N - 1);
+	else m_glm->Update(false);
+
+	return n;
+}
+
 void CPostDocument::SetDataField(int n)
 {
 	m_glm->GetColorMap()->SetEvalField(n);
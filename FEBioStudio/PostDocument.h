@@ -187,6 +187,17 @@ public:
 
 	void SetGLModel(Post::CGLModel* glm);
 
+public:
+	// Follow mode keeps the plot file open so that states written by a running
+	// job can be appended to the model. Returns false if the file reader does
+	// not support it.
+	bool SetFollowMode(bool b);
+	bool IsFollowing();
+
+	// Read the new states of a followed plot file and update the model. 
+	// Returns the number of states added, or -1 on error.
+	int ReadNewStates();
+
 public:
 	//! save to session file
 	bool SavePostSession(const std::string& fileName);
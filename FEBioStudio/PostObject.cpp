@@ -73,19 +73,5 @@ void CPostObject::UpdateMesh()
 		SetFEMesh(postMesh);
 		BuildGMesh();
 	}
-	else
-	{
-		GMesh* mesh = GetRenderMesh(); assert(mesh);
-
-		for (int i = 0; i < mesh->Nodes(); ++i)
-		{
-			GMesh::NODE& nd = mesh->Node(i);
-			FSNode& ns = postMesh->Node(nd.nid);
-
-			nd.r = ns.r;
-		}
-		//		mesh->Update();
-		mesh->UpdateBoundingBox();
-		mesh->UpdateNormals();
-	}
+	else UpdateGMeshNodes();
 }
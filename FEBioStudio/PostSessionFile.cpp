@@ -1,6 +1,7 @@
 #include "stdafx.h"
 #include "PostSessionFile.h"
 #include <QtCore/QDir>
+#include <QtCore/QDateTime>
 #include <XML/XMLWriter.h>
 #include <XML/XMLReader.h>
 #include <PostGL/GLModel.h>
@@ -10,6 +11,7 @@
 #include <XPLTLib/xpltFileReader.h>
 #include <PostLib/FELSDYNAimport.h>
 #include <PostLib/FEKinemat.h>
+#include <PostLib/FEDataCache.h>
 #include "FEKinematFileReader.h"
 #include <GeomLib/GObject.h>
 #include <FEBio/FEBioExport.h> // for type_to_string<vec3d>
@@ -28,17 +30,30 @@ template <> std::string type_to_string<GLColor>(const GLColor& v)
 
 template <> void string_to_type<GLColor>(const std::string& s, GLColor& v);
 
+// get the size and modification time of the plot file, which are used to check
+// if the derived data cache is still valid.
+static bool plotFileStamp(const std::string& plotFile, int64_t& size, int64_t& time)
+{
+	QFileInfo fi(QString::fromStdString(plotFile));
+	if (fi.exists() == false) return false;
+	size = fi.size();
+	time = fi.lastModified().toSecsSinceEpoch();
+	return true;
+}
+
 PostSessionFileReader::PostSessionFileReader(CPostDocument* doc) : m_doc(doc)
 {
 	m_openFile = nullptr;
 	m_fem = nullptr;
 	m_pg = nullptr;
 	m_szfile = nullptr;
+	m_cache = nullptr;
 }
 
 PostSessionFileReader::~PostSessionFileReader()
 {
 	delete m_openFile;
+	delete m_cache;
 }
 
 FileReader* PostSessionFileReader::GetOpenFileReader()
@@ -87,6 +102,8 @@ bool PostSessionFileReader::Load(const char* szfile)
 	if (szfile == nullptr) return false;
 	m_szfile = szfile;
 	m_pg = nullptr;
+	m_plotFile.clear();
+	delete m_cache; m_cache = nullptr;
 
 	XMLReader xml;
 	if (xml.Open(szfile) == false) return errf("Failed opening post session file.");
@@ -124,6 +141,10 @@ bool PostSessionFileReader::Load(const char* szfile)
 			{
 				if (parse_datafield(tag) == false) return false;
 			}
+			else if (tag == "derived_field")
+			{
+				if (parse_derived_field(tag) == false) return false;
+			}
 			else if (tag == "mesh:nodeset")
 			{
 				if (parse_mesh_nodeset(tag) == false) return false;
@@ -164,6 +185,9 @@ bool PostSessionFileReader::Load(const char* szfile)
 
 	xml.Close();
 
+	// we no longer need the cache file
+	delete m_cache; m_cache = nullptr;
+
 	return true;
 }
 
@@ -229,6 +253,7 @@ bool PostSessionFileReader::parse_model(XMLTag& tag)
 		{
 			return errf("Failed loading model file\n%s", modelFile.c_str());
 		}
+		m_plotFile = modelFile;
 
 		// now create a GL model
 		m_doc->SetGLModel(new Post::CGLModel(m_fem));
@@ -270,6 +295,7 @@ bool PostSessionFileReader::parse_open(XMLTag& tag)
 	{
 		return errf("Failed loading model file\n%s", modelFile.c_str());
 	}
+	m_plotFile = modelFile;
 
 	// now create a GL model
 	m_doc->SetGLModel(new Post::CGLModel(m_fem));
@@ -355,6 +381,29 @@ bool PostSessionFileReader::parse_datafield(XMLTag& tag)
 	return true;
 }
 
+bool PostSessionFileReader::parse_derived_field(XMLTag& tag)
+{
+	const char* szname = tag.AttributeValue("name");
+	const char* szfilter = tag.AttributeValue("filter");
+
+	// open the cache the first time we need it
+	if (m_cache == nullptr)
+	{
+		m_cache = new Post::FEDataCache(m_fem);
+		int64_t size = 0, time = 0;
+		if (!m_plotFile.empty() && plotFileStamp(m_plotFile, size, time))
+			m_cache->Open(Post::FEDataCache::CacheFileName(m_plotFile), size, time);
+	}
+
+	// If the field is not in the cache (e.g. the plot file changed), it is skipped.
+	if (m_cache->ReadField(szname, szfilter) == nullptr)
+	{
+		errf("Derived data field \"%s\" could not be restored from the cache.", szname);
+	}
+
+	return true;
+}
+
 bool PostSessionFileReader::parse_mesh_nodeset(XMLTag& tag)
 {
 	string name = tag.AttributeValue("name");
@@ -671,6 +720,7 @@ bool PostSessionFileWriter::Write(const char* szfile)
 	XMLWriter& xml = *m_xml;
 	if (xml.open(szfile) == false) return false;
 	m_fileName = szfile;
+	m_plotFile.clear();
 
 	XMLElement root("febiostudio_post_session");
 	root.add_attribute("version", "2.0");
@@ -733,6 +783,7 @@ void PostSessionFileWriter::WriteModel()
 		else if (openFileReader)
 		{
 			// save plot file
+			m_plotFile = openFileReader->GetFileName();
 			std::string plotFile = currentDir.relativeFilePath(QString::fromStdString(openFileReader->GetFileName())).toStdString();
 			XMLElement plt("model");
 			plt.add_attribute("file", plotFile);
@@ -762,6 +813,7 @@ void PostSessionFileWriter::WriteModel()
 	{
 		// save plot file
 		std::string plotFile = m_doc->GetDocFilePath();
+		m_plotFile = plotFile;
 		XMLElement plt("model");
 		plt.add_attribute("file", plotFile);
 		xml.add_empty(plt);
@@ -798,9 +850,34 @@ void PostSessionFileWriter::WriteDataFields()
 {
 	XMLWriter& xml = *m_xml;
 
-	// save data field settings
 	Post::FEPostModel& fem = *m_doc->GetFSModel();
 	Post::FEDataManager& dm = *fem.GetDataManager();
+
+	// Save the derived fields. Their data is stored in a cache file next to the
+	// plot file, so it doesn't need to be recalculated when the session is opened.
+	// (This is only done for plot files; the cache is removed when there are
+	// no derived fields.)
+	int64_t size = 0, time = 0;
+	if (!m_plotFile.empty() && plotFileStamp(m_plotFile, size, time))
+	{
+		Post::FEDataCache cache(&fem);
+		if (cache.Write(Post::FEDataCache::CacheFileName(m_plotFile), size, time))
+		{
+			for (int i = 0; i < dm.DataFields(); ++i)
+			{
+				Post::ModelDataField* data = *dm.DataField(i);
+				if (data && data->IsDerived())
+				{
+					XMLElement el("derived_field");
+					el.add_attribute("name", data->GetName());
+					el.add_attribute("filter", data->GetFilterDefinition());
+					xml.add_empty(el);
+				}
+			}
+		}
+	}
+
+	// save data field settings
 	for (int i = 0; i < dm.DataFields(); ++i)
 	{
 		Post::ModelDataField* data = *dm.DataField(i);
@@ -9,6 +9,7 @@ class XMLWriter;
 namespace Post {
 	class FEPostModel;
 	class GLPlotGroup;
+	class FEDataCache;
 }
 
 class PostSessionFileReader : public FileReader
@@ -26,6 +27,7 @@ private:
 	bool parse_model(XMLTag& tag);
 	bool parse_material(XMLTag& tag);
 	bool parse_datafield(XMLTag& tag);
+	bool parse_derived_field(XMLTag& tag);
 	bool parse_mesh_nodeset(XMLTag& tag);
 	bool parse_mesh_edgeset(XMLTag& tag);
 	bool parse_mesh_surface(XMLTag& tag);
@@ -43,6 +45,8 @@ protected:
 	Post::FEPostModel*	m_fem;
 	Post::GLPlotGroup*	m_pg; // group to add plot to
 	FileReader*			m_openFile;	// the reader for opening the file
+	std::string			m_plotFile;	// the plot file (absolute path)
+	Post::FEDataCache*	m_cache;	// derived data cache
 };
 
 class PostSessionFileWriter : public FileWriter
@@ -65,4 +69,5 @@ private:
 	CPostDocument* m_doc;
 	XMLWriter* m_xml;
 	string	m_fileName;
+	string	m_plotFile;
 };
@@ -42,6 +42,7 @@ public:
 
 	QAction*	m_actionPlay;
 	QAction*	m_actionColorMap;
+	QAction*	m_actionFollow;
 
 	CDataFieldSelector*	m_selectData;
 	QSpinBox*	m_spin;
@@ -50,6 +51,7 @@ public:
 	void setup(CPostToolBar* tb)
 	{
 		QAction* actionRefresh = addAction("Reload", "actionRefresh", "refresh");
+		m_actionFollow = addAction("Follow", "actionFollow", QString(), true);
 		QAction* actionFirst = addAction("first", "actionFirst", "back");
 		QAction* actionPrev = addAction("previous", "actionPrev", "prev"); actionPrev->setShortcut(Qt::Key_Left);
 		m_actionPlay = addAction("Play", "actionPlay", "play"); m_actionPlay->setShortcut(Qt::Key_Space);
@@ -71,6 +73,7 @@ public:
 		m_selectData->setObjectName("selectData");
 
 		actionRefresh->setWhatsThis("<font color=\"black\">Click this to reload the plot file.");
+		m_actionFollow->setWhatsThis("<font color=\"black\">Click this to follow the plot file of a running job. New states will be added to the model as they are written.");
 		actionFirst->setWhatsThis("<font color=\"black\">Click this to go to the first time step in the model.");
 		actionPrev->setWhatsThis("<font color=\"black\">Click this to go to the previous time step in the model.");
 		m_actionPlay->setWhatsThis("<font color=\"black\">Click this to toggle the animation on or off");
@@ -95,6 +98,7 @@ public:
 		tb->addSeparator();
 
 		tb->addAction(actionRefresh);
+		tb->addAction(m_actionFollow);
 		tb->addSeparator();
 		tb->addAction(actionFirst);
 		tb->addAction(actionPrev);
@@ -158,6 +162,9 @@ void CPostToolBar::Update()
 	if (map->IsActive()) ui->m_actionColorMap->setChecked(true);
 	else ui->m_actionColorMap->setChecked(false);
 
+	// update the follow state
+	CheckFollow(doc->IsFollowing());
+
 	// update the state indicator
 	int ntime = mdl->CurrentTimeIndex() + 1;
 
@@ -176,6 +183,13 @@ void CPostToolBar::CheckPlayButton(bool b)
 	ui->m_actionPlay->setChecked(b);
 }
 
+void CPostToolBar::CheckFollow(bool b)
+{
+	ui->m_actionFollow->blockSignals(true);
+	ui->m_actionFollow->setChecked(b);
+	ui->m_actionFollow->blockSignals(false);
+}
+
 void CPostToolBar::CheckColorMap(bool b)
 {
 	if (b != ui->m_actionColorMap->isChecked())
@@ -40,6 +40,8 @@ public:
 
 	void CheckPlayButton(bool b);
 
+	void CheckFollow(bool b);
+
 	void CheckColorMap(bool b);
 	bool IsColorMapActive();
 	void ToggleColorMap();
@@ -57,7 +57,6 @@ public:
 
 	QLineEdit*	m_maxIters;
 	QLineEdit*	m_tol;
-	QLineEdit*	m_sor;
 
 public:
 	UIScalarFieldTool(CScalarFieldTool* w)
@@ -100,11 +99,9 @@ public:
 		f->addRow("Material:", m_matList = new QComboBox);
 		f->addRow("Max iterations:", m_maxIters = new QLineEdit); m_maxIters->setText(QString::number(1000));
 		f->addRow("Tolerance:", m_tol = new QLineEdit); m_tol->setText(QString::number(1e-4));
-		f->addRow("SOR parameter:", m_sor = new QLineEdit); m_sor->setText(QString::number(1.8));
 
 		m_maxIters->setValidator(new QIntValidator());
 		m_tol->setValidator(new QDoubleValidator());
-		m_sor->setValidator(new QDoubleValidator());
 
 		l->addLayout(f);
 
@@ -304,17 +301,14 @@ void CScalarFieldTool::OnApply()
 	// get parameters
 	int maxIter = ui->m_maxIters->text().toInt();
 	double tol = ui->m_tol->text().toDouble();
-	double w = ui->m_sor->text().toDouble();
 
 	wnd->AddLogEntry(QString("max iters     = %1\n").arg(maxIter));
 	wnd->AddLogEntry(QString("tolerance     = %1\n").arg(tol));
-	wnd->AddLogEntry(QString("SOR parameter = %1\n").arg(w));
 
 	// solve Laplace equation
 	LaplaceSolver L;
 	L.SetMaxIterations(maxIter);
 	L.SetTolerance(tol);
-	L.SetRelaxation(w);
 	bool b = L.Solve(pm, val, bn, 1);
 	int niters = L.GetIterationCount();
 	wnd->AddLogEntry(QString("%1").arg(b ? "Converged!\n" : "NOT converged!\n"));
@@ -33,6 +33,9 @@ SOFTWARE.*/
 #include <FSCore/FSDir.h>
 #include <QMessageBox>
 #include <QFileDialog>
+#include <QInputDialog>
+#include <QThread>
+#include <FEMLib/FSModel.h>
 #include "DlgFEBioInfo.h"
 #include "DlgFEBioPlugins.h"
 
@@ -270,6 +273,67 @@ void CMainWindow::on_actionFEBioStop_triggered()
 	else QMessageBox::information(this, "FEBio Studio", "No FEBio job is running.");
 }
 
+void CMainWindow::on_actionFEBioSweep_triggered()
+{
+	CModelDocument* doc = dynamic_cast<CModelDocument*>(GetDocument());
+	if (doc == nullptr) return;
+
+	// we use the settings of the last job as the template for the sweep
+	if (doc->FEBioJobs() == 0)
+	{
+		QMessageBox::information(this, "Parameter sweep", "Run the model at least once before running a parameter sweep.\nThe sweep will use the settings of the last job.");
+		return;
+	}
+	CFEBioJob* baseJob = doc->GetFEBioJob(doc->FEBioJobs() - 1);
+
+	// collect the model parameters we can sweep
+	FSModel* fem = doc->GetFSModel();
+	QStringList params;
+	for (int i = 0; i < fem->Parameters(); ++i)
+	{
+		Param& p = fem->GetParam(i);
+		if ((p.GetParamType() == Param_FLOAT) && p.GetShortName()) params << p.GetShortName();
+	}
+	if (params.isEmpty())
+	{
+		QMessageBox::information(this, "Parameter sweep", "This model does not define any model parameters.");
+		return;
+	}
+
+	bool ok = false;
+	QString paramName = QInputDialog::getItem(this, "Parameter sweep", "Parameter:", params, 0, false, &ok);
+	if (!ok) return;
+
+	double v0 = fem->GetParam(paramName.toStdString().c_str())->GetFloatValue();
+	double vmin = QInputDialog::getDouble(this, "Parameter sweep", "Start value:", v0, -1e99, 1e99, 6, &ok); if (!ok) return;
+	double vmax = QInputDialog::getDouble(this, "Parameter sweep", "End value:", v0, -1e99, 1e99, 6, &ok); if (!ok) return;
+	int steps = QInputDialog::getInt(this, "Parameter sweep", "Number of values:", 10, 1, 10000, 1, &ok); if (!ok) return;
+
+	int cores = QThread::idealThreadCount();
+	int maxJobs = QInputDialog::getInt(this, "Parameter sweep", "Max concurrent jobs:", ui->m_jobManager->MaxConcurrentJobs(), 1, (cores > 1 ? cores : 1), 1, &ok); if (!ok) return;
+	ui->m_jobManager->SetMaxConcurrentJobs(maxJobs);
+
+	std::vector<double> values(steps);
+	for (int i = 0; i < steps; ++i)
+	{
+		values[i] = (steps > 1 ? vmin + (vmax - vmin) * i / (steps - 1.0) : vmin);
+	}
+
+	ShowLogPanel();
+	int n = ui->m_jobManager->QueueParameterSweep(doc, baseJob, paramName.toStdString(), values);
+	AddLogEntry(QString("Queued %1 jobs (%2 concurrent, %3 threads each)\n").arg(n).arg(maxJobs).arg(ui->m_jobManager->ThreadsPerJob()));
+}
+
+void CMainWindow::on_actionFEBioCancelQueue_triggered()
+{
+	if ((ui->m_jobManager->QueuedJobs() == 0) && (ui->m_jobManager->RunningQueuedJobs() == 0))
+	{
+		QMessageBox::information(this, "FEBio Studio", "No FEBio jobs are queued.");
+		return;
+	}
+	ui->m_jobManager->CancelQueue();
+}
+
 void CMainWindow::on_actionFEBioOptimize_triggered()
 {
 	CModelDocument* doc = dynamic_cast<CModelDocument*>(GetDocument());
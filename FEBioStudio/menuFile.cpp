@@ -991,11 +991,14 @@ void CMainWindow::SavePostDoc()
 		break;
 		case 1:
 		{
-			CDlgExportXPLT dlg(this);
+			CDlgExportXPLT dlg(this, fem);
 			if (dlg.exec() == QDialog::Accepted)
 			{
 				Post::xpltFileExport ex;
 				ex.SetCompression(dlg.m_bcompress);
+				ex.SetStateStride(dlg.m_stride);
+				if (dlg.m_btime) ex.SetTimeRange(dlg.m_tmin, dlg.m_tmax);
+				ex.SetDataFields(dlg.m_fields);
 				bret = ex.Save(fem, szfilename);
 				error = ex.GetErrorMessage();
 			}
@@ -877,6 +877,29 @@ void CMainWindow::on_actionRefresh_triggered()
 	}
 }
 
+//-----------------------------------------------------------------------------
+void CMainWindow::on_actionFollow_toggled(bool bchecked)
+{
+	CPostDocument* doc = GetPostDocument();
+	if (doc == nullptr) return;
+	if (bchecked == doc->IsFollowing()) return;
+
+	if (bchecked)
+	{
+		if (doc->SetFollowMode(true) == false)
+		{
+			ui->postToolBar->CheckFollow(false);
+			QMessageBox::critical(this, "FEBio Studio", "Only xplt files can be followed.");
+			return;
+		}
+
+		// the file has to be reopened in follow mode
+		on_actionRefresh_triggered();
+		ui->m_followTimer->start(1000);
+	}
+	else doc->SetFollowMode(false);
+}
+
 //-----------------------------------------------------------------------------
 // set the current time of the current post doc
 void CMainWindow::SetCurrentTime(int n)
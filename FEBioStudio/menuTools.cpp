@@ -35,6 +35,7 @@ SOFTWARE.*/
 #include "DlgMeshDiagnostics.h"
 #include "DlgMaterialTest.h"
 #include <QMessageBox>
+#include <QFileDialog>
 #include <GeomLib/MeshLayer.h>
 #include <GeomLib/GObject.h>
 #include <GeomLib/GModel.h>
@@ -45,6 +46,7 @@ SOFTWARE.*/
 #include <PostLib/FELSDYNAimport.h>
 #include <PostGL/GLModel.h>
 #include "FEKinematFileReader.h"
+#include <FSCore/CallTracer.h>
 
 void CMainWindow::on_actionCurveEditor_triggered()
 {
@@ -130,15 +132,16 @@ public:
 		// update post document
 		m_doc->Initialize();
 
-		// update displacements on all states
+		// update displacements of the current state
+		// (other states are updated when they become active)
 		m_task = 2;
 		Post::CGLModel& mdl = *m_doc->GetGLModel();
 		if (mdl.GetDisplacementMap() == nullptr)
 		{
 			mdl.AddDisplacementMap("Displacement");
 		}
-		int nstates = mdl.GetFSModel()->GetStates();
-		for (m_currentState = 0; m_currentState < nstates; ++m_currentState) mdl.UpdateDisplacements(m_currentState, true);
+		m_currentState = mdl.GetFSModel()->CurrentTimeIndex();
+		mdl.UpdateDisplacements(m_currentState, true);
 
 		// all done
 		m_kine = nullptr;
@@ -247,6 +250,29 @@ void CMainWindow::on_actionPlotMix_triggered()
 	dlg.exec();
 }
 
+void CMainWindow::on_actionProfiler_toggled(bool b)
+{
+	// start a new profile each time the profiler is turned on
+	if (b) CProfiler::Reset();
+	CProfiler::Enable(b);
+}
+
+void CMainWindow::on_actionSaveProfile_triggered()
+{
+	// print the call tree to the log
+	AddLogEntry("\nProfile:\n===================\n");
+	AddLogEntry(QString::fromStdString(CProfiler::GetReport()));
+
+	// save the timeline
+	QString fileName = QFileDialog::getSaveFileName(this, "Save Profile", CurrentWorkingDirectory(), "Chrome trace (*.json)");
+	if (fileName.isEmpty()) return;
+
+	if (CProfiler::WriteChromeTrace(fileName.toStdString().c_str()) == false)
+	{
+		QMessageBox::critical(this, "FEBio Studio", QString("Failed saving profile to %1").arg(fileName));
+	}
+}
+
 void CMainWindow::on_actionOptions_triggered()
 {
 	CDlgSettings dlg(this);
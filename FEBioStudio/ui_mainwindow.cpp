@@ -208,6 +208,8 @@ void Ui::CMainWindow::buildMenu(::CMainWindow* mainWindow)
 	// --- FEBio menu actions ---
 	actionFEBioRun = addAction("Run FEBio ...", "actionFEBioRun", "febiorun"); actionFEBioRun->setShortcut(Qt::Key_F5);
 	actionFEBioStop = addAction("Stop FEBio", "actionFEBioStop");
+	QAction* actionFEBioSweep = addAction("Run parameter sweep ...", "actionFEBioSweep");
+	QAction* actionFEBioCancelQueue = addAction("Cancel queued jobs", "actionFEBioCancelQueue");
 	QAction* actionFEBioOptimize = addAction("Generate optimization file ...", "actionFEBioOptimize");
 	QAction* actionFEBioTangent = addAction("Generate tangent diagnostic ...", "actionFEBioTangent");
 	QAction* actionFEBioInfo = addAction("FEBio Info ...", "actionFEBioInfo");
@@ -222,6 +224,8 @@ void Ui::CMainWindow::buildMenu(::CMainWindow* mainWindow)
 	actionMaterialTest = addAction("Material test ...", "actionMaterialTest");
 	QAction* actionKinemat = addAction("Kinemat ...", "actionKinemat");
 	QAction* actionPlotMix = addAction("Plotmix ...", "actionPlotMix");
+	QAction* actionProfiler = addAction("Enable Profiler", "actionProfiler", QString(), true);
+	QAction* actionSaveProfile = addAction("Save Profile ...", "actionSaveProfile");
 	actionOptions = addAction("Options ...", "actionOptions"); actionOptions->setShortcut(Qt::Key_F12);
 
 	QAction* actionLayerInfo = addAction("Print Layer Info", "actionLayerInfo"); actionLayerInfo->setShortcut(Qt::AltModifier | Qt::Key_L);
@@ -561,6 +565,10 @@ void Ui::CMainWindow::buildMenu(::CMainWindow* mainWindow)
 	menuBar->addAction(menuFEBio->menuAction());
 	menuFEBio->addAction(actionFEBioRun);
 	menuFEBio->addAction(actionFEBioStop);
+	menuFEBio->addSeparator();
+	menuFEBio->addAction(actionFEBioSweep);
+	menuFEBio->addAction(actionFEBioCancelQueue);
+	menuFEBio->addSeparator();
 	menuFEBio->addAction(actionFEBioOptimize);
 	menuFEBio->addAction(actionFEBioTangent);
 	menuFEBio->addAction(actionFEBioInfo);
@@ -617,6 +625,10 @@ void Ui::CMainWindow::buildMenu(::CMainWindow* mainWindow)
 	menuTools->addAction(actionMaterialTest);
 	menuTools->addAction(actionKinemat);
 	menuTools->addAction(actionPlotMix);
+	menuTools->addSeparator();
+	menuTools->addAction(actionProfiler);
+	menuTools->addAction(actionSaveProfile);
+	menuTools->addSeparator();
 	menuTools->addAction(actionOptions);
 
 	// View menu
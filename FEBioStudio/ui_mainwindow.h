@@ -397,6 +397,7 @@ public:
 	FEBioStudioProject	m_project;
 
 	QTimer* m_autoSaveTimer = nullptr;
+	QTimer* m_followTimer = nullptr;	// polls followed plot files
 
 	FBS_SETTINGS m_settings;
 
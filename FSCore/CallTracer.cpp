@@ -28,10 +28,14 @@ SOFTWARE.*/
 #include "CallTracer.h"
 #include <assert.h>
 #include <cstring>
+#include <stdio.h>
+#include <chrono>
+#include <mutex>
+#include <functional>
 
 //-------------------------------------------------------------------
-std::vector<const char*> CCallStack::m_stack;
-bool CCallStack::m_blocked = false;
+thread_local std::vector<const char*> CCallStack::m_stack;
+thread_local bool CCallStack::m_blocked = false;
 
 //-------------------------------------------------------------------
 void CCallStack::PushCall(const char* sz)
@@ -88,10 +92,259 @@ std::string CCallStack::GetCurrentCall()
 CCallTracer::CCallTracer(const char* sz)
 {
 	CCallStack::PushCall(sz);
+	m_profiled = CProfiler::IsEnabled();
+	if (m_profiled) CProfiler::BeginScope(sz);
 }
 
 //-------------------------------------------------------------------
 CCallTracer::~CCallTracer()
 {
+	if (m_profiled) CProfiler::EndScope();
 	CCallStack::PopCall();
 }
+
+//===================================================================
+namespace {
+
+	typedef std::chrono::steady_clock Clock;
+
+	struct ProfileEvent
+	{
+		const char*	name;
+		double		ts;		// start time (in microseconds)
+		double		dur;	// duration (in microseconds)
+	};
+
+	struct OpenScope
+	{
+		int					node;
+		Clock::time_point	start;
+	};
+
+	// profile data of a single thread
+	// The lock is only contended when another thread reads or resets the data.
+	struct ThreadProfile
+	{
+		std::mutex					lock;
+		int							tid;
+		Clock::time_point			start;	// (copy of profileStart)
+		std::vector<CProfiler::Node>	tree;
+		std::vector<OpenScope>		stack;
+		std::vector<ProfileEvent>	events;
+	};
+
+	// max number of events recorded per thread
+	const size_t MAX_PROFILE_EVENTS = 1000000;
+
+	// The thread profiles are never deleted, so that the thread-local
+	// pointers remain valid.
+	std::mutex						profileLock;
+	std::vector<ThreadProfile*>		profileThreads;
+	thread_local ThreadProfile*		thisThreadProfile = nullptr;
+	Clock::time_point				profileStart = Clock::now();
+
+	void InitTree(std::vector<CProfiler::Node>& tree)
+	{
+		tree.clear();
+		tree.push_back(CProfiler::Node("root"));
+	}
+
+	ThreadProfile& GetThreadProfile()
+	{
+		if (thisThreadProfile == nullptr)
+		{
+			ThreadProfile* tp = new ThreadProfile;
+			InitTree(tp->tree);
+
+			std::lock_guard<std::mutex> lock(profileLock);
+			tp->start = profileStart;
+			tp->tid = (int)profileThreads.size();
+			profileThreads.push_back(tp);
+			thisThreadProfile = tp;
+		}
+		return *thisThreadProfile;
+	}
+
+	// find (or add) the child of a node
+	int FindChild(std::vector<CProfiler::Node>& tree, int parent, const char* sz)
+	{
+		const std::vector<int>& children = tree[parent].children;
+		for (int i : children)
+		{
+			const char* szi = tree[i].name;
+			if ((szi == sz) || (strcmp(szi, sz) == 0)) return i;
+		}
+
+		int n = (int)tree.size();
+		tree.push_back(CProfiler::Node(sz, parent));
+		tree[parent].children.push_back(n);
+		return n;
+	}
+
+	// merge the subtree of a thread's node into the destination node
+	void MergeTree(std::vector<CProfiler::Node>& dst, int ndst, const std::vector<CProfiler::Node>& src, int nsrc)
+	{
+		const CProfiler::Node& s = src[nsrc];
+		for (int i : s.children)
+		{
+			const CProfiler::Node& si = src[i];
+			int n = FindChild(dst, ndst, si.name);
+			dst[n].count += si.count;
+			dst[n].total += si.total;
+			dst[n].self += si.self;
+			MergeTree(dst, n, src, i);
+		}
+	}
+
+	void WriteJSONString(FILE* fp, const char* sz)
+	{
+		fputc('"', fp);
+		for (const char* c = sz; *c; ++c)
+		{
+			if ((*c == '"') || (*c == '\\')) fputc('\\', fp);
+			if ((unsigned char)(*c) >= 0x20) fputc(*c, fp);
+		}
+		fputc('"', fp);
+	}
+}
+
+//-------------------------------------------------------------------
+std::atomic<bool> CProfiler::m_enabled(false);
+std::atomic<bool> CProfiler::m_recordEvents(true);
+
+//-------------------------------------------------------------------
+void CProfiler::Enable(bool b, bool recordEvents)
+{
+	m_recordEvents = recordEvents;
+	m_enabled = b;
+}
+
+//-------------------------------------------------------------------
+void CProfiler::Reset()
+{
+	std::lock_guard<std::mutex> lock(profileLock);
+	profileStart = Clock::now();
+	for (ThreadProfile* tp : profileThreads)
+	{
+		std::lock_guard<std::mutex> tplock(tp->lock);
+		InitTree(tp->tree);
+		tp->stack.clear();
+		tp->events.clear();
+		tp->start = profileStart;
+	}
+}
+
+//-------------------------------------------------------------------
+void CProfiler::BeginScope(const char* sz)
+{
+	ThreadProfile& tp = GetThreadProfile();
+	std::lock_guard<std::mutex> lock(tp.lock);
+	int parent = (tp.stack.empty() ? 0 : tp.stack.back().node);
+	OpenScope scope = { FindChild(tp.tree, parent, sz), Clock::now() };
+	tp.stack.push_back(scope);
+}
+
+//-------------------------------------------------------------------
+void CProfiler::EndScope()
+{
+	ThreadProfile& tp = GetThreadProfile();
+	std::lock_guard<std::mutex> lock(tp.lock);
+
+	// the stack can be empty if the profiler was reset inside this scope
+	if (tp.stack.empty()) return;
+
+	Clock::time_point t1 = Clock::now();
+	OpenScope scope = tp.stack.back(); tp.stack.pop_back();
+	double dt = std::chrono::duration<double>(t1 - scope.start).count();
+
+	Node& node = tp.tree[scope.node];
+	node.count++;
+	node.total += dt;
+	node.self += dt;
+	tp.tree[node.parent].self -= dt;
+
+	if (m_recordEvents && (tp.events.size() < MAX_PROFILE_EVENTS))
+	{
+		ProfileEvent ev;
+		ev.name = node.name;
+		ev.ts = std::chrono::duration<double, std::micro>(scope.start - tp.start).count();
+		ev.dur = dt*1e6;
+		tp.events.push_back(ev);
+	}
+}
+
+//-------------------------------------------------------------------
+std::vector<CProfiler::Node> CProfiler::GetCallTree()
+{
+	std::vector<Node> tree;
+	InitTree(tree);
+
+	std::lock_guard<std::mutex> lock(profileLock);
+	for (ThreadProfile* tp : profileThreads)
+	{
+		std::lock_guard<std::mutex> tplock(tp->lock);
+		MergeTree(tree, 0, tp->tree, 0);
+	}
+
+	// the root's time is the sum of the top-level scopes
+	Node& root = tree[0];
+	for (int i : root.children) root.total += tree[i].total;
+	root.self = 0.0;
+
+	return tree;
+}
+
+//-------------------------------------------------------------------
+std::string CProfiler::GetReport()
+{
+	std::vector<Node> tree = GetCallTree();
+
+	// The percentage is relative to the parent scope. Note that scopes that
+	// are executed on worker threads show up as top-level scopes.
+	std::string s;
+	char sz[512];
+	snprintf(sz, sizeof(sz), "%-48s %10s %12s %12s %9s\n", "scope", "calls", "total (ms)", "self (ms)", "% parent");
+	s += sz;
+
+	std::function<void(int, int)> printNode = [&](int n, int level) {
+		const Node& node = tree[n];
+		std::string name = std::string(2 * level, ' ') + node.name;
+		double T = (level > 0 ? tree[node.parent].total : node.total);
+		double pct = (T > 0 ? 100.0 * node.total / T : 0.0);
+		snprintf(sz, sizeof(sz), "%-48s %10d %12.3f %12.3f %9.2f\n", name.c_str(), node.count, node.total*1000.0, node.self*1000.0, pct);
+		s += sz;
+		for (int i : node.children) printNode(i, level + 1);
+	};
+	for (int i : tree[0].children) printNode(i, 0);
+
+	return s;
+}
+
+//-------------------------------------------------------------------
+bool CProfiler::WriteChromeTrace(const char* szfile)
+{
+	FILE* fp = fopen(szfile, "wt");
+	if (fp == nullptr) return false;
+
+	fprintf(fp, "{\"traceEvents\":[\n");
+	bool first = true;
+
+	std::lock_guard<std::mutex> lock(profileLock);
+	for (ThreadProfile* tp : profileThreads)
+	{
+		std::lock_guard<std::mutex> tplock(tp->lock);
+		for (const ProfileEvent& ev : tp->events)
+		{
+			if (first == false) fprintf(fp, ",\n");
+			fprintf(fp, "{\"name\":");
+			WriteJSONString(fp, ev.name);
+			fprintf(fp, ",\"ph\":\"X\",\"ts\":%.3f,\"dur\":%.3f,\"pid\":1,\"tid\":%d}", ev.ts, ev.dur, tp->tid);
+			first = false;
+		}
+	}
+
+	fprintf(fp, "\n],\"displayTimeUnit\":\"ms\"}\n");
+	fclose(fp);
+
+	return true;
+}
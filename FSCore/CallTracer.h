@@ -27,10 +27,11 @@ SOFTWARE.*/
 #pragma once
 #include <vector>
 #include <string>
+#include <atomic>
 
 //-------------------------------------------------------------------
 // This class can be used to track a call stack. Macros assist
-// with the use of this class.
+// with the use of this class. Each thread has its own stack.
 class CCallStack
 {
 public:
@@ -49,8 +50,58 @@ private:
 	CCallStack();
 
 private:
-	static std::vector<const char*> m_stack;
-	static bool	m_blocked;	// lock stack
+	static thread_local std::vector<const char*> m_stack;
+	static thread_local bool	m_blocked;	// lock stack
+};
+
+//-------------------------------------------------------------------
+// Scoped profiler that is driven by the TRACE macro. When enabled, the 
+// TRACE scopes are timed on the thread that executes them and collected
+// in a call tree per thread. Optionally, each scope is also recorded as 
+// an event, which can be saved in the Chrome trace format (chrome://tracing). 
+// The profiler is off by default, in which case TRACE only maintains the
+// call stack.
+class CProfiler
+{
+public:
+	struct Node
+	{
+		Node(const char* sz = nullptr, int p = -1) : name(sz), parent(p), count(0), total(0.0), self(0.0) {}
+
+		const char*	name;
+		int			parent;		// index of parent node (-1 for root)
+		int			count;		// number of calls
+		double		total;		// inclusive time (in seconds)
+		double		self;		// exclusive time (in seconds)
+		std::vector<int>	children;
+	};
+
+public:
+	static void Enable(bool b, bool recordEvents = true);
+	static bool IsEnabled() { return m_enabled; }
+
+	// Clear all collected data. 
+	// This and the following functions can be called while other threads
+	// are profiling, although their results will then be a snapshot.
+	static void Reset();
+
+	// get the call tree, merged over all threads (the first node is the root)
+	static std::vector<Node> GetCallTree();
+
+	// get a text report of the call tree
+	static std::string GetReport();
+
+	// save the recorded events in the Chrome trace format
+	static bool WriteChromeTrace(const char* szfile);
+
+public:
+	// these are called by CCallTracer
+	static void BeginScope(const char* sz);
+	static void EndScope();
+
+private:
+	static std::atomic<bool>	m_enabled;
+	static std::atomic<bool>	m_recordEvents;
 };
 
 //-------------------------------------------------------------------
@@ -59,6 +110,9 @@ class CCallTracer
 public:
 	CCallTracer(const char* sz);
 	~CCallTracer();
+
+private:
+	bool	m_profiled;
 };
 
 //-------------------------------------------------------------------
@@ -0,0 +1,365 @@
+/*This file is part of the FEBio Studio source code and is licensed under the MIT license
+listed below.
+
+See Copyright-FEBio-Studio.txt for details.
+
+Copyright (c) 2023 University of Utah, The Trustees of Columbia University in
+the City of New York, and others.
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.*/
+#include "stdafx.h"
+#include "GLGlyphMesh.h"
+#include "GLProgram.h"
+#include <GL/glew.h>
+#ifdef WIN32
+#include <Windows.h>
+#include <gl/GL.h>
+#endif
+#ifdef __APPLE__
+#include <OpenGL/gl.h>
+#endif
+#ifdef LINUX
+#include <GL/gl.h>
+#endif
+#include <math.h>
+
+//-----------------------------------------------------------------------------
+// The instancing shader. The glyph vertex is transformed by the instance axes and moved 
+// to the instance position. Lighting is a simple approximation of the fixed-function 
+// lighting with the first light source.
+static const char* glyphVertexShader = \
+"#version 120\n"\
+"attribute vec3 vr;\n"\
+"attribute vec3 vn;\n"\
+"attribute vec3 ir;\n"\
+"attribute vec3 ie0;\n"\
+"attribute vec3 ie1;\n"\
+"attribute vec3 ie2;\n"\
+"attribute vec4 ic;\n"\
+"uniform int lighting;\n"\
+"varying vec4 color;\n"\
+"void main()\n"\
+"{\n"\
+"	vec3 p = ir + ie0*vr.x + ie1*vr.y + ie2*vr.z;\n"\
+"	vec4 q = gl_ModelViewMatrix*vec4(p, 1.0);\n"\
+"	gl_Position = gl_ProjectionMatrix*q;\n"\
+"	gl_ClipVertex = q;\n"\
+"	color = ic;\n"\
+"	if (lighting != 0)\n"\
+"	{\n"\
+"		vec3 n = cross(ie1, ie2)*vn.x + cross(ie2, ie0)*vn.y + cross(ie0, ie1)*vn.z;\n"\
+"		vec3 N = normalize(gl_NormalMatrix*n);\n"\
+"		vec3 L = normalize(gl_LightSource[0].position.xyz - q.xyz*gl_LightSource[0].position.w);\n"\
+"		float d = abs(dot(N, L));\n"\
+"		vec3 a = gl_LightModel.ambient.rgb + gl_FrontMaterial.ambient.rgb*gl_LightSource[0].ambient.rgb;\n"\
+"		color = vec4(min(ic.rgb*(a + gl_LightSource[0].diffuse.rgb*d), vec3(1.0)), ic.a);\n"\
+"	}\n"\
+"}\n";
+
+static const char* glyphFragmentShader = \
+"#version 120\n"\
+"varying vec4 color;\n"\
+"void main()\n"\
+"{\n"\
+"	gl_FragColor = color;\n"\
+"}\n";
+
+// the attributes of the shader, in the order of their locations
+static const char* glyphAttributes[] = { "vr", "vn", "ir", "ie0", "ie1", "ie2", "ic", nullptr };
+
+static GLProgram glyphProgram;
+static int glyphProgramStatus = 0; // 0 = not created yet, 1 = ready, -1 = not supported
+
+//-----------------------------------------------------------------------------
+GLGlyphMesh::GLGlyphMesh()
+{
+	m_lines = false;
+	m_radius = 0.f;
+	m_instances = 0;
+}
+
+void GLGlyphMesh::Instance::SetZAxis(const vec3f& v)
+{
+	vec3f ez = v; ez.Normalize();
+	vec3f a = (fabs(ez.x) < 0.9f ? vec3f(1.f, 0.f, 0.f) : vec3f(0.f, 1.f, 0.f));
+	vec3f ex = a ^ ez; ex.Normalize();
+	vec3f ey = ez ^ ex;
+	e[0] = ex;
+	e[1] = ey;
+	e[2] = ez;
+}
+
+void GLGlyphMesh::ClearGlyph()
+{
+	m_gr.clear();
+	m_gn.clear();
+	m_lines = false;
+	m_radius = 0.f;
+	m_it.clear();
+	m_ic.clear();
+	m_instances = 0;
+}
+
+void GLGlyphMesh::AddTriangle(const vec3f& r0, const vec3f& r1, const vec3f& r2, const vec3f& n0, const vec3f& n1, const vec3f& n2)
+{
+	assert(m_lines == false);
+	m_gr.push_back(r0); m_gn.push_back(n0);
+	m_gr.push_back(r1); m_gn.push_back(n1);
+	m_gr.push_back(r2); m_gn.push_back(n2);
+	for (int i = 0; i < 3; ++i)
+	{
+		float R = m_gr[m_gr.size() - 1 - i].Length();
+		if (R > m_radius) m_radius = R;
+	}
+}
+
+// Adds the side of a cylinder (or cone) along the z-axis, without caps (like gluCylinder)
+void GLGlyphMesh::AddCylinder(float r0, float r1, float z0, float z1, int slices)
+{
+	if (slices < 3) slices = 3;
+	float dz = z1 - z0;
+	float nz = (dz != 0.f ? (r0 - r1) / dz : 0.f);
+	for (int i = 0; i < slices; ++i)
+	{
+		float wa = 2.f*(float)PI*i / slices;
+		float wb = 2.f*(float)PI*(i + 1) / slices;
+		float ca = cosf(wa), sa = sinf(wa);
+		float cb = cosf(wb), sb = sinf(wb);
+
+		vec3f a0(r0*ca, r0*sa, z0), a1(r1*ca, r1*sa, z1);
+		vec3f b0(r0*cb, r0*sb, z0), b1(r1*cb, r1*sb, z1);
+
+		vec3f na(ca, sa, nz); na.Normalize();
+		vec3f nb(cb, sb, nz); nb.Normalize();
+
+		AddTriangle(a0, b0, b1, na, nb, nb);
+		AddTriangle(a0, b1, a1, na, nb, na);
+	}
+}
+
+// Adds a sphere centered at the origin
+void GLGlyphMesh::AddSphere(float radius, int slices, int stacks)
+{
+	if (slices < 3) slices = 3;
+	if (stacks < 2) stacks = 2;
+	for (int j = 0; j < stacks; ++j)
+	{
+		float pa = (float)PI*j / stacks;
+		float pb = (float)PI*(j + 1) / stacks;
+		for (int i = 0; i < slices; ++i)
+		{
+			float wa = 2.f*(float)PI*i / slices;
+			float wb = 2.f*(float)PI*(i + 1) / slices;
+
+			vec3f n00(sinf(pa)*cosf(wa), sinf(pa)*sinf(wa), cosf(pa));
+			vec3f n10(sinf(pa)*cosf(wb), sinf(pa)*sinf(wb), cosf(pa));
+			vec3f n01(sinf(pb)*cosf(wa), sinf(pb)*sinf(wa), cosf(pb));
+			vec3f n11(sinf(pb)*cosf(wb), sinf(pb)*sinf(wb), cosf(pb));
+
+			if (j > 0) AddTriangle(n00*radius, n01*radius, n10*radius, n00, n01, n10);
+			if (j < stacks - 1) AddTriangle(n10*radius, n01*radius, n11*radius, n10, n01, n11);
+		}
+	}
+}
+
+// Adds a box centered at the origin with half-widths hx, hy, hz
+void GLGlyphMesh::AddBox(float hx, float hy, float hz)
+{
+	const int FN[6][4] = {
+		{1, 2, 6, 5}, {0, 4, 7, 3}, {2, 3, 7, 6}, {0, 1, 5, 4}, {4, 5, 6, 7}, {0, 3, 2, 1}
+	};
+	const vec3f N[6] = {
+		vec3f(1, 0, 0), vec3f(-1, 0, 0), vec3f(0, 1, 0), vec3f(0, -1, 0), vec3f(0, 0, 1), vec3f(0, 0, -1)
+	};
+	vec3f r[8] = {
+		vec3f(-hx, -hy, -hz), vec3f(hx, -hy, -hz), vec3f(hx, hy, -hz), vec3f(-hx, hy, -hz),
+		vec3f(-hx, -hy,  hz), vec3f(hx, -hy,  hz), vec3f(hx, hy,  hz), vec3f(-hx, hy,  hz)
+	};
+	for (int i = 0; i < 6; ++i)
+	{
+		const int* f = FN[i];
+		AddTriangle(r[f[0]], r[f[1]], r[f[2]], N[i], N[i], N[i]);
+		AddTriangle(r[f[0]], r[f[2]], r[f[3]], N[i], N[i], N[i]);
+	}
+}
+
+void GLGlyphMesh::AddLine(const vec3f& a, const vec3f& b)
+{
+	assert(m_gn.empty());
+	m_lines = true;
+	m_gr.push_back(a);
+	m_gr.push_back(b);
+	if (a.Length() > m_radius) m_radius = a.Length();
+	if (b.Length() > m_radius) m_radius = b.Length();
+}
+
+float GLGlyphMesh::InstanceRadius(const GLGlyphMesh::Instance& inst) const
+{
+	float smax = 0.f;
+	for (int k = 0; k < 3; ++k)
+	{
+		float s = fabs(inst.s[k]);
+		if (s > smax) smax = s;
+	}
+	return smax*m_radius;
+}
+
+void GLGlyphMesh::Build(const std::vector<GLGlyphMesh::Instance>& inst, const std::vector<double>& clip)
+{
+	// find the instances that are not clipped
+	std::vector<int> items;
+	items.reserve(inst.size());
+	int NC = (int)clip.size() / 4;
+	for (int i = 0; i < (int)inst.size(); ++i)
+	{
+		const Instance& g = inst[i];
+		bool bclip = false;
+		if (NC > 0)
+		{
+			double R = InstanceRadius(g);
+			for (int k = 0; k < NC; ++k)
+			{
+				const double* a = &clip[4 * k];
+				if (a[0] * g.r.x + a[1] * g.r.y + a[2] * g.r.z + a[3] < -R) { bclip = true; break; }
+			}
+		}
+		if (bclip == false) items.push_back(i);
+	}
+
+	// only the transformation and color of each instance is stored
+	int NI = (int)items.size();
+	m_it.resize(12 * (size_t)NI);
+	m_ic.resize(4 * (size_t)NI);
+	m_instances = NI;
+
+#pragma omp parallel for
+	for (int i = 0; i < NI; ++i)
+	{
+		const Instance& g = inst[items[i]];
+		float* t = &m_it[12 * (size_t)i];
+		t[0] = g.r.x; t[1] = g.r.y; t[2] = g.r.z;
+		for (int k = 0; k < 3; ++k)
+		{
+			vec3f e = g.e[k] * g.s[k];
+			t[3 * k + 3] = e.x; t[3 * k + 4] = e.y; t[3 * k + 5] = e.z;
+		}
+
+		unsigned char* c = &m_ic[4 * (size_t)i];
+		c[0] = g.c.r; c[1] = g.c.g; c[2] = g.c.b; c[3] = g.c.a;
+	}
+}
+
+void GLGlyphMesh::Render()
+{
+	if ((m_instances == 0) || m_gr.empty()) return;
+
+	if (RenderInstanced() == false) RenderEachInstance();
+}
+
+// Draw all instances with one call. This requires OpenGL 3.3 (for the attribute divisors).
+bool GLGlyphMesh::RenderInstanced()
+{
+	if (glyphProgramStatus == 0)
+	{
+		glyphProgramStatus = -1;
+		if (GLEW_VERSION_3_3 && glyphProgram.Create(glyphVertexShader, glyphFragmentShader, glyphAttributes))
+			glyphProgramStatus = 1;
+	}
+	if (glyphProgramStatus != 1) return false;
+
+	glyphProgram.Use();
+	glyphProgram.SetInt("lighting", ((m_lines == false) && glIsEnabled(GL_LIGHTING) ? 1 : 0));
+
+	// the glyph vertices
+	glEnableVertexAttribArray(0);
+	glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, 0, &m_gr[0]);
+	if (m_lines == false)
+	{
+		glEnableVertexAttribArray(1);
+		glVertexAttribPointer(1, 3, GL_FLOAT, GL_FALSE, 0, &m_gn[0]);
+	}
+	else glVertexAttrib3f(1, 0.f, 0.f, 1.f);
+
+	// the instance data advances once per instance
+	GLsizei stride = 12 * sizeof(float);
+	for (int k = 0; k < 4; ++k)
+	{
+		glEnableVertexAttribArray(2 + k);
+		glVertexAttribPointer(2 + k, 3, GL_FLOAT, GL_FALSE, stride, &m_it[3 * k]);
+		glVertexAttribDivisor(2 + k, 1);
+	}
+	glEnableVertexAttribArray(6);
+	glVertexAttribPointer(6, 4, GL_UNSIGNED_BYTE, GL_TRUE, 0, &m_ic[0]);
+	glVertexAttribDivisor(6, 1);
+
+	glDrawArraysInstanced((m_lines ? GL_LINES : GL_TRIANGLES), 0, (GLsizei)m_gr.size(), m_instances);
+
+	// restore state
+	for (int k = 2; k <= 6; ++k)
+	{
+		glVertexAttribDivisor(k, 0);
+		glDisableVertexAttribArray(k);
+	}
+	glDisableVertexAttribArray(1);
+	glDisableVertexAttribArray(0);
+	glUseProgram(0);
+
+	return true;
+}
+
+// Fallback for when instancing is not available: draw the glyph once per instance
+void GLGlyphMesh::RenderEachInstance()
+{
+	glPushAttrib(GL_ENABLE_BIT);
+	glEnable(GL_NORMALIZE);
+
+	glEnableClientState(GL_VERTEX_ARRAY);
+	glVertexPointer(3, GL_FLOAT, 0, &m_gr[0]);
+	if (m_lines == false)
+	{
+		glEnableClientState(GL_NORMAL_ARRAY);
+		glNormalPointer(GL_FLOAT, 0, &m_gn[0]);
+	}
+
+	GLenum mode = (m_lines ? GL_LINES : GL_TRIANGLES);
+	GLsizei NG = (GLsizei)m_gr.size();
+
+	// column-major matrix with the scaled axes as the first three columns and the position as the last
+	float m[16] = { 0.f };
+	m[15] = 1.f;
+	for (int i = 0; i < m_instances; ++i)
+	{
+		const float* t = &m_it[12 * (size_t)i];
+		m[ 0] = t[3]; m[ 1] = t[ 4]; m[ 2] = t[ 5];
+		m[ 4] = t[6]; m[ 5] = t[ 7]; m[ 6] = t[ 8];
+		m[ 8] = t[9]; m[ 9] = t[10]; m[10] = t[11];
+		m[12] = t[0]; m[13] = t[ 1]; m[14] = t[ 2];
+
+		glColor4ubv(&m_ic[4 * (size_t)i]);
+		glPushMatrix();
+		glMultMatrixf(m);
+		glDrawArrays(mode, 0, NG);
+		glPopMatrix();
+	}
+
+	if (m_lines == false) glDisableClientState(GL_NORMAL_ARRAY);
+	glDisableClientState(GL_VERTEX_ARRAY);
+
+	glPopAttrib();
+}
@@ -0,0 +1,101 @@
+/*This file is part of the FEBio Studio source code and is licensed under the MIT license
+listed below.
+
+See Copyright-FEBio-Studio.txt for details.
+
+Copyright (c) 2023 University of Utah, The Trustees of Columbia University in
+the City of New York, and others.
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.*/
+#pragma once
+#include <FSCore/math3d.h>
+#include <FSCore/color.h>
+#include <vector>
+
+//=============================================================================
+// Mesh for rendering many copies (instances) of the same glyph. The glyph geometry is 
+// defined once in a local coordinate system, where the z-axis is the main axis of the glyph.
+// Each instance then places the glyph at a position, with three axes, a scale factor
+// along each axis, and a color. Only the glyph geometry and a small transformation per 
+// instance are stored. When the hardware supports it, all glyphs are drawn with a single 
+// instanced draw call. Otherwise, the glyph is drawn once for each instance. 
+class GLGlyphMesh
+{
+public:
+	struct Instance
+	{
+		vec3f	r;		// position
+		vec3f	e[3];	// local axes (unit vectors)
+		float	s[3];	// scale factors along the local axes
+		GLColor	c;		// color
+
+		// align the local z-axis with v and pick the other two axes perpendicular to it
+		void SetZAxis(const vec3f& v);
+	};
+
+public:
+	GLGlyphMesh();
+
+	// clear the glyph geometry and all instances
+	void ClearGlyph();
+
+	// functions for defining the glyph geometry. A glyph consists either of
+	// triangles or of lines, but not both. 
+	void AddCylinder(float r0, float r1, float z0, float z1, int slices);
+	void AddSphere(float radius, int slices, int stacks);
+	void AddBox(float hx, float hy, float hz);
+	void AddLine(const vec3f& a, const vec3f& b);
+
+	bool IsEmpty() const { return m_gr.empty(); }
+
+	// radius of the sphere (centered at the origin) that contains the glyph
+	float GlyphRadius() const { return m_radius; }
+
+	// radius of the sphere (centered at the position) that contains an instance
+	float InstanceRadius(const Instance& inst) const;
+
+	// number of instances
+	int Instances() const { return m_instances; }
+
+public:
+	// Store the instances. Instances that lie completely on the clipped side of one 
+	// of the clip planes are skipped. The clip planes are given as 4 coefficients a 
+	// per plane, where points with a0*x + a1*y + a2*z + a3 < 0 are clipped.
+	void Build(const std::vector<Instance>& inst, const std::vector<double>& clip = std::vector<double>());
+
+	// render all instances
+	void Render();
+
+private:
+	void AddTriangle(const vec3f& r0, const vec3f& r1, const vec3f& r2, const vec3f& n0, const vec3f& n1, const vec3f& n2);
+
+	bool RenderInstanced();
+	void RenderEachInstance();
+
+private:
+	std::vector<vec3f>	m_gr;	// glyph vertex positions
+	std::vector<vec3f>	m_gn;	// glyph vertex normals (triangle glyphs only)
+	bool				m_lines;	// the glyph consists of lines
+	float				m_radius;
+
+	// Per instance, the position followed by the three scaled axes (12 floats), and the color (rgba)
+	std::vector<float>			m_it;
+	std::vector<unsigned char>	m_ic;
+	int							m_instances;
+};
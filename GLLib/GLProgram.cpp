@@ -57,7 +57,7 @@ bool compileShader(unsigned int shaderid, const char* shadersrc)
 	return (success != 0);
 }
 
-bool GLProgram::Create(const char* szvert, const char* szfrag)
+bool GLProgram::Create(const char* szvert, const char* szfrag, const char** szattribs)
 {
 	// create the fragment shader
 	GLuint vertShader = 0, fragShader = 0;
@@ -80,6 +80,12 @@ bool GLProgram::Create(const char* szvert, const char* szfrag)
 	if (vertShader > 0) glAttachShader(m_progId, vertShader);
 	if (fragShader > 0) glAttachShader(m_progId, fragShader);
 
+	// bind attribute locations (must be done before linking)
+	if (szattribs)
+	{
+		for (int i = 0; szattribs[i]; ++i) glBindAttribLocation(m_progId, i, szattribs[i]);
+	}
+
 	// link program
 	int success = 0;
 	glLinkProgram(m_progId);
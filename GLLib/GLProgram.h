@@ -34,7 +34,8 @@ public:
 	GLProgram();
 
 	// create the shaders, compile and link
-	bool Create(const char* szvert, const char* szfrag);
+	// The optional attribute list is null-terminated. Attribute i is bound to location i.
+	bool Create(const char* szvert, const char* szfrag, const char** szattribs = nullptr);
 
 	// use the GL program
 	void Use();
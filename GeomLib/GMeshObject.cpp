@@ -728,42 +728,109 @@ void GMeshObject::BuildGMesh()
 		for (int j = 0; j < ne; ++j) pm->Node(e.n[j]).m_ntag = 1;
 	}
 
+	// number the render mesh nodes
+	int nodes = 0;
+	for (int i=0; i<NN; ++i)
+	{
+		FSNode& node = pm->Node(i);
+		node.m_ntag = (node.m_ntag == 1 ? nodes++ : -1);
+	}
+
+	// figure out where each edge and face goes, so we can allocate the 
+	// render mesh up front and fill it in parallel.
+	int NL = pm->Edges();
+	vector<int> edgeOffset(NL + 1, 0);
+	for (int i=0; i<NL; ++i)
+	{
+		FSEdge& es = pm->Edge(i);
+		int ns = (es.IsExterior() ? GMesh::EdgeSegments(es.Nodes()) : 0);
+		edgeOffset[i + 1] = edgeOffset[i] + ns;
+	}
+
+	int NF = pm->Faces();
+	vector<int> faceOffset(NF + 1, 0);
+	for (int i=0; i<NF; ++i)
+	{
+		FSFace& fs = pm->Face(i);
+		faceOffset[i + 1] = faceOffset[i] + GMesh::FaceTriangles(fs.Nodes());
+	}
+
+	gmesh->Create(nodes, faceOffset[NF], edgeOffset[NL]);
+
 	// create nodes
+#pragma omp parallel for
 	for (int i=0; i<NN; ++i)
 	{
 		FSNode& node = pm->Node(i);
-		if (node.m_ntag == 1) node.m_ntag = gmesh->AddNode(node.r, i, node.m_gid);
+		if (node.m_ntag >= 0)
+		{
+			GMesh::NODE& gn = gmesh->Node(node.m_ntag);
+			gn.r = node.r;
+			gn.pid = node.m_gid;
+			gn.nid = i;
+		}
 	}
 
 	// create edges
-	int n[FSFace::MAX_NODES];
-	for (int i=0; i<pm->Edges(); ++i)
+#pragma omp parallel for
+	for (int i=0; i<NL; ++i)
 	{
 		FSEdge& es = pm->Edge(i);
-		if (es.IsExterior())
+		if (edgeOffset[i + 1] > edgeOffset[i])
 		{
-			n[0] = pm->Node(es.n[0]).m_ntag; assert(n[0] >= 0);
-			n[1] = pm->Node(es.n[1]).m_ntag; assert(n[1] >= 0);
-			if (es.n[2] != -1) { n[2] = pm->Node(es.n[2]).m_ntag; assert(n[2] >= 0); }
-			if (es.n[3] != -1) { n[3] = pm->Node(es.n[3]).m_ntag; assert(n[3] >= 0); }
+			int n[FSEdge::MAX_NODES];
+			int ne = es.Nodes();
+			for (int j=0; j<ne; ++j) { n[j] = pm->Node(es.n[j]).m_ntag; assert(n[j] >= 0); }
 			assert(es.m_gid >= 0);
-			gmesh->AddEdge(n, es.Nodes(), es.m_gid);
+			gmesh->SetEdge(edgeOffset[i], n, ne, es.m_gid);
 		}
 	}
 
 	// create face data
-	for (int i=0; i<pm->Faces(); ++i)
+#pragma omp parallel for
+	for (int i=0; i<NF; ++i)
 	{
 		FSFace& fs = pm->Face(i);
-		int nf = fs.Nodes();
-		for (int j=0; j<nf; ++j) n[j] = pm->Node(fs.n[j]).m_ntag;
-		gmesh->AddFace(n, nf, fs.m_gid, fs.m_sid, fs.IsExternal());
+		if (faceOffset[i + 1] > faceOffset[i])
+		{
+			int n[FSFace::MAX_NODES];
+			int nf = fs.Nodes();
+			for (int j=0; j<nf; ++j) n[j] = pm->Node(fs.n[j]).m_ntag;
+			gmesh->SetFace(faceOffset[i], n, nf, fs.m_gid, fs.m_sid, fs.IsExternal());
+		}
 	}
 
 	gmesh->Update();
 	SetRenderMesh(gmesh);
 }
 
+//-----------------------------------------------------------------------------
+// Only copies the node positions to the render mesh. This can be used when the
+// mesh topology did not change (e.g. after a transform or smoothing operation).
+void GMeshObject::UpdateGMeshNodes()
+{
+	GMesh* gmesh = GetRenderMesh();
+	FSMesh* pm = GetFEMesh();
+	if ((gmesh == nullptr) || (pm == nullptr) || gmesh->IsEmpty()) { BuildGMesh(); return; }
+
+	int NN = pm->Nodes();
+	int N = gmesh->Nodes();
+	int nerr = 0;
+#pragma omp parallel for reduction(+:nerr)
+	for (int i=0; i<N; ++i)
+	{
+		GMesh::NODE& gn = gmesh->Node(i);
+		if ((gn.nid >= 0) && (gn.nid < NN)) gn.r = pm->Node(gn.nid).r;
+		else nerr++;
+	}
+
+	// if the render mesh no longer matches the mesh, we need to rebuild it
+	if (nerr > 0) { BuildGMesh(); return; }
+
+	gmesh->UpdateBoundingBox();
+	gmesh->UpdateNormals();
+}
+
 //-----------------------------------------------------------------------------
 // Create a clone of this object
 GObject* GMeshObject::Clone()
@@ -85,6 +85,8 @@ public:
 	bool DeletePart(GPart* pg) override;
 	bool DeleteParts(std::vector<GPart*> pg);
 
+	void UpdateGMeshNodes() override;
+
 protected:
 	void BuildGMesh() override;
 
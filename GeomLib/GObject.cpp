@@ -486,7 +486,7 @@ void GObject::UpdateGNodes()
 		if (n.m_gid >= 0) m_Node[n.m_gid]->LocalPosition() = n.r;
 	}
 
-	BuildGMesh();
+	UpdateGMeshNodes();
 }
 
 //-----------------------------------------------------------------------------
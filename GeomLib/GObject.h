@@ -176,6 +176,10 @@ public:
 	// build the render mesh
 	virtual void BuildGMesh();
 
+	// update the node positions of the render mesh, assuming the mesh topology
+	// did not change (by default, this rebuilds the render mesh)
+	virtual void UpdateGMeshNodes() { BuildGMesh(); }
+
 	// get the render mesh
 	GMesh*	GetRenderMesh();
 
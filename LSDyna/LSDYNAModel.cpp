@@ -52,56 +52,44 @@ void LSDYNAModel::clear()
 	}
 }
 
-int LSDYNAModel::FindNode(int id, list<LSDYNAModel::NODE>::iterator& pn)
+int LSDYNAModel::NodeIndex(int nodeId) const
 {
-	int N = (int)m_node.size();
-	int m = 0;
-	do
+	if (m_NLT.empty() == false)
 	{
-		if (id == pn->id) return pn->n;
-		else if (id < pn->id)
-		{
-			if (pn->n > 0) --pn; else return -1;
-		}
-		else
-		{
-			if (pn->n < N - 1) ++pn; else return -1;
-		}
-		++m;
-	} while (m <= N);
+		int n = nodeId - m_off;
+		return ((n >= 0) && (n < (int)m_NLT.size()) ? m_NLT[n] : -1);
+	}
 
-	return -1;
+	auto it = m_NLTmap.find(nodeId);
+	return (it != m_NLTmap.end() ? it->second : -1);
 }
 
-int LSDYNAModel::FindFace(int n[4])
+bool LSDYNAModel::UnknownNode(int nodeId, const char* szitem, int itemId)
 {
-	int* pf = m_pFace[n[0]];
-	int N = m_nFace[n[0]];
-	int i;
-
-	FSMesh* pm = m_po->GetFEMesh();
-
-	for (i = 0; i<N; ++i)
-	{
-		FSFace& face = pm->Face(pf[i]);
-		if (face.HasNode(n[1]) &&
-			face.HasNode(n[2]) &&
-			face.HasNode(n[3])) return pf[i];
-	}
-
-	return -1;
+	std::ostringstream ss;
+	ss << "Unknown node ID " << nodeId << " in " << szitem << " " << itemId;
+	m_err = ss.str();
+	return false;
 }
 
 int LSDYNAModel::FindShellDomain(int pid)
 {
-    int N = (int)m_dshell.size();
-    for (int i=0; i<N; ++i)
-        if (m_dshell[i].pid == pid) return i;
-    return -1;
+	auto it = m_DLT.find(pid);
+	return (it != m_DLT.end() ? it->second : -1);
+}
+
+void LSDYNAModel::BuildDLT()
+{
+	// if a part has multiple shell domains, the first one is used
+	m_DLT.clear();
+	int N = (int)m_dshell.size();
+	for (int i = 0; i < N; ++i) m_DLT.emplace(m_dshell[i].pid, i);
 }
 
 bool LSDYNAModel::BuildModel(FSModel& fem)
 {
+	m_err.clear();
+
 	// add the parameters
 	if (BuildParameters(fem) == false) return false;
 
@@ -135,11 +123,24 @@ void LSDYNAModel::BuildNLT()
 
 	// build the node lookup table
 	// this is used to convert node IDs into zero-based IDs
+	// If the IDs are sparse, a dense table would waste too much memory,
+	// so we use a hash map instead.
 	m_off = imin;
-	int nsize = imax - imin + 1;
-	m_NLT.assign(nsize, -1);
-	in = m_node.begin();
-	for (int i = 0; i < nodes; ++i, ++in) m_NLT[in->id - imin] = i;
+	m_NLT.clear();
+	m_NLTmap.clear();
+	double nsize = (double)imax - (double)imin + 1.0;
+	if (nsize <= 4.0 * nodes + 1024.0)
+	{
+		m_NLT.assign((size_t)nsize, -1);
+		in = m_node.begin();
+		for (int i = 0; i < nodes; ++i, ++in) m_NLT[in->id - imin] = i;
+	}
+	else
+	{
+		m_NLTmap.reserve(nodes);
+		in = m_node.begin();
+		for (int i = 0; i < nodes; ++i, ++in) m_NLTmap[in->id] = i;
+	}
 }
 
 bool LSDYNAModel::BuildFEMesh(FSModel& fem)
@@ -157,8 +158,9 @@ bool LSDYNAModel::BuildFEMesh(FSModel& fem)
 	FSMesh* pm = new FSMesh();
 	pm->Create(nodes, elems);
 
-	// build the node table
+	// build the node and shell domain tables
 	BuildNLT();
+	BuildDLT();
 
 	// create nodes
 	vector<NODE>::iterator in = m_node.begin();
@@ -205,14 +207,11 @@ bool LSDYNAModel::BuildFEMesh(FSModel& fem)
 			}
 			else pe->SetType(FE_HEX8);
 
-			pe->m_node[0] = NodeIndex(ih.n[0]); if (pe->m_node[0] < 0) return false;
-			pe->m_node[1] = NodeIndex(ih.n[1]); if (pe->m_node[1] < 0) return false;
-			pe->m_node[2] = NodeIndex(ih.n[2]); if (pe->m_node[2] < 0) return false;
-			pe->m_node[3] = NodeIndex(ih.n[3]); if (pe->m_node[3] < 0) return false;
-			pe->m_node[4] = NodeIndex(ih.n[4]); if (pe->m_node[4] < 0) return false;
-			pe->m_node[5] = NodeIndex(ih.n[5]); if (pe->m_node[5] < 0) return false;
-			pe->m_node[6] = NodeIndex(ih.n[6]); if (pe->m_node[6] < 0) return false;
-			pe->m_node[7] = NodeIndex(ih.n[7]); if (pe->m_node[7] < 0) return false;
+			for (int k = 0; k < 8; ++k)
+			{
+				pe->m_node[k] = NodeIndex(ih.n[k]);
+				if (pe->m_node[k] < 0) { delete pm; return UnknownNode(ih.n[k], "solid element", ih.eid); }
+			}
 		}
 	}
 
@@ -230,10 +229,11 @@ bool LSDYNAModel::BuildFEMesh(FSModel& fem)
 			pe->m_gid = is.pid;
 			pe->m_nid = is.eid;
 
-			pe->m_node[0] = NodeIndex(is.n[0]); if (pe->m_node[0] < 0) return false;
-			pe->m_node[1] = NodeIndex(is.n[1]); if (pe->m_node[1] < 0) return false;
-			pe->m_node[2] = NodeIndex(is.n[2]); if (pe->m_node[2] < 0) return false;
-			pe->m_node[3] = NodeIndex(is.n[3]); if (pe->m_node[3] < 0) return false;
+			for (int k = 0; k < 4; ++k)
+			{
+				pe->m_node[k] = NodeIndex(is.n[k]);
+				if (pe->m_node[k] < 0) { delete pm; return UnknownNode(is.n[k], "shell element", is.eid); }
+			}
 
             int n = FindShellDomain(is.pid);
             if (n != -1) {
@@ -409,7 +409,11 @@ bool LSDYNAModel::BuildFEMesh(FSModel& fem)
 	for (SET_NODE_LIST_TITLE& nl : m_nodelist)
 	{
 		std::vector<int> nodelist(nl.m_nodelist);
-		for (int i = 0; i < nodelist.size(); ++i) nodelist[i] = NodeIndex(nodelist[i]);
+		for (int i = 0; i < nodelist.size(); ++i)
+		{
+			nodelist[i] = NodeIndex(nl.m_nodelist[i]);
+			if (nodelist[i] < 0) return UnknownNode(nl.m_nodelist[i], "node set", nl.m_nid);
+		}
 		FSNodeSet* pg = new FSNodeSet(m_po, nodelist);
 		pg->SetName(nl.m_name);
 		m_po->AddFENodeSet(pg);
@@ -424,51 +428,6 @@ bool LSDYNAModel::BuildFEMesh(FSModel& fem)
 	return true;
 }
 
-void LSDYNAModel::UpdateMesh(FSMesh& mesh)
-{
-	int nsize = 0, i, j, n, m, l;
-
-	int nodes = mesh.Nodes();
-	int faces = mesh.Faces();
-
-	m_nFace.resize(nodes);
-	for (i = 0; i < nodes; ++i) m_nFace[i] = 0;
-
-	for (i = 0; i < faces; ++i)
-	{
-		FSFace& face = mesh.Face(i);
-		n = face.Nodes();
-		for (j = 0; j < n; ++j) m_nFace[face.n[j]]++;
-		nsize += n;
-	}
-
-	m_iFace.resize(nsize);
-	m_pFace.resize(nodes);
-	int* pi = &m_iFace[0];
-
-	for (i = 0; i < nodes; ++i)
-	{
-		m_pFace[i] = pi;
-		n = m_nFace[i];
-		pi += n;
-		m_nFace[i] = 0;
-	}
-
-	for (i = 0; i < faces; ++i)
-	{
-		FSFace& face = mesh.Face(i);
-		n = face.Nodes();
-		for (j = 0; j < n; ++j)
-		{
-			m = face.n[j];
-
-			l = m_nFace[m];
-			m_pFace[m][l] = i;
-			m_nFace[m]++;
-		}
-	}
-}
-
 bool LSDYNAModel::BuildMaterials(FSModel& fem)
 {
 	if (m_Mat.empty()) return true;
@@ -675,7 +634,9 @@ bool LSDYNAModel::BuildDiscrete(FSModel& fem)
 				GDiscreteSpringSet* ps = materialMap[mid];
 
 				int n1 = NodeIndex(el.n1);
+				if (n1 < 0) return UnknownNode(el.n1, "discrete element", el.eid);
 				int n2 = NodeIndex(el.n2);
+				if (n2 < 0) return UnknownNode(el.n2, "discrete element", el.eid);
 				int m1 = po->MakeGNode(n1);
 				int m2 = po->MakeGNode(n2);
 
@@ -29,6 +29,7 @@ SOFTWARE.*/
 #include <list>
 #include <string>
 #include <cstring>
+#include <unordered_map>
 
 //using namespace std;
 
@@ -293,13 +294,13 @@ public:
 
 	GMeshObject* TakeObject() { GMeshObject* po = m_po; m_po = 0; return po; }
 
-	int FindNode(int id, list<NODE>::iterator& pn);
-
-	int FindFace(int n[4]);
+	// returns the zero-based index of a node, or -1 if the node id is not found
+	int FindNode(int id) const { return NodeIndex(id); }
 
     int FindShellDomain(int pid);
-    
-	void UpdateMesh(FSMesh& mesh);
+
+	// error message of the last failed BuildModel
+	const std::string& GetErrorString() const { return m_err; }
 
 	void allocData(int N) { m_Data.assign(N, vector<double>(2)); }
 	double& NodeData(int i, int j) { return m_Data[i][j]; }
@@ -311,8 +312,12 @@ protected:
 	bool BuildParameters(FSModel& fem);
 	bool BuildDiscrete(FSModel& fem);
 	void BuildNLT();
+	void BuildDLT();
 
-	int NodeIndex(int nodeId) { return m_NLT[nodeId - m_off]; }
+	int NodeIndex(int nodeId) const;
+
+	// set the error message for an unknown node ID and return false
+	bool UnknownNode(int nodeId, const char* szitem, int itemId);
 
 public:
 	vector<ELEMENT_SOLID>		m_solid;
@@ -327,16 +332,20 @@ public:
 	vector<LOAD_CURVE>	m_lc;
 	vector<PARAMETER>	m_param;
 	GMeshObject*	m_po; 
-	vector<int>		m_iFace;
-	vector<int*>	m_pFace;
-	vector<int>		m_nFace;
 	vector< vector<double> >	m_Data;	// nodal data
 
 	// node lookup table
+	// (a dense table is used when node ids are compact, otherwise a hash map)
 	vector<int> m_NLT;
+	std::unordered_map<int, int> m_NLTmap;
 	int m_off;
 
+	// shell domain lookup table (part id to index in m_dshell)
+	std::unordered_map<int, int> m_DLT;
+
 	// load curve lookup table
 	vector<int> m_LCT;
 	int m_lct_off;
+
+	std::string	m_err;
 };
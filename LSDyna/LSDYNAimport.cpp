@@ -78,6 +78,7 @@ bool LSDYNAimport::Load(const char* szfile)
 		std::string s = log.str();
 		if (s.empty() == false) errf(s.c_str());
 	}
+	else if (m_dyna.GetErrorString().empty() == false) errf(m_dyna.GetErrorString().c_str());
 
 	// clean up
 	m_dyna.clear();
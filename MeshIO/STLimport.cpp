@@ -31,6 +31,8 @@ SOFTWARE.*/
 //-----------------------------------------------------------------------------
 STLimport::STLimport(FSProject& prj) : FSFileImport(prj)
 {
+	m_pfem = nullptr;
+	m_nline = 0;
 }
 
 //-----------------------------------------------------------------------------
@@ -75,6 +77,7 @@ bool STLimport::Load(const char* szfile)
 		// try to read binary STL
 		if (read_binary(szfile) == false)
 		{
+			m_vert.clear();
 			return false;
 		}
 	}
@@ -82,6 +85,9 @@ bool STLimport::Load(const char* szfile)
 	// build the nodes
 	GObject* po = build_mesh();
 
+	// we don't need the facet data anymore
+	std::vector<float>().swap(m_vert);
+
 //	static int nc = 1;
 //	char sz[256];
 //	sprintf(sz, "STL-Object%02d", nc++);
@@ -113,12 +119,10 @@ bool STLimport::read_ascii(const char* szfile)
 	char szline[256] = { 0 };
 	if (read_line(szline, "solid") == false) return errf("First line must be solid definition.");
 
-	// clear the list
-	m_Face.clear();
+	// clear the vertex data
+	m_vert.clear();
 
 	// read all the triangles
-	int nc = 0;
-	FACET face;
 	do
 	{
 		// read the facet line
@@ -133,18 +137,15 @@ bool STLimport::read_ascii(const char* szfile)
 		if (read_line(szline, "outer loop") == false) return errf("Error encountered at line %d", m_nline);
 
 		// read the vertex data
-		float x, y, z;
-		if (read_line(szline, "vertex ") == false) return errf("Error encountered at line %d", m_nline);
-		sscanf(szline, "vertex %g%g%g", &x, &y, &z);
-		face.v1[0] = x;	face.v1[1] = y; face.v1[2] = z;
-
-		if (read_line(szline, "vertex ") == false) return errf("Error encountered at line %d", m_nline);
-		sscanf(szline, "vertex %g%g%g", &x, &y, &z);
-		face.v2[0] = x;	face.v2[1] = y; face.v2[2] = z;
-
-		if (read_line(szline, "vertex ") == false) return errf("Error encountered at line %d", m_nline);
-		sscanf(szline, "vertex %g%g%g", &x, &y, &z);
-		face.v3[0] = x;	face.v3[1] = y; face.v3[2] = z;
+		for (int i = 0; i < 3; ++i)
+		{
+			float x, y, z;
+			if (read_line(szline, "vertex ") == false) return errf("Error encountered at line %d", m_nline);
+			sscanf(szline, "vertex %g%g%g", &x, &y, &z);
+			m_vert.push_back(x);
+			m_vert.push_back(y);
+			m_vert.push_back(z);
+		}
 
 		// read the endloop tag
 		if (read_line(szline, "endloop") == false) return errf("Error encountered at line %d", m_nline);
@@ -152,8 +153,6 @@ bool STLimport::read_ascii(const char* szfile)
 		// read the endfacet tag
 		if (read_line(szline, "endfacet") == false) return errf("Error encountered at line %d", m_nline);
 
-		// add the facet to the list
-		m_Face.push_back(face);
 	} while (1);
 
 	// close the file
@@ -162,21 +161,10 @@ bool STLimport::read_ascii(const char* szfile)
 	return true;
 }
 
-//-----------------------------------------------------------------------------
-// read a line from the input file
-bool STLimport::read_facet(STLimport::FACET& f)
-{
-	unsigned short att;
-	if (fread(f.norm, sizeof(float), 3, m_fp) != 3) return false;
-	if (fread(f.v1, sizeof(float), 3, m_fp) != 3) return false;
-	if (fread(f.v2, sizeof(float), 3, m_fp) != 3) return false;
-	if (fread(f.v3, sizeof(float), 3, m_fp) != 3) return false;
-	if (fread(&att, sizeof(att), 1, m_fp) != 1) return false;
-	return true;
-}
-
 //-----------------------------------------------------------------------------
 // Load an STL model
+// The facets are read in large blocks and the vertex coordinates are copied 
+// directly into the flat vertex array.
 bool STLimport::read_binary(const char* szfile)
 {
 	FSModel& fem = m_prj.GetFSModel();
@@ -189,23 +177,37 @@ bool STLimport::read_binary(const char* szfile)
 	char szbuf[80] = { 0 };
 	if (fread(szbuf, 80, 1, m_fp) != 1) return errf("Failed reading header.");
 
-	// clear the list
-	m_Face.clear();
+	// clear the vertex data
+	m_vert.clear();
 
 	// read the number of triangles
 	int numtri = 0;
-	fread(&numtri, sizeof(int), 1, m_fp);
+	if (fread(&numtri, sizeof(int), 1, m_fp) != 1) return errf("Failed reading number of triangles.");
 	if (numtri <= 0) return errf("Invalid number of triangles.");
 
-	// read all the triangles
-	FACET face;
-	for (int i = 0; i < numtri; ++i)
+	// Each facet record stores the normal, the three vertices and a 2-byte attribute
+	const int FACET_SIZE = 12 * sizeof(float) + 2;
+
+	// make sure the file actually contains that many facets before we allocate
+	if (84 + (long long)numtri * FACET_SIZE > (long long)FileSize()) return errf("Invalid number of triangles.");
+
+	// allocate vertex data
+	m_vert.resize((size_t)numtri * 9);
+	const int BLOCK_SIZE = 65536;
+	std::vector<char> buf((size_t)BLOCK_SIZE * FACET_SIZE);
+	float* pv = m_vert.data();
+	for (int i0 = 0; i0 < numtri; i0 += BLOCK_SIZE)
 	{
-		// read the facet line
-		if (read_facet(face) == false) return errf("Error encountered reading triangle data.");
+		int nb = (numtri - i0 < BLOCK_SIZE ? numtri - i0 : BLOCK_SIZE);
+		if (fread(buf.data(), FACET_SIZE, nb, m_fp) != (size_t)nb) return errf("Error encountered reading triangle data.");
 
-		// add the facet to the list
-		m_Face.push_back(face);
+		// skip the normal and copy the vertices
+#pragma omp parallel for
+		for (int i = 0; i < nb; ++i)
+		{
+			const char* pf = &buf[(size_t)i * FACET_SIZE] + 3 * sizeof(float);
+			memcpy(pv + (size_t)(i0 + i) * 9, pf, 9 * sizeof(float));
+		}
 	}
 
 	// close the file
@@ -215,82 +217,135 @@ bool STLimport::read_binary(const char* szfile)
 }
 
 //-----------------------------------------------------------------------------
-// Build the FE model
-GObject* STLimport::build_mesh()
+// hash of the (single precision) coordinates of a vertex
+static unsigned int vertex_key(const float* v, unsigned int k[3])
 {
-	int i;
+	for (int i = 0; i < 3; ++i)
+	{
+		float f = v[i] + 0.0f;	// maps -0 to +0
+		memcpy(&k[i], &f, sizeof(float));
+	}
 
-	// number of facets
-	int NF = (int)m_Face.size();
-
-	// find the bounding box of the model
-	BOX& b = m_box = BoundingBox();
-	double h = 0.01*b.GetMaxExtent();
-	b.Inflate(h,h,h);
-	vec3d r0(b.x0, b.y0, b.z0);
-	vec3d r1(b.x1, b.y1, b.z1);
-
-	// create the box partition
-	int NB = m_NB = (int) pow((double) (NF*3), 0.17) + 1;
-	m_BL.resize(NB*NB*NB);
-	int n = 0;
-	for (i=0; i<NB; ++i)
-		for (int j=0; j<NB; ++j)
-			for (int k=0; k<NB; ++k)
+	unsigned int h = k[0] * 73856093u ^ k[1] * 19349663u ^ k[2] * 83492791u;
+	h ^= h >> 16; h *= 0x85ebca6bu;
+	h ^= h >> 13; h *= 0xc2b2ae35u;
+	h ^= h >> 16;
+	return h;
+}
+
+//-----------------------------------------------------------------------------
+// Vertices with identical coordinates are merged into one node. The vertices
+// are distributed over shards by their hash, and each shard is processed in 
+// parallel with its own open-addressing table. Node numbers are then assigned
+// in order of first occurrence.
+int STLimport::weld_vertices(std::vector<int>& nodeIndex)
+{
+	const int NV = (int)(m_vert.size() / 3);
+	const float* v = m_vert.data();
+
+	// calculate the vertex hashes
+	std::vector<unsigned int> hash(NV);
+#pragma omp parallel for
+	for (int i = 0; i < NV; ++i)
+	{
+		unsigned int k[3];
+		hash[i] = vertex_key(v + 3 * i, k);
+	}
+
+	// sort the vertices into shards, keeping them in order inside each shard
+	const int NS = 256;
+	std::vector<int> offset(NS + 1, 0);
+	for (int i = 0; i < NV; ++i) offset[(hash[i] % NS) + 1]++;
+	for (int i = 0; i < NS; ++i) offset[i + 1] += offset[i];
+	std::vector<int> shard(NV);
+	std::vector<int> pos(offset.begin(), offset.end() - 1);
+	for (int i = 0; i < NV; ++i) shard[pos[hash[i] % NS]++] = i;
+
+	// for each vertex, find the first vertex with the same coordinates
+	std::vector<int> first(NV);
+#pragma omp parallel for schedule(dynamic)
+	for (int s = 0; s < NS; ++s)
+	{
+		int n0 = offset[s];
+		int nv = offset[s + 1] - n0;
+		if (nv == 0) continue;
+
+		unsigned int size = 1;
+		while (size < 2 * (unsigned int)nv) size <<= 1;
+		std::vector<int> table(size, -1);
+
+		for (int j = 0; j < nv; ++j)
+		{
+			int i = shard[n0 + j];
+			unsigned int ki[3];
+			vertex_key(v + 3 * i, ki);
+
+			unsigned int h = (hash[i] / NS) & (size - 1);
+			while (true)
 			{
-				OBOX& bn = m_BL[n++];
-				bn.r0.x = r0.x + i*(r1.x - r0.x)/NB;
-				bn.r0.y = r0.x + j*(r1.x - r0.x)/NB;
-				bn.r0.z = r0.x + k*(r1.x - r0.x)/NB;
-
-				bn.r1.x = r0.x + (i+1)*(r1.x - r0.x)/NB;
-				bn.r1.y = r0.x + (j+1)*(r1.x - r0.x)/NB;
-				bn.r1.z = r0.x + (k+1)*(r1.x - r0.x)/NB;
+				int m = table[h];
+				if (m == -1) { table[h] = i; first[i] = i; break; }
+
+				unsigned int km[3];
+				vertex_key(v + 3 * m, km);
+				if ((ki[0] == km[0]) && (ki[1] == km[1]) && (ki[2] == km[2])) { first[i] = m; break; }
+
+				h = (h + 1) & (size - 1);
 			}
+		}
+	}
 
-	// reserve space for nodes
-	m_Node.reserve(NF*3);
-	
-	// create the nodes
-	list<FACET>::iterator pf = m_Face.begin();
-	int nid = 0;
-	for (i=0; i<NF; ++i, ++pf)
+	// assign node numbers
+	nodeIndex.resize(NV);
+	int NN = 0;
+	for (int i = 0; i < NV; ++i)
 	{
-		FACET& f = *pf;
-        vec3d v1 = vec3d(f.v1[0], f.v1[1], f.v1[2]); f.n[0] = find_node(v1);
-        vec3d v2 = vec3d(f.v2[0], f.v2[1], f.v2[2]); f.n[1] = find_node(v2);
-        vec3d v3 = vec3d(f.v3[0], f.v3[1], f.v3[2]); f.n[2] = find_node(v3);
-		f.nid = nid++;
+		if (first[i] == i) nodeIndex[i] = NN++;
+		else nodeIndex[i] = nodeIndex[first[i]];
 	}
-	int NN = (int)m_Node.size();
+
+	return NN;
+}
+
+//-----------------------------------------------------------------------------
+// Build the FE model
+GObject* STLimport::build_mesh()
+{
+	// number of facets
+	int NF = (int)(m_vert.size() / 9);
+	int NV = 3 * NF;
+
+	// merge the vertices
+	std::vector<int> nodeIndex;
+	int NN = weld_vertices(nodeIndex);
 
 	// create the mesh
 	FSSurfaceMesh* pm = new FSSurfaceMesh;
 	pm->Create(NN, 0, NF);
 
 	// create nodes
-	for (i=0; i<NN; ++i)
+	// (nodes are numbered in order of first occurrence)
+	const float* v = m_vert.data();
+	for (int i = 0, n = 0; i < NV; ++i)
 	{
-		vec3d& ri = m_Node[i].r;
-		FSNode& node = pm->Node(i);
-		node.pos(ri);
+		if (nodeIndex[i] == n)
+		{
+			const float* vi = v + 3 * i;
+			FSNode& node = pm->Node(n++);
+			node.pos(vec3d(vi[0], vi[1], vi[2]));
+		}
 	}
 
 	// create elements
-	list<FACET>::iterator is = m_Face.begin();
-	for (i=0; i<NF; ++i, ++is)
+#pragma omp parallel for
+	for (int i = 0; i < NF; ++i)
 	{
-		FACET& f = *is;
-		int n = f.nid;
-		if (n >= 0)
-		{
-			FSFace& face = pm->Face(n);
-			face.SetType(FE_FACE_TRI3);
-			face.m_gid = 0;
-			face.n[0] = f.n[0];
-			face.n[1] = f.n[1];
-			face.n[2] = f.n[2];
-		}
+		FSFace& face = pm->Face(i);
+		face.SetType(FE_FACE_TRI3);
+		face.m_gid = 0;
+		face.n[0] = nodeIndex[3 * i];
+		face.n[1] = nodeIndex[3 * i + 1];
+		face.n[2] = nodeIndex[3 * i + 2];
 	}
 
 	// update the mesh
@@ -299,54 +354,3 @@ GObject* STLimport::build_mesh()
 
 	return po;
 }
-
-//-----------------------------------------------------------------------------
-int STLimport::FindBox(const vec3d& r)
-{
-	BOX& b = m_box;
-	int i = (int)(m_NB*(r.x - b.x0)/(b.x1 - b.x0));
-	int j = (int)(m_NB*(r.y - b.y0)/(b.y1 - b.y0));
-	int k = (int)(m_NB*(r.z - b.z0)/(b.z1 - b.z0));
-	return k + j*(m_NB + i*m_NB);
-}
-
-//-----------------------------------------------------------------------------
-int STLimport::find_node(const vec3d& r, const double eps)
-{
-	// get the box in which this node lies
-	int nb = FindBox(r);
-	assert((nb >= 0)&&(nb<(int)m_BL.size()));
-	OBOX& b = m_BL[nb];
-
-	// see if this node is already in this box
-	int N = (int)b.NL.size();
-	for (int i=0; i<N; ++i)
-	{
-		NODE& ni = m_Node[b.NL[i]];
-		vec3d& ri = ni.r;
-		if ((ri - r)*(ri - r) < eps) return ni.n;
-	}
-
-	N = (int)m_Node.size();
-	NODE nd;
-	nd.r = r;
-	nd.n = N;
-	m_Node.push_back(nd);
-	b.NL.push_back(nd.n);
-	return nd.n;
-}
-
-//-----------------------------------------------------------------------------
-BOX STLimport::BoundingBox()
-{
-	list<FACET>::iterator pf = m_Face.begin();
-	vec3d r = vec3d(pf->v1[0], pf->v1[1], pf->v1[2]);
-	BOX b(r, r);
-	for (pf = m_Face.begin(); pf != m_Face.end(); ++pf)
-	{
-		b += vec3d(pf->v1[0], pf->v1[1], pf->v1[2]);
-		b += vec3d(pf->v2[0], pf->v2[1], pf->v2[2]);
-		b += vec3d(pf->v3[0], pf->v3[1], pf->v3[2]);
-	}
-	return b;
-}
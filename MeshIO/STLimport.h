@@ -30,41 +30,9 @@ SOFTWARE.*/
 #include <FEMLib/FSProject.h>
 
 #include <vector>
-#include <list>
 
 class STLimport : public FSFileImport
 {
-	struct FACET
-	{
-		float	norm[3];
-		float	v1[3];
-		float	v2[3];
-		float	v3[3];
-		int		n[3];
-		int		nid;
-	};
-
-	struct NODE
-	{
-		vec3d	r;
-		int		n;
-	};
-
-	class OBOX
-	{
-	public:
-		vec3d		r0, r1;		// points defining box
-		std::vector<int>	NL;			// list of nodes inside this box
-
-	public:
-		OBOX(){}
-		OBOX(const OBOX& b) 
-		{
-			r0 = b.r0; r1 = b.r1;
-			NL = b.NL; 
-		}
-	};
-
 public:
 	STLimport(FSProject& prj);
 	virtual ~STLimport(void);
@@ -75,26 +43,17 @@ protected:
 	bool read_line(char* szline, const char* sz);
 
 	GObject* build_mesh();
-	int find_node(const vec3d& r, const double eps = 1e-14);
-	int FindBox(const vec3d& r);
 
-	::BOX BoundingBox();
+	// weld the facet vertices. Returns the number of unique nodes and 
+	// fills the node index of each facet vertex.
+	int weld_vertices(std::vector<int>& nodeIndex);
 
 private:
 	bool read_ascii(const char* szfile);
 	bool read_binary(const char* szfile);
 
-private:
-	bool read_facet(FACET& f);
-
 protected:
 	FSModel*			m_pfem;
-	std::list<FACET>	m_Face;
-	std::vector<NODE>	m_Node;
+	std::vector<float>	m_vert;		// facet vertex coordinates (3 vertices x 3 floats per facet)
 	int					m_nline;	// line counter
-
-	int					m_NB;
-	std::vector<OBOX>	m_BL;		// box lists
-
-	BOX				m_box;		// bounding box
 };
@@ -28,6 +28,14 @@ SOFTWARE.*/
 #include <GeomLib/GMeshObject.h>
 #include <GeomLib/GModel.h>
 
+#ifdef WIN32
+#define fseek64 _fseeki64
+#define ftell64 _ftelli64
+#else
+#define fseek64 fseeko
+#define ftell64 ftello
+#endif
+
 #ifdef LINUX
 #include <wctype.h>
 #endif
@@ -83,9 +91,55 @@ public:
     vector<int>     m_cellcnctvty;
 };
 
+//-----------------------------------------------------------------------------
+// Binary legacy VTK files store all data in big-endian byte order.
+template <typename S, typename T> static bool read_big_endian(FILE* fp, T* v, size_t n)
+{
+	const size_t BLOCK_SIZE = 65536;
+	std::vector<S> buf(n < BLOCK_SIZE ? n : BLOCK_SIZE);
+	for (size_t i0 = 0; i0 < n; i0 += BLOCK_SIZE)
+	{
+		size_t m = (n - i0 < BLOCK_SIZE ? n - i0 : BLOCK_SIZE);
+		if (fread(buf.data(), sizeof(S), m, fp) != m) return false;
+
+#pragma omp parallel for
+		for (int i = 0; i < (int)m; ++i)
+		{
+			S s = buf[i];
+			unsigned char* b = (unsigned char*)&s;
+			for (size_t k = 0; k < sizeof(S) / 2; ++k) std::swap(b[k], b[sizeof(S) - k - 1]);
+			v[i0 + i] = (T)s;
+		}
+	}
+	return true;
+}
+
+// size (in bytes) of a legacy VTK data type (returns 0 for unknown types)
+static size_t vtk_type_size(const char* sztype)
+{
+	if (sztype == nullptr) return 0;
+	if (strncmp(sztype, "unsigned_char", 13) == 0) return 1;
+	if (strncmp(sztype, "char", 4) == 0) return 1;
+	if (strncmp(sztype, "unsigned_short", 14) == 0) return 2;
+	if (strncmp(sztype, "short", 5) == 0) return 2;
+	if (strncmp(sztype, "unsigned_int", 12) == 0) return 4;
+	if (strncmp(sztype, "int", 3) == 0) return 4;
+	if (strncmp(sztype, "vtktypeint32", 12) == 0) return 4;
+	if (strncmp(sztype, "float", 5) == 0) return 4;
+	if (strncmp(sztype, "vtktypeint64", 12) == 0) return 8;
+	if (strncmp(sztype, "unsigned_long", 13) == 0) return 8;
+	if (strncmp(sztype, "long", 4) == 0) return 8;
+	if (strncmp(sztype, "double", 6) == 0) return 8;
+	return 0;
+}
+
 VTKimport::VTKimport(FSProject& prj) : FSFileImport(prj)
 {
 	m_szline[0] = 0;
+	m_dataSetType = 0;
+	m_binary = false;
+	m_numTuples = 0;
+	m_cellData = false;
 }
 
 VTKimport::~VTKimport(void)
@@ -109,6 +163,24 @@ bool VTKimport::checkLine(const char* sz)
 	return (strncmp(m_szline, sz, strlen(sz)) == 0);
 }
 
+// read n integers of the given type from a BINARY file
+bool VTKimport::read_binary_ints(std::vector<int>& v, size_t n, const char* sztype)
+{
+	v.resize(n);
+	size_t sz = vtk_type_size(sztype);
+	if (sz == 4) return read_big_endian<int>(m_fp, v.data(), n);
+	if (sz == 8) return read_big_endian<long long>(m_fp, v.data(), n);
+	return false;
+}
+
+// skip n values of the given type in a BINARY file
+bool VTKimport::skip_binary(size_t n, const char* sztype)
+{
+	size_t sz = vtk_type_size(sztype);
+	if (sz == 0) return false;
+	return (fseek64(m_fp, (long long)(n * sz), SEEK_CUR) == 0);
+}
+
 int VTKimport::parseLine(std::vector<std::string>& str)
 {
 	str.clear();
@@ -139,7 +211,8 @@ int VTKimport::parseLine(std::vector<std::string>& str)
 
 bool VTKimport::Load(const char* szfile)
 {
-	if (!Open(szfile, "rt")) return errf("Failed opening file %s.", szfile);
+	// (opened in binary mode, since BINARY files mix text and data)
+	if (!Open(szfile, "rb")) return errf("Failed opening file %s.", szfile);
 
 	// read the first line 
 	if (nextLine() == false) return errf("Unexpected end of file.");
@@ -148,9 +221,11 @@ bool VTKimport::Load(const char* szfile)
 	// next line is info, so can be skipped
 	if (nextLine() == false) return errf("Unexpected end of file.");
 
-	// next line must be ASCII
+	// next line must be ASCII or BINARY
 	if (nextLine() == false) return errf("Unexpected end of file.");
-	if (checkLine("ASCII") == false) return errf("Only ASCII VTK files are supported.");
+	if (checkLine("ASCII")) m_binary = false;
+	else if (checkLine("BINARY")) m_binary = true;
+	else return errf("Only ASCII and BINARY VTK files are supported.");
 
 	// read the DATASET line
 	if (nextLine() == false) return errf("Unexpected end of file.");
@@ -199,6 +274,14 @@ bool VTKimport::Load(const char* szfile)
 		{
 			if (read_FIELD(vtk) == false)  return false;
 		}
+		else if (checkLine("SCALARS"))
+		{
+			if (read_SCALARS(vtk) == false)  return false;
+		}
+		else if (checkLine("VECTORS") || checkLine("TENSORS") || checkLine("COLOR_SCALARS") || checkLine("TEXTURE_COORDINATES") || checkLine("LOOKUP_TABLE"))
+		{
+			if (skip_attribute() == false)  return false;
+		}
 	}
 	while (nextLine());
 
@@ -221,6 +304,17 @@ bool VTKimport::read_POINTS(VTKMesh& vtk)
 
 	vtk.m_nodeList.resize(nodes);
 
+	if (m_binary)
+	{
+		// read directly into the node list
+		double* r = vtk.m_nodeList[0].r;
+		bool bok = false;
+		if (strstr(m_szline, "double")) bok = read_big_endian<double>(m_fp, r, 3 * (size_t)nodes);
+		else bok = read_big_endian<float>(m_fp, r, 3 * (size_t)nodes);
+		if (bok == false) return errf("An error occured while reading the nodal coordinates.");
+		return true;
+	}
+
 	// read the nodes
 	double temp[9];
 	int nodesRead = 0;
@@ -260,6 +354,24 @@ bool VTKimport::read_POLYGONS(VTKMesh& vtk)
 	sscanf(m_szline + 8, "%d %d", &elems, &size);
 	vtk.m_cellList.resize(elems);
 
+	if (m_binary)
+	{
+		std::vector<int> data;
+		if (read_binary_ints(data, size, "int") == false) return errf("An error occured while reading the POLYGONS section.");
+		for (int i = 0, n = 0; i < elems; ++i)
+		{
+			VTKMesh::CELL& cell = vtk.m_cellList[i];
+			if (n >= size) return errf("An error occured while reading the POLYGONS section.");
+			int numNodes = data[n++];
+			if ((numNodes < 3) || (numNodes > 4) || (n + numNodes > size)) return errf("Invalid polygon type.");
+			for (int j = 0; j < numNodes; ++j) cell.node[j] = data[n++];
+			cell.numNodes = numNodes;
+			cell.label = 1;
+			cell.cellType = (numNodes == 3 ? VTK_TRIANGLE : VTK_QUAD);
+		}
+		return true;
+	}
+
 	for (int i = 0; i < elems; ++i)
 	{
 		VTKMesh::CELL& cell = vtk.m_cellList[i];
@@ -287,6 +399,61 @@ bool VTKimport::read_CELLS(VTKMesh& vtk)
 	sscanf(m_szline + 5, "%d %d", &elems, &size);
 	if (elems == 0) return errf("Invalid number of cells in CELLS section.");
 
+	if (m_binary)
+	{
+		// the data either follows immediately (legacy format) or 
+		// is split in an OFFSETS and CONNECTIVITY array (version 5.1)
+		long long pos = ftell64(m_fp);
+		char szbuf[8] = { 0 };
+		bool newFormat = ((fread(szbuf, 1, 7, m_fp) == 7) && (strncmp(szbuf, "OFFSETS", 7) == 0));
+		fseek64(m_fp, pos, SEEK_SET);
+
+		if (newFormat)
+		{
+			if (nextLine() == false) return errf("An unexpected error occured while reading the file data.");
+			if (read_binary_ints(vtk.m_celloffsets, elems, m_szline + 8) == false) return errf("An error occured while reading the cell offsets.");
+
+			if ((nextLine() == false) || (checkLine("CONNECTIVITY") == false))
+				return errf("An error occured due to missing or incorrect cell connectivity data.");
+			if (read_binary_ints(vtk.m_cellcnctvty, size, m_szline + 13) == false) return errf("An error occured while reading the cell connectivity.");
+
+			// (there is one more offset than there are cells)
+			elems--;
+			vtk.m_cellList.resize(elems);
+#pragma omp parallel for
+			for (int i = 0; i < elems; ++i)
+			{
+				VTKMesh::CELL& cell = vtk.m_cellList[i];
+				int n0 = vtk.m_celloffsets[i];
+				int numNodes = vtk.m_celloffsets[i + 1] - n0;
+				if ((numNodes < 0) || (numNodes > FSElement::MAX_NODES) || (n0 + numNodes > size)) numNodes = 0;
+				for (int j = 0; j < numNodes; ++j) cell.node[j] = vtk.m_cellcnctvty[n0 + j];
+				cell.numNodes = numNodes;
+				cell.cellType = VTK_INVALID; // must be determined by CELL_TYPES
+				cell.label = 1;
+			}
+		}
+		else
+		{
+			std::vector<int> data;
+			if (read_binary_ints(data, size, "int") == false) return errf("An error occured while reading the CELLS section.");
+
+			vtk.m_cellList.resize(elems);
+			for (int i = 0, n = 0; i < elems; ++i)
+			{
+				VTKMesh::CELL& cell = vtk.m_cellList[i];
+				if (n >= size) return errf("An error occured while reading the CELLS section.");
+				int numNodes = data[n++];
+				if ((numNodes < 0) || (numNodes > FSElement::MAX_NODES) || (n + numNodes > size)) return errf("Invalid number of nodes in CELLS section.");
+				for (int j = 0; j < numNodes; ++j) cell.node[j] = data[n++];
+				cell.numNodes = numNodes;
+				cell.cellType = VTK_INVALID; // must be determined by CELL_TYPES
+				cell.label = 1;
+			}
+		}
+		return true;
+	}
+
     // check for cell offsets
     if (nextLine() == false) return errf("An unexpected error occured while reading the file data.");
     
@@ -382,11 +549,19 @@ bool VTKimport::read_CELL_TYPES(VTKMesh& vtk)
 	int elems = atoi(m_szline + 10);
 	if (elems != vtk.m_cellList.size()) return errf("Incorrect number of cells in CELL_TYPES.");
 
+	std::vector<int> types;
+	if (m_binary && (read_binary_ints(types, elems, "int") == false)) return errf("An error occured while reading the CELL_TYPES section.");
+
 	for (int i = 0; i < elems; ++i)
 	{
 		VTKMesh::CELL& cell = vtk.m_cellList[i];
-		if (nextLine() == false) return errf("An unexpected error occured while reading the file data.");
-		int n = atoi(m_szline);
+		int n = 0;
+		if (m_binary) n = types[i];
+		else
+		{
+			if (nextLine() == false) return errf("An unexpected error occured while reading the file data.");
+			n = atoi(m_szline);
+		}
 		switch (n)
 		{
 		case VTK_TETRA     : cell.cellType = VTK_TETRA; break;
@@ -409,6 +584,10 @@ bool VTKimport::read_POINT_DATA(VTKMesh& vtkMesh)
 	int nodes = atoi(m_szline + 10);
 	if (nodes != vtkMesh.nodes()) return errf("Incorrect number of nodes specified in POINT_DATA.");
 
+	// the attributes that follow are defined on the nodes
+	m_numTuples = nodes;
+	m_cellData = false;
+
 	return true;
 }
 
@@ -419,44 +598,87 @@ bool VTKimport::read_CELL_DATA(VTKMesh& vtkMesh)
 	int cells = atoi(m_szline + 10);
 	if (cells != vtkMesh.cells()) return errf("Incorrect number of cells specified in CELL_DATA.");
 
+	// the attributes that follow are defined on the cells
+	m_numTuples = cells;
+	m_cellData = true;
+
+	return true;
+}
+
+// SCALARS dataName dataType [numComp]
+// Integer cell scalars are read as element labels. Everything else is skipped.
+bool VTKimport::read_SCALARS(VTKMesh& vtkMesh)
+{
+	vector<string> att;
+	int nread = parseLine(att);
+	if (nread < 3) return errf("Invalid SCALARS definition.");
+	int numComp = (nread > 3 ? atoi(att[3].c_str()) : 1);
+	if (numComp <= 0) return errf("Invalid number of components in SCALARS definition.");
+
+	// the LOOKUP_TABLE line is optional
+	long long pos = ftell64(m_fp);
 	if (nextLine() == false) return errf("An unexpected error occured while reading the file data.");
-	if (strncmp(m_szline, "SCALARS", 7) == 0)
+	if (checkLine("LOOKUP_TABLE") == false) fseek64(m_fp, pos, SEEK_SET);
+
+	int cells = m_numTuples;
+	if (m_cellData && (att[2] == "int") && (numComp == 1))
 	{
-		vector<string> att;
-		parseLine(att);
-		if (att[2] == "int")
+		if (m_binary)
 		{
-			if (nextLine() == false) return errf("An unexpected error occured while reading the file data.");
-			if (strncmp(m_szline, "LOOKUP_TABLE", 12) == 0)
-			{
-                // read the offsets
-                int temp[9];
-                int idsRead = 0;
-                while (idsRead < cells)
-                {
-                    if (nextLine() == false) return errf("An unexpected error occured while reading the file data.");
-                    
-                    // There can be up to 9 offsets defined per line
-                    int nread = sscanf(m_szline, "%d%d%d%d%d%d%d%d%d", &temp[0], &temp[1], &temp[2], &temp[3], &temp[4], &temp[5], &temp[6], &temp[7], &temp[8]);
-                    if (nread > 9)
-                        return errf("An error occured while reading the nodal coordinates.");
-                    
-                    for (int j = 0; j < nread; ++j) {
-                        VTKMesh::CELL& cell = vtkMesh.m_cellList[idsRead+j];
-                        cell.label = temp[j];
-                    }
-                    
-                    idsRead += nread;
+			std::vector<int> ids;
+			if (read_binary_ints(ids, cells, "int") == false) return errf("An unexpected error occured while reading the file data.");
+			for (int i = 0; i < cells; ++i) vtkMesh.m_cellList[i].label = ids[i];
+		}
+		else
+		{
+            // read the offsets
+            int temp[9];
+            int idsRead = 0;
+            while (idsRead < cells)
+            {
+                if (nextLine() == false) return errf("An unexpected error occured while reading the file data.");
+                
+                // There can be up to 9 offsets defined per line
+                int nread = sscanf(m_szline, "%d%d%d%d%d%d%d%d%d", &temp[0], &temp[1], &temp[2], &temp[3], &temp[4], &temp[5], &temp[6], &temp[7], &temp[8]);
+                if ((nread <= 0) || (idsRead + nread > cells))
+                    return errf("An error occured while reading the cell labels.");
+                
+                for (int j = 0; j < nread; ++j) {
+                    VTKMesh::CELL& cell = vtkMesh.m_cellList[idsRead+j];
+                    cell.label = temp[j];
                 }
-                assert(idsRead == cells);
                 
-			}
+                idsRead += nread;
+            }
+            assert(idsRead == cells);
 		}
 	}
+	else if (m_binary)
+	{
+		if (skip_binary((size_t)numComp*m_numTuples, att[2].c_str()) == false) return errf("Unsupported data type \"%s\" in SCALARS section.", att[2].c_str());
+	}
 
 	return true;
 }
 
+// Skip the data of a dataset attribute we don't process. ASCII data lines are
+// ignored by the keyword parser, but BINARY data has to be skipped explicitly.
+bool VTKimport::skip_attribute()
+{
+	if (m_binary == false) return true;
+
+	vector<string> att;
+	int nread = parseLine(att);
+	const string& key = att[0];
+	size_t n = (size_t)m_numTuples;
+	if ((key == "VECTORS") && (nread >= 3)) return skip_binary(3 * n, att[2].c_str()) || errf("Unsupported data type \"%s\" in VECTORS section.", att[2].c_str());
+	if ((key == "TENSORS") && (nread >= 3)) return skip_binary(9 * n, att[2].c_str()) || errf("Unsupported data type \"%s\" in TENSORS section.", att[2].c_str());
+	if ((key == "TEXTURE_COORDINATES") && (nread >= 4)) return skip_binary(atoi(att[2].c_str()) * n, att[3].c_str()) || errf("Unsupported data type \"%s\" in TEXTURE_COORDINATES section.", att[3].c_str());
+	if ((key == "COLOR_SCALARS") && (nread >= 3)) return skip_binary(atoi(att[2].c_str()) * n, "unsigned_char") || errf("An unexpected error occured while reading the file data.");
+	if ((key == "LOOKUP_TABLE") && (nread >= 3)) return skip_binary(4 * (size_t)atoi(att[2].c_str()), "unsigned_char") || errf("An unexpected error occured while reading the file data.");
+	return errf("Invalid %s definition.", key.c_str());
+}
+
 bool VTKimport::read_NORMALS(VTKMesh& vtkMesh)
 {
 	vector<string> att;
@@ -465,7 +687,13 @@ bool VTKimport::read_NORMALS(VTKMesh& vtkMesh)
 
 	if ((nread == 3) && (att[2] != "float")) return errf("Only floats supported in NORMALS");
 
-	int nodes = vtkMesh.nodes();
+	int nodes = (m_numTuples > 0 ? m_numTuples : vtkMesh.nodes());
+	if (m_binary)
+	{
+		if (skip_binary(3 * (size_t)nodes, "float") == false) return errf("An unexpected error occured while reading the file data.");
+		return true;
+	}
+
 	int lines = nodes / 3;
 	if ((nodes % 3) != 0) lines++;
 	for (int i = 0; i < lines; ++i)
@@ -497,6 +725,21 @@ bool VTKimport::read_FIELD(VTKMesh& vtkMesh)
 
 		bool isLabels = ((att[0] == "labels") && (numComp == 1) && (numTuples == vtkMesh.cells()));
 
+		if (m_binary)
+		{
+			if (nread < 4) return errf("Missing data type in field definition.");
+			const char* sztype = att[3].c_str();
+			size_t nsize = (size_t)numComp*numTuples;
+			if (isLabels && (vtk_type_size(sztype) == 4) && (strncmp(sztype, "float", 5) != 0))
+			{
+				std::vector<int> labels;
+				if (read_binary_ints(labels, nsize, sztype) == false) return errf("An unexpected error occured while reading the file data.");
+				for (size_t i = 0; i < nsize; ++i) vtkMesh.m_cellList[i].label = labels[i];
+			}
+			else if (skip_binary(nsize, sztype) == false) return errf("An unexpected error occured while reading the file data.");
+			continue;
+		}
+
 		double v[9];
 		int nsize = numComp*numTuples;
 		int nreadTotal = 0;
@@ -531,6 +774,7 @@ bool VTKimport::BuildMesh(VTKMesh& vtk)
 	pm->Create(nodes, elems);
 
 	// copy nodal data
+#pragma omp parallel for
 	for (int i = 0; i < nodes; ++i)
 	{
 		FSNode& node = pm->Node(i);
@@ -539,6 +783,8 @@ bool VTKimport::BuildMesh(VTKMesh& vtk)
 	}
 
 	// copy element data
+	bool bok = true;
+#pragma omp parallel for shared(bok)
 	for (int i = 0; i < elems; ++i)
 	{
 		FSElement& el = pm->Element(i);
@@ -556,14 +802,19 @@ bool VTKimport::BuildMesh(VTKMesh& vtk)
 		case VTK_WEDGE     : el.SetType(FE_PENTA6); break;
 		case VTK_PYRAMID   : el.SetType(FE_PYRA5 ); break;
 		default:
-			delete pm;
-			return errf("Error trying to build mesh");
+			bok = false;
+			continue;
 		}
 
 		int nn = el.Nodes();
 		assert(nn == cell.numNodes);
 		for (int j = 0; j < nn; ++j) el.m_node[j] = cell.node[j];
 	}
+	if (bok == false)
+	{
+		delete pm;
+		return errf("Error trying to build mesh");
+	}
 
 	pm->RebuildMesh();
 	GMeshObject* po = new GMeshObject(pm);
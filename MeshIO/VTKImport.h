@@ -53,6 +53,8 @@ private:
 	bool read_CELL_DATA(VTKMesh& vtkMesh);
 	bool read_NORMALS(VTKMesh& vtkMesh);
 	bool read_FIELD(VTKMesh& vtkMesh);
+	bool read_SCALARS(VTKMesh& vtkMesh);
+	bool skip_attribute();
 
 	bool BuildMesh(VTKMesh& vtkMesh);
 
@@ -60,7 +62,14 @@ private:
 
 	int parseLine(std::vector<std::string>& str);
 
+	// helpers for BINARY files
+	bool read_binary_ints(std::vector<int>& v, size_t n, const char* sztype);
+	bool skip_binary(size_t n, const char* sztype);
+
 private:
 	char	m_szline[256];
 	int		m_dataSetType;
+	bool	m_binary;	// BINARY (instead of ASCII) data
+	int		m_numTuples;	// number of tuples in the current POINT_DATA or CELL_DATA section
+	bool	m_cellData;		// true if the current section is CELL_DATA
 };
@@ -28,6 +28,16 @@ SOFTWARE.*/
 #include <GeomLib/GMeshObject.h>
 #include <GeomLib/GModel.h>
 #include <XML/XMLReader.h>
+#include <algorithm>
+#include <cstdint>
+
+#ifdef WIN32
+#define fseek64 _fseeki64
+#define ftell64 _ftelli64
+#else
+#define fseek64 fseeko
+#define ftell64 ftello
+#endif
 #ifdef HAVE_ZLIB
 #include <zlib.h>
 
@@ -133,7 +143,8 @@ public:
 		UINT8,
 		INT32,
 		INT64,
-		FLOAT32
+		FLOAT32,
+		FLOAT64
 	};
 
 	enum Format
@@ -164,7 +175,9 @@ public:
 	{
 		switch (m_type)
 		{
-		case FLOAT32: return (m_values_float.size() / m_numComps); break;
+		case FLOAT32:
+		case FLOAT64:
+			return (m_values_float.size() / m_numComps); break;
 		case UINT8:
 		case INT32:
 		case INT64:
@@ -182,6 +195,9 @@ public:
 	void get(int n, double* v) const { *v = m_values_float[n]; }
 	void get(int n, int*    v) const { *v = m_values_int[n]; }
 
+	// set the values from a buffer of (unaligned) binary data
+	bool setValues(const unsigned char* d, size_t bytes, bool swapBytes);
+
 public:
 	int	m_type;
 	int m_format;
@@ -293,6 +309,7 @@ public:
 				assert(false);
 			}
 			int m = cell.m_numNodes;
+			if ((m < 0) || (m > VTKCell::MAX_NODES)) { cell.m_numNodes = 0; return cell; }
 			for (int i = 0; i < m; ++i)
 			{
 				cell.m_node[i] = m_cell_connect.m_values_int[n0 + i];
@@ -306,6 +323,7 @@ public:
 			int n1 = m_cell_offsets.m_values_int[n];
 			cell.m_numNodes = n1 - n0;
 			int m = cell.m_numNodes;
+			if ((m < 0) || (m > VTKCell::MAX_NODES)) { cell.m_numNodes = 0; return cell; }
 			for (int i = 0; i < m; ++i)
 			{
 				cell.m_node[i] = m_cell_connect.m_values_int[n0 + i];
@@ -329,6 +347,8 @@ public:
 class VTKAppendedData
 {
 public:
+	VTKAppendedData() { m_raw = false; }
+
 	void SetData(const char* szdata)
 	{
 		m_data = szdata;
@@ -339,10 +359,61 @@ public:
 		return m_data.data() + offset;
 	}
 
+	// raw appended data is read directly from the file (see VTKFileReader::ReadRawAppendedData)
+	void SetRaw(bool b) { m_raw = b; }
+	bool IsRaw() const { return m_raw; }
+
+	bool IsEmpty() const { return m_data.empty() && m_bytes.empty(); }
+
+	std::vector<unsigned char>& RawData() { return m_bytes; }
+
+	// returns a pointer to the raw data at the offset, and the number of bytes available from there
+	const unsigned char* GetRawData(size_t offset, size_t& bytes) const
+	{
+		if (offset >= m_bytes.size()) { bytes = 0; return nullptr; }
+		bytes = m_bytes.size() - offset;
+		return m_bytes.data() + offset;
+	}
+
 private:
+	bool		m_raw;
 	std::string	m_data;
+	std::vector<unsigned char>	m_bytes;
 };
 
+//=================================================================
+// converts n (unaligned) values of type S to type T
+template <typename S, typename T> static void convert_raw(const unsigned char* src, size_t n, T* dst, bool swapBytes)
+{
+#pragma omp parallel for
+	for (int i = 0; i < (int)n; ++i)
+	{
+		S s;
+		memcpy(&s, src + i * sizeof(S), sizeof(S));
+		if (swapBytes)
+		{
+			unsigned char* b = (unsigned char*)&s;
+			for (size_t k = 0; k < sizeof(S) / 2; ++k) std::swap(b[k], b[sizeof(S) - k - 1]);
+		}
+		dst[i] = (T)s;
+	}
+}
+
+bool VTKDataArray::setValues(const unsigned char* d, size_t bytes, bool swapBytes)
+{
+	switch (m_type)
+	{
+	case UINT8  : m_values_int.resize(bytes); convert_raw<unsigned char>(d, bytes, m_values_int.data(), false); break;
+	case INT32  : m_values_int.resize(bytes / 4); convert_raw<int>(d, bytes / 4, m_values_int.data(), swapBytes); break;
+	case INT64  : m_values_int.resize(bytes / 8); convert_raw<long long>(d, bytes / 8, m_values_int.data(), swapBytes); break;
+	case FLOAT32: m_values_float.resize(bytes / 4); convert_raw<float>(d, bytes / 4, m_values_float.data(), swapBytes); break;
+	case FLOAT64: m_values_float.resize(bytes / 8); convert_raw<double>(d, bytes / 8, m_values_float.data(), swapBytes); break;
+	default:
+		return false;
+	}
+	return true;
+}
+
 //=================================================================
 class VTKModel
 {
@@ -439,10 +510,97 @@ private:
 	std::vector<unsigned char>	m_bytes;
 };
 
+size_t VTKFileReader::ReadHeaderValue(const unsigned char* p) const
+{
+	size_t v = 0;
+	bool swapBytes = (m_byteOrder == BigEndian);
+	if (m_headerType == UInt64) { unsigned long long n; convert_raw<unsigned long long>(p, 1, &n, swapBytes); v = (size_t)n; }
+	else { unsigned int n; convert_raw<unsigned int>(p, 1, &n, swapBytes); v = n; }
+	return v;
+}
+
+// Decompress zlib compressed data. The data is stored in blocks that are
+// compressed independently, so we can inflate them in parallel.
+// The header is: [#blocks][block size][last block size][compressed block sizes]
+bool VTKFileReader::DecompressBlocks(const unsigned char* src, size_t bytes, std::vector<unsigned char>& out)
+{
+#ifdef HAVE_ZLIB
+	size_t hsize = (m_headerType == UInt64 ? 8 : 4);
+	if (bytes < 3 * hsize) return false;
+	size_t nblocks   = ReadHeaderValue(src);
+	size_t blockSize = ReadHeaderValue(src + hsize);
+	size_t lastSize  = ReadHeaderValue(src + 2 * hsize);
+	if (nblocks > (bytes - 3*hsize) / hsize) return false;
+	if (nblocks == 0) { out.clear(); return true; }
+
+	// get the offsets of the compressed blocks
+	const unsigned char* data = src + (3 + nblocks) * hsize;
+	size_t avail = bytes - (3 + nblocks) * hsize;
+	std::vector<size_t> offset(nblocks + 1, 0);
+	for (size_t i = 0; i < nblocks; ++i)
+	{
+		offset[i + 1] = offset[i] + ReadHeaderValue(src + (3 + i) * hsize);
+		if (offset[i + 1] > avail) return false;
+	}
+
+	// (a last block size of zero means the last block is full)
+	if (lastSize == 0) lastSize = blockSize;
+	if ((blockSize == 0) || (lastSize > blockSize)) return false;
+
+	// zlib cannot expand data by more than about a factor 1032, so use that
+	// to reject corrupt block sizes before allocating the output buffer.
+	const size_t maxRatio = 1032;
+	for (size_t i = 0; i < nblocks; ++i)
+	{
+		size_t csize = offset[i + 1] - offset[i];
+		size_t usize = (i == nblocks - 1 ? lastSize : blockSize);
+		if (usize / maxRatio > csize) return false;
+	}
+	if (nblocks - 1 > (SIZE_MAX - lastSize) / blockSize) return false;
+	out.resize((nblocks - 1) * blockSize + lastSize);
+
+	bool bok = true;
+#pragma omp parallel for shared(bok)
+	for (int i = 0; i < (int)nblocks; ++i)
+	{
+		uLongf expected = (uLongf)(i == (int)nblocks - 1 ? lastSize : blockSize);
+		uLongf outSize = expected;
+		int ret = uncompress(out.data() + i * blockSize, &outSize, data + offset[i], (uLong)(offset[i + 1] - offset[i]));
+		if ((ret != Z_OK) || (outSize != expected)) bok = false;
+	}
+	return bok;
+#else
+	return errf("This build does not support zlib compressed data.");
+#endif
+}
+
 bool VTKFileReader::ProcessProcessDataArray(VTKDataArray& ar, VTKAppendedData& data)
 {
 	if (ar.m_format != VTKDataArray::APPENDED) return true;
 
+	if (data.IsRaw())
+	{
+		size_t hsize = (m_headerType == UInt64 ? 8 : 4);
+		size_t avail = 0;
+		const unsigned char* buf = data.GetRawData(ar.m_offset, avail);
+		if ((buf == nullptr) || (avail < hsize)) return errf("Invalid offset in appended data.");
+
+		bool swapBytes = (m_byteOrder == BigEndian);
+		if (m_compressor == ZLibCompression)
+		{
+			std::vector<unsigned char> tmp;
+			if (DecompressBlocks(buf, avail, tmp) == false) return errf("Failed decompressing appended data.");
+			return ar.setValues(tmp.data(), tmp.size(), swapBytes);
+		}
+		else
+		{
+			// the header stores the size of the array (in bytes)
+			size_t bytes = ReadHeaderValue(buf);
+			if (bytes > avail - hsize) return errf("Invalid size of appended data array.");
+			return ar.setValues(buf + hsize, bytes, swapBytes);
+		}
+	}
+
 	// get the buffer at the offset
 	const char* buf = data.GetData(ar.m_offset);
 
@@ -525,7 +683,92 @@ bool VTKFileReader::ProcessDataArrays(VTKModel& vtk, VTKAppendedData& data)
 		if (ProcessProcessDataArray(piece.m_cell_offsets, data) == false) return false;
 		if (ProcessProcessDataArray(piece.m_cell_connect, data) == false) return false;
 		if (ProcessProcessDataArray(piece.m_cell_types  , data) == false) return false;
+
+		if (!piece.m_cell_types.m_values_int.empty() && (piece.m_cell_types.m_values_int.size() != piece.m_numCells)) return errf("Error reading cell types");
+	}
+
+	return true;
+}
+
+// Get the value of an attribute from the text of a tag (e.g. <AppendedData encoding="raw">).
+// Values can be enclosed in single or double quotes.
+static std::string GetTagAttribute(const std::string& stag, const char* szatt)
+{
+	const size_t l = strlen(szatt);
+	size_t pos = 0;
+	while ((pos = stag.find(szatt, pos)) != std::string::npos)
+	{
+		// make sure we matched the whole attribute name
+		size_t i = pos + l;
+		if ((pos > 0) && (isspace((unsigned char)stag[pos - 1]) == 0)) { pos = i; continue; }
+		while ((i < stag.size()) && isspace((unsigned char)stag[i])) i++;
+		if ((i >= stag.size()) || (stag[i] != '=')) { pos = i; continue; }
+		i++;
+		while ((i < stag.size()) && isspace((unsigned char)stag[i])) i++;
+		if ((i >= stag.size()) || ((stag[i] != '"') && (stag[i] != '\''))) return "";
+		char q = stag[i++];
+		size_t j = stag.find(q, i);
+		if (j == std::string::npos) return "";
+		return stag.substr(i, j - i);
+	}
+	return "";
+}
+
+// Raw appended data is binary and cannot be processed by the xml reader, 
+// so we read it directly from the file. The data starts after the '_' 
+// character that follows the AppendedData tag and is read in one block.
+bool VTKFileReader::ReadRawAppendedData(const char* szfile, VTKAppendedData& data)
+{
+	FILE* fp = fopen(szfile, "rb");
+	if (fp == nullptr) return errf("Failed opening file %s.", szfile);
+
+	// find the AppendedData tag
+	const char* sztag = "<AppendedData";
+	const size_t l = strlen(sztag);
+	const size_t BUF_SIZE = 1 << 20;
+	std::vector<char> buf(BUF_SIZE + l);
+	long long pos = -1;
+	long long filePos = 0;
+	size_t keep = 0;
+	while (pos < 0)
+	{
+		size_t nread = fread(buf.data() + keep, 1, BUF_SIZE, fp);
+		if (nread == 0) break;
+		size_t n = keep + nread;
+		char* c = std::search(buf.data(), buf.data() + n, sztag, sztag + l);
+		if (c != buf.data() + n) pos = filePos - (long long)keep + (c - buf.data());
+		else
+		{
+			// keep the tail, in case the tag straddles two blocks
+			keep = (n < l ? n : l);
+			memmove(buf.data(), buf.data() + n - keep, keep);
+		}
+		filePos += nread;
 	}
+	if (pos < 0) { fclose(fp); return true; }
+
+	// read the tag's attributes
+	fseek64(fp, pos, SEEK_SET);
+	std::string stag;
+	int ch = 0;
+	while (((ch = fgetc(fp)) != EOF) && (ch != '>')) stag += (char)ch;
+	if (GetTagAttribute(stag, "encoding") != "raw") { fclose(fp); return true; }
+
+	// the data starts after the underscore
+	while (((ch = fgetc(fp)) != EOF) && (ch != '_'));
+	if (ch == EOF) { fclose(fp); return errf("invalid formatting of AppendData"); }
+
+	long long start = ftell64(fp);
+	fseek64(fp, 0, SEEK_END);
+	long long end = ftell64(fp);
+	fseek64(fp, start, SEEK_SET);
+
+	std::vector<unsigned char>& bytes = data.RawData();
+	bytes.resize((size_t)(end - start));
+	size_t nread = fread(bytes.data(), 1, bytes.size(), fp);
+	fclose(fp);
+	if (nread != bytes.size()) return errf("Failed reading appended data.");
+	data.SetRaw(true);
 
 	return true;
 }
@@ -549,6 +792,7 @@ bool VTUimport::Load(const char* szfile)
 
 	VTKModel vtk;
 	VTKAppendedData data;
+	bool readRaw = false;
 
 	// parse the file
 	try {
@@ -562,6 +806,7 @@ bool VTUimport::Load(const char* szfile)
 			else if (tag == "AppendedData")
 			{
 				if (ParseAppendedData(tag, data) == false) return false;
+				readRaw = data.IsRaw();
 			}
 			else return false;
 			++tag;
@@ -569,10 +814,14 @@ bool VTUimport::Load(const char* szfile)
 	}
 	catch (...)
 	{
-
+		// the xml reader may have failed on raw binary data
+		readRaw = true;
 	}
 	xml.Close();
 
+	// read raw appended data
+	if (readRaw && (ReadRawAppendedData(szfile, data) == false)) return false;
+
 	// process the appended arrays
 	if (ProcessDataArrays(vtk, data) == false) return false;
 
@@ -598,6 +847,7 @@ bool VTPimport::Load(const char* szfile)
 
 	VTKModel vtk;
 	VTKAppendedData data;
+	bool readRaw = false;
 
 	// parse the file
 	try {
@@ -611,6 +861,7 @@ bool VTPimport::Load(const char* szfile)
 			else if (tag == "AppendedData")
 			{
 				if (ParseAppendedData(tag, data) == false) return false;
+				readRaw = data.IsRaw();
 			}
 			else return false;
 			++tag;
@@ -618,11 +869,15 @@ bool VTPimport::Load(const char* szfile)
 	}
 	catch (...)
 	{
-
+		// the xml reader may have failed on raw binary data
+		readRaw = true;
 	}
 
 	xml.Close();
 
+	// read raw appended data
+	if (readRaw && (ReadRawAppendedData(szfile, data) == false)) return false;
+
 	// process the appended arrays
 	if (ProcessDataArrays(vtk, data) == false) return false;
 
@@ -703,7 +958,7 @@ bool VTKFileReader::ParsePoints(XMLTag& tag, VTKPiece& piece)
 			VTKDataArray& points = piece.m_points;
 			if (ParseDataArray(tag, points) == false) return false;
 
-			if (points.m_type != VTKDataArray::FLOAT32) return false;
+			if ((points.m_type != VTKDataArray::FLOAT32) && (points.m_type != VTKDataArray::FLOAT64)) return false;
 			if (points.m_numComps != 3) return false;
 		}
 		else tag.skip();
@@ -733,7 +988,6 @@ bool VTKFileReader::ParseCells(XMLTag& tag, VTKPiece& piece)
 			else if (strcmp(szname, "types") == 0)
 			{
 				if (ParseDataArray(tag, piece.m_cell_types) == false) return false;
-				if (piece.m_cell_types.m_values_int.size() != piece.m_numCells) return errf("Error reading cell types");
 			}
 		}
 		else tag.skip();
@@ -790,7 +1044,8 @@ bool VTKFileReader::ParseDataArray(XMLTag& tag, VTKDataArray& vtkDataArray)
 	if      (strcmp(sztype, "Float32") == 0) vtkDataArray.m_type = VTKDataArray::FLOAT32;
 	else if (strcmp(sztype, "UInt8"  ) == 0) vtkDataArray.m_type = VTKDataArray::UINT8;
 	else if (strcmp(sztype, "Int64"  ) == 0) vtkDataArray.m_type = VTKDataArray::INT64;
-	else if (strcmp(sztype, "Int32"  ) == 0) vtkDataArray.m_type = VTKDataArray::INT64;
+	else if (strcmp(sztype, "Int32"  ) == 0) vtkDataArray.m_type = VTKDataArray::INT32;
+	else if (strcmp(sztype, "Float64") == 0) vtkDataArray.m_type = VTKDataArray::FLOAT64;
 	else return errf("Unknown data array type %s", sztype);
 
 	// get the number of components
@@ -799,7 +1054,7 @@ bool VTKFileReader::ParseDataArray(XMLTag& tag, VTKDataArray& vtkDataArray)
 	// get the value
 	if (vtkDataArray.m_format == VTKDataArray::ASCII)
 	{
-		if (vtkDataArray.m_type == VTKDataArray::FLOAT32)
+		if ((vtkDataArray.m_type == VTKDataArray::FLOAT32) || (vtkDataArray.m_type == VTKDataArray::FLOAT64))
 		{
 			tag.value(vtkDataArray.m_values_float);
 		}
@@ -843,40 +1098,8 @@ bool VTKFileReader::ParseDataArray(XMLTag& tag, VTKDataArray& vtkDataArray)
 		n -= headerSize;
 
 		// process array
-		if (vtkDataArray.m_type == VTKDataArray::FLOAT32)
-		{
-			std::vector<double>& v = vtkDataArray.m_values_float;
-			size_t m = n / 4;
-			v.resize(m);
-			for (int i = 0; i < m; ++i)
-			{
-				v[i] = *((float*)d);
-				d += 4;
-			}
-		}
-		else if (vtkDataArray.m_type == VTKDataArray::INT32)
-		{
-			std::vector<int>& v = vtkDataArray.m_values_int;
-			size_t m = n / 4;
-			v.resize(m);
-			for (int i = 0; i < m; ++i)
-			{
-				v[i] = *((int*)d);
-				d += 4;
-			}
-		}
-		else if (vtkDataArray.m_type == VTKDataArray::INT64)
-		{
-			std::vector<int>& v = vtkDataArray.m_values_int;
-			size_t m = n / 8;
-			v.resize(m);
-			for (int i = 0; i < m; ++i)
-			{
-				v[i] = *((int*)d);
-				d += 8;
-			}
-		}
-		else return false;
+		if (n < 0) return false;
+		if (vtkDataArray.setValues(d, n, (m_byteOrder == BigEndian)) == false) return false;
 	}
 
 	// There can be children, so we need to skip this tag
@@ -902,13 +1125,18 @@ bool VTKFileReader::BuildMesh(VTKModel& vtk)
 		pm->Create(nodes, elems);
 
 		// copy nodal data
+		const std::vector<double>& r = piece.m_points.m_values_float;
+		if (r.size() < 3 * (size_t)nodes) { delete pm; return errf("Error trying to build mesh"); }
+#pragma omp parallel for
 		for (int i = 0; i < nodes; ++i)
 		{
 			FSNode& node = pm->Node(i);
-			node.r = piece.Point(i);
+			node.r = vec3d(r[3 * i], r[3 * i + 1], r[3 * i + 2]);
 		}
 
 		// copy element data
+		bool bok = true;
+#pragma omp parallel for shared(bok)
 		for (int i = 0; i < elems; ++i)
 		{
 			FSElement& el = pm->Element(i);
@@ -927,14 +1155,19 @@ bool VTKFileReader::BuildMesh(VTKModel& vtk)
 			case VTKCell::VTK_WEDGE     : el.SetType(FE_PENTA6); break;
 			case VTKCell::VTK_PYRAMID   : el.SetType(FE_PYRA5); break;
 			default:
-				delete pm;
-				return errf("Error trying to build mesh");
+				bok = false;
+				continue;
 			}
 
 			int nn = el.Nodes();
-			assert(nn == cell.m_numNodes);
+			if (nn != cell.m_numNodes) { bok = false; continue; }
 			for (int j = 0; j < nn; ++j) el.m_node[j] = cell.m_node[j];
 		}
+		if (bok == false)
+		{
+			delete pm;
+			return errf("Error trying to build mesh");
+		}
 
 		pm->RebuildMesh();
 		GMeshObject* po = new GMeshObject(pm);
@@ -952,6 +1185,14 @@ bool VTKFileReader::BuildMesh(VTKModel& vtk)
 bool VTKFileReader::ParseAppendedData(XMLTag& tag, VTKAppendedData& vtkAppendedData)
 {
 	const char* szenc = tag.AttributeValue("encoding");
+
+	// raw data is read separately (see ReadRawAppendedData)
+	if (strcmp(szenc, "raw") == 0)
+	{
+		vtkAppendedData.SetRaw(true);
+		return true;
+	}
+
 	if (strcmp(szenc, "base64") != 0) return errf("Unrecognized encoding type in AppendedData");
 
 	// strip all white space
@@ -74,6 +74,9 @@ protected:
 	bool ParseAppendedData(XMLTag& tag, VTKAppendedData& vtkAppendedData);
 	bool ProcessProcessDataArray(VTKDataArray& ar, VTKAppendedData& data);
 	bool ProcessDataArrays(VTKModel& vtk, VTKAppendedData& data);
+	bool ReadRawAppendedData(const char* szfile, VTKAppendedData& data);
+	bool DecompressBlocks(const unsigned char* src, size_t bytes, std::vector<unsigned char>& out);
+	size_t ReadHeaderValue(const unsigned char* p) const;
 
 	bool BuildMesh(VTKModel& vtk);
 
@@ -39,6 +39,8 @@ SOFTWARE.*/
 #include <algorithm>
 #include <unordered_set>
 #include <map>
+#include <atomic>
+#include <FSCore/CallTracer.h>
 using namespace std;
 
 double bias(double b, double x)
@@ -61,12 +63,15 @@ FSMesh::FSMesh()
 {
 	m_pobj = 0;
 	m_nltmin = 0;
+	Modified();
 }
 
 //-----------------------------------------------------------------------------
 // copy constructor
 FSMesh::FSMesh(FSMesh& m)
 {
+	Modified();
+
 	// create the nodes
 	m_Node.resize(m.Nodes());
 	for (int i=0; i<Nodes(); ++i) m_Node[i] = m.m_Node[i];
@@ -98,6 +103,8 @@ FSMesh::FSMesh(FSMesh& m)
 //-----------------------------------------------------------------------------
 FSMesh::FSMesh(FSSurfaceMesh& m)
 {
+	Modified();
+
 	int NN = m.Nodes();
 	int NF = m.Faces();
 	int NE = m.Edges();
@@ -149,6 +156,7 @@ FSMesh::~FSMesh()
 // Clear the mesh data
 void FSMesh::Clear()
 {
+	Modified();
 	m_Edge.clear();
 	m_Face.clear();
 	m_Elem.clear();
@@ -177,6 +185,16 @@ void FSMesh::Create(int nodes, int elems, int faces, int edges)
 
 	// clear mesh data
 	ClearMeshData();
+
+	Modified();
+}
+
+//-----------------------------------------------------------------------------
+static std::atomic<unsigned int> meshModCounter(0);
+
+void FSMesh::Modified()
+{
+	m_modCounter = ++meshModCounter;
 }
 
 //-----------------------------------------------------------------------------
@@ -527,6 +545,8 @@ void FSMesh::BuildMesh()
 //-----------------------------------------------------------------------------
 void FSMesh::UpdateMesh()
 {
+	Modified();
+
 	FSCoreMesh::UpdateMesh();
 
 	// rebuild the lookup tables
@@ -538,6 +558,8 @@ void FSMesh::UpdateMesh()
 // Convenience function that calls the mesh builder to do all the work
 void FSMesh::RebuildMesh(double smoothingAngle, bool partitionMesh)
 {
+	TRACE("FSMesh::RebuildMesh");
+
 	FEMeshBuilder meshBuilder(*this);
 	meshBuilder.RebuildMesh(smoothingAngle, partitionMesh);
 }
@@ -674,16 +696,58 @@ bool FSMesh::ValidateEdges() const
 	return true;
 }
 
+//-----------------------------------------------------------------------------
+// Record used for matching element faces. Faces are identified by their type
+// and sorted corner nodes, so matching faces end up next to each other after sorting.
+struct FaceMatchRecord
+{
+	int	key[5];	// face type followed by the sorted corner nodes
+	int	elem;	// element index
+	int	lid;	// local face index (-1 for shells)
+
+	bool operator < (const FaceMatchRecord& r) const
+	{
+		for (int i = 0; i < 5; ++i)
+		{
+			if (key[i] != r.key[i]) return (key[i] < r.key[i]);
+		}
+		if (elem != r.elem) return (elem < r.elem);
+		return (lid < r.lid);
+	}
+
+	bool SameFace(const FaceMatchRecord& r) const
+	{
+		for (int i = 0; i < 5; ++i) if (key[i] != r.key[i]) return false;
+		return true;
+	}
+};
+
+static void SetFaceMatchRecord(FaceMatchRecord& r, const FSFace& f, int elem, int lid)
+{
+	int nc = (f.Shape() == FE_FACE_QUAD ? 4 : 3);
+	r.key[0] = f.Type();
+	for (int i = 0; i < 4; ++i) r.key[i + 1] = (i < nc ? f.n[i] : -1);
+	std::sort(r.key + 1, r.key + 1 + nc);
+	r.elem = elem;
+	r.lid = lid;
+}
+
 //-----------------------------------------------------------------------------
 // This function finds the element neighbours.
-//
+// Solid faces are matched by sorting face records on their corner nodes, which 
+// avoids the node-element table search. Shells and beams still use the node-element table.
 void FSMesh::UpdateElementNeighbors()
 {
+	TRACE("FSMesh::UpdateElementNeighbors");
+
 	// get number of elements
 	int elems = Elements();
 
 	// reset all element neighbor and face ptrs
-#pragma omp parallel for
+	// and count the face records we'll need
+	vector<int> offset(elems + 1, 0);
+	int nshells = 0, nbeams = 0;
+#pragma omp parallel for reduction(+:nshells, nbeams)
 	for (int i = 0; i < elems; i++)
 	{
 		FEElement_& el = ElementRef(i);
@@ -693,78 +757,95 @@ void FSMesh::UpdateElementNeighbors()
 			el.m_nbr[j] = -1;
 			el.m_face[j] = -1;
 		}
-	}
 
-	// calculate the node-element table
-	FSNodeElementList NET;
-	NET.Build(this);
+		if (el.IsSolid()) offset[i + 1] = el.Faces();
+		else if (el.IsShell()) { offset[i + 1] = 1; nshells++; }
+		else if (el.IsBeam()) nbeams++;
+	}
+	for (int i = 0; i < elems; ++i) offset[i + 1] += offset[i];
 
-	// loop over all elements
-#pragma omp parallel for shared(NET)
+	// build the face records
+	vector<FaceMatchRecord> rec(offset[elems]);
+#pragma omp parallel for
 	for (int i = 0; i < elems; i++)
 	{
-		FEElement_* pe = ElementPtr(i);
-		// do the solid elements first
-		int n = pe->Faces();
-		FSFace f1, f2;
-		for (int j = 0; j < n; j++)
+		FEElement_& el = ElementRef(i);
+		FSFace f;
+		int m = offset[i];
+		if (el.IsSolid())
 		{
-			// check if we already have a neighbor assigned
-			if (pe->m_nbr[j] == -1)
+			int n = el.Faces();
+			for (int j = 0; j < n; ++j)
 			{
-				// get the corresponding element face
-				pe->GetFace(j, f1);
+				el.GetFace(j, f);
+				SetFaceMatchRecord(rec[m + j], f, i, j);
+			}
+		}
+		else if (el.IsShell())
+		{
+			el.GetShellFace(f);
+			SetFaceMatchRecord(rec[m], f, i, -1);
+		}
+	}
 
-				// pick a node on the face
-				int inode = f1.n[0];
-				int nval = NET.Valence(inode);
-				bool bfound = false;
+	// sort them so that matching faces are adjacent
+	std::sort(rec.begin(), rec.end());
 
-				// search for shell neighbors first
-				// This is necessary since a shell can share a face with a solid. 
-				// This requires a bit of special handling, so we need to check for that first
-				for (int k = 0; k < nval; k++)
-				{
-					int nbe = NET.ElementIndex(inode, k);
-					FEElement_* pne = NET.Element(inode, k);
-					if ((pne != pe) && pne->IsShell())
-					{
-						// get the shell surface facet
-						pne->GetShellFace(f2);
-						if (f1 == f2)
-						{
-							bfound = true;
-							pe->m_nbr[j] = nbe;
-							break;
-						}
-					}
-				}
+	// Match the solid faces. Each group of equal records is a shared face.
+	// A shell takes precedence over solids since a shell can share a face with a solid. 
+	int NR = (int)rec.size();
+#pragma omp parallel for schedule(dynamic, 1024)
+	for (int i = 0; i < NR; ++i)
+	{
+		// only process the first record of each group
+		if ((i > 0) && rec[i].SameFace(rec[i - 1])) continue;
+
+		int i1 = i + 1;
+		while ((i1 < NR) && rec[i].SameFace(rec[i1])) i1++;
+		if (i1 - i < 2) continue;
+
+		// find the shell in this group (if any)
+		int shell = -1;
+		for (int k = i; k < i1; ++k)
+			if (rec[k].lid == -1) { shell = rec[k].elem; break; }
 
-				if (bfound == false)
+		for (int k = i; k < i1; ++k)
+		{
+			const FaceMatchRecord& rk = rec[k];
+			if (rk.lid == -1) continue;
+
+			FEElement_& el = ElementRef(rk.elem);
+			if (shell != -1) el.m_nbr[rk.lid] = shell;
+			else
+			{
+				// pick the first other solid in this group
+				for (int l = i; l < i1; ++l)
 				{
-					// search for solid neighbors next
-					for (int k = 0; k < nval; k++)
+					if (rec[l].elem != rk.elem)
 					{
-						int nbe = NET.ElementIndex(inode, k);
-						FEElement_* pne = ElementPtr(nbe);
-						if ((pne != pe) && pne->IsSolid())
-						{
-							int l = pne->FindFace(f1);
-							if (l != -1)
-							{
-								bfound = true;
-								pe->m_nbr[j] = nbe;
-								pne->m_nbr[l] = i;
-								break;
-							}
-						}
+						el.m_nbr[rk.lid] = rec[l].elem;
+						break;
 					}
 				}
 			}
 		}
+	}
+
+	// we're done if we don't have shells or beams
+	if ((nshells == 0) && (nbeams == 0)) return;
+
+	// calculate the node-element table
+	FSNodeElementList NET;
+	NET.Build(this);
+
+	// loop over all elements
+#pragma omp parallel for shared(NET)
+	for (int i = 0; i < elems; i++)
+	{
+		FEElement_* pe = ElementPtr(i);
 
-		// do the shell elements next
-		n = pe->Edges();
+		// do the shell elements
+		int n = pe->Edges();
 		for (int j = 0; j < n; j++)
 		{
 			if (pe->m_nbr[j] == -1)
@@ -1132,6 +1213,38 @@ void FSMesh::UpdateFaceNeighbors()
 	}
 }
 
+//-----------------------------------------------------------------------------
+//! This function only updates the neighbours of the faces in the list, e.g. the 
+//! faces around a local modification. It uses the node-face table, which must be 
+//! up to date. Unlike the function above, it does not check part connectivity.
+void FSMesh::UpdateFaceNeighbors(const std::vector<int>& faceList)
+{
+	int NF = (int)faceList.size();
+#pragma omp parallel for
+	for (int l = 0; l<NF; ++l)
+	{
+		FSFace* pf = FacePtr(faceList[l]);
+
+		int n[4];
+		int ne = pf->Edges();
+		for (int j = 0; j<ne; ++j)
+		{
+			pf->GetEdgeNodes(j, n);
+			int nval = m_NFL.Valence(n[0]);
+			pf->m_nbr[j] = -1;
+			for (int k = 0; k<nval; ++k)
+			{
+				FSFace* pfn = m_NFL.Face(n[0], k);
+				if ((pfn != pf) && pfn->HasEdge(n[0], n[1]) && isValidFaceNeighbor(*pf, *pfn))
+				{
+					pf->m_nbr[j] = m_NFL.FaceIndex(n[0], k);
+					break;
+				}
+			}
+		}
+	}
+}
+
 //-----------------------------------------------------------------------------
 // This function finds the edge neighbours.
 void FSMesh::UpdateEdgeNeighbors()
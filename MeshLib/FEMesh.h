@@ -98,6 +98,11 @@ public:
 
 	int CountSelectedElements() const;
 
+	// The modification counter is assigned a new (globally unique) value whenever the
+	// mesh is created or updated, so that data derived from the mesh can tell if it is outdated.
+	unsigned int ModificationCounter() const { return m_modCounter; }
+	void Modified();
+
 	// return node index from its nodal ID
 	int NodeIndexFromID(int nid);
 
@@ -126,6 +131,7 @@ public: // Helper functions for updating mesh data structures
 
 	void UpdateElementNeighbors();
 	void UpdateFaceNeighbors();
+	void UpdateFaceNeighbors(const std::vector<int>& faceList);
 	void UpdateEdgeNeighbors();
 	void UpdateFaceElementTable();
 
@@ -205,6 +211,8 @@ protected:
 	std::vector<int> m_ELT;	// Element ID lookup table
 	int m_eltmin;			// the min ID
 
+	unsigned int	m_modCounter;	// modification counter
+
 	friend class FEMeshBuilder;
 };
 
@@ -96,7 +96,7 @@ bool FSMeshBase::IsCreaseEdge(int n0, int n1)
 }
 
 //-----------------------------------------------------------------------------
-const vector<NodeFaceRef>& FSMeshBase::NodeFaceList(int n) const 
+FSItemRange<NodeFaceRef> FSMeshBase::NodeFaceList(int n) const 
 { 
 	return m_NFL.FaceList(n); 
 }
@@ -676,7 +676,7 @@ void FSMeshBase::GetNodeNeighbors(int inode, int levels, std::set<int>& nl1)
 		for (it = nl1.begin(); it != nl1.end(); ++it)
 		{
 			// get the node-face list
-			const vector<NodeFaceRef>& nfl = NodeFaceList(*it);
+			FSItemRange<NodeFaceRef> nfl = NodeFaceList(*it);
 			int NF = nfl.size();
 
 			// add the other nodes
@@ -692,7 +692,7 @@ void FSMeshBase::GetNodeNeighbors(int inode, int levels, std::set<int>& nl1)
 		for (it = nl1.begin(); it != nl1.end(); ++it)
 		{
 			// get the node-face list
-			const vector<NodeFaceRef>& nfl = NodeFaceList(*it);
+			FSItemRange<NodeFaceRef> nfl = NodeFaceList(*it);
 			int NF = nfl.size();
 
 			// add the other nodes
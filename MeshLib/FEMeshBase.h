@@ -108,7 +108,7 @@ public:
 
 	bool IsCreaseEdge(int n0, int n1);
 
-	const std::vector<NodeFaceRef>& NodeFaceList(int n) const;
+	FSItemRange<NodeFaceRef> NodeFaceList(int n) const;
 
 protected:
 	void RemoveEdges(int ntag);
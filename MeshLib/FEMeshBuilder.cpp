@@ -29,6 +29,7 @@ SOFTWARE.*/
 #include <GeomLib/GObject.h>
 #include <MeshLib/FEFaceEdgeList.h>
 #include <memory>
+#include <FSCore/CallTracer.h>
 using namespace std;
 
 FEMeshBuilder::FEMeshBuilder(FSMesh& mesh) : m_mesh(mesh)
@@ -297,6 +298,9 @@ void FEMeshBuilder::DeleteSelectedElements()
 // Delete tagged elements
 void FEMeshBuilder::DeleteTaggedElements(int tag)
 {
+	// for solid meshes, we only update the region around the deleted elements
+	if (DeleteTaggedSolidElements(tag)) return;
+
 	// Let's go ahead and remove all tagged elements
 	m_mesh.RemoveElements(tag);
 	m_mesh.UpdateElementPartitions();
@@ -308,6 +312,149 @@ void FEMeshBuilder::DeleteTaggedElements(int tag)
 	m_mesh.RebuildMesh();
 }
 
+//-----------------------------------------------------------------------------
+// Delete the tagged elements of a solid mesh without rebuilding the entire mesh.
+// The dirty region are the remaining elements that lose a neighbor. Only their
+// exposed faces are created and partitioned, and only the faces next to the 
+// removed faces need new neighbors. All other faces keep their partition and 
+// smoothing IDs. The edges and nodes are still rebuilt from the surface.
+// Returns false without modifying the mesh if this cannot be done, e.g. when the 
+// mesh has shells or beams, in which case the caller needs to do a full rebuild.
+bool FEMeshBuilder::DeleteTaggedSolidElements(int tag)
+{
+	int NE0 = m_mesh.Elements();
+	int NF0 = m_mesh.Faces();
+	if ((NE0 == 0) || (NF0 == 0)) return false;
+
+	// new element indices (-1 for deleted elements)
+	vector<int> newElem(NE0, -1);
+	int NE = 0;
+	for (int i = 0; i < NE0; ++i)
+	{
+		FSElement& el = m_mesh.Element(i);
+		if (el.IsSolid() == false) return false;
+		if (el.m_ntag != tag) newElem[i] = NE++;
+	}
+	if ((NE == 0) || (NE == NE0)) return false;
+
+	// new face indices (-1 for faces of deleted elements)
+	vector<int> newFace(NF0, -1);
+	int NF = 0;
+	for (int i = 0; i < NF0; ++i)
+	{
+		FSFace& face = m_mesh.Face(i);
+		assert(face.m_elem[0].eid >= 0);
+		bool keep = true;
+		for (int k = 0; k < 3; ++k)
+		{
+			int eid = face.m_elem[k].eid;
+			if ((eid >= 0) && (newElem[eid] == -1)) keep = false;
+		}
+		if (keep) newFace[i] = NF++;
+	}
+
+	// update the element neighbors and faces, and find the exposed element faces
+	vector<pair<int, int> > exposed;
+	for (int i = 0; i < NE0; ++i)
+	{
+		if (newElem[i] == -1) continue;
+
+		FSElement& el = m_mesh.Element(i);
+		int nf = el.Faces();
+		for (int j = 0; j < nf; ++j)
+		{
+			int nbr = el.m_nbr[j];
+			if (nbr >= 0)
+			{
+				el.m_nbr[j] = newElem[nbr];
+				if (newElem[nbr] == -1) exposed.push_back(pair<int, int>(newElem[i], j));
+			}
+			if (el.m_face[j] >= 0) el.m_face[j] = newFace[el.m_face[j]];
+		}
+	}
+
+	// remove the elements
+	m_mesh.RemoveElements(tag);
+	m_mesh.UpdateElementPartitions();
+
+	// Remove the faces of deleted elements. 
+	// Faces that lose a neighbor are dirty.
+	vector<int> dirtyFaces;
+	for (int i = 0; i < NF0; ++i)
+	{
+		int n = newFace[i];
+		if (n == -1) continue;
+
+		FSFace& face = m_mesh.Face(n);
+		if (n != i) face = m_mesh.Face(i);
+		face.SetID(n + 1);
+
+		for (int k = 0; k < 3; ++k)
+		{
+			int eid = face.m_elem[k].eid;
+			if (eid >= 0) face.m_elem[k].eid = newElem[eid];
+		}
+
+		bool dirty = false;
+		int ne = face.Edges();
+		for (int j = 0; j < ne; ++j)
+		{
+			int nbr = face.m_nbr[j];
+			if (nbr >= 0)
+			{
+				face.m_nbr[j] = newFace[nbr];
+				if (newFace[nbr] == -1) dirty = true;
+			}
+		}
+		if (dirty) dirtyFaces.push_back(n);
+	}
+	m_mesh.m_Face.resize(NF);
+
+	// add the exposed faces
+	for (int i = 0; i < (int)exposed.size(); ++i)
+	{
+		int eid = exposed[i].first;
+		int lid = exposed[i].second;
+		FSElement& el = m_mesh.Element(eid);
+
+		int nf = m_mesh.Faces();
+		FSFace face;
+		el.GetFace(lid, face);
+		face.SetExterior(true);
+		face.SetID(nf + 1);
+		face.m_elem[0].eid = eid;
+		face.m_elem[0].lid = lid;
+		m_mesh.m_Face.push_back(face);
+
+		el.m_face[lid] = nf;
+		el.SetExterior(true);
+		dirtyFaces.push_back(nf);
+	}
+
+	// remove isolated nodes (this also updates the face nodes)
+	RemoveIsolatedNodes();
+
+	// update the neighbors of the dirty faces
+	m_mesh.m_NFL.Build(&m_mesh);
+	m_mesh.UpdateFaceNeighbors(dirtyFaces);
+
+	// partition the exposed faces
+	PartitionNewFaces(NF, 60.0);
+	m_mesh.UpdateFacePartitions();
+	m_mesh.UpdateSmoothingGroups();
+
+	// rebuild the edges and nodes
+	BuildEdges();
+	AutoPartitionEdges();
+	AutoPartitionNodes();
+	m_mesh.RebuildNodeData();
+
+	// update the mesh
+	m_mesh.UpdateMesh();
+
+	return true;
+}
+
 FSMesh* FEMeshBuilder::DeleteParts(FSMesh& mesh, std::vector<int> partIds)
 {
 	const int TAG = 1;
@@ -1079,6 +1226,60 @@ void FEMeshBuilder::RemoveDuplicateFaces()
 	m_mesh.UpdateFacePartitions();
 }
 
+//-----------------------------------------------------------------------------
+// After a face's nodes were permuted, its edges are reordered. This remaps 
+// the face neighbors to the new edge order by matching the edges of the old face.
+static void RemapFaceNeighbors(FSFace& face, FSFace& oldFace)
+{
+	int ne = face.Edges();
+	for (int j = 0; j < ne; ++j)
+	{
+		int k = oldFace.FindEdge(face.GetEdge(j));
+		assert(k != -1);
+		face.m_nbr[j] = (k != -1 ? oldFace.m_nbr[k] : -1);
+	}
+}
+
+//-----------------------------------------------------------------------------
+// After an element's nodes were permuted, its local faces (or edges for shells)
+// are reordered. This remaps the neighbor and face data of the element, and the local 
+// face index of its faces, without having to rebuild the element and face tables.
+static void RemapElementTopology(FSMesh& mesh, int eid, FSElement& oldElem)
+{
+	FSElement& el = mesh.Element(eid);
+	if (el.IsSolid())
+	{
+		int nf = el.Faces();
+		for (int j = 0; j < nf; ++j)
+		{
+			int k = oldElem.FindFace(el.GetFace(j));
+			assert(k != -1);
+			if (k == -1) continue;
+
+			el.m_nbr[j] = oldElem.m_nbr[k];
+			el.m_face[j] = oldElem.m_face[k];
+			if (el.m_face[j] >= 0)
+			{
+				FSFace& face = mesh.Face(el.m_face[j]);
+				for (int l = 0; l < 3; ++l)
+				{
+					if (face.m_elem[l].eid == eid) face.m_elem[l].lid = j;
+				}
+			}
+		}
+	}
+	else if (el.IsShell())
+	{
+		int ne = el.Edges();
+		for (int j = 0; j < ne; ++j)
+		{
+			int k = oldElem.FindEdge(el.GetEdge(j));
+			assert(k != -1);
+			el.m_nbr[j] = (k != -1 ? oldElem.m_nbr[k] : -1);
+		}
+	}
+}
+
 //-----------------------------------------------------------------------------
 // Invert selected elements (or all if none are selected)
 void FEMeshBuilder::InvertSelectedElements()
@@ -1119,12 +1320,17 @@ void FEMeshBuilder::InvertSelectedFaces()
 void FEMeshBuilder::InvertTaggedFaces(int ntag)
 {
 	// invert tagged elements
-	for (int i = 0; i<m_mesh.Faces(); ++i)
+	// Only the node order of the tagged faces changes, so the element and face-element
+	// tables remain valid and we only need to remap the neighbors of the tagged faces.
+	int NF = m_mesh.Faces();
+#pragma omp parallel for
+	for (int i = 0; i<NF; ++i)
 	{
 		FSFace& f = m_mesh.Face(i);
 		if (f.m_ntag == ntag)
 		{
-			int n = f.Nodes(), m;
+			FSFace oldFace(f);
+			int m;
 
 			switch (f.Type())
 			{
@@ -1150,12 +1356,11 @@ void FEMeshBuilder::InvertTaggedFaces(int ntag)
 			default:
 				assert(false);
 			}
+
+			RemapFaceNeighbors(f, oldFace);
 		}
 	}
 
-	m_mesh.UpdateElementNeighbors();
-	m_mesh.UpdateFaceElementTable();
-	m_mesh.UpdateFaceNeighbors();
 	m_mesh.UpdateNormals();
 }
 
@@ -1164,11 +1369,16 @@ void FEMeshBuilder::InvertTaggedFaces(int ntag)
 void FEMeshBuilder::InvertTaggedElements(int ntag)
 {
 	// invert tagged elements
-	for (int i = 0; i<m_mesh.Elements(); ++i)
+	// Only the tagged elements (and their faces) are affected, so instead of rebuilding 
+	// the element and face tables for the entire mesh, we remap their local topology.
+	int NE = m_mesh.Elements();
+#pragma omp parallel for
+	for (int i = 0; i<NE; ++i)
 	{
 		FSElement& e = m_mesh.Element(i);
 		if (e.m_ntag == ntag)
 		{
+			FSElement oldElem(e);
 			int n = e.Nodes(), m;
 
 			switch (e.Type())
@@ -1247,11 +1457,15 @@ void FEMeshBuilder::InvertTaggedElements(int ntag)
 			default:
 				assert(false);
 			}
+
+			RemapElementTopology(m_mesh, i, oldElem);
 		}
 	}
 
 	// mirror the faces
-	for (int i = 0; i<m_mesh.Faces(); ++i)
+	int NF = m_mesh.Faces();
+#pragma omp parallel for
+	for (int i = 0; i<NF; ++i)
 	{
 		FSFace& f = m_mesh.Face(i);
 		FEElement_* pe = m_mesh.ElementPtr(f.m_elem[0].eid);
@@ -1261,14 +1475,14 @@ void FEMeshBuilder::InvertTaggedElements(int ntag)
 			FSFace g;
 			m_mesh.FindFace(pe, f, g);
 
-			for (int j = 0; j<FSElement::MAX_NODES; ++j)
+			FSFace oldFace(f);
+			for (int j = 0; j<FSFace::MAX_NODES; ++j)
 				f.n[j] = g.n[j];
+
+			RemapFaceNeighbors(f, oldFace);
 		}
 	}
 
-	m_mesh.UpdateElementNeighbors();
-	m_mesh.UpdateFaceElementTable();
-	m_mesh.UpdateFaceNeighbors();
 	m_mesh.UpdateMesh();
 }
 
@@ -1809,10 +2023,100 @@ void FEMeshBuilder::AutoPartitionSurface()
 	}
 }
 
+//-----------------------------------------------------------------------------
+// Assigns smoothing groups and surface partitions to the faces from index f0 onward,
+// in the same way as AutoSmooth and AutoPartitionSurface, but without changing the 
+// other faces. The new groups are numbered after the existing ones.
+void FEMeshBuilder::PartitionNewFaces(int f0, double smoothingAngle)
+{
+	int NF = m_mesh.Faces();
+	if (f0 >= NF) return;
+
+	int nsg = 0, ngid = 0;
+	for (int i = 0; i < f0; ++i)
+	{
+		FSFace& face = m_mesh.Face(i);
+		if (face.m_sid >= nsg) nsg = face.m_sid + 1;
+		if (face.m_gid >= ngid) ngid = face.m_gid + 1;
+	}
+
+	// calculate the face normals
+	for (int i = f0; i < NF; ++i)
+	{
+		FSFace& face = m_mesh.Face(i);
+		vec3d& r0 = m_mesh.Node(face.n[0]).r;
+		vec3d& r1 = m_mesh.Node(face.n[1]).r;
+		vec3d& r2 = m_mesh.Node(face.n[2]).r;
+		face.m_fn = to_vec3f((r1 - r0) ^ (r2 - r0));
+		face.m_fn.Normalize();
+		face.m_sid = -1;
+		face.m_gid = -1;
+	}
+
+	// assign smoothing groups
+	double eps = cos(smoothingAngle * DEG2RAD);
+	vector<int> stack;
+	for (int i = f0; i < NF; ++i)
+	{
+		if (m_mesh.Face(i).m_sid != -1) continue;
+
+		m_mesh.Face(i).m_sid = nsg;
+		stack.push_back(i);
+		while (stack.empty() == false)
+		{
+			FSFace& face = m_mesh.Face(stack.back()); stack.pop_back();
+			int ne = face.Edges();
+			for (int j = 0; j < ne; ++j)
+			{
+				int nbr = face.m_nbr[j];
+				if (nbr < f0) continue;
+
+				FSFace& face2 = m_mesh.Face(nbr);
+				if ((face2.m_sid == -1) && (face.m_fn * face2.m_fn >= eps))
+				{
+					face2.m_sid = nsg;
+					stack.push_back(nbr);
+				}
+			}
+		}
+		++nsg;
+	}
+
+	// partition the faces based on the smoothing groups and element partitions
+	for (int i = f0; i < NF; ++i)
+	{
+		if (m_mesh.Face(i).m_gid != -1) continue;
+
+		m_mesh.Face(i).m_gid = ngid;
+		stack.push_back(i);
+		while (stack.empty() == false)
+		{
+			FSFace& face = m_mesh.Face(stack.back()); stack.pop_back();
+			int gid = m_mesh.Element(face.m_elem[0].eid).m_gid;
+			int ne = face.Edges();
+			for (int j = 0; j < ne; ++j)
+			{
+				int nbr = face.m_nbr[j];
+				if (nbr < f0) continue;
+
+				FSFace& face2 = m_mesh.Face(nbr);
+				if ((face2.m_gid == -1) && (face2.m_sid == face.m_sid) && (m_mesh.Element(face2.m_elem[0].eid).m_gid == gid))
+				{
+					face2.m_gid = ngid;
+					stack.push_back(nbr);
+				}
+			}
+		}
+		++ngid;
+	}
+}
+
 //-----------------------------------------------------------------------------
 // This function builds the surface, edges and node of the mesh
 void FEMeshBuilder::RebuildMesh(double smoothingAngle, bool partitionMesh, bool creaseInternal)
 {
+	TRACE("FEMeshBuilder::RebuildMesh");
+
 	// update the element neighbours
 	m_mesh.UpdateElementNeighbors();
 
@@ -2020,9 +2324,15 @@ void FEMeshBuilder::AutoPartitionNodes()
 //-----------------------------------------------------------------------------
 void FEMeshBuilder::BuildFaces()
 {
+	TRACE("FEMeshBuilder::BuildFaces");
+
 	// let's count them first
-	int faces = 0;
+	// We count the solid and shell faces per element so that the faces 
+	// can be created in parallel further below.
 	int elems = m_mesh.Elements();
+	vector<int> solidOffset(elems + 1, 0);
+	vector<int> shellOffset(elems + 1, 0);
+#pragma omp parallel for
 	for (int i = 0; i<elems; i++)
 	{
 		FSElement& el = m_mesh.Element(i);
@@ -2032,6 +2342,7 @@ void FEMeshBuilder::BuildFaces()
 		// or if the neighbor has a different gid and is not a shell.
 		// Note that we need to make sure we don't double-count.
 		int n = el.Faces();
+		int faces = 0;
 		for (int j = 0; j<n; ++j)
 		{
 			if (el.m_nbr[j] == -1) ++faces;
@@ -2044,14 +2355,18 @@ void FEMeshBuilder::BuildFaces()
 				}
 			}
 		}
+		solidOffset[i + 1] = faces;
 
 		// shell elements always add a face
-		if (el.IsShell())
-		{
-			++faces;
-		}
+		shellOffset[i + 1] = (el.Edges() > 0 ? 1 : 0);
 	}
 
+	// solid faces go first, followed by the shell faces
+	for (int i = 0; i<elems; ++i) solidOffset[i + 1] += solidOffset[i];
+	shellOffset[0] = solidOffset[elems];
+	for (int i = 0; i<elems; ++i) shellOffset[i + 1] += shellOffset[i];
+	int faces = shellOffset[elems];
+
 	// make sure we have faces
 	if (faces == 0)
 	{
@@ -2063,14 +2378,13 @@ void FEMeshBuilder::BuildFaces()
 	m_mesh.m_Face.resize(faces);
 
 	// create the faces
-	FSFace* pf = m_mesh.FacePtr();
-	int nf = 0;
-
-	// solid elements
+#pragma omp parallel for
 	for (int i = 0; i<elems; i++)
 	{
 		FSElement& el = m_mesh.Element(i);
 
+		// solid elements
+		int nf = solidOffset[i];
 		int n = el.Faces();
 		for (int j = 0; j<n; j++)
 		{
@@ -2079,34 +2393,30 @@ void FEMeshBuilder::BuildFaces()
 			FEElement_* pen = (nbid == -1 ? 0 : m_mesh.ElementPtr(nbid));
 			if (pen == 0)
 			{
-				el.GetFace(j, *pf);
-				pf->SetExterior(true);
-				pf->SetID(nf + 1);
-				++pf; ++nf;
+				FSFace& face = m_mesh.Face(nf);
+				el.GetFace(j, face);
+				face.SetExterior(true);
+				face.SetID(nf + 1);
+				++nf;
 			}
 			else if ((el.m_gid < pen->m_gid) && (pen->IsShell() == false))
 			{
-				*pf = el.GetFace(j);
-				pf->SetExterior(false);
-				pf->SetID(nf + 1);
-				++pf; ++nf;
+				FSFace& face = m_mesh.Face(nf);
+				face = el.GetFace(j);
+				face.SetExterior(false);
+				face.SetID(nf + 1);
+				++nf;
 			}
 		}
-	}
-
-	// shell elements
-	for (int i = 0; i<elems; i++)
-	{
-		FSElement& el = m_mesh.Element(i);
 
 		// shell elements
-		int n = el.Edges();
-		if (n>0)
+		if (el.Edges() > 0)
 		{
-			el.GetShellFace(*pf);
-			pf->SetExterior(true);
-			pf->SetID(nf + 1);
-			++pf; ++nf;
+			nf = shellOffset[i];
+			FSFace& face = m_mesh.Face(nf);
+			el.GetShellFace(face);
+			face.SetExterior(true);
+			face.SetID(nf + 1);
 		}
 	}
 
@@ -2117,6 +2427,8 @@ void FEMeshBuilder::BuildFaces()
 //-----------------------------------------------------------------------------
 void FEMeshBuilder::BuildEdges()
 {
+	TRACE("FEMeshBuilder::BuildEdges");
+
 	// delete edges
 	m_mesh.m_Edge.clear();
 
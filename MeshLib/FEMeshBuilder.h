@@ -124,9 +124,11 @@ private:
 	void BuildEdges();
 	void AutoPartitionElements();
 	void AutoPartitionSurface();
+	void PartitionNewFaces(int f0, double smoothingAngle);
 	void AutoPartitionEdges();
 	void AutoPartitionNodes();
 	FSMesh* DeleteTaggedParts(FSMesh& mesh, int tag);
+	bool DeleteTaggedSolidElements(int tag);
 
 private:
 	FSMesh&	m_mesh;
@@ -27,6 +27,8 @@ SOFTWARE.*/
 #include "FENodeEdgeList.h"
 #include "FELineMesh.h"
 #include <assert.h>
+#include <algorithm>
+#include <atomic>
 using namespace std;
 
 FSNodeEdgeList::FSNodeEdgeList(FSLineMesh* mesh) : m_mesh(mesh)
@@ -36,12 +38,13 @@ FSNodeEdgeList::FSNodeEdgeList(FSLineMesh* mesh) : m_mesh(mesh)
 
 void FSNodeEdgeList::Clear()
 {
+	m_off.clear();
 	m_edge.clear();
 }
 
 bool FSNodeEdgeList::IsEmpty() const
 {
-	return m_edge.empty();
+	return m_off.empty();
 }
 
 void FSNodeEdgeList::Build(FSLineMesh* pmesh, bool segsOnly)
@@ -49,43 +52,66 @@ void FSNodeEdgeList::Build(FSLineMesh* pmesh, bool segsOnly)
 	m_mesh = pmesh;
 	assert(pmesh);
 	FSLineMesh& mesh = *m_mesh;
+	Clear();
 
 	// allocate valence array
 	int N = mesh.Nodes();
 	if (N == 0) return;
-	m_edge.resize(N);
+	vector< atomic<int> > pos(N);
+#pragma omp parallel for
+	for (int i = 0; i < N; ++i) pos[i] = 0;
 
-	// fill edge array
+	// count the edges of each node
 	int NE = mesh.Edges();
-	for (int i=0; i<NE; ++i)
+#pragma omp parallel for
+	for (int i = 0; i < NE; ++i)
 	{
 		const FSEdge& edge = mesh.Edge(i);
 		if ((segsOnly == false) || (edge.IsExterior()))
 		{
-			int n0 = edge.n[0];
-			int n1 = edge.n[1];
+			pos[edge.n[0]]++;
+			pos[edge.n[1]]++;
+		}
+	}
 
-			vector<int>& l0 = m_edge[n0];
-			vector<int>& l1 = m_edge[n1];
+	// calculate the offsets
+	m_off.resize(N + 1);
+	m_off[0] = 0;
+	for (int i = 0; i < N; ++i) m_off[i + 1] = m_off[i] + pos[i];
+
+	// fill edge array
+#pragma omp parallel for
+	for (int i = 0; i < N; ++i) pos[i] = m_off[i];
 
-			l0.push_back(i);
-			l1.push_back(i);
+	m_edge.resize(m_off[N]);
+#pragma omp parallel for
+	for (int i = 0; i < NE; ++i)
+	{
+		const FSEdge& edge = mesh.Edge(i);
+		if ((segsOnly == false) || (edge.IsExterior()))
+		{
+			m_edge[pos[edge.n[0]]++] = i;
+			m_edge[pos[edge.n[1]]++] = i;
 		}
 	}
+
+	// the fill order depends on the threads, so sort the edges
+#pragma omp parallel for schedule(dynamic, 1024)
+	for (int i = 0; i < N; ++i) std::sort(m_edge.begin() + m_off[i], m_edge.begin() + m_off[i + 1]);
 }
 
 // Return the edge for a given node
 const FSEdge* FSNodeEdgeList::Edge(int node, int edge) const
 {
-	return m_mesh->EdgePtr(m_edge[node][edge]);
+	return m_mesh->EdgePtr(m_edge[m_off[node] + edge]);
 }
 
 int FSNodeEdgeList::EdgeIndex(int node, int edge) const 
 { 
-	return m_edge[node][edge]; 
+	return m_edge[m_off[node] + edge]; 
 }
 
-const std::vector<int>& FSNodeEdgeList::EdgeIndexList(int node) const
+FSItemRange<int> FSNodeEdgeList::EdgeIndexList(int node) const
 {
-	return m_edge[node];
+	return FSItemRange<int>(m_edge.data() + m_off[node], m_edge.data() + m_off[node + 1]);
 }
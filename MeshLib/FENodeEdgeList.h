@@ -26,10 +26,13 @@ SOFTWARE.*/
 
 #pragma once
 #include <vector>
+#include "FEItemRange.h"
 
 class FSLineMesh;
 class FSEdge;
 
+// The list is stored in compressed row format: the edges of node n are
+// stored in m_edge[m_off[n]] to m_edge[m_off[n+1]-1].
 class FSNodeEdgeList
 {
 public:
@@ -42,7 +45,7 @@ public:
 	bool IsEmpty() const;
 
 	// Return the number of edges for a given node
-	int Edges(int node) const { return (int) m_edge[node].size(); }
+	int Edges(int node) const { return m_off[node + 1] - m_off[node]; }
 
 	// Return the edge for a given node
 	const FSEdge* Edge(int node, int edge) const;
@@ -50,9 +53,10 @@ public:
 	// return the edge index
 	int EdgeIndex(int node, int edge) const;
 
-	const std::vector<int>& EdgeIndexList(int node) const;
+	FSItemRange<int> EdgeIndexList(int node) const;
 
 private:
 	FSLineMesh*			m_mesh;
-	std::vector< std::vector<int> >	m_edge;		// edge list
+	std::vector<int>	m_off;		// offset into edge list (size = nodes + 1)
+	std::vector<int>	m_edge;		// edge list
 };
@@ -25,6 +25,8 @@ OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
 SOFTWARE.*/
 
 #include "FENodeElementList.h"
+#include <algorithm>
+#include <atomic>
 
 FSNodeElementList::FSNodeElementList()
 {
@@ -39,41 +41,68 @@ void FSNodeElementList::Build(FSCoreMesh* pm)
 {
 	m_pm = pm;
 	assert(m_pm);
-	m_elem.clear();
+	Clear();
 
 	int NN = m_pm->Nodes();
 	int NE = m_pm->Elements();
 	if ((NE == 0) || (NN == 0)) return;
 
-	m_elem.resize(NN);
-	for (int i=0; i<NE; ++i)
+	// count the number of elements each node belongs to
+	std::vector< std::atomic<int> > pos(NN);
+#pragma omp parallel for
+	for (int i = 0; i < NN; ++i) pos[i] = 0;
+
+#pragma omp parallel for
+	for (int i = 0; i < NE; ++i)
 	{
 		FEElement_& el = m_pm->ElementRef(i);
 		int ne = el.Nodes();
-		for (int j=0; j<ne; ++j) 
-		{
-			int n = el.m_node[j];
+		for (int j = 0; j < ne; ++j) pos[el.m_node[j]]++;
+	}
 
-			std::vector<NodeElemRef>& lj = m_elem[n];
+	// calculate the offsets
+	m_off.resize(NN + 1);
+	m_off[0] = 0;
+	for (int i = 0; i < NN; ++i) m_off[i + 1] = m_off[i] + pos[i];
 
-			NodeElemRef ref;
+	// fill the references
+#pragma omp parallel for
+	for (int i = 0; i < NN; ++i) pos[i] = m_off[i];
+
+	m_elem.resize(m_off[NN]);
+#pragma omp parallel for
+	for (int i = 0; i < NE; ++i)
+	{
+		FEElement_& el = m_pm->ElementRef(i);
+		int ne = el.Nodes();
+		for (int j = 0; j < ne; ++j)
+		{
+			NodeElemRef& ref = m_elem[pos[el.m_node[j]]++];
 			ref.eid = i;
 			ref.nid = j;
 			ref.pe = &el;
-
-			lj.push_back(ref);
 		}
 	}
+
+	// the fill order depends on the threads, so sort the references
+#pragma omp parallel for schedule(dynamic, 1024)
+	for (int i = 0; i < NN; ++i)
+	{
+		std::sort(m_elem.begin() + m_off[i], m_elem.begin() + m_off[i + 1], [](const NodeElemRef& a, const NodeElemRef& b) {
+			return (a.eid < b.eid) || ((a.eid == b.eid) && (a.nid < b.nid));
+		});
+	}
 }
 
 void FSNodeElementList::Clear()
 {
+	m_off.clear();
 	m_elem.clear();
 }
 
 bool FSNodeElementList::IsEmpty() const
 {
-	return m_elem.empty();
+	return m_off.empty();
 }
 
 bool FSNodeElementList::HasElement(int node, int iel) const
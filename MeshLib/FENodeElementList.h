@@ -26,6 +26,7 @@ SOFTWARE.*/
 #pragma once
 #include <vector>
 #include "FECoreMesh.h"
+#include "FEItemRange.h"
 
 //-----------------------------------------------------------------------------
 // the first index is the element number
@@ -36,6 +37,8 @@ struct NodeElemRef {
 	FEElement_*	pe;	// pointer to element
 };
 
+// The list is stored in compressed row format: the references of node n are
+// stored in m_elem[m_off[n]] to m_elem[m_off[n+1]-1], ordered by element index.
 class FSNodeElementList
 {
 public:
@@ -48,16 +51,17 @@ public:
 
 	bool IsEmpty() const;
 
-	int Valence(int n) const { return (int)m_elem[n].size(); }
-	FEElement_* Element(int n, int j) { return m_elem[n][j].pe; }
-	int ElementIndex(int n, int j) const { return m_elem[n][j].eid; }
+	int Valence(int n) const { return m_off[n + 1] - m_off[n]; }
+	FEElement_* Element(int n, int j) { return m_elem[m_off[n] + j].pe; }
+	int ElementIndex(int n, int j) const { return m_elem[m_off[n] + j].eid; }
 
 	bool HasElement(int node, int iel) const;
 
 	std::vector<int> ElementIndexList(int n) const;
-	const std::vector<NodeElemRef>& ElementList(int n) const { return m_elem[n]; }
+	FSItemRange<NodeElemRef> ElementList(int n) const { return FSItemRange<NodeElemRef>(m_elem.data() + m_off[n], m_elem.data() + m_off[n + 1]); }
 
 protected:
 	FSCoreMesh*	m_pm;
-	std::vector< std::vector<NodeElemRef> >	m_elem;
+	std::vector<int>			m_off;	// offset into element reference list (size = nodes + 1)
+	std::vector<NodeElemRef>	m_elem;	// element references
 };
@@ -28,6 +28,8 @@ SOFTWARE.*/
 #include "FEMeshBase.h"
 #include "FEFace.h"
 #include <assert.h>
+#include <algorithm>
+#include <atomic>
 using namespace std;
 
 //-----------------------------------------------------------------------------
@@ -44,13 +46,14 @@ FSNodeFaceList::~FSNodeFaceList(void)
 //-----------------------------------------------------------------------------
 void FSNodeFaceList::Clear()
 {
+	m_off.clear();
 	m_face.clear();
 }
 
 //-----------------------------------------------------------------------------
 bool FSNodeFaceList::IsEmpty() const
 {
-	return m_face.empty();
+	return m_off.empty();
 }
 
 //-----------------------------------------------------------------------------
@@ -76,28 +79,56 @@ void FSNodeFaceList::Build(FSMeshBase* pm)
 	m_pm = pm;
 	assert(m_pm);
 	FSMeshBase& m = *m_pm;
+	Clear();
 
 	int NN = m.Nodes();
 	int NF = m.Faces();
 
-	m_face.resize(NN);
-	for (int i=0; i<NF; ++i)
+	// count the number of faces each node belongs to
+	vector< atomic<int> > pos(NN);
+#pragma omp parallel for
+	for (int i = 0; i < NN; ++i) pos[i] = 0;
+
+#pragma omp parallel for
+	for (int i = 0; i < NF; ++i)
 	{
 		FSFace& f = m.Face(i);
 		int nf = f.Nodes();
-		for (int j = 0; j<nf; ++j)
-		{
-			int n = f.n[j];
-			vector<NodeFaceRef>& li = m_face[n];
+		for (int j = 0; j < nf; ++j) pos[f.n[j]]++;
+	}
+
+	// calculate the offsets
+	m_off.resize(NN + 1);
+	m_off[0] = 0;
+	for (int i = 0; i < NN; ++i) m_off[i + 1] = m_off[i] + pos[i];
 
-			NodeFaceRef ref;
+	// fill the references
+#pragma omp parallel for
+	for (int i = 0; i < NN; ++i) pos[i] = m_off[i];
+
+	m_face.resize(m_off[NN]);
+#pragma omp parallel for
+	for (int i = 0; i < NF; ++i)
+	{
+		FSFace& f = m.Face(i);
+		int nf = f.Nodes();
+		for (int j = 0; j < nf; ++j)
+		{
+			NodeFaceRef& ref = m_face[pos[f.n[j]]++];
 			ref.fid = i;
 			ref.nid = j;
 			ref.pf = &f;
-
-			li.push_back(ref);
 		}
 	}
+
+	// the fill order depends on the threads, so sort the references
+#pragma omp parallel for schedule(dynamic, 1024)
+	for (int i = 0; i < NN; ++i)
+	{
+		std::sort(m_face.begin() + m_off[i], m_face.begin() + m_off[i + 1], [](const NodeFaceRef& a, const NodeFaceRef& b) {
+			return (a.fid < b.fid) || ((a.fid == b.fid) && (a.nid < b.nid));
+		});
+	}
 }
 
 //-----------------------------------------------------------------------------
@@ -129,7 +160,10 @@ bool FSNodeFaceList::Sort(int node)
 
 	for (int i=0; i<nval; ++i) Face(node, i)->m_ntag = 0;
 
-	NodeFaceRef ref = m_face[node][0];
+	if (nval == 0) return true;
+	NodeFaceRef* nf = &m_face[m_off[node]];
+
+	NodeFaceRef ref = nf[0];
 	ref.pf->m_ntag = 1;
 	fl.push_back(ref);
 	bool bdone = false;
@@ -161,8 +195,8 @@ bool FSNodeFaceList::Sort(int node)
 				}
 				assert(k < nval);
 
-				fl.push_back(m_face[node][k]);
-				ref = m_face[node][k];
+				fl.push_back(nf[k]);
+				ref = nf[k];
 				bdone = false;
 			}
 		}
@@ -172,14 +206,14 @@ bool FSNodeFaceList::Sort(int node)
 	// for non-manifold topologies this algorithm
 	// can fail. In that case, we return false
 	if ((int)fl.size() != nval) return false;
-	m_face[node] = fl;
+	std::copy(fl.begin(), fl.end(), nf);
 
 	return true;
 }
 
-const vector<NodeFaceRef>& FSNodeFaceList::FaceList(int n) const
+FSItemRange<NodeFaceRef> FSNodeFaceList::FaceList(int n) const
 { 
-	return m_face[n]; 
+	return FSItemRange<NodeFaceRef>(m_face.data() + m_off[n], m_face.data() + m_off[n + 1]);
 }
 
 //-----------------------------------------------------------------------------
@@ -204,12 +238,12 @@ int FSNodeFaceList::FindFace(int inode, int n[10], int m)
 		assert(false);
 	};
 
-	vector<NodeFaceRef>& ni = m_face[inode];
-	int nf = (int)ni.size();
+	int nf = Valence(inode);
 	for (int i = 0; i<nf; ++i)
 	{
-		FSFace& f = m_pm->Face(ni[i].fid);
-		if (f == ft) return ni[i].fid;
+		int fid = FaceIndex(inode, i);
+		FSFace& f = m_pm->Face(fid);
+		if (f == ft) return fid;
 	}
 	return -1;
 }
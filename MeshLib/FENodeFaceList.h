@@ -25,6 +25,7 @@ OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
 SOFTWARE.*/
 #pragma once
 #include <vector>
+#include "FEItemRange.h"
 
 class FSFace;
 class FSMeshBase;
@@ -35,6 +36,8 @@ struct NodeFaceRef {
 	FSFace*	pf;		// face pointer
 };
 
+// The list is stored in compressed row format: the references of node n are
+// stored in m_face[m_off[n]] to m_face[m_off[n+1]-1].
 class FSNodeFaceList
 {
 public:
@@ -48,9 +51,9 @@ public:
 
 	bool IsEmpty() const;
 
-	int Valence(int i) const { return (int) m_face[i].size(); }
-	FSFace* Face(int n, int i) { return m_face[n][i].pf; }
-	int FaceIndex(int n, int i) { return m_face[n][i].fid; }
+	int Valence(int i) const { return m_off[i + 1] - m_off[i]; }
+	FSFace* Face(int n, int i) { return m_face[m_off[n] + i].pf; }
+	int FaceIndex(int n, int i) { return m_face[m_off[n] + i].fid; }
 
 	bool HasFace(int n, FSFace* pf);
 
@@ -58,12 +61,13 @@ public:
 
 	int FindFace(int inode, int n[10], int m);
 
-	const std::vector<NodeFaceRef>& FaceList(int n) const;
+	FSItemRange<NodeFaceRef> FaceList(int n) const;
 
 protected:
 	bool Sort(int node);
 
 protected:
 	FSMeshBase*	m_pm;
-	std::vector< std::vector<NodeFaceRef> >	m_face;
+	std::vector<int>			m_off;	// offset into face reference list (size = nodes + 1)
+	std::vector<NodeFaceRef>	m_face;	// face references
 };
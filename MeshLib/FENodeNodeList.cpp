@@ -29,6 +29,7 @@ SOFTWARE.*/
 #include "FENodeNodeList.h"
 #include "FENodeElementList.h"
 #include "FENodeFaceList.h"
+#include <algorithm>
 
 FSNodeNodeList::FSNodeNodeList(FSMesh* pm, bool preservePartitions)
 {
@@ -53,8 +54,6 @@ void FSNodeNodeList::Build(FSMesh* pm, bool preservePartitions)
 	NEL.Build(pm);
 
 	int NN = pm->Nodes();
-	std::vector<int> tag; tag.assign(NN, -1);
-
 	std::vector<int> P(NN, 0), D(NN, -1);
 	if (preservePartitions)
 	{
@@ -106,73 +105,54 @@ void FSNodeNodeList::Build(FSMesh* pm, bool preservePartitions)
 
 	}
 
+	// This is done in two passes: first we count the neighbours of each node,
+	// and then we fill the list. The neighbours are collected per node, so both
+	// passes can run in parallel.
 	m_val.resize(NN);
-	int nsize = 0;
-
-	for (int i=0; i<NN; ++i)
+	m_off.resize(NN);
+	for (int pass = 0; pass < 2; ++pass)
 	{
-		int Pi = P[i];
-		double Di = D[i];
-		int n = 0;
-		int nv = NEL.Valence(i);
-		for (int j = 0; j < nv; ++j)
+#pragma omp parallel
 		{
-			FEElement_* pe = NEL.Element(i, j);
-			int ne = pe->Nodes();
-			for (int k = 0; k < ne; ++k)
+			std::vector<int> nbr;
+#pragma omp for schedule(dynamic, 1024)
+			for (int i = 0; i < NN; ++i)
 			{
-				int nn = pe->m_node[k];
-				if ((nn != i) && (tag[nn] != i))
+				int Pi = P[i];
+				double Di = D[i];
+				nbr.clear();
+				int nv = NEL.Valence(i);
+				for (int j = 0; j < nv; ++j)
 				{
-					int Pn = P[nn], Dn = D[nn];
-					if ((preservePartitions == false) || 
-						(Pi < Pn) ||
-						((Pi == Pn) && (Di == Dn)))
+					FEElement_* pe = NEL.Element(i, j);
+					int ne = pe->Nodes();
+					for (int k = 0; k < ne; ++k)
 					{
-						tag[nn] = i;
-						n++;
+						int nn = pe->m_node[k];
+						if ((nn != i) && (std::find(nbr.begin(), nbr.end(), nn) == nbr.end()))
+						{
+							int Pn = P[nn], Dn = D[nn];
+							if ((preservePartitions == false) ||
+								(Pi < Pn) ||
+								((Pi == Pn) && (Di == Dn)))
+							{
+								nbr.push_back(nn);
+							}
+						}
 					}
 				}
+
+				if (pass == 0) m_val[i] = (int)nbr.size();
+				else std::copy(nbr.begin(), nbr.end(), m_node.begin() + m_off[i]);
 			}
 		}
-		m_val[i] = n;
-		nsize += n;
-	}
-
-	m_off.resize(NN);
-	m_off[0] = 0;
-	for (int i=1; i<NN; ++i) m_off[i] = m_off[i-1] + m_val[i-1];
-
-	for (int i=0; i<NN; ++i) tag[i] = -1;
 
-	m_node.resize(nsize);
-
-	for (int i=0; i<NN; ++i)
-	{
-		int Pi = P[i], Di = D[i];
-		int n = 0;
-		int nv = NEL.Valence(i);
-		int noff = m_off[i];
-		for (int j = 0, n = 0; j < nv; ++j)
+		if (pass == 0)
 		{
-			FEElement_* pe = NEL.Element(i, j);
-			int ne = pe->Nodes();
-			for (int k = 0; k < ne; ++k)
-			{
-				int nn = pe->m_node[k];
-				if ((nn != i) && (tag[nn] != i))
-				{
-					int Pn = P[nn], Dn = D[nn];
-					if ((preservePartitions == false) || 
-						(Pi < Pn) ||
-						((Pi == Pn) && (Di == Dn)))
-					{
-						tag[nn] = i;
-						m_node[noff + n] = nn;
-						n++;
-					}
-				}
-			}
+			if (NN == 0) break;
+			m_off[0] = 0;
+			for (int i = 1; i < NN; ++i) m_off[i] = m_off[i - 1] + m_val[i - 1];
+			m_node.resize(m_off[NN - 1] + m_val[NN - 1]);
 		}
 	}
 }
@@ -185,61 +165,46 @@ void FSNodeNodeList::Build(FSSurfaceMesh* pm)
 	FSNodeFaceList NFL;
 	NFL.Build(pm);
 
-	int i, j, k, n;
 	int NN = pm->Nodes();
-	std::vector<int> tag; tag.assign(NN, -1);
 
+	// (see the FSMesh version above)
 	m_val.resize(NN);
-	int nsize = 0;
-
-	for (i = 0; i<NN; ++i)
+	m_off.resize(NN);
+	for (int pass = 0; pass < 2; ++pass)
 	{
-		int nv = NFL.Valence(i);
-		for (j = n = 0; j<nv; ++j)
+#pragma omp parallel
 		{
-			FSFace* pf = NFL.Face(i, j);
-			int nf = pf->Nodes();
-			for (k = 0; k<nf; ++k)
+			std::vector<int> nbr;
+#pragma omp for schedule(dynamic, 1024)
+			for (int i = 0; i < NN; ++i)
 			{
-				int nn = pf->n[k];
-				if ((nn != i) && (tag[nn] != i))
+				nbr.clear();
+				int nv = NFL.Valence(i);
+				for (int j = 0; j < nv; ++j)
 				{
-					tag[nn] = i;
-					n++;
+					FSFace* pf = NFL.Face(i, j);
+					int nf = pf->Nodes();
+					for (int k = 0; k < nf; ++k)
+					{
+						int nn = pf->n[k];
+						if ((nn != i) && (std::find(nbr.begin(), nbr.end(), nn) == nbr.end()))
+						{
+							nbr.push_back(nn);
+						}
+					}
 				}
-			}
 
-			m_val[i] = n;
-			nsize += n;
+				if (pass == 0) m_val[i] = (int)nbr.size();
+				else std::copy(nbr.begin(), nbr.end(), m_node.begin() + m_off[i]);
+			}
 		}
-	}
-
-	m_off.resize(NN);
-	m_off[0] = 0;
-	for (i = 1; i<NN; ++i) m_off[i] = m_off[i - 1] + m_val[i - 1];
-
-	for (i = 0; i<NN; ++i) tag[i] = -1;
 
-	m_node.resize(nsize);
-
-	for (i = 0; i<NN; ++i)
-	{
-		int nv = NFL.Valence(i);
-		int noff = m_off[i];
-		for (j = n = 0; j<nv; ++j)
+		if (pass == 0)
 		{
-			FSFace* pf = NFL.Face(i, j);
-			int nf = pf->Nodes();
-			for (k = 0; k<nf; ++k)
-			{
-				int nn = pf->n[k];
-				if ((nn != i) && (tag[nn] != i))
-				{
-					tag[nn] = i;
-					m_node[noff + n] = nn;
-					n++;
-				}
-			}
+			if (NN == 0) break;
+			m_off[0] = 0;
+			for (int i = 1; i < NN; ++i) m_off[i] = m_off[i - 1] + m_val[i - 1];
+			m_node.resize(m_off[NN - 1] + m_val[NN - 1]);
 		}
 	}
 }
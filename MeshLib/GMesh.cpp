@@ -81,150 +81,147 @@ int GMesh::AddNode(const vec3d& r, int nodeID, int gid)
 }
 
 //-----------------------------------------------------------------------------
-void GMesh::AddEdge(int* n, int nodes, int gid)
-{
-	EDGE e;
-	if (nodes == 2)
+// The segments of the edges and the triangles of the faces, for each supported
+// number of nodes.
+namespace {
+	const int EDGE2_SEG[1][2] = { {0, 1} };
+	const int EDGE3_SEG[2][2] = { {0, 2}, {2, 1} };
+	const int EDGE4_SEG[3][2] = { {0, 2}, {2, 3}, {3, 1} };
+
+	const int TRI3_TRI[1][3] = { {0, 1, 2} };
+	const int QUAD4_TRI[2][3] = { {2, 3, 0}, {0, 1, 2} };
+	const int TRI6_TRI[4][3] = { {0, 3, 5}, {1, 4, 3}, {2, 5, 4}, {3, 4, 5} };
+	const int TRI7_TRI[6][3] = { {0, 3, 6}, {1, 6, 3}, {1, 4, 6}, {2, 6, 4}, {2, 5, 6}, {0, 6, 5} };
+	// NOTE: We don't add a central node for QUAD8 since we need a one-to-one
+	// correspondence between nodes from the original mesh and the GMesh.
+	const int QUAD8_TRI[6][3] = { {0, 4, 7}, {4, 1, 5}, {5, 2, 6}, {6, 3, 7}, {5, 6, 7}, {4, 5, 7} };
+	const int QUAD9_TRI[8][3] = { {0, 4, 7}, {4, 1, 5}, {5, 2, 6}, {6, 3, 7}, {4, 8, 7}, {4, 5, 8}, {8, 5, 6}, {8, 6, 7} };
+	const int TRI10_TRI[9][3] = { {0, 3, 7}, {1, 5, 4}, {2, 8, 6}, {9, 7, 3}, {9, 3, 4}, {9, 4, 5}, {9, 5, 6}, {9, 6, 8}, {9, 8, 7} };
+
+	const int(*EdgeSegmentTable(int nodes))[2]
 	{
-		e.n[0] = n[0];
-		e.n[1] = n[1];
-		e.pid = gid;
-		m_Edge.push_back(e);
+		switch (nodes)
+		{
+		case 2: return EDGE2_SEG;
+		case 3: return EDGE3_SEG;
+		case 4: return EDGE4_SEG;
+		}
+		return nullptr;
 	}
-	else if (nodes == 3)
+
+	const int(*FaceTriangleTable(int nodes))[3]
 	{
-		e.n[0] = n[0];
-		e.n[1] = n[2];
-		e.pid = gid;
-		m_Edge.push_back(e);
+		switch (nodes)
+		{
+		case  3: return TRI3_TRI;
+		case  4: return QUAD4_TRI;
+		case  6: return TRI6_TRI;
+		case  7: return TRI7_TRI;
+		case  8: return QUAD8_TRI;
+		case  9: return QUAD9_TRI;
+		case 10: return TRI10_TRI;
+		}
+		return nullptr;
+	}
+}
 
-		e.n[0] = n[2];
-		e.n[1] = n[1];
-		e.pid = gid;
-		m_Edge.push_back(e);
+//-----------------------------------------------------------------------------
+int GMesh::EdgeSegments(int nodes)
+{
+	switch (nodes)
+	{
+	case 2: return 1;
+	case 3: return 2;
+	case 4: return 3;
 	}
-	else if (nodes == 4)
+	return 0;
+}
+
+//-----------------------------------------------------------------------------
+int GMesh::FaceTriangles(int nodes)
+{
+	switch (nodes)
 	{
-		e.n[0] = n[0];
-		e.n[1] = n[2];
-		e.pid = gid;
-		m_Edge.push_back(e);
+	case  3: return 1;
+	case  4: return 2;
+	case  6: return 4;
+	case  7: return 6;
+	case  8: return 6;
+	case  9: return 8;
+	case 10: return 9;
+	}
+	return 0;
+}
 
-		e.n[0] = n[2];
-		e.n[1] = n[3];
-		e.pid = gid;
-		m_Edge.push_back(e);
+//-----------------------------------------------------------------------------
+void GMesh::SetEdge(int i, const int* n, int nodes, int gid)
+{
+	const int(*seg)[2] = EdgeSegmentTable(nodes);
+	if (seg == nullptr) { assert(false); return; }
 
-		e.n[0] = n[3];
-		e.n[1] = n[1];
+	int ns = EdgeSegments(nodes);
+	for (int k = 0; k < ns; ++k)
+	{
+		EDGE& e = m_Edge[i + k];
+		e.n[0] = n[seg[k][0]];
+		e.n[1] = n[seg[k][1]];
 		e.pid = gid;
-		m_Edge.push_back(e);
 	}
-	else assert(false);
+}
+
+//-----------------------------------------------------------------------------
+void GMesh::SetFace(int i, const int* n, int nodes, int gid, int smoothID, bool bext)
+{
+	const int(*tri)[3] = FaceTriangleTable(nodes);
+	if (tri == nullptr) { assert(false); return; }
+
+	int nt = FaceTriangles(nodes);
+	for (int k = 0; k < nt; ++k)
+	{
+		FACE& f = m_Face[i + k];
+		f.n[0] = n[tri[k][0]];
+		f.n[1] = n[tri[k][1]];
+		f.n[2] = n[tri[k][2]];
+		f.c[0] = GLColor(0, 0, 0);
+		f.c[1] = GLColor(0, 0, 0);
+		f.c[2] = GLColor(0, 0, 0);
+		f.pid = gid;
+		f.sid = smoothID;
+		f.bext = bext;
+		f.eid = -1;
+	}
+}
+
+//-----------------------------------------------------------------------------
+void GMesh::AddEdge(int* n, int nodes, int gid)
+{
+	int ns = EdgeSegments(nodes);
+	if (ns == 0) { assert(false); return; }
+
+	int i = Edges();
+	m_Edge.resize(i + ns);
+	SetEdge(i, n, nodes, gid);
 }
 
 //-----------------------------------------------------------------------------
 int GMesh::AddFace(int n0, int n1, int n2, int groupID, int smoothID, bool bext)
 {
-	FACE f;
-	f.n[0] = n0;
-	f.n[1] = n1;
-	f.n[2] = n2;
-	f.c[0] = GLColor(0, 0, 0);
-	f.c[1] = GLColor(0, 0, 0);
-	f.c[2] = GLColor(0, 0, 0);
-	f.pid = groupID;
-	f.sid = smoothID;
-	f.bext = bext;
-	f.eid = -1;
-	m_Face.push_back(f);
-	return ((int)m_Face.size() - 1);
+	int n[3] = { n0, n1, n2 };
+	int i = Faces();
+	m_Face.resize(i + 1);
+	SetFace(i, n, 3, groupID, smoothID, bext);
+	return i;
 }
 
 //-----------------------------------------------------------------------------
 void GMesh::AddFace(int* n, int nodes, int groupID, int smoothID, bool bext)
 {
-	switch (nodes)
-	{
-	case 3: // TRI3
-		{
-			AddFace(n[0], n[1], n[2], groupID, smoothID, bext);
-		}
-		break;
-	case 4: // QUAD4
-		{
-			AddFace(n[2], n[3], n[0], groupID, smoothID, bext);
-			AddFace(n[0], n[1], n[2], groupID, smoothID, bext);
-		}
-		break;
-	case 6: // TRI6
-		{
-			AddFace(n[0], n[3], n[5], groupID, smoothID, bext);
-			AddFace(n[1], n[4], n[3], groupID, smoothID, bext);
-			AddFace(n[2], n[5], n[4], groupID, smoothID, bext);
-			AddFace(n[3], n[4], n[5], groupID, smoothID, bext);
-		}
-		break;
-	case 7: // TRI7
-		{
-			AddFace(n[0], n[3], n[6], groupID, smoothID, bext);
-			AddFace(n[1], n[6], n[3], groupID, smoothID, bext);
-			AddFace(n[1], n[4], n[6], groupID, smoothID, bext);
-			AddFace(n[2], n[6], n[4], groupID, smoothID, bext);
-			AddFace(n[2], n[5], n[6], groupID, smoothID, bext);
-			AddFace(n[0], n[6], n[5], groupID, smoothID, bext);
-		}
-		break;
-	case 8: // QUAD8
-		{
-			// NOTE: Commented this out since I need a one-to-one correspondence
-			// between nodes from the original mesh and the GMesh
-			// we add a central node to make the improve the rendering a bit
-/*			vec3d x[8];
-			for (int i = 0; i < 8; ++i) x[i] = Node(n[i]).r;
-			vec3d r = QUAD8::eval(x, 0.0, 0.0);
-			int n9 = AddNode(r);
-*/
-			AddFace(n[0], n[4], n[7], groupID, smoothID, bext);
-			AddFace(n[4], n[1], n[5], groupID, smoothID, bext);
-			AddFace(n[5], n[2], n[6], groupID, smoothID, bext);
-			AddFace(n[6], n[3], n[7], groupID, smoothID, bext);
-//			AddFace(n9, n[7], n[4], groupID, smoothID, bext);
-//			AddFace(n9, n[4], n[5], groupID, smoothID, bext);
-//			AddFace(n9, n[5], n[6], groupID, smoothID, bext);
-//			AddFace(n9, n[6], n[7], groupID, smoothID, bext);
-			AddFace(n[5], n[6], n[7], groupID, smoothID, bext);
-			AddFace(n[4], n[5], n[7], groupID, smoothID, bext);
-		}
-		break;
-	case 9: // QUAD9
-		{
-			AddFace(n[0], n[4], n[7], groupID, smoothID, bext);
-			AddFace(n[4], n[1], n[5], groupID, smoothID, bext);
-			AddFace(n[5], n[2], n[6], groupID, smoothID, bext);
-			AddFace(n[6], n[3], n[7], groupID, smoothID, bext);
-			AddFace(n[4], n[8], n[7], groupID, smoothID, bext);
-			AddFace(n[4], n[5], n[8], groupID, smoothID, bext);
-			AddFace(n[8], n[5], n[6], groupID, smoothID, bext);
-			AddFace(n[8], n[6], n[7], groupID, smoothID, bext);
-		}
-		break;
-	case 10: // TRI10
-		{
-			AddFace(n[0], n[3], n[7], groupID, smoothID, bext);
-			AddFace(n[1], n[5], n[4], groupID, smoothID, bext);
-			AddFace(n[2], n[8], n[6], groupID, smoothID, bext);
-			AddFace(n[9], n[7], n[3], groupID, smoothID, bext);
-			AddFace(n[9], n[3], n[4], groupID, smoothID, bext);
-			AddFace(n[9], n[4], n[5], groupID, smoothID, bext);
-			AddFace(n[9], n[5], n[6], groupID, smoothID, bext);
-			AddFace(n[9], n[6], n[8], groupID, smoothID, bext);
-			AddFace(n[9], n[8], n[7], groupID, smoothID, bext);
-		}
-		break;
-	default:
-		assert(false);
-	}
+	int nt = FaceTriangles(nodes);
+	if (nt == 0) { assert(false); return; }
+
+	int i = Faces();
+	m_Face.resize(i + nt);
+	SetFace(i, n, nodes, groupID, smoothID, bext);
 }
 
 //-----------------------------------------------------------------------------
@@ -321,6 +318,7 @@ void GMesh::UpdateNormals()
 	int NF = Faces();
 
 	// calculate face normals
+#pragma omp parallel for
 	for (int i=0; i<NF; ++i) 
 	{
 		FACE& f = m_Face[i];
@@ -404,6 +402,7 @@ void GMesh::UpdateNormals()
 	}
 
 	// normalize face normals
+#pragma omp parallel for
 	for (int i=0; i<NF; ++i)
 	{
 		FACE& f = m_Face[i];
@@ -456,65 +455,74 @@ void GMesh::UpdateNormals()
 }
 */
 
-//-----------------------------------------------------------------------------
-bool CmpFace(GMesh::FACE f1, GMesh::FACE f2)
-{
-	return (f1.pid < f2.pid);
-}
-
-bool CmpEdge(GMesh::EDGE e1, GMesh::EDGE e2)
-{
-	return (e1.pid < e2.pid);
-}
-
 //-----------------------------------------------------------------------------
 void GMesh::Update()
 {
+	// Sort the faces and edges by pid. Since the pids are small integers, we
+	// use a (stable) counting sort, which also gives us the start index and 
+	// length of each surface and edge.
 	int NF = (int) m_Face.size();
 	if (NF)
 	{
-		// sort the face list by pid
-		stable_sort(m_Face.begin(), m_Face.end(), CmpFace);
-
 		// find the largest PID value
-		// since the faces are sorted, this is the last one
-		int FID = m_Face[NF-1].pid + 1;
+		int FID = 0;
+		for (int i=0; i<NF; ++i) if (m_Face[i].pid >= FID) FID = m_Face[i].pid + 1;
 
 		// find the start index and length of each surface
-		m_FIL.resize(FID);
-		for (int i=0; i<FID; ++i) m_FIL[i].second = 0;
+		m_FIL.assign(FID, pair<int, int>(0, 0));
 		for (int i=0; i<NF; ++i)
 		{
-			FACE& f = m_Face[i];
+			FACE& f = m_Face[i]; assert(f.pid >= 0);
 			m_FIL[f.pid].second += 1;
 		}
 		m_FIL[0].first = 0;
 		for (int i=1; i<FID; ++i) m_FIL[i].first = m_FIL[i-1].first + m_FIL[i-1].second;
+
+		// sort the face list
+		vector<int> pos(FID);
+		for (int i=0; i<FID; ++i) pos[i] = m_FIL[i].first;
+		vector<FACE> faces(NF);
+		for (int i=0; i<NF; ++i) faces[pos[m_Face[i].pid]++] = m_Face[i];
+		m_Face.swap(faces);
 	}
 
 	int NE = (int)m_Edge.size();
 	if (NE)
 	{
-		// sort the edge list by pid
-		stable_sort(m_Edge.begin(), m_Edge.end(), CmpEdge);
-
 		// find the largest PID value
-		// since the edges are sorted, this is the last one
-		int EID = m_Edge[NE-1].pid + 1;
+		// Edges with a negative pid are placed first
+		int EID = 0, nneg = 0;
+		for (int i=0; i<NE; ++i)
+		{
+			if (m_Edge[i].pid >= EID) EID = m_Edge[i].pid + 1;
+			if (m_Edge[i].pid < 0) nneg++;
+		}
 
 		// find the start index and length of each edge
-		m_EIL.resize(EID);
+		m_EIL.assign(EID, pair<int, int>(0, 0));
+		for (int i=0; i<NE; ++i)
+		{
+			EDGE& e = m_Edge[i];
+			if (e.pid >= 0) m_EIL[e.pid].second += 1;
+		}
 		if (EID > 0)
 		{
-			for (int i=0; i<EID; ++i) m_EIL[i].second = 0;
-			for (int i=0; i<NE; ++i)
-			{
-				EDGE& e = m_Edge[i];
-				if (e.pid >= 0) m_EIL[e.pid].second += 1;
-			}
-			m_EIL[0].first = 0;
+			m_EIL[0].first = nneg;
 			for (int i=1; i<EID; ++i) m_EIL[i].first = m_EIL[i-1].first + m_EIL[i-1].second;
 		}
+
+		// sort the edge list
+		vector<int> pos(EID);
+		for (int i=0; i<EID; ++i) pos[i] = m_EIL[i].first;
+		vector<EDGE> edges(NE);
+		int neg = 0;
+		for (int i=0; i<NE; ++i)
+		{
+			const EDGE& e = m_Edge[i];
+			if (e.pid >= 0) edges[pos[e.pid]++] = e;
+			else edges[neg++] = e;
+		}
+		m_Edge.swap(edges);
 	}
 
 	UpdateBoundingBox();
@@ -687,6 +695,7 @@ void GMesh::FindNeighbors()
 	}
 
 	// B. Find all neighbors
+#pragma omp parallel for private(j, k)
 	for (i=0; i<NF; ++i)
 	{
 		FACE& f = m_Face[i];
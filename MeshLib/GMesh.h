@@ -101,6 +101,17 @@ public:
 
 	void Attach(GMesh& m, bool bupdate = true);
 
+public:
+	// Number of triangles (segments) a face (edge) with the given number of 
+	// nodes is split into.
+	static int FaceTriangles(int nodes);
+	static int EdgeSegments(int nodes);
+
+	// Set the triangles (segments) of a face (edge), starting at index i. This
+	// can be used to fill a mesh that was allocated with Create in parallel.
+	void SetFace(int i, const int* n, int nodes, int gid = 0, int smoothID = 0, bool bext = true);
+	void SetEdge(int i, const int* n, int nodes, int gid = 0);
+
 public:
 	int	AddNode(const vec3d& r, int groupID = 0);
 	int	AddNode(const vec3d& r, int nodeID, int groupID);
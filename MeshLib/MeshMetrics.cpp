@@ -1162,7 +1162,7 @@ double Curvature(FSMesh& mesh, int node, int measure, int levels, int maxIters,
 	vec3f r0 = to_vec3f(mesh.Node(node).pos());
 
 	// get the node-face list
-	const vector<NodeFaceRef>& nfl = mesh.NodeFaceList(node);
+	FSItemRange<NodeFaceRef> nfl = mesh.NodeFaceList(node);
 	int NF = nfl.size();
 
 	// estimate surface normal
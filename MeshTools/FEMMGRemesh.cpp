@@ -33,6 +33,7 @@ SOFTWARE.*/
 #include <mmg/mmg2d/libmmg2d.h>
 #endif
 #include <MeshLib/FEMeshBuilder.h>
+#include <FSCore/CallTracer.h>
 using namespace std;
 
 extern int ET_TET[6][2]; // in lut.cpp
@@ -51,6 +52,8 @@ MMGRemesh::MMGRemesh() : FEModifier("MMG Remesh")
 
 FSMesh* MMGRemesh::Apply(FSMesh* pm)
 {
+	TRACE("MMGRemesh::Apply");
+
 	if (pm == nullptr) { SetError("This object has no mesh."); return 0; }
 	if (pm->IsType(FE_TET4))
 	{
@@ -93,200 +93,264 @@ FSMesh* FEMeshSmoothingModifier::Apply(FSMesh* pm)
 	return pnew;
 }
 
-void FEMeshSmoothingModifier::Laplacian_Smoothing(FSMesh* pnew,vector<int> hashmap)
+//-----------------------------------------------------------------------------
+// The smoothing kernels below do Jacobi-style sweeps: the new positions are 
+// calculated from the positions of the previous sweep and stored in a second
+// buffer, so that all nodes can be updated in parallel.
+static void get_positions(FSMesh* pm, vector<vec3d>& r)
+{
+	int NN = pm->Nodes();
+	r.resize(NN);
+#pragma omp parallel for
+	for (int i = 0; i < NN; ++i) r[i] = pm->Node(i).r;
+}
+
+static void set_positions(FSMesh* pm, const vector<vec3d>& r)
+{
+	int NN = pm->Nodes();
+#pragma omp parallel for
+	for (int i = 0; i < NN; ++i) pm->Node(i).r = r[i];
+}
+
+void FEMeshSmoothingModifier::Laplacian_Smoothing(FSMesh* pnew, const vector<int>& hashmap)
 {
 	//Creating a node node list
 	FSNodeNodeList NNL(pnew);
 
+	int NN = pnew->Nodes();
+	vector<vec3d> r0, r1(NN);
+	get_positions(pnew, r0);
+
 	for(int j =0 ;j<m_iteration;j++)
 	{
-		for(int i = 0; i < pnew->Nodes() ; i++)
+#pragma omp parallel for
+		for(int i = 0; i < NN ; i++)
 		{
-			if(hashmap[i] == 0)
+			int nval = NNL.Valence(i);
+			if((hashmap[i] == 0) && (nval > 0))
 			{
-				FSNode& ni = pnew->Node(i);
 				vec3d r_new; 
-				for (int k = 0; k<NNL.Valence(i);k++)
+				for (int k = 0; k<nval;k++)
 				{
-					vec3d x = pnew->Node(NNL.Node(i, k)).r;
-					r_new = r_new + x;
+					r_new = r_new + r0[NNL.Node(i, k)];
 				}
-				r_new = r_new/NNL.Valence(i);
-				r_new =(r_new * m_threshold1) + (ni.r * (1-m_threshold1));
-				ni.r = r_new;
+				r_new = r_new/nval;
+				r1[i] =(r_new * m_threshold1) + (r0[i] * (1-m_threshold1));
 			}
+			else r1[i] = r0[i];
 		}
+		r0.swap(r1);
 	}
+
+	set_positions(pnew, r0);
 }
 
-void FEMeshSmoothingModifier::Laplacian_Smoothing2(FSMesh* pnew,vector<int> hashmap)
+void FEMeshSmoothingModifier::Laplacian_Smoothing2(FSMesh* pnew, const vector<int>& hashmap)
 {
 	//Creating a node node list
 	FSNodeNodeList NNL(pnew);
 
+	int NN = pnew->Nodes();
+	vector<vec3d> r0, r1(NN);
+	get_positions(pnew, r0);
+
 	for(int j =0 ;j<m_iteration;j++)
 	{
-		for(int i = 0; i < pnew->Nodes() ; i++)
+#pragma omp parallel for
+		for(int i = 0; i < NN ; i++)
 		{
+			r1[i] = r0[i];
 			if(hashmap[i] == 0)
 			{
-				FSNode& ni = pnew->Node(i);
+				vec3d ri = r0[i];
 				vec3d r_new; 
 				double sum_dist=0;
 				for (int k = 0; k<NNL.Valence(i);k++)
 				{
-					vec3d x = pnew->Node(NNL.Node(i, k)).r;
-					double dist = (x - ni.r).Length();
+					vec3d x = r0[NNL.Node(i, k)];
+					double dist = (x - ri).Length();
 					r_new = r_new + (x * dist);
 					sum_dist += dist;
 				}
-				r_new = r_new/sum_dist;
-				r_new =(r_new * m_threshold1) + (ni.r * (1-m_threshold1));
-				ni.r = r_new;
+				if (sum_dist > 0)
+				{
+					r_new = r_new/sum_dist;
+					r1[i] =(r_new * m_threshold1) + (ri * (1-m_threshold1));
+				}
 			}
 		}
+		r0.swap(r1);
 	}
+
+	set_positions(pnew, r0);
 }
 
-void FEMeshSmoothingModifier::Taubin_Smoothing(FSMesh* pnew,vector<int> hashmap)
+void FEMeshSmoothingModifier::Taubin_Smoothing(FSMesh* pnew, const vector<int>& hashmap)
 {
 	//Creating a node node list
 	FSNodeNodeList NNL(pnew);
 	
-	vector<vec3d>phi_node;
-	phi_node.reserve(pnew->Nodes());
+	int NN = pnew->Nodes();
+	vector<vec3d> r0, r1(NN);
+	get_positions(pnew, r0);
+
+	vector<vec3d> phi_node(NN);
 	for(int j =0 ;j<m_iteration;j++)
 	{		
-		for(int i = 0; i < pnew->Nodes() ; i++)
+#pragma omp parallel for
+		for(int i = 0; i < NN ; i++)
 		{
-			FSNode& ni = pnew->Node(i);
+			int nval = NNL.Valence(i);
 			vec3d r_sum;
-			for (int k = 0; k<NNL.Valence(i);k++)
+			if (nval > 0)
 			{
-				vec3d x = pnew->Node(NNL.Node(i, k)).r;
-				r_sum += x;
+				for (int k = 0; k<nval;k++) r_sum += r0[NNL.Node(i, k)];
+				r_sum = r_sum/nval;
+				r_sum -= r0[i];
 			}
-			r_sum = r_sum/NNL.Valence(i);
-			r_sum -= ni.r;
-			phi_node.push_back(r_sum);
-		}		
-		for(int i = 0; i < pnew->Nodes() ; i++)
+			phi_node[i] = r_sum;
+		}
+
+#pragma omp parallel for
+		for(int i = 0; i < NN ; i++)
 		{
-			if(hashmap[i] == 0)
+			int nval = NNL.Valence(i);
+			if((hashmap[i] == 0) && (nval > 0))
 			{
-				FSNode& ni = pnew->Node(i);
 				vec3d phi_old = phi_node[i];
 
 				vec3d r_sq_sum,phi_sq_old; 
-				for (int k = 0; k<NNL.Valence(i);k++)
+				for (int k = 0; k<nval;k++)
 				{
 					int neigh_node = NNL.Node(i, k);
 					r_sq_sum += phi_node[neigh_node];
 				}
-				phi_sq_old = r_sq_sum/NNL.Valence(i);
+				phi_sq_old = r_sq_sum/nval;
 				phi_sq_old -= phi_old;
 
-				ni.r = ni.r - (phi_old * (m_threshold2 - m_threshold1)) - (phi_sq_old *(m_threshold1*m_threshold2));
+				r1[i] = r0[i] - (phi_old * (m_threshold2 - m_threshold1)) - (phi_sq_old *(m_threshold1*m_threshold2));
 			}
+			else r1[i] = r0[i];
 		}
-		phi_node.clear();
+		r0.swap(r1);
 	}
+
+	set_positions(pnew, r0);
 }
 
-void FEMeshSmoothingModifier::Crease_Enhancing_Diffusion(FSMesh* pnew,vector<int> hashmap)
+void FEMeshSmoothingModifier::Crease_Enhancing_Diffusion(FSMesh* pnew, const vector<int>& hashmap)
 {
 	//creating Node Element list
 	FSNodeFaceList NFL;
 	NFL.Build(pnew);
 
-	//calculating m(R) for each face i.e for each triangle	
-	vector<FSFace*> mR ;
-	vector<vec3d>m_R;
-	vector<vec3d>m_R_new;	
-	mR.reserve(pnew->Faces());
-	m_R.reserve(pnew->Faces());
-	m_R_new.reserve(pnew->Faces());
+	int NF = pnew->Faces();
+	int NN = pnew->Nodes();
+
+	// The neighbouring faces of each face (i.e. the faces that share a node with it)
+	// don't change, so we collect them once in a compressed list.
+	vector<int> nbrOff(NF + 1, 0), nbrFace;
+	{
+		vector< vector<int> > nbr(NF);
+#pragma omp parallel for
+		for (int i = 0; i < NF; i++)
+		{
+			FSFace& fa = pnew->Face(i);
+			vector<int>& fi = nbr[i];
+			for (int j = 0; j < 3; j++)
+			{
+				int nodeID = fa.n[j];
+				for (int k = 0; k < NFL.Valence(nodeID); k++)
+				{
+					int fid = NFL.FaceIndex(nodeID, k);
+					if (fid != i) fi.push_back(fid);
+				}
+			}
+			sort(fi.begin(), fi.end());
+			fi.erase(unique(fi.begin(), fi.end()), fi.end());
+		}
+		for (int i = 0; i < NF; i++) nbrOff[i + 1] = nbrOff[i] + (int)nbr[i].size();
+		nbrFace.resize(nbrOff[NF]);
+#pragma omp parallel for
+		for (int i = 0; i < NF; i++) std::copy(nbr[i].begin(), nbr[i].end(), nbrFace.begin() + nbrOff[i]);
+	}
 
 	//for first iteration m_R are normals
-	for(int i =0; i< pnew->Faces();i++)
+	vector<vec3d> m_R(NF), m_R_new(NF);
+	for(int i =0; i< NF;i++)
 	{
 		FSFace& fa = pnew->Face(i);
-		m_R.push_back(to_vec3d(fa.m_fn));
+		m_R[i] = to_vec3d(fa.m_fn);
 	}
+
+	vector<vec3d> r0, r1(NN);
+	get_positions(pnew, r0);
+
+	vector<vec3d> centroid(NF);
+	vector<double> area(NF);
 	for (int iter = 0 ; iter< m_iteration;iter++)
-	{				
+	{
+		// update the face centroids and areas
+#pragma omp parallel for
+		for (int i = 0; i < NF; i++)
+		{
+			FSFace& fa = pnew->Face(i);
+			vec3d r[3]; //three nodes of the face
+			r[0] = r0[fa.n[0]];
+			r[1] = r0[fa.n[1]];
+			r[2] = r0[fa.n[2]];
+			centroid[i] = (r[0] + r[1] + r[2]) / 3;
+			area[i] = area_triangle(r);
+		}
+
 		//for each face calculate m_R
-		for(int i =0;i<pnew->Faces();i++)
+#pragma omp parallel for
+		for(int i =0;i<NF;i++)
 		{
 			FSFace& fa = pnew->Face(i);				
-			vec3d centroid_R = (pnew->Node(fa.n[0]).r + pnew->Node(fa.n[1]).r + pnew->Node(fa.n[2]).r )/3;
-			//finding the neighbouring faces
-			for(int j =0 ;j<3 ;j++)
-			{
-				int nodeID = fa.n[j];
-				for (int k = 0; k<NFL.Valence(nodeID);k++)
-				{
-					FSFace *fa1 = NFL.Face(nodeID,k);
-					if(fa1->m_ntag != 1 && fa1->m_elem[0].eid != i)
-					{
-						fa1->m_ntag = 1;
-						mR.push_back(fa1);
-					}
-				}					
-			}
-			//now we have the neighbouring faces in mR list
+			vec3d centroid_R = centroid[i];
+
 			double weight =0;
-			m_R_new.push_back(vec3d(0,0,0));
-			for(int k =0;k<mR.size();k++)
+			vec3d mR;
+			for(int k = nbrOff[i]; k < nbrOff[i + 1]; k++)
 			{
-				FSFace *fa1 = mR[k];
-				vec3d r[3]; //three nodes of the face
-				r[0] = pnew->Node(fa1->n[0]).r;
-				r[1] = pnew->Node(fa1->n[1]).r;
-				r[2] = pnew->Node(fa1->n[2]).r;
-				vec3d centroid_S = (r[0]+r[1]+r[2])/3;
-				double dist = (centroid_S - centroid_R).Length();
-				double angle = acos((fa.m_fn * fa1->m_fn)/(fa.m_fn.Length() * fa1->m_fn.Length()));//angle between the normals
-				double weight1 = area_triangle(r) * exp(-m_threshold1 * angle*angle*dist*dist);
+				int nf = nbrFace[k];
+				FSFace& fa1 = pnew->Face(nf);
+				double dist = (centroid[nf] - centroid_R).Length();
+				double angle = acos((fa.m_fn * fa1.m_fn)/(fa.m_fn.Length() * fa1.m_fn.Length()));//angle between the normals
+				double weight1 = area[nf] * exp(-m_threshold1 * angle*angle*dist*dist);
 				weight += weight1;
-				m_R_new[i] += m_R[fa1->m_elem[0].eid] * weight1;
-				fa1->m_ntag = 0;
+				mR += m_R[nf] * weight1;
 			}
-			m_R_new[i] = m_R_new[i]/weight;	
-			mR.clear();
+			m_R_new[i] = (weight > 0 ? mR/weight : m_R[i]);
 		}
 		//we have m_R_new for each face.
-		for(int i =0 ;i<m_R_new.size();i++)
-		{
-			m_R[i] = m_R_new[i];
-		}
-		m_R_new.clear();
+		m_R.swap(m_R_new);
+
 		//For each node modify its coodinates
-		for(int i = 0 ;i < pnew->Nodes();i++)
+#pragma omp parallel for
+		for(int i = 0 ;i < NN;i++)
 		{
+			r1[i] = r0[i];
 			if(hashmap[i] == 0) //not the edge node
 			{
-				FSNode& ni = pnew->Node(i);
 				vec3d vR; 
 				double weight=0;
 				for (int k = 0; k<NFL.Valence(i);k++)
 				{
-					FSFace *fa1 = NFL.Face(i,k);
-					vec3d r[3]; //three nodes of the face
-					r[0] = pnew->Node(fa1->n[0]).r;
-					r[1] = pnew->Node(fa1->n[1]).r;
-					r[2] = pnew->Node(fa1->n[2]).r;
-					vec3d centroid = (r[0]+r[1]+r[2])/3;
-					weight += area_triangle(r);
-					vec3d PC = centroid - ni.r;
-					double temp = PC * m_R[fa1->m_elem[0].eid];
-					vR += (m_R[fa1->m_elem[0].eid] * temp)*area_triangle(r);
+					int nf = NFL.FaceIndex(i, k);
+					weight += area[nf];
+					vec3d PC = centroid[nf] - r0[i];
+					double temp = PC * m_R[nf];
+					vR += (m_R[nf] * temp)*area[nf];
 				}	
-				vR = vR/weight;
-				ni.r = ni.r + vR;
+				if (weight > 0) r1[i] = r0[i] + vR/weight;
 			}				
 		}
+		r0.swap(r1);
 	}//end of one iteration
+
+	set_positions(pnew, r0);
 }
 
 double frand(double dmin = 0.0, double dmax = 1.0)
@@ -295,7 +359,7 @@ double frand(double dmin = 0.0, double dmax = 1.0)
 	return (dmin + f*(dmax - dmin));
 }
 
-void FEMeshSmoothingModifier::Add_Noise(FSMesh* pnew, vector<int> hashmap)
+void FEMeshSmoothingModifier::Add_Noise(FSMesh* pnew, const vector<int>& hashmap)
 {
 	for (int j = 0; j<m_iteration; j++)
 	{
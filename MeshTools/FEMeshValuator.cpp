@@ -32,6 +32,12 @@ SOFTWARE.*/
 #include <MeshLib/FENodeData.h>
 #include <MeshLib/FEElementData.h>
 #include <MeshLib/MeshTools.h>
+#include <MeshLib/hex.h>
+#include <set>
+
+// in MeshTools\lut.cpp
+extern int ET_HEX[12][2];
+extern int ET_TET[6][2];
 
 //-----------------------------------------------------------------------------
 // constructor
@@ -40,6 +46,12 @@ FEMeshValuator::FEMeshValuator(FSMesh& mesh) : m_mesh(mesh)
 	m_curvature_levels = 1;
 	m_curvature_maxiters = 10;
 	m_curvature_extquad = false;
+
+	for (int i = 0; i < MAX_DEFAULT_FIELDS; ++i)
+	{
+		m_cache[i].valid = false;
+		m_cache[i].modCounter = 0;
+	}
 }
 
 //-----------------------------------------------------------------------------
@@ -68,18 +80,21 @@ std::vector< std::string > FEMeshValuator::GetDataFieldNames()
 //-----------------------------------------------------------------------------
 void FEMeshValuator::SetCurvatureLevels(int levels)
 {
+	if (levels != m_curvature_levels) m_cache[PRINC_CURVE_1].valid = m_cache[PRINC_CURVE_2].valid = false;
 	m_curvature_levels = levels;
 }
 
 //-----------------------------------------------------------------------------
 void FEMeshValuator::SetCurvatureMaxIters(int maxIters)
 {
+	if (maxIters != m_curvature_maxiters) m_cache[PRINC_CURVE_1].valid = m_cache[PRINC_CURVE_2].valid = false;
 	m_curvature_maxiters = maxIters;
 }
 
 //-----------------------------------------------------------------------------
 void FEMeshValuator::SetCurvatureExtQuad(bool b)
 {
+	if (b != m_curvature_extquad) m_cache[PRINC_CURVE_1].valid = m_cache[PRINC_CURVE_2].valid = false;
 	m_curvature_extquad = b;
 }
 
@@ -94,24 +109,14 @@ void FEMeshValuator::Evaluate(int nfield)
 	data.Init(&m_mesh, 0.0, 0);
 	if (nfield < MAX_DEFAULT_FIELDS)
 	{
+		UpdateCache(std::vector<int>(1, nfield));
+		FieldCache& c = m_cache[nfield];
+
 		if ((nfield == PRINC_CURVE_1) || (nfield == PRINC_CURVE_2))
 		{
-			if (m_mesh.IsShell())
+			if (c.val.empty() == false)
 			{
-				int NN = m_mesh.Nodes();
-				vector<double> nodeData(NN, 0.0);
-				for (int i = 0; i < NN; ++i)
-				{
-					try {
-						double val = EvaluateNode(i, nfield);
-						nodeData[i] = val;
-					}
-					catch (...)
-					{
-
-					}
-				}
-
+#pragma omp parallel for
 				for (int i = 0; i < NE; ++i)
 				{
 					FSElement& el = m_mesh.Element(i);
@@ -121,7 +126,7 @@ void FEMeshValuator::Evaluate(int nfield)
 						int ne = el.Nodes();
 						for (int j = 0; j < ne; ++j)
 						{
-							double vj = nodeData[el.m_node[j]];
+							double vj = c.val[el.m_node[j]];
 							data.SetElementValue(i, j, vj);
 						}
 					}
@@ -130,20 +135,14 @@ void FEMeshValuator::Evaluate(int nfield)
 		}
 		else
 		{
+#pragma omp parallel for
 			for (int i = 0; i < NE; ++i)
 			{
 				FSElement& el = m_mesh.Element(i);
-				if (el.IsVisible())
+				if (el.IsVisible() && c.ok[i])
 				{
-					try {
-						double val = EvaluateElement(i, nfield);
-						data.SetElementValue(i, val);
-						data.SetElementDataTag(i, 1);
-					}
-					catch (...)
-					{
-						data.SetElementDataTag(i, 0);
-					}
+					data.SetElementValue(i, c.val[i]);
+					data.SetElementDataTag(i, 1);
 				}
 				else data.SetElementDataTag(i, 0);
 			}
@@ -238,6 +237,260 @@ void FEMeshValuator::Evaluate(int nfield)
 	data.UpdateValueRange();
 }
 
+//-----------------------------------------------------------------------------
+// Fields that have a specialized implementation for linear tets and hexes.
+// These compute all requested metrics from a single load of the nodal coordinates
+// using straight-line code instead of the generic per-field functions.
+static const unsigned int TET4_FIELDS =
+	(1u << FEMeshValuator::ELEMENT_VOLUME) | (1u << FEMeshValuator::JACOBIAN) |
+	(1u << FEMeshValuator::TET_QUALITY) | (1u << FEMeshValuator::TET_MIN_DIHEDRAL_ANGLE) |
+	(1u << FEMeshValuator::TET_MAX_DIHEDRAL_ANGLE) | (1u << FEMeshValuator::MIN_EDGE_LENGTH) |
+	(1u << FEMeshValuator::MAX_EDGE_LENGTH);
+
+static const unsigned int HEX8_FIELDS =
+	(1u << FEMeshValuator::ELEMENT_VOLUME) | (1u << FEMeshValuator::JACOBIAN) |
+	(1u << FEMeshValuator::MIN_EDGE_LENGTH) | (1u << FEMeshValuator::MAX_EDGE_LENGTH);
+
+static void EvaluateTet4Metrics(const vec3d* p, unsigned int mask, double* v)
+{
+	// edge lengths
+	double L2min = 1e99, L2max = 0.0;
+	for (int i = 0; i < 6; ++i)
+	{
+		vec3d e = p[ET_TET[i][1]] - p[ET_TET[i][0]];
+		double L2 = e*e;
+		L2min = (L2 < L2min ? L2 : L2min);
+		L2max = (L2 > L2max ? L2 : L2max);
+	}
+	v[FEMeshValuator::MIN_EDGE_LENGTH] = sqrt(L2min);
+	v[FEMeshValuator::MAX_EDGE_LENGTH] = sqrt(L2max);
+
+	// the jacobian is constant
+	vec3d a = p[1] - p[0];
+	vec3d b = p[2] - p[0];
+	vec3d c = p[3] - p[0];
+	vec3d bc = b ^ c;
+	double detJ = a*bc;
+	v[FEMeshValuator::JACOBIAN] = detJ;
+	v[FEMeshValuator::ELEMENT_VOLUME] = detJ / 6.0;
+
+	// radius of the circumsphere over the shortest edge
+	if (mask & (1u << FEMeshValuator::TET_QUALITY))
+	{
+		vec3d ca = c ^ a;
+		vec3d ab = a ^ b;
+		vec3d x = (bc*(a*a) + ca*(b*b) + ab*(c*c)) / (2.0*detJ);
+		v[FEMeshValuator::TET_QUALITY] = x.Length() / sqrt(L2min);
+	}
+
+	// dihedral angles
+	const unsigned int angles = (1u << FEMeshValuator::TET_MIN_DIHEDRAL_ANGLE) | (1u << FEMeshValuator::TET_MAX_DIHEDRAL_ANGLE);
+	if (mask & angles)
+	{
+		vec3d fn[4];
+		for (int i = 0; i < 4; ++i)
+		{
+			const int* m = FTTET[i];
+			fn[i] = (p[m[1]] - p[m[0]]) ^ (p[m[2]] - p[m[0]]);
+			fn[i].Normalize();
+		}
+
+		const int LT[6][2] = { { 0, 1 }, { 1, 2 }, { 0, 2 }, { 0, 3 }, { 1, 3 }, { 2, 3 } };
+		double cwmin = 1.0, cwmax = -1.0;
+		for (int i = 0; i < 6; ++i)
+		{
+			double cw = -fn[LT[i][0]] * fn[LT[i][1]];
+			cwmin = (cw < cwmin ? cw : cwmin);
+			cwmax = (cw > cwmax ? cw : cwmax);
+		}
+		v[FEMeshValuator::TET_MIN_DIHEDRAL_ANGLE] = 180.0*acos(cwmax) / PI;
+		v[FEMeshValuator::TET_MAX_DIHEDRAL_ANGLE] = 180.0*acos(cwmin) / PI;
+	}
+}
+
+// shape function derivatives of a hex8 at its integration points
+struct HEX8_TABLE
+{
+	double Gr[8][8], Gs[8][8], Gt[8][8];
+};
+
+static void EvaluateHex8Metrics(const vec3d* p, const HEX8_TABLE& T, double* v)
+{
+	// edge lengths
+	double L2min = 1e99, L2max = 0.0;
+	for (int i = 0; i < 12; ++i)
+	{
+		vec3d e = p[ET_HEX[i][1]] - p[ET_HEX[i][0]];
+		double L2 = e*e;
+		L2min = (L2 < L2min ? L2 : L2min);
+		L2max = (L2 > L2max ? L2 : L2max);
+	}
+	v[FEMeshValuator::MIN_EDGE_LENGTH] = sqrt(L2min);
+	v[FEMeshValuator::MAX_EDGE_LENGTH] = sqrt(L2max);
+
+	// volume and min jacobian (all gauss weights are one)
+	double vol = 0.0, Jmin = 0.0;
+	for (int n = 0; n < 8; ++n)
+	{
+		double J[3][3] = { {0} };
+		for (int i = 0; i < 8; ++i)
+		{
+			double gr = T.Gr[n][i], gs = T.Gs[n][i], gt = T.Gt[n][i];
+			J[0][0] += gr*p[i].x; J[0][1] += gs*p[i].x; J[0][2] += gt*p[i].x;
+			J[1][0] += gr*p[i].y; J[1][1] += gs*p[i].y; J[1][2] += gt*p[i].y;
+			J[2][0] += gr*p[i].z; J[2][1] += gs*p[i].z; J[2][2] += gt*p[i].z;
+		}
+
+		double detJ = J[0][0] * (J[1][1] * J[2][2] - J[1][2] * J[2][1])
+			+ J[0][1] * (J[1][2] * J[2][0] - J[2][2] * J[1][0])
+			+ J[0][2] * (J[1][0] * J[2][1] - J[1][1] * J[2][0]);
+
+		vol += detJ;
+		if ((n == 0) || (detJ < Jmin)) Jmin = detJ;
+	}
+	v[FEMeshValuator::ELEMENT_VOLUME] = vol;
+	v[FEMeshValuator::JACOBIAN] = Jmin;
+}
+
+//-----------------------------------------------------------------------------
+void FEMeshValuator::UpdateCache(const std::vector<int>& fields)
+{
+	unsigned int modCounter = m_mesh.ModificationCounter();
+	int NE = m_mesh.Elements();
+
+	// find the element fields that need to be evaluated
+	std::vector<int> todo;
+	for (int nfield : fields)
+	{
+		if ((nfield < 0) || (nfield >= MAX_DEFAULT_FIELDS)) continue;
+
+		FieldCache& c = m_cache[nfield];
+		if (c.valid && (c.modCounter == modCounter)) continue;
+
+		if ((nfield == PRINC_CURVE_1) || (nfield == PRINC_CURVE_2))
+		{
+			// the curvature uses the face tags, so this is evaluated serially
+			UpdateCurvatureCache(nfield);
+		}
+		else
+		{
+			c.val.assign(NE, 0.0);
+			c.ok.assign(NE, 0);
+			todo.push_back(nfield);
+		}
+		c.valid = true;
+		c.modCounter = modCounter;
+	}
+	if (todo.empty()) return;
+
+	int nf = (int)todo.size();
+	unsigned int mask = 0;
+	for (int k = 0; k < nf; ++k) mask |= (1u << todo[k]);
+
+	HEX8_TABLE hex8;
+	double gr[8], gs[8], gt[8], gw[8];
+	HEX8::gauss_data(gr, gs, gt, gw);
+	for (int n = 0; n < 8; ++n) HEX8::shape_deriv(hex8.Gr[n], hex8.Gs[n], hex8.Gt[n], gr[n], gs[n], gt[n]);
+
+	// Some of the metric functions initialize static tables the first time they
+	// are called, so evaluate one element of each type before going parallel.
+	std::set<int> types;
+	std::vector<char> done(NE, 0);
+	for (int i = 0; i < NE; ++i)
+	{
+		int ntype = m_mesh.Element(i).Type();
+		if (types.find(ntype) == types.end())
+		{
+			types.insert(ntype);
+			for (int k = 0; k < nf; ++k)
+			{
+				FieldCache& c = m_cache[todo[k]];
+				try {
+					c.val[i] = EvaluateElement(i, todo[k]);
+					c.ok[i] = 1;
+				}
+				catch (...) {}
+			}
+			done[i] = 1;
+		}
+	}
+
+	// evaluate all requested fields in one pass
+#pragma omp parallel for schedule(dynamic, 1024)
+	for (int i = 0; i < NE; ++i)
+	{
+		if (done[i]) continue;
+
+		const FSElement& el = m_mesh.Element(i);
+
+		// specialized evaluation of linear tets and hexes
+		double v[MAX_DEFAULT_FIELDS];
+		unsigned int handled = 0;
+		if ((el.Type() == FE_TET4) && (mask & TET4_FIELDS))
+		{
+			vec3d r[4];
+			for (int j = 0; j < 4; ++j) r[j] = m_mesh.Node(el.m_node[j]).r;
+			EvaluateTet4Metrics(r, mask, v);
+			handled = TET4_FIELDS;
+		}
+		else if ((el.Type() == FE_HEX8) && (mask & HEX8_FIELDS))
+		{
+			vec3d r[8];
+			for (int j = 0; j < 8; ++j) r[j] = m_mesh.Node(el.m_node[j]).r;
+			EvaluateHex8Metrics(r, hex8, v);
+			handled = HEX8_FIELDS;
+		}
+
+		for (int k = 0; k < nf; ++k)
+		{
+			int nfield = todo[k];
+			FieldCache& c = m_cache[nfield];
+			if (handled & (1u << nfield))
+			{
+				c.val[i] = v[nfield];
+				c.ok[i] = 1;
+			}
+			else
+			{
+				try {
+					c.val[i] = EvaluateElement(i, nfield);
+					c.ok[i] = 1;
+				}
+				catch (...)
+				{
+					c.ok[i] = 0;
+				}
+			}
+		}
+	}
+}
+
+//-----------------------------------------------------------------------------
+void FEMeshValuator::UpdateCurvatureCache(int nfield)
+{
+	FieldCache& c = m_cache[nfield];
+	c.val.clear();
+	c.ok.clear();
+
+	// curvature is only evaluated for shell meshes
+	if (m_mesh.IsShell() == false) return;
+
+	int NN = m_mesh.Nodes();
+	c.val.assign(NN, 0.0);
+	c.ok.assign(NN, 0);
+	for (int i = 0; i < NN; ++i)
+	{
+		try {
+			c.val[i] = EvaluateNode(i, nfield);
+			c.ok[i] = 1;
+		}
+		catch (...)
+		{
+
+		}
+	}
+}
+
 //-----------------------------------------------------------------------------
 // Evaluate element data
 double FEMeshValuator::EvaluateElement(int n, int nfield, int* err)
@@ -59,6 +59,10 @@ public:
 	// evaluate the particular data field
 	void Evaluate(int nfield);
 
+	// make sure the cached values of the (default) data fields are up to date.
+	// All element metrics are evaluated in a single parallel pass over the elements.
+	void UpdateCache(const std::vector<int>& fields);
+
 	// evaluate just one element
 	double EvaluateElement(int i, int nfield, int* err = 0);
 	double EvaluateNode(int i, int nfield, int* err = 0);
@@ -66,11 +70,16 @@ public:
 	// get the list of all datafield names
 	static std::vector< std::string > GetDataFieldNames();
 
+	FSMesh& GetMesh() { return m_mesh; }
+
 public:
 	void SetCurvatureLevels(int levels);
 	void SetCurvatureMaxIters(int maxIters);
 	void SetCurvatureExtQuad(bool b);
 
+private:
+	void UpdateCurvatureCache(int nfield);
+
 private:
 	FSMesh& m_mesh;
 
@@ -78,6 +87,16 @@ private:
 	int	m_curvature_levels;
 	int	m_curvature_maxiters;
 	bool m_curvature_extquad;
+
+	// cached values of the default data fields
+	struct FieldCache
+	{
+		bool				valid;
+		unsigned int		modCounter;	// mesh modification counter when this was evaluated
+		std::vector<double>	val;		// element values (or nodal values for curvature)
+		std::vector<char>	ok;			// zero if the value could not be evaluated
+	};
+	FieldCache	m_cache[MAX_DEFAULT_FIELDS];
 };
 
 class FESurfaceMeshValuator
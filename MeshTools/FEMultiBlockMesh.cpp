@@ -34,6 +34,7 @@ SOFTWARE.*/
 #include <algorithm>
 #include "FESelection.h"
 #include <GeomLib/GGroup.h>
+#include <FSCore/CallTracer.h>
 
 void MBBlock::SetNodes(int n1,int n2,int n3,int n4,int n5,int n6,int n7,int n8)
 {
@@ -126,6 +127,8 @@ bool FEMultiBlockMesh::BuildMultiBlock()
 //
 FSMesh* FEMultiBlockMesh::BuildMesh()
 {
+	TRACE("FEMultiBlockMesh::BuildMesh");
+
 	if ((m_elemType != FE_HEX8) && (m_elemType != FE_HEX20) && (m_elemType != FE_HEX27))
 	{
 		assert(false);
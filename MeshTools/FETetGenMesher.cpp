@@ -30,6 +30,7 @@ SOFTWARE.*/
 #include <GeomLib/geom.h>
 #include <GeomLib/GSurfaceMeshObject.h>
 #include "FEModifier.h"
+#include <FSCore/CallTracer.h>
 using namespace std;
 
 //-----------------------------------------------------------------------------
@@ -97,6 +98,8 @@ int FETetGenMesher::ElementType()
 //
 FSMesh* FETetGenMesher::BuildMesh()
 {
+	TRACE("FETetGenMesher::BuildMesh");
+
 	GSurfaceMeshObject* surfObj = dynamic_cast<GSurfaceMeshObject*>(m_po);
 	if (surfObj)
 	{
@@ -30,14 +30,137 @@ SOFTWARE.*/
 #include <MeshLib/FENodeNodeList.h>
 #include <MeshLib/FENodeElementList.h>
 #include <MeshLib/MeshMetrics.h>
+#include <algorithm>
+#include <set>
 
+//-----------------------------------------------------------------------------
+// Sparse symmetric matrix in compressed row format. The column indices
+// of each row are sorted. 
+class LaplaceMatrix
+{
+public:
+	int Rows() const { return (int)m_off.size() - 1; }
+
+	// find the position of an entry (or -1 if it's not in the sparsity pattern)
+	int Find(int i, int j) const
+	{
+		const int* c0 = m_col.data() + m_off[i];
+		const int* c1 = m_col.data() + m_off[i + 1];
+		const int* c = std::lower_bound(c0, c1, j);
+		return ((c != c1) && (*c == j) ? (int)(c - m_col.data()) : -1);
+	}
+
+	// y = A*x
+	void Multiply(const vector<double>& x, vector<double>& y) const
+	{
+		int N = Rows();
+#pragma omp parallel for
+		for (int i = 0; i < N; ++i)
+		{
+			double s = 0.0;
+			for (int k = m_off[i]; k < m_off[i + 1]; ++k) s += m_val[k] * x[m_col[k]];
+			y[i] = s;
+		}
+	}
+
+public:
+	vector<int>		m_off;	// row offsets (size = rows + 1)
+	vector<int>		m_col;	// column indices
+	vector<double>	m_val;	// values
+	vector<int>		m_diag;	// position of diagonal entries
+};
+
+static double dot_product(const vector<double>& a, const vector<double>& b)
+{
+	int N = (int)a.size();
+	double s = 0.0;
+#pragma omp parallel for reduction(+:s)
+	for (int i = 0; i < N; ++i) s += a[i] * b[i];
+	return s;
+}
+
+//-----------------------------------------------------------------------------
+// Incomplete Cholesky factorization (no fill-in) of a symmetric matrix.
+// The factor L is stored row-wise, with the diagonal as the last entry of each row.
+class ICPreconditioner
+{
+public:
+	bool Create(const LaplaceMatrix& A)
+	{
+		int N = A.Rows();
+		m_off.assign(N + 1, 0);
+		for (int i = 0; i < N; ++i) m_off[i + 1] = m_off[i] + (A.m_diag[i] - A.m_off[i] + 1);
+		m_col.resize(m_off[N]);
+		m_val.resize(m_off[N]);
+		for (int i = 0; i < N; ++i)
+		{
+			std::copy(A.m_col.begin() + A.m_off[i], A.m_col.begin() + A.m_diag[i] + 1, m_col.begin() + m_off[i]);
+			std::copy(A.m_val.begin() + A.m_off[i], A.m_val.begin() + A.m_diag[i] + 1, m_val.begin() + m_off[i]);
+		}
+
+		for (int i = 0; i < N; ++i)
+		{
+			int ni = m_off[i + 1] - 1;
+			for (int k = m_off[i]; k <= ni; ++k)
+			{
+				// subtract the product of the rows i and j (up to column j)
+				int j = m_col[k];
+				int nj = m_off[j + 1] - 1;
+				double s = m_val[k];
+				for (int ka = m_off[i], kb = m_off[j]; (ka < k) && (kb < nj);)
+				{
+					if      (m_col[ka] < m_col[kb]) ka++;
+					else if (m_col[ka] > m_col[kb]) kb++;
+					else s -= m_val[ka++] * m_val[kb++];
+				}
+
+				if (k < ni) m_val[k] = s / m_val[nj];
+				else
+				{
+					if (s <= 0.0) return false;
+					m_val[k] = sqrt(s);
+				}
+			}
+		}
+		return true;
+	}
+
+	// z = (L*L^T)^-1 * r
+	void Apply(const vector<double>& r, vector<double>& z) const
+	{
+		int N = (int)m_off.size() - 1;
+		z = r;
+		for (int i = 0; i < N; ++i)
+		{
+			int ni = m_off[i + 1] - 1;
+			double s = z[i];
+			for (int k = m_off[i]; k < ni; ++k) s -= m_val[k] * z[m_col[k]];
+			z[i] = s / m_val[ni];
+		}
+		for (int i = N - 1; i >= 0; --i)
+		{
+			int ni = m_off[i + 1] - 1;
+			z[i] /= m_val[ni];
+			for (int k = m_off[i]; k < ni; ++k) z[m_col[k]] -= m_val[k] * z[i];
+		}
+	}
+
+private:
+	vector<int>		m_off;
+	vector<int>		m_col;
+	vector<double>	m_val;
+};
+
+//-----------------------------------------------------------------------------
 LaplaceSolver::LaplaceSolver()
 {
 	m_maxIters = 1000;
 	m_tol = 1e-4;
 	m_w = 1.0;
+	m_method = JACOBI_PCG;
 
 	m_niters = 0;
+	m_relNorm = 0.0;
 }
 
 void LaplaceSolver::SetMaxIterations(int n)
@@ -55,6 +178,11 @@ void LaplaceSolver::SetRelaxation(double w)
 	m_w = w;
 }
 
+void LaplaceSolver::SetSolverMethod(int n)
+{
+	m_method = n;
+}
+
 int LaplaceSolver::GetIterationCount() const
 {
 	return m_niters;
@@ -65,6 +193,11 @@ double LaplaceSolver::GetRelativeNorm() const
 	return m_relNorm;
 }
 
+const vector<double>& LaplaceSolver::GetConvergenceHistory() const
+{
+	return m_history;
+}
+
 // Solves the Laplace equation on the mesh.
 // Input: val = initial values for all nodes
 //        bn  = boundary flags: 0 = free, 1 = fixed
@@ -72,6 +205,8 @@ double LaplaceSolver::GetRelativeNorm() const
 bool LaplaceSolver::Solve(FSMesh* pm, vector<double>& val, vector<int>& bn, int elemTag)
 {
 	m_niters = 0;
+	m_relNorm = 0.0;
+	m_history.clear();
 
 	// make sure the value and flag arrays are of the correct size
 	int NN = pm->Nodes();
@@ -120,10 +255,28 @@ bool LaplaceSolver::Solve(FSMesh* pm, vector<double>& val, vector<int>& bn, int
 	}
 
 	// calculate the element volumes
+	// The volume functions initialize static integration tables the first time
+	// they are called, so evaluate one element of each type before going parallel.
 	vector<double> Ve(NE, 0.0);
-	for (int i = 0; i < elist.size(); ++i)
+	vector<char> done(NE, 0);
+	std::set<int> types;
+	for (int i = 0; i < (int)elist.size(); ++i)
+	{
+		int eid = elist[i];
+		FSElement& el = pm->Element(eid);
+		if (types.insert(el.Type()).second == false) continue;
+		if (el.IsSolid())
+			Ve[eid] = FEMeshMetrics::ElementVolume(*pm, el);
+		else
+			Ve[eid] = FEMeshMetrics::ShellArea(*pm, el);
+		done[eid] = 1;
+	}
+
+#pragma omp parallel for
+	for (int i = 0; i < (int)elist.size(); ++i)
 	{
 		int eid = elist[i];
+		if (done[eid]) continue;
 		FSElement& el = pm->Element(eid);
 		if (el.IsSolid())
 			Ve[eid] = FEMeshMetrics::ElementVolume(*pm, el);
@@ -157,133 +310,207 @@ bool LaplaceSolver::Solve(FSMesh* pm, vector<double>& val, vector<int>& bn, int
 	}
 	assert(nc == nodeList.size());
 
+	// number the equations (one for each free node)
+	vector<int> eq(NN, -1);
+	int neq = 0;
+	for (int i = 0; i < NN; ++i)
+		if (bn[i] == 0) eq[i] = neq++;
+	if (neq == 0) return true;
+
 	// create Node-Node list
 	FSNodeNodeList NNL(pm);
 
-	// create node-element list
-	FSNodeElementList NEL;
-	NEL.Build(pm);
-
-	// we'll assign values to the edges and the nodes
-	NNL.InitValues(0.0);
-	vector<double> D(NN, 0.0);
-
-	// build the diagonal terms
-	for (int i=0; i<NN; ++i)
+	// build the sparsity pattern
+	LaplaceMatrix A;
+	A.m_off.assign(neq + 1, 0);
+	for (int i = 0; i < NN; ++i)
 	{
-		if (bn[i] == 0)
+		if (eq[i] >= 0)
 		{
-			int eval = NEL.Valence(i);
-			for (int j=0; j<eval; ++j)
+			int n = 1;
+			int nval = NNL.Valence(i);
+			for (int j = 0; j < nval; ++j) if (eq[NNL.Node(i, j)] >= 0) n++;
+			A.m_off[eq[i] + 1] = n;
+		}
+	}
+	for (int i = 0; i < neq; ++i) A.m_off[i + 1] += A.m_off[i];
+	A.m_col.resize(A.m_off[neq]);
+	A.m_val.assign(A.m_off[neq], 0.0);
+	A.m_diag.resize(neq);
+#pragma omp parallel for
+	for (int i = 0; i < NN; ++i)
+	{
+		int ei = eq[i];
+		if (ei >= 0)
+		{
+			int* col = A.m_col.data() + A.m_off[ei];
+			int n = 0;
+			col[n++] = ei;
+			int nval = NNL.Valence(i);
+			for (int j = 0; j < nval; ++j)
 			{
-				int iel = NEL.ElementIndex(i, j);
-				FEElement_& ej = *NEL.Element(i, j);
-
-				if (ej.m_ntag == elemTag)
-				{
-					int na = ej.FindNodeIndex(i);
-					assert(na != -1);
-
-					double Vj = Ve[iel];
-					int nj = ej.Nodes();
-					double dot = 0.0;
-					for (int k = 0; k < nj; ++k)
-					{
-						vec3d Ga = FEMeshMetrics::ShapeGradient(*pm, ej, na, k);
-						dot += Ga * Ga;
-					}
-					dot *= Vj / nj;
-
-					D[i] += dot;
-				}
+				int ej = eq[NNL.Node(i, j)];
+				if (ej >= 0) col[n++] = ej;
 			}
+			std::sort(col, col + n);
+			A.m_diag[ei] = A.Find(ei, ei);
 		}
-		else D[i] = 1.0;
 	}
 
-	// build the edge weights
-	for (int i=0; i<NN; ++i)
+	// Assemble the matrix. The contributions of the fixed nodes go into the rhs.
+	vector<double> b(neq, 0.0);
+#pragma omp parallel for
+	for (int i = 0; i < (int)elist.size(); ++i)
 	{
-		int nval = NNL.Valence(i);
-		for (int j=0; j<nval; ++j)
-		{
-			int ni = i;
-			int nj = NNL.Node(i, j);
+		int eid = elist[i];
+		FSElement& el = pm->Element(eid);
+		int ne = el.Nodes();
 
-			// we must loop over the union of Sa and Sb
-			int nei = NEL.Valence(ni);
+		// shape function gradients at the nodes
+		vec3d G[FSElement::MAX_NODES][FSElement::MAX_NODES];
+		for (int a = 0; a < ne; ++a)
+			for (int k = 0; k < ne; ++k) G[a][k] = FEMeshMetrics::ShapeGradient(*pm, el, a, k);
 
-			double Kij = 0.0;
+		double w = Ve[eid] / ne;
+		for (int a = 0; a < ne; ++a)
+		{
+			int ea = eq[el.m_node[a]];
+			if (ea < 0) continue;
 
-			for (int k=0; k<nei; ++k)
+			for (int c = 0; c < ne; ++c)
 			{
-				int kel = NEL.ElementIndex(ni, k);
-				if (NEL.HasElement(nj, kel))
+				double Kac = 0.0;
+				for (int k = 0; k < ne; ++k) Kac += G[a][k] * G[c][k];
+				Kac *= w;
+
+				int nodec = el.m_node[c];
+				int ec = eq[nodec];
+				if (ec >= 0)
 				{
-					FEElement_& ek = *NEL.Element(ni, k);
-
-					if (ek.m_ntag == elemTag)
-					{
-						int na = ek.FindNodeIndex(ni); assert(na != -1);
-						int nb = ek.FindNodeIndex(nj); assert(nb != -1);
-
-						double Vk = Ve[kel];
-						int nk = ek.Nodes();
-
-						double dot = 0.0;
-						for (int k = 0; k < nk; ++k)
-						{
-							vec3d Ga = FEMeshMetrics::ShapeGradient(*pm, ek, na, k);
-							vec3d Gb = FEMeshMetrics::ShapeGradient(*pm, ek, nb, k);
-							dot += Ga * Gb;
-						}
-						dot *= Vk / nk;
-
-						Kij += dot;
-					}
+					int pos = A.Find(ea, ec); assert(pos >= 0);
+#pragma omp atomic
+					A.m_val[pos] += Kac;
+				}
+				else
+				{
+					double f = -Kac * val[nodec];
+#pragma omp atomic
+					b[ea] += f;
 				}
 			}
-
-			NNL.Value(i, j) = Kij;
 		}
 	}
 
-	// inverted diagonal values
-	vector<double> Dinv(NN);
-	for (int i=0; i<NN; ++i) Dinv[i] = 1.0 / D[i];
+	// the initial guess
+	vector<double> x(neq);
+	for (int i = 0; i < NN; ++i) if (eq[i] >= 0) x[eq[i]] = val[i];
+
+	// solve the equations
+	bool bconv = false;
+	if (m_method == SOR) bconv = SolveSOR(A, b, x);
+	else bconv = SolvePCG(A, b, x);
+
+	// copy the solution
+	for (int i = 0; i < NN; ++i) if (eq[i] >= 0) val[i] = x[eq[i]];
+
+	return bconv;
+}
 
-	// start the iterations
-	double norm0 = 0, norm, normp;
+// Solve the equations with successive over-relaxation
+bool LaplaceSolver::SolveSOR(const LaplaceMatrix& A, const vector<double>& b, vector<double>& x)
+{
+	int N = A.Rows();
+	double norm0 = 0, norm;
 	m_relNorm = 1.0;
 	do
 	{
 		norm = 0;
-		for (int i=0; i<NN; ++i)
+		for (int i=0; i<N; ++i)
 		{
-			if (bn[i] == 0)
+			double sum = b[i];
+			for (int k = A.m_off[i]; k < A.m_off[i + 1]; ++k)
 			{
-				double sum = 0;
-				int nval = NNL.Valence(i);
-				for (int k=0; k<nval; ++k) sum -= val[NNL.Node(i, k)]*NNL.Value(i,k);
+				if (k != A.m_diag[i]) sum -= A.m_val[k] * x[A.m_col[k]];
+			}
 
-				double newVal = (1.0 - m_w)*val[i] + sum * m_w * Dinv[i];
+			double newVal = (1.0 - m_w)*x[i] + sum * m_w / A.m_val[A.m_diag[i]];
 
-				double dv = (val[i] - newVal);
-				norm += dv * dv;
+			double dv = (x[i] - newVal);
+			norm += dv * dv;
 
-				val[i] = newVal;
-			}
+			x[i] = newVal;
 		}
 		norm = sqrt(norm);
-		if (m_niters == 0) { norm0 = normp = norm; }
-		m_relNorm = norm / norm0;
-		double mu = norm / normp;
-		normp = norm;
-
-		printf("%d: %lg, %lg, %lg\n", m_niters, norm, m_relNorm, mu);
+		if (m_niters == 0) norm0 = norm;
+		m_relNorm = (norm0 > 0 ? norm / norm0 : 0.0);
+		m_history.push_back(m_relNorm);
 		m_niters++;
 	}
 	while ((m_niters < m_maxIters)&&(m_relNorm > m_tol));
 
 	return (m_relNorm < m_tol);
 }
+
+// Solve the equations with the preconditioned conjugate gradient method
+bool LaplaceSolver::SolvePCG(const LaplaceMatrix& A, const vector<double>& b, vector<double>& x)
+{
+	int N = A.Rows();
+
+	// setup the preconditioner
+	// (we fall back to Jacobi if the incomplete factorization fails)
+	ICPreconditioner IC;
+	bool useIC = ((m_method == IC_PCG) && IC.Create(A));
+	vector<double> Dinv(N);
+	for (int i = 0; i < N; ++i) Dinv[i] = 1.0 / A.m_val[A.m_diag[i]];
+
+	auto precondition = [&](const vector<double>& r, vector<double>& z) {
+		if (useIC) IC.Apply(r, z);
+		else
+		{
+#pragma omp parallel for
+			for (int i = 0; i < N; ++i) z[i] = Dinv[i] * r[i];
+		}
+	};
+
+	// initial residual
+	vector<double> r(N), z(N), p(N), q(N);
+	A.Multiply(x, q);
+#pragma omp parallel for
+	for (int i = 0; i < N; ++i) r[i] = b[i] - q[i];
+
+	double norm0 = sqrt(dot_product(r, r));
+	m_relNorm = 0.0;
+	if (norm0 == 0.0) return true;
+
+	precondition(r, z);
+	p = z;
+	double rz = dot_product(r, z);
+	do
+	{
+		A.Multiply(p, q);
+		double alpha = rz / dot_product(p, q);
+
+#pragma omp parallel for
+		for (int i = 0; i < N; ++i)
+		{
+			x[i] += alpha * p[i];
+			r[i] -= alpha * q[i];
+		}
+
+		m_relNorm = sqrt(dot_product(r, r)) / norm0;
+		m_history.push_back(m_relNorm);
+		m_niters++;
+		if (m_relNorm <= m_tol) break;
+
+		precondition(r, z);
+		double rz_new = dot_product(r, z);
+		double beta = rz_new / rz;
+		rz = rz_new;
+
+#pragma omp parallel for
+		for (int i = 0; i < N; ++i) p[i] = z[i] + beta * p[i];
+	}
+	while (m_niters < m_maxIters);
+
+	return (m_relNorm <= m_tol);
+}
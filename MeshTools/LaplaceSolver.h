@@ -31,17 +31,26 @@ SOFTWARE.*/
 using std::vector;
 
 class FSMesh;
+class LaplaceMatrix;
 
 //-----------------------------------------------------------------------------
 //! This class solves the Laplace equation using an iterative method
 class LaplaceSolver
 {
+public:
+	enum SolverMethod {
+		SOR,		//!< successive over-relaxation
+		JACOBI_PCG,	//!< conjugate gradient with Jacobi preconditioner
+		IC_PCG		//!< conjugate gradient with incomplete Cholesky preconditioner
+	};
+
 public:
 	LaplaceSolver();
 
 	void SetMaxIterations(int n);
 	void SetTolerance(double a);
 	void SetRelaxation(double w);
+	void SetSolverMethod(int n);
 
 	// Solves the Laplace equation on the mesh.
 	// Input: val = initial values for all nodes
@@ -53,13 +62,22 @@ public: // output
 	int GetIterationCount() const;
 	double GetRelativeNorm() const;
 
+	// relative convergence norm of each iteration
+	const vector<double>& GetConvergenceHistory() const;
+
+private:
+	bool SolveSOR(const LaplaceMatrix& A, const vector<double>& b, vector<double>& x);
+	bool SolvePCG(const LaplaceMatrix& A, const vector<double>& b, vector<double>& x);
+
 private:
 	// input parameters
 	int		m_maxIters;	//!< max nr of iterations
 	double	m_tol;	//!< convergence tolerance
-	double	m_w;	//!< relaxation parameter
+	double	m_w;	//!< relaxation parameter (SOR only)
+	int		m_method;	//!< solver method (see SolverMethod)
 
 	// output variables
 	int		m_niters;		//!< nr of iterations
 	double	m_relNorm;		//!< final relative convergence norm
+	vector<double>	m_history;	//!< relative norm of each iteration
 };
@@ -30,6 +30,7 @@ SOFTWARE.*/
 #include <MeshLib/FEMesh.h>
 #include <MeshLib/FESurfaceMesh.h>
 #include <FEBioStudio/Logger.h>
+#include <FSCore/CallTracer.h>
 
 // NOTE: Can't build with Netgen in debug config, so just turning it off for now. 
 #if defined(WIN32) && defined(_DEBUG)
@@ -89,6 +90,8 @@ namespace netgen
 
 FSMesh*	NetGenMesher::BuildMesh()
 {
+	TRACE("NetGenMesher::BuildMesh");
+
 #ifdef HAS_NETGEN
     using namespace nglib;
     using namespace netgen;
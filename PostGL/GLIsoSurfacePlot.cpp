@@ -75,6 +75,11 @@ CGLIsoSurfacePlot::CGLIsoSurfacePlot()
 	m_userMin = 0.;
 	m_userMax = 1.;
 
+	m_lastTime = 0;
+	m_lastdt = 0.f;
+	m_bupdateIndex = true;
+	m_indexTime = -1;
+
 	m_Col.SetDivisions(m_nslices);
 	m_Col.SetSmooth(false);
 
@@ -105,11 +110,13 @@ bool CGLIsoSurfacePlot::UpdateData(bool bsave)
 
 	if (bsave)
 	{
-		bool update = false;
-		if (m_nfield    != GetIntValue  (DATA_FIELD)) { m_nfield    = GetIntValue  (DATA_FIELD); update = true; }
+		// changing the field or range type requires a reset, but the other parameters
+		// only change the slices, so we can reuse the nodal values and element index.
+		bool update = false, reset = false;
+		if (m_nfield    != GetIntValue  (DATA_FIELD)) { m_nfield    = GetIntValue  (DATA_FIELD); reset = true; }
 		if (m_nslices   != GetIntValue  (SLICES    )) { m_nslices   = GetIntValue  (SLICES    ); update = true; }
 		if (m_bsmooth   != GetBoolValue (SMOOTH    )) { m_bsmooth   = GetBoolValue (SMOOTH    ); update = true; }
-		if (m_rangeType != GetIntValue  (RANGE_TYPE)) { m_rangeType = GetIntValue  (RANGE_TYPE); update = true; }
+		if (m_rangeType != GetIntValue  (RANGE_TYPE)) { m_rangeType = GetIntValue  (RANGE_TYPE); reset = true; }
 		if (m_userMax   != GetFloatValue(USER_MAX  )) { m_userMax   = GetFloatValue(USER_MAX  ); update = true; }
 		if (m_userMin   != GetFloatValue(USER_MIN  )) { m_userMin   = GetFloatValue(USER_MIN  ); update = true; }
 		if (m_Col.GetColorMap() != GetIntValue(COLOR_MAP)) { m_Col.SetColorMap(GetIntValue(COLOR_MAP)); update = true; }
@@ -120,7 +127,8 @@ bool CGLIsoSurfacePlot::UpdateData(bool bsave)
 
 		m_Col.SetDivisions(m_nslices);
 
-		if (update) Update();
+		if (reset) Update();
+		else if (update) Update(m_lastTime, m_lastdt, false);
 
 		if (m_transparency != GetFloatValue(TRANSPARENCY))
 		{
@@ -205,10 +213,6 @@ void CGLIsoSurfacePlot::UpdateMesh()
 
 void CGLIsoSurfacePlot::UpdateSlice(GMesh& mesh, float ref, GLColor col)
 {
-	float ev[8];	// element nodal values
-	vec3f ex[8];	// element nodal positions
-	vec3f en[8];	// element nodal gradients
-
 	const int HEX_NT[8] = {0, 1, 2, 3, 4, 5, 6, 7};
 	const int PEN_NT[8] = {0, 1, 2, 2, 3, 4, 5, 5};
 	const int TET_NT[8] = {0, 1, 2, 2, 3, 3, 3, 3};
@@ -220,14 +224,28 @@ void CGLIsoSurfacePlot::UpdateSlice(GMesh& mesh, float ref, GLColor col)
 	// get the mesh
 	FEPostMesh* pm = mdl->GetActiveMesh();
 
-	const int* nt = nullptr;
+	// only the elements whose value range contains the reference value can be cut
+	vector<int> elemList;
+	m_index.Find(ref, elemList);
+
+	struct TRI {
+		vec3f r[3], vn[3];
+	};
+	int NE = (int)elemList.size();
+	vector< vector<TRI> > tris(NE);
 
 	// loop over all elements
-	for (int i=0; i<pm->Elements(); ++i)
+#pragma omp parallel for schedule(dynamic, 64)
+	for (int i=0; i<NE; ++i)
 	{
+		float ev[8];	// element nodal values
+		vec3f ex[8];	// element nodal positions
+		vec3f en[8];	// element nodal gradients
+		const int* nt = nullptr;
+
 		// render only if the element is visible and
 		// its material is enabled
-		FEElement_& el = pm->ElementRef(i);
+		FEElement_& el = pm->ElementRef(elemList[i]);
 		Material* pmat = ps->GetMaterial(el.m_MatID);
 		if (pmat->benable && (el.IsVisible() || m_bcut_hidden) && el.IsSolid())
 		{
@@ -246,6 +264,7 @@ void CGLIsoSurfacePlot::UpdateSlice(GMesh& mesh, float ref, GLColor col)
 			case FE_TET15  : nt = TET_NT; break;
 			default:
 				assert(false);
+				continue;
 			}
 
 			// get the nodal values
@@ -255,7 +274,7 @@ void CGLIsoSurfacePlot::UpdateSlice(GMesh& mesh, float ref, GLColor col)
 
 				ev[k] = m_val[el.m_node[nt[k]]];
 				ex[k] = to_vec3f(node.r);
-				en[k] = m_grd[el.m_node[nt[k]]];
+				if (m_bsmooth) en[k] = m_grd[el.m_node[nt[k]]];
 			}
 
 			// calculate the case of the element
@@ -270,7 +289,9 @@ void CGLIsoSurfacePlot::UpdateSlice(GMesh& mesh, float ref, GLColor col)
 				if (*pf == -1) break;
 
 				// calculate nodal positions
-				vec3f r[3], vn[3];
+				TRI tri;
+				vec3f* r = tri.r;
+				vec3f* vn = tri.vn;
 				for (int k=0; k<3; k++)
 				{
 					int n1 = ET_HEX[pf[k]][0];
@@ -306,12 +327,47 @@ void CGLIsoSurfacePlot::UpdateSlice(GMesh& mesh, float ref, GLColor col)
 					}
 				}
 
-				// Add the face
-				mesh.AddFace(r, vn, col);
+				tris[i].push_back(tri);
 				pf+=3;
 			}
 		}
 	}
+
+	// Add the faces
+	for (int i = 0; i < NE; ++i)
+	{
+		for (TRI& tri : tris[i]) mesh.AddFace(tri.r, tri.vn, col);
+	}
+}
+
+//-----------------------------------------------------------------------------
+// build the index of the element value ranges
+void CGLIsoSurfacePlot::UpdateIndex()
+{
+	FEPostMesh* pm = GetModel()->GetActiveMesh();
+	int NE = pm->Elements();
+	vector<float> vmin(NE, 1.f), vmax(NE, 0.f);
+#pragma omp parallel for
+	for (int i = 0; i < NE; ++i)
+	{
+		FEElement_& el = pm->ElementRef(i);
+		if (el.IsSolid())
+		{
+			int ne = el.Nodes();
+			float v0 = m_val[el.m_node[0]], v1 = v0;
+			for (int k = 1; k < ne; ++k)
+			{
+				float v = m_val[el.m_node[k]];
+				if (v < v0) v0 = v;
+				if (v > v1) v1 = v;
+			}
+			vmin[i] = v0;
+			vmax[i] = v1;
+		}
+	}
+	m_index.Build(vmin, vmax);
+	m_indexTime = m_lastTime;
+	m_bupdateIndex = false;
 }
 
 //-----------------------------------------------------------------------------
@@ -343,6 +399,7 @@ void CGLIsoSurfacePlot::Update(int ntime, float dt, bool breset)
 	int NS = pfem->GetStates();
 
 	if (breset) { m_map.Clear(); m_GMap.Clear(); m_rng.clear(); m_val.clear(); m_grd.clear(); }
+	if (breset || (ntime != m_indexTime)) m_bupdateIndex = true;
 
 	if (m_map.States() != pfem->GetStates())
 	{
@@ -356,6 +413,7 @@ void CGLIsoSurfacePlot::Update(int ntime, float dt, bool breset)
 	// see if we need to update this state
 	if (m_map.GetTag(ntime) != m_nfield)
 	{
+		m_bupdateIndex = true;
 		m_map.SetTag(ntime, m_nfield);
 		vector<float>& val = m_map.State(ntime);
 
@@ -408,6 +466,7 @@ void CGLIsoSurfacePlot::Update(int ntime, float dt, bool breset)
 	// copy nodal values into current value buffer
 	m_val = m_map.State(ntime);
 	if (m_bsmooth) m_grd = m_GMap.State(ntime);
+	if (m_bupdateIndex) UpdateIndex();
 
 	// update colormap range
 	vec2f r = m_rng[ntime];
@@ -28,6 +28,7 @@ SOFTWARE.*/
 #include "GLPlot.h"
 #include "GLWLib/GLWidget.h"
 #include "PostLib/DataMap.h"
+#include "PostLib/ElementRangeIndex.h"
 #include <MeshLib/GMesh.h>
 #include <GLLib/GLMesh.h>
 
@@ -83,6 +84,7 @@ public:
 protected:
 	void UpdateMesh();
 	void UpdateSlice(GMesh& mesh, float ref, GLColor col);
+	void UpdateIndex();
 
 protected:
 	int		m_nslices;		// nr. of iso surface slices
@@ -108,6 +110,10 @@ protected:
 
 	GLTriMesh	m_glmesh; // the mesh to render
 
+	ElementRangeIndex	m_index;	// index of the element value ranges (for the current values)
+	int					m_indexTime;	// time step the index was built for
+	bool				m_bupdateIndex;
+
 	int		m_lastTime;
 	float	m_lastdt;
 };
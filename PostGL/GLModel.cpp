@@ -36,6 +36,7 @@ SOFTWARE.*/
 #include <GLLib/GLMeshRender.h>
 #include <GLLib/glx.h>
 #include <stack>
+#include <FSCore/CallTracer.h>
 
 typedef unsigned char byte;
 
@@ -212,6 +213,8 @@ void CGLModel::SetTimeValue(float ftime)
 // Update the model data
 bool CGLModel::Update(bool breset)
 {
+	TRACE("CGLModel::Update");
+
 	if (m_ps == nullptr) return true;
 
 	FEPostModel& fem = *m_ps;
@@ -460,6 +463,8 @@ void CGLModel::RemoveDisplacementMap()
 //-----------------------------------------------------------------------------
 void CGLModel::Render(CGLContext& rc)
 {
+	TRACE("CGLModel::Render");
+
 	if (GetFSModel() == nullptr) return;
 
 	// activate all clipping planes
@@ -566,6 +571,8 @@ void CGLModel::Render(CGLContext& rc)
 //-----------------------------------------------------------------------------
 void CGLModel::RenderMeshLines(CGLContext& rc)
 {
+	TRACE("CGLModel::RenderMeshLines");
+
 	FEPostModel* fem = GetFSModel();
 	if (fem == nullptr) return;
 	for (int m = 0; m < fem->Materials(); ++m)
@@ -604,6 +611,8 @@ void CGLModel::RenderMeshLines(CGLContext& rc)
 //-----------------------------------------------------------------------------
 void CGLModel::RenderPlots(CGLContext& rc, int renderOrder)
 {
+	TRACE("CGLModel::RenderPlots");
+
 	GPlotList& PL = m_pPlot;
 	// clear all clipping planes
 	CGLPlaneCutPlot::ClearClipPlanes();
@@ -2986,7 +2995,7 @@ void CGLModel::SelectConnectedEdges(FSEdge& e)
 		{
 			int m = pe->n[i];
 			int ne = NEL.Edges(m);
-			const std::vector<int>& EL = NEL.EdgeIndexList(m);
+			FSItemRange<int> EL = NEL.EdgeIndexList(m);
 			for (int j=0; j<ne; ++j)
 			{
 				FSEdge& ej = mesh.Edge(EL[j]);
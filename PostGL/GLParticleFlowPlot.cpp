@@ -27,6 +27,7 @@ SOFTWARE.*/
 #include "stdafx.h"
 #include "GLParticleFlowPlot.h"
 #include "GLModel.h"
+#include <MeshLib/MeshTools.h>
 using namespace Post;
 
 REGISTER_CLASS(CGLParticleFlowPlot, CLASS_PLOT, "particle-flow", 0);
@@ -65,6 +66,12 @@ CGLParticleFlowPlot::CGLParticleFlowPlot()
 	m_lastTime = 0.f;
 	m_lastDt = 1.f;
 
+	m_particles = 0;
+	m_states = 0;
+	m_ntime = -1;
+	m_pathTime = -1;
+	m_pathLen = 0;
+
 	UpdateData(false);
 }
 
@@ -150,87 +157,79 @@ void CGLParticleFlowPlot::SetDensity(float v)
 
 void CGLParticleFlowPlot::Render(CGLContext& rc)
 {
-	int NP = (int) m_particles.size();
-	if (NP == 0) return;
+	if (m_particles == 0) return;
 
 	glPushAttrib(GL_ENABLE_BIT);
 	glDisable(GL_LIGHTING);
 	glDisable(GL_TEXTURE_1D);
 
-	// build a point mesh
-	GLPointMesh mesh(NP, GLMesh::FLAG_COLOR);
-	mesh.BeginMesh();
-	for (int i=0; i<NP; ++i)
-	{
-		FlowParticle& p = m_particles[i];
-		if (p.m_balive) mesh.AddVertex(p.m_r, p.m_col);
-	}
-	mesh.EndMesh();
-
 	// render the points
-	mesh.Render();
+	m_points.Render();
 
 	if (m_showPath)
 	{
 		int ntime = GetModel()->CurrentTimeIndex();
 		if (ntime >= m_seedTime + 1)
 		{
-			// count line segments
-			int lines = 0;
-			for (int i = 0; i < NP; ++i)
-			{
-				FlowParticle& p = m_particles[i];
+			// the path lines only change with the time or the path length
+			if ((ntime != m_pathTime) || (m_pathLength != m_pathLen)) UpdatePathLines(ntime);
 
-				int tend = ntime;
-				if (tend > p.m_ndeath) tend = p.m_ndeath;
+			// render the lines
+			glColor3ub(0,0,255);
+			m_paths.Render();
+		}
+	}
 
-				int n0 = m_seedTime;
-				if (m_pathLength > 0)
-				{
-					n0 = ntime - m_pathLength;
-					if (n0 < m_seedTime) n0 = m_seedTime;
-					if (n0 > tend) n0 = tend;
-				}
+	glPopAttrib();
+}
 
-				lines += tend - n0 + 1;
-			}
+void CGLParticleFlowPlot::UpdatePathLines(int ntime)
+{
+	m_pathTime = ntime;
+	m_pathLen = m_pathLength;
 
-			// allocate line mesh
-			GLLineMesh lineMesh(lines);
+	int NP = m_particles;
+	int NS = m_states;
 
-			glColor3ub(0,0,255);
-			lineMesh.BeginMesh();
-			for (int i = 0; i<NP; ++i)
-			{
-				FlowParticle& p = m_particles[i];
+	// count line segments
+	int lines = 0;
+	for (int i = 0; i < NP; ++i)
+	{
+		int tend = ntime;
+		if (tend > m_death[i]) tend = m_death[i];
 
-				int tend = ntime;
-				if (tend > p.m_ndeath) tend = p.m_ndeath;
+		int n0 = m_seedTime;
+		if (m_pathLength > 0)
+		{
+			n0 = ntime - m_pathLength;
+			if (n0 < m_seedTime) n0 = m_seedTime;
+			if (n0 > tend) n0 = tend;
+		}
 
-				int n0 = m_seedTime;
-				if (m_pathLength > 0)
-				{
-					n0 = ntime - m_pathLength;
-					if (n0 < m_seedTime) n0 = m_seedTime;
-					if (n0 > tend) n0 = tend;
-				}
+		lines += tend - n0 + 1;
+	}
 
-				for (int n=n0; n<tend; ++n)
-				{
-					vec3f& r0 = p.m_pos[n];
-					vec3f& r1 = p.m_pos[n+1];
-					lineMesh.AddVertex(r0);
-					lineMesh.AddVertex(r1);
-				}					
-			}
-			lineMesh.EndMesh();
+	// build the line mesh
+	m_paths.Create(lines);
+	m_paths.BeginMesh();
+	for (int i = 0; i<NP; ++i)
+	{
+		const vec3f* pos = &m_pos[(size_t)i*NS];
 
-			// render the lines
-			lineMesh.Render();
+		int tend = ntime;
+		if (tend > m_death[i]) tend = m_death[i];
+
+		int n0 = m_seedTime;
+		if (m_pathLength > 0)
+		{
+			n0 = ntime - m_pathLength;
+			if (n0 < m_seedTime) n0 = m_seedTime;
+			if (n0 > tend) n0 = tend;
 		}
-	}
 
-	glPopAttrib();
+		for (int n=n0; n<tend; ++n) m_paths.AddLine(pos[n], pos[n + 1]);
+	}
+	m_paths.EndMesh();
 }
 
 void CGLParticleFlowPlot::Update(int ntime, float dt, bool breset)
@@ -238,7 +237,14 @@ void CGLParticleFlowPlot::Update(int ntime, float dt, bool breset)
 	m_lastTime = ntime;
 	m_lastDt = dt;
 
-	if (breset) { m_map.Clear(); m_rng.clear(); m_maxtime = -1; m_particles.clear(); }
+	if (breset)
+	{
+		m_map.Clear(); m_rng.clear(); m_maxtime = -1;
+		m_particles = m_states = 0;
+		m_pos.clear(); m_vel.clear(); m_death.clear(); m_elem.clear();
+		m_points.Create(0, GLMesh::FLAG_COLOR);
+		m_pathTime = -1;
+	}
 	if (m_nvec == -1) return;
 
 	CGLModel* mdl = GetModel();
@@ -256,13 +262,16 @@ void CGLParticleFlowPlot::Update(int ntime, float dt, bool breset)
 	FSMeshBase* pm = mdl->GetActiveMesh();
 	FEPostModel* pfem = mdl->GetFSModel();
 
-	if (m_map.States() == 0)
+	if (m_map.States() != pfem->GetStates())
 	{
 		int NS = pfem->GetStates();
 		int NN = pm->Nodes();
 
 		m_map.Create(NS, NN, vec3f(0, 0, 0), -1);
 		m_rng.resize(NS);
+
+		// states were appended, so extend the particle history
+		if (m_states > 0) ResizeParticleHistory(NS);
 	}
 
 	// check the tag
@@ -311,7 +320,8 @@ void CGLParticleFlowPlot::UpdateParticles(int ntime)
 	if (ntime < m_seedTime)
 	{
 		// deactivate all particles
-		for (int i=0; i<m_particles.size(); ++i) m_particles[i].m_balive = false;
+		m_ntime = ntime;
+		m_points.Create(0, GLMesh::FLAG_COLOR);
 		return;
 	}
 
@@ -328,6 +338,7 @@ void CGLParticleFlowPlot::UpdateParticles(int ntime)
 		// advance the particles from maxtime to this time
 		AdvanceParticles(m_maxtime, ntime);
 		m_maxtime = ntime;
+		m_pathTime = -1;
 	}
 
 	// update current state of the particles
@@ -336,23 +347,7 @@ void CGLParticleFlowPlot::UpdateParticles(int ntime)
 
 void CGLParticleFlowPlot::UpdateParticleState(int ntime)
 {
-	int NP = (int) m_particles.size();
-	for (int i=0; i<NP; ++i)
-	{
-		FlowParticle& p = m_particles[i];
-
-		if (ntime >= p.m_ndeath)
-		{
-			p.m_balive = false;
-		}
-		else
-		{
-			p.m_balive = true;
-			p.m_r = p.m_pos[ntime];
-			p.m_v = p.m_vel[ntime];
-		}
-	}
-
+	m_ntime = ntime;
 	UpdateParticleColors();
 }
 
@@ -365,21 +360,38 @@ void CGLParticleFlowPlot::UpdateParticleColors()
 	int ncol = m_Col.GetColorMap();
 	CColorMap& col = ColorMapManager::GetColorMap(ncol);
 
-	int NP = (int)m_particles.size();
-	for (int i = 0; i<NP; ++i)
+	int NP = m_particles;
+	int NS = m_states;
+	int ntime = m_ntime;
+
+	// count the live particles
+	int alive = 0;
+	if ((ntime >= 0) && (ntime < NS))
 	{
-		FlowParticle& p = m_particles[i];
-		if (p.m_balive)
+		for (int i = 0; i < NP; ++i) if (ntime < m_death[i]) alive++;
+	}
+
+	// build the point mesh from the cached state
+	m_points.Create(alive, GLMesh::FLAG_COLOR);
+	m_points.BeginMesh();
+	if (alive > 0)
+	{
+		for (int i = 0; i < NP; ++i)
 		{
-			vec3f& v = p.m_v;
-			float V = v.Length();
-			float w = (V - vmin) / (vmax - vmin);
-			p.m_col = col.map(w);
+			if (ntime < m_death[i])
+			{
+				const vec3f& r = m_pos[(size_t)i*NS + ntime];
+				const vec3f& v = m_vel[(size_t)i*NS + ntime];
+				float V = v.Length();
+				float w = (V - vmin) / (vmax - vmin);
+				m_points.AddVertex(r, col.map(w));
+			}
 		}
 	}
+	m_points.EndMesh();
 }
 
-vec3f CGLParticleFlowPlot::Velocity(const vec3f& r, int ntime, float w, bool& ok)
+vec3f CGLParticleFlowPlot::Velocity(const vec3f& r, int ntime, float w, int& nelem, bool& ok)
 {
 	vec3f v(0.f, 0.f, 0.f);
 	vec3f ve0[FSElement::MAX_NODES];
@@ -389,11 +401,33 @@ vec3f CGLParticleFlowPlot::Velocity(const vec3f& r, int ntime, float w, bool& ok
 	vector<vec3f>& val0 = m_map.State(ntime    );
 	vector<vec3f>& val1 = m_map.State(ntime + 1);
 
-	int nelem;
+	// particles move in small steps, so first try the element the particle was
+	// in last, then its neighbors, and only then search the octree.
 	double q[3];
-	if (m_find->FindElement(r, nelem, q))
+	ok = false;
+	if (nelem >= 0)
+	{
+		FEElement_& el = mesh.ElementRef(nelem);
+		if (ProjectInsideElement(mesh, el, r, q)) ok = true;
+		else
+		{
+			int nf = el.Faces();
+			for (int i = 0; i < nf; ++i)
+			{
+				FEElement_* pe = mesh.ElementPtr(el.m_nbr[i]);
+				if (pe && ProjectInsideElement(mesh, *pe, r, q))
+				{
+					nelem = el.m_nbr[i];
+					ok = true;
+					break;
+				}
+			}
+		}
+	}
+	if (ok == false) ok = m_find->FindElement(r, nelem, q);
+
+	if (ok)
 	{
-		ok = true;
 		FEElement_& el = mesh.ElementRef(nelem);
 
 		int ne = el.Nodes();
@@ -408,7 +442,7 @@ vec3f CGLParticleFlowPlot::Velocity(const vec3f& r, int ntime, float w, bool& ok
 
 		v = v0*(1.f - w) + v1*w;
 	}
-	else ok = false;
+	else nelem = -1;
 
 	return v;
 }
@@ -420,66 +454,94 @@ void CGLParticleFlowPlot::AdvanceParticles(int n0, int n1)
 	if (mdl == 0) return;
 	FEPostModel& fem = *mdl->GetFSModel();
 
-	// get the mesh
-	FSMeshBase& mesh = *mdl->GetActiveMesh();
-
-	BOX box = m_find->BoundingBox();
-	float R = box.GetMaxExtent();
 	float dt = m_dt;
 	if (dt <= 0.f) return;
 
-	for (int ntime=n0; ntime<n1; ++ntime)
+	// the particles are independent, so each thread advances its particles
+	// over the whole time interval
+	int NP = m_particles;
+	int NS = m_states;
+#pragma omp parallel for schedule(dynamic, 256)
+	for (int i = 0; i<NP; ++i)
 	{
-		float t0 = fem.GetState(ntime    )->m_time;
-		float t1 = fem.GetState(ntime + 1)->m_time;
-		if (t1 < t0) t1 = t0;
+		vec3f* pos = &m_pos[(size_t)i*NS];
+		vec3f* vel = &m_vel[(size_t)i*NS];
+		int nelem = m_elem[i];
 
-		int NP = (int)m_particles.size();
-#pragma omp parallel for shared (NP)
-		for (int i = 0; i<NP; ++i)
+		for (int ntime = n0; ntime < n1; ++ntime)
 		{
-			FlowParticle& p = m_particles[i];
-			p.m_pos[ntime+1] = p.m_pos[ntime];
-			p.m_vel[ntime+1] = p.m_vel[ntime];
-		}
+			pos[ntime + 1] = pos[ntime];
+			vel[ntime + 1] = vel[ntime];
+			if (m_death[i] <= ntime) continue;
 
-		float t = t0;
-		while (t < t1)
-		{
-			t += dt;
-			if (t > t1) t = t1;
-			float w = (t - t0) / (t1 - t0);
+			float t0 = fem.GetState(ntime    )->m_time;
+			float t1 = fem.GetState(ntime + 1)->m_time;
+			if (t1 < t0) t1 = t0;
 
-			int NP = (int) m_particles.size();
-#pragma omp parallel for shared (NP)
-			for (int i=0; i<NP; ++i)
+			float t = t0;
+			while (t < t1)
 			{
-				FlowParticle& p = m_particles[i];
+				t += dt;
+				if (t > t1) t = t1;
+				float w = (t - t0) / (t1 - t0);
+
+				vec3f r1 = pos[ntime + 1] + vel[ntime + 1]*dt;
 
-				if (p.m_ndeath > ntime)
+				bool ok = true;
+				vec3f v1 = Velocity(r1, ntime, w, nelem, ok);
+				if (ok == false)
 				{
-					vec3f r0 = p.m_pos[ntime + 1];
-					vec3f v0 = p.m_vel[ntime + 1];
-
-					vec3f r1 = r0 + v0*dt;
-
-					bool ok = true;
-					vec3f v1 = Velocity(r1, ntime, w, ok);
-					if (ok == false)
-					{
-						p.m_ndeath = ntime + 1;
-					}
-					else
-					{
-						p.m_pos[ntime + 1] = r1;
-						p.m_vel[ntime + 1] = v1;
-					}
+					m_death[i] = ntime + 1;
+					break;
+				}
+				else
+				{
+					pos[ntime + 1] = r1;
+					vel[ntime + 1] = v1;
 				}
 			}
 		}
+
+		m_elem[i] = nelem;
 	}
 }
 
+// The particle history is stored per particle, so when the number of states changes
+// it is copied over to the new layout. Particles that were alive in the last state 
+// remain alive. If states were removed, the particles are seeded again.
+void CGLParticleFlowPlot::ResizeParticleHistory(int NS)
+{
+	int NS0 = m_states;
+	if (NS == NS0) return;
+
+	if (NS < NS0)
+	{
+		m_particles = m_states = 0;
+		m_pos.clear(); m_vel.clear(); m_death.clear(); m_elem.clear();
+		m_maxtime = -1;
+		m_pathTime = -1;
+		return;
+	}
+
+	int NP = m_particles;
+	vector<vec3f> pos((size_t)NP*NS, vec3f(0.f, 0.f, 0.f));
+	vector<vec3f> vel((size_t)NP*NS, vec3f(0.f, 0.f, 0.f));
+#pragma omp parallel for
+	for (int i = 0; i < NP; ++i)
+	{
+		for (int n = 0; n < NS0; ++n)
+		{
+			pos[(size_t)i*NS + n] = m_pos[(size_t)i*NS0 + n];
+			vel[(size_t)i*NS + n] = m_vel[(size_t)i*NS0 + n];
+		}
+		if (m_death[i] >= NS0) m_death[i] = NS;
+	}
+	m_pos.swap(pos);
+	m_vel.swap(vel);
+	m_states = NS;
+	m_pathTime = -1;
+}
+
 static float frand()
 {
 	return rand() / (float) RAND_MAX;
@@ -488,7 +550,11 @@ static float frand()
 void CGLParticleFlowPlot::SeedParticles()
 {
 	// clear current particles, if any
-	m_particles.clear();
+	m_particles = 0;
+	m_pos.clear();
+	m_vel.clear();
+	m_death.clear();
+	m_elem.clear();
 
 	// get the model
 	CGLModel* mdl = GetModel();
@@ -497,6 +563,7 @@ void CGLParticleFlowPlot::SeedParticles()
 	// get the number of states
 	FEPostModel* fem = mdl->GetFSModel();
 	int NS = fem->GetStates();
+	m_states = NS;
 
 	// make sure there is a valid seed time
 	if ((m_seedTime < 0) || (m_seedTime >= NS)) return;
@@ -509,8 +576,15 @@ void CGLParticleFlowPlot::SeedParticles()
 	// make sure vtol is positive
 	float vtol = fabs(m_vtol);
 
-	// loop over all the surface facts
+	// generate the random numbers up front since rand() is not thread safe
 	int NF = mesh.Faces();
+	vector<float> prob(NF);
+	for (int i = 0; i < NF; ++i) prob[i] = frand();
+
+	// find the faces that will seed a particle. Each face writes its own slot,
+	// so no locking is needed.
+	vector<vec3f> seedPos(NF), seedVel(NF);
+	vector<int> isSeed(NF, 0);
 #pragma omp parallel for shared (NF)
 	for (int i = 0; i<NF; ++i)
 	{
@@ -522,12 +596,9 @@ void CGLParticleFlowPlot::SeedParticles()
 		for (int j = 0; j<nf; ++j) vf += val[f.n[j]];
 		vf /= nf;
 
-		// generate random number
-		float w = frand();
-
 		// see if this is a valid candidate for a seed
 		vec3f fn = f.m_fn;
-		if ((fn*vf < -vtol) && (w <= m_density))
+		if ((fn*vf < -vtol) && (prob[i] <= m_density))
 		{
 			// calculate the face center, this will be the seed
 			// NOTE: We are using reference coordinates, therefore we assume that the mesh is not deforming!!
@@ -535,22 +606,33 @@ void CGLParticleFlowPlot::SeedParticles()
 			for (int j = 0; j<nf; ++j) cf += mesh.Node(f.n[j]).r;
 			cf /= nf;
 
-			// create a particle here
-			FlowParticle p;
-			p.m_pos.resize(NS);
-			p.m_vel.resize(NS);
-			p.m_balive = true;
-			p.m_ndeath = NS;	// assume the particle will live the entire time
-
-			// set initial position and velocity
-			p.m_pos[m_seedTime] = to_vec3f(cf);
-			p.m_vel[m_seedTime] = vf;
-
-			// add it to the pile
-#pragma omp critical
-            {
-                m_particles.push_back(p);
-            }
+			seedPos[i] = to_vec3f(cf);
+			seedVel[i] = vf;
+			isSeed[i] = 1;
+		}
+	}
+
+	// count the particles
+	int NP = 0;
+	for (int i = 0; i < NF; ++i) NP += isSeed[i];
+
+	// allocate the particle history
+	m_particles = NP;
+	m_pos.assign((size_t)NP*NS, vec3f(0.f, 0.f, 0.f));
+	m_vel.assign((size_t)NP*NS, vec3f(0.f, 0.f, 0.f));
+	m_death.assign(NP, NS);	// assume the particles will live the entire time
+	m_elem.assign(NP, -1);
+
+	// set initial position and velocity
+	int n = 0;
+	for (int i = 0; i < NF; ++i)
+	{
+		if (isSeed[i])
+		{
+			m_pos[(size_t)n*NS + m_seedTime] = seedPos[i];
+			m_vel[(size_t)n*NS + m_seedTime] = seedVel[i];
+			m_elem[n] = mesh.Face(i).m_elem[0].eid;
+			n++;
 		}
 	}
 }
@@ -28,6 +28,7 @@ SOFTWARE.*/
 #include "GLPlot.h"
 #include <PostLib/FEPostMesh.h>
 #include <MeshLib/FEFindElement.h>
+#include <GLLib/GLMesh.h>
 
 namespace Post {
 
@@ -35,41 +36,6 @@ class CGLParticleFlowPlot : public CGLPlot
 {
 	enum { DATA_FIELD, COLOR_MAP, CLIP, SEED_STEP, THRESHOLD, DENSITY, STEP_SIZE, PATH_LINES, PATH_LENGTH };
 
-	class FlowParticle
-	{
-	public:
-		FlowParticle(){}
-		FlowParticle(const FlowParticle& p)
-		{
-			m_r = p.m_r;
-			m_v = p.m_v;
-			m_col = p.m_col;
-			m_balive = p.m_balive;
-			m_ndeath = p.m_ndeath;
-			m_pos = p.m_pos;
-			m_vel = p.m_vel;
-		}
-		void operator =(const FlowParticle& p)
-		{
-			m_r = p.m_r;
-			m_v = p.m_v;
-			m_col = p.m_col;
-			m_balive = p.m_balive;
-			m_ndeath = p.m_ndeath;
-			m_pos = p.m_pos;
-			m_vel = p.m_vel;
-		}
-
-	public:
-		vec3f			m_r;		// current particle position
-		vec3f			m_v;		// current particle velocity
-		GLColor			m_col;		// particles color
-		bool			m_balive;	// is particle alive at current position?
-		int				m_ndeath;	// time of death
-		vector<vec3f>	m_pos;		// particle position at various times
-		vector<vec3f>	m_vel;		// particle velocity at various times
-	};
-
 public:
 	CGLParticleFlowPlot();
 
@@ -107,10 +73,14 @@ protected:
 
 	void AdvanceParticles(int t0, int t1);
 
-	vec3f Velocity(const vec3f& r, int ntime, float dt, bool& ok);
+	void ResizeParticleHistory(int states);
+
+	vec3f Velocity(const vec3f& r, int ntime, float dt, int& nelem, bool& ok);
 
 	void UpdateParticleState(int ntime);
 
+	void UpdatePathLines(int ntime);
+
 public:
 	void UpdateParticleColors();
 
@@ -136,6 +106,20 @@ private:
 
 	FEFindElement*	m_find;
 
-	vector<FlowParticle>	m_particles;
+	// The particle trajectories are stored as flat arrays with one block of
+	// states per particle (i.e. m_pos[i*m_states + n]), so that changing the
+	// time only needs to look up the cached values.
+	int				m_particles;	// number of particles
+	int				m_states;		// number of states per particle
+	vector<vec3f>	m_pos;			// particle positions
+	vector<vec3f>	m_vel;			// particle velocities
+	vector<int>		m_death;		// time of death of each particle
+	vector<int>		m_elem;			// last element each particle was found in
+
+	int				m_ntime;		// time of the current particle state
+	GLPointMesh		m_points;		// particles at current time
+	GLLineMesh		m_paths;		// path lines
+	int				m_pathTime;		// time for which the path lines were built (-1 if invalid)
+	int				m_pathLen;		// path length for which the path lines were built
 };
 }
@@ -92,6 +92,9 @@ CGLPlaneCutPlot::CGLPlaneCutPlot()
 
 	m_bupdateSlice = false;
 
+	m_indexMesh = nullptr;
+	m_bupdateIndex = true;
+
 	UpdateData(false);
 }
 
@@ -189,6 +192,7 @@ void CGLPlaneCutPlot::InitClipPlanes()
 void CGLPlaneCutPlot::Update(int ntime, float dt, bool breset)
 {
 	m_bupdateSlice = true;
+	m_bupdateIndex = true;
 }
 
 ///////////////////////////////////////////////////////////////////////////////
@@ -458,12 +462,12 @@ void CGLPlaneCutPlot::UpdateLineMesh()
 	int matId = -1;
 	Material* pmat = nullptr;
 
-	// repeat over all elements
+	// repeat over all elements that are cut by the plane
 	vector<vec3d> points; points.reserve(1024);
-	for (int i=0; i<pm->Elements(); ++i)
+	for (int i=0; i<(int)m_cutElems.size(); ++i)
 	{
 		// render only when visible
-		FEElement_& el = pm->ElementRef(i);
+		FEElement_& el = *m_cutElems[i];
 		if (el.m_MatID != matId)
 		{
 			pmat = ps->GetMaterial(el.m_MatID);
@@ -678,8 +682,14 @@ void CGLPlaneCutPlot::UpdateSlice()
 	FEPostMesh* pm = mdl->GetActiveMesh();
 
 	m_slice.Clear();
+	m_cutElems.clear();
 
-	Post::FEState& state = *ps->CurrentState();
+	// see if the element index needs to be rebuilt
+	bool bnormal = (m_indexNormal.x != norm.x) || (m_indexNormal.y != norm.y) || (m_indexNormal.z != norm.z);
+	if (m_bupdateIndex || bnormal || (m_indexMesh != pm) || ((int)m_index.size() != pm->Domains()))
+	{
+		UpdateIndex(pm, norm);
+	}
 
 	// loop over all domains
 	for (int n = 0; n < pm->Domains(); ++n)
@@ -701,15 +711,6 @@ void CGLPlaneCutPlot::UpdateSlice()
 
 void CGLPlaneCutPlot::AddDomain(FEPostMesh* pm, int n)
 {
-	float ev[8];
-	vec3d ex[8];
-	int	nf[8];
-	EDGE edge[15];
-	int en[8];
-	int	rf[3];
-
-	MeshDomain& dom = pm->Domain(n);
-
 	// get the plane equations
 	GLdouble a[4];
 	GetNormalizedEquations(a);
@@ -722,190 +723,263 @@ void CGLPlaneCutPlot::AddDomain(FEPostMesh* pm, int n)
 	CGLModel* mdl = GetModel();
 	int ndivs = mdl->GetSubDivisions();
 
-	FEPostModel* ps = mdl->GetFSModel();
+	// only the elements whose distance range contains the plane can be cut
+	MeshDomain& dom = pm->Domain(n);
+	vector<int> elemList;
+	if (n < (int)m_index.size()) m_index[n].Find(ref, elemList);
+
+	// slice the elements
+	int NE = (int)elemList.size();
+	vector< vector<GLSlice::FACE> > faces(NE);
+	vector<int> cases(NE, -1);
+#pragma omp parallel for schedule(dynamic, 64)
+	for (int i = 0; i < NE; ++i)
+	{
+		FEElement_& el = dom.Element(elemList[i]);
+		if (el.IsVisible() || m_bcut_hidden)
+		{
+			cases[i] = SliceElement(pm, el, n, norm, ref, ndivs, faces[i]);
+		}
+	}
+
+	// add the faces to the slice
+	for (int i = 0; i < NE; ++i)
+	{
+		if (cases[i] >= 0)
+		{
+			FEElement_& el = dom.Element(elemList[i]);
+			el.m_ntag = cases[i];
+			m_cutElems.push_back(&el);
+			m_slice.AddFaces(faces[i]);
+		}
+	}
+}
+
+//-----------------------------------------------------------------------------
+// Calculate the intersection of an element with the plane. The faces are added
+// to the faces list and the function returns the case of the element.
+int CGLPlaneCutPlot::SliceElement(FEPostMesh* pm, FEElement_& el, int n, const vec3d& norm, double ref, int ndivs, vector<GLSlice::FACE>& faces)
+{
+	float ev[8];
+	vec3d ex[8];
+	int	nf[8];
+	int en[8];
+	int	rf[3];
+
+	FEPostModel* ps = GetModel()->GetFSModel();
 	Post::FEState& state = *ps->CurrentState();
 
-	// repeat over all elements
-	for (int i = 0; i < dom.Elements(); ++i)
+	const int *nt = nullptr;
+	switch (el.Type())
 	{
-		// render only when visible
-		FEElement_& el = dom.Element(i);
-		if ((el.IsVisible() || m_bcut_hidden) && el.IsSolid())
+	case FE_HEX8: nt = HEX_NT; break;
+	case FE_HEX20: nt = HEX_NT; break;
+	case FE_HEX27: nt = HEX_NT; break;
+	case FE_PENTA6: nt = PEN_NT; break;
+	case FE_PENTA15: nt = PEN_NT; break;
+	case FE_TET4: nt = TET_NT; break;
+	case FE_TET5: nt = TET_NT; break;
+	case FE_TET10: nt = TET_NT; break;
+	case FE_TET15: nt = TET_NT; break;
+	case FE_TET20: nt = TET_NT; break;
+	case FE_PYRA5: nt = PYR_NT; break;
+	case FE_PYRA13: nt = PYR_NT; break;
+	default:
+		return 0;
+	}
+
+	// get the nodal values
+	for (int k = 0; k < 8; ++k)
+	{
+		FSNode& node = pm->Node(el.m_node[nt[k]]);
+		nf[k] = (node.IsExterior() ? 1 : 0);
+		ex[k] = node.r;
+		en[k] = el.m_node[nt[k]];
+		ev[k] = state.m_NODE[el.m_node[nt[k]]].m_val;
+	}
+
+	// calculate the case of the element
+	int ncase = 0;
+	for (int k = 0; k < 8; ++k)
+		if (norm*ex[k] >= ref) ncase |= (1 << k);
+
+	if ((ndivs <= 1) || (el.Shape() != ELEM_HEX))
+	{
+		// loop over faces
+		int* pf = LUT[ncase];
+		int ne = 0;
+		for (int l = 0; l < 5; l++)
 		{
-			const int *nt = nullptr;
-			switch (el.Type())
-			{
-			case FE_HEX8: nt = HEX_NT; break;
-			case FE_HEX20: nt = HEX_NT; break;
-			case FE_HEX27: nt = HEX_NT; break;
-			case FE_PENTA6: nt = PEN_NT; break;
-			case FE_PENTA15: nt = PEN_NT; break;
-			case FE_TET4: nt = TET_NT; break;
-			case FE_TET5: nt = TET_NT; break;
-			case FE_TET10: nt = TET_NT; break;
-			case FE_TET15: nt = TET_NT; break;
-			case FE_TET20: nt = TET_NT; break;
-			case FE_PYRA5: nt = PYR_NT; break;
-            case FE_PYRA13: nt = PYR_NT; break;
-			}
+			if (*pf == -1) break;
 
-			// get the nodal values
-			for (int k = 0; k < 8; ++k)
+			// calculate nodal positions
+			vec3d r[3];
+			float tex[3], w1, w2, w;
+			for (int k = 0; k < 3; k++)
 			{
-				FSNode& node = pm->Node(el.m_node[nt[k]]);
-				nf[k] = (node.IsExterior() ? 1 : 0);
-				ex[k] = node.r;
-				en[k] = el.m_node[nt[k]];
-				ev[k] = state.m_NODE[el.m_node[nt[k]]].m_val;
+				int n1 = ET_HEX[pf[k]][0];
+				int n2 = ET_HEX[pf[k]][1];
+
+				w1 = norm * ex[n1];
+				w2 = norm * ex[n2];
+
+				if (w2 != w1)
+					w = (ref - w1) / (w2 - w1);
+				else
+					w = 0.f;
+
+				float v = ev[n1] * (1 - w) + ev[n2] * w;
+
+				r[k] = ex[n1] * (1 - w) + ex[n2] * w;
+				tex[k] = v;
+				rf[k] = ((nf[n1] == 1) && (nf[n2] == 1) ? 1 : 0);
 			}
 
-			// calculate the case of the element
-			int ncase = 0;
-			for (int k = 0; k < 8; ++k)
-				if (norm*ex[k] >= ref) ncase |= (1 << k);
+			GLSlice::FACE face;
+			face.mat = n;
+			face.r[0] = r[0];
+			face.r[1] = r[1];
+			face.r[2] = r[2];
+			face.tex[0] = tex[0];
+			face.tex[1] = tex[1];
+			face.tex[2] = tex[2];
+			face.bactive = el.IsActive();
 
-			el.m_ntag = ncase;
+			faces.push_back(face);
 
-			if ((ndivs <= 1) || (el.Shape() != ELEM_HEX))
+			pf += 3;
+		}
+	}
+	else
+	{
+		for (int ix = 0; ix < ndivs; ++ix)
+		{
+			double wr0 = -1.0 + 2.0*ix / ndivs;
+			double wr1 = -1.0 + 2.0*(ix + 1) / ndivs;
+			for (int iy = 0; iy < ndivs; ++iy)
 			{
-				// loop over faces
-				int* pf = LUT[ncase];
-				int ne = 0;
-				for (int l = 0; l < 5; l++)
+				double ws0 = -1.0 + 2.0*iy / ndivs;
+				double ws1 = -1.0 + 2.0*(iy + 1) / ndivs;
+				for (int iz = 0; iz < ndivs; ++iz)
 				{
-					if (*pf == -1) break;
+					double wt0 = -1.0 + 2.0*iz / ndivs;
+					double wt1 = -1.0 + 2.0*(iz + 1) / ndivs;
+
+					double H[8][8];
+					HEX8::shape(H[0], wr0, ws0, wt0);
+					HEX8::shape(H[1], wr1, ws0, wt0);
+					HEX8::shape(H[2], wr1, ws1, wt0);
+					HEX8::shape(H[3], wr0, ws1, wt0);
+					HEX8::shape(H[4], wr0, ws0, wt1);
+					HEX8::shape(H[5], wr1, ws0, wt1);
+					HEX8::shape(H[6], wr1, ws1, wt1);
+					HEX8::shape(H[7], wr0, ws1, wt1);
+
+					vec3d x[8];
+					float v[8];
+					for (int kk = 0; kk < 8; ++kk)
+					{
+						double* h = H[kk];
+						x[kk] = vec3d(0, 0, 0);
+						v[kk] = 0.0;
+						for (int jj = 0; jj < 8; ++jj)
+						{
+							x[kk] += ex[jj] * h[jj];
+							v[kk] += ev[jj] * h[jj];
+						}
+					}																					
 
-					// calculate nodal positions
-					vec3d r[3];
-					float tex[3], w1, w2, w;
-					for (int k = 0; k < 3; k++)
+					// calculate the case of the element
+					int ncase = 0;
+					for (int k = 0; k < 8; ++k)
+						if (norm*x[k] >= ref) ncase |= (1 << k);
+
+					// loop over faces
+					int* pf = LUT[ncase];
+					int ne = 0;
+					for (int l = 0; l < 5; l++)
 					{
-						int n1 = ET_HEX[pf[k]][0];
-						int n2 = ET_HEX[pf[k]][1];
+						if (*pf == -1) break;
 
-						w1 = norm * ex[n1];
-						w2 = norm * ex[n2];
+						// calculate nodal positions
+						vec3d r[3];
+						float tex[3], w1, w2, w;
+						for (int k = 0; k < 3; k++)
+						{
+							int n1 = ET_HEX[pf[k]][0];
+							int n2 = ET_HEX[pf[k]][1];
 
-						if (w2 != w1)
-							w = (ref - w1) / (w2 - w1);
-						else
-							w = 0.f;
+							w1 = norm * x[n1];
+							w2 = norm * x[n2];
 
-						float v = ev[n1] * (1 - w) + ev[n2] * w;
+							if (w2 != w1)
+								w = (ref - w1) / (w2 - w1);
+							else
+								w = 0.f;
 
-						r[k] = ex[n1] * (1 - w) + ex[n2] * w;
-						tex[k] = v;
-						rf[k] = ((nf[n1] == 1) && (nf[n2] == 1) ? 1 : 0);
-					}
+							float f = v[n1] * (1 - w) + v[n2] * w;
 
-					GLSlice::FACE face;
-					face.mat = n;
-					face.r[0] = r[0];
-					face.r[1] = r[1];
-					face.r[2] = r[2];
-					face.tex[0] = tex[0];
-					face.tex[1] = tex[1];
-					face.tex[2] = tex[2];
-					face.bactive = el.IsActive();
+							r[k] = x[n1] * (1 - w) + x[n2] * w;
+							tex[k] = f;
+						}
 
-					m_slice.AddFace(face);
+						GLSlice::FACE face;
+						face.mat = n;
+						face.r[0] = r[0];
+						face.r[1] = r[1];
+						face.r[2] = r[2];
+						face.tex[0] = tex[0];
+						face.tex[1] = tex[1];
+						face.tex[2] = tex[2];
+						face.bactive = el.IsActive();
 
-					pf += 3;
+						faces.push_back(face);
+
+						pf += 3;
+					}
 				}
 			}
-			else
+		}
+	}
+
+	return ncase;
+}
+
+//-----------------------------------------------------------------------------
+// Build the index of the element distance ranges to the plane
+void CGLPlaneCutPlot::UpdateIndex(FEPostMesh* pm, const vec3d& norm)
+{
+	int ND = pm->Domains();
+	m_index.assign(ND, ElementRangeIndex());
+	for (int n = 0; n < ND; ++n)
+	{
+		MeshDomain& dom = pm->Domain(n);
+		int NE = dom.Elements();
+		vector<float> dmin(NE, 1.f), dmax(NE, 0.f);
+#pragma omp parallel for
+		for (int i = 0; i < NE; ++i)
+		{
+			FEElement_& el = dom.Element(i);
+			if (el.IsSolid())
 			{
-				for (int ix = 0; ix < ndivs; ++ix)
+				int ne = el.Nodes();
+				double d0 = norm * pm->Node(el.m_node[0]).r, d1 = d0;
+				for (int k = 1; k < ne; ++k)
 				{
-					double wr0 = -1.0 + 2.0*ix / ndivs;
-					double wr1 = -1.0 + 2.0*(ix + 1) / ndivs;
-					for (int iy = 0; iy < ndivs; ++iy)
-					{
-						double ws0 = -1.0 + 2.0*iy / ndivs;
-						double ws1 = -1.0 + 2.0*(iy + 1) / ndivs;
-						for (int iz = 0; iz < ndivs; ++iz)
-						{
-							double wt0 = -1.0 + 2.0*iz / ndivs;
-							double wt1 = -1.0 + 2.0*(iz + 1) / ndivs;
-
-							double H[8][8];
-							HEX8::shape(H[0], wr0, ws0, wt0);
-							HEX8::shape(H[1], wr1, ws0, wt0);
-							HEX8::shape(H[2], wr1, ws1, wt0);
-							HEX8::shape(H[3], wr0, ws1, wt0);
-							HEX8::shape(H[4], wr0, ws0, wt1);
-							HEX8::shape(H[5], wr1, ws0, wt1);
-							HEX8::shape(H[6], wr1, ws1, wt1);
-							HEX8::shape(H[7], wr0, ws1, wt1);
-
-							vec3d x[8];
-							float v[8];
-							for (int kk = 0; kk < 8; ++kk)
-							{
-								double* h = H[kk];
-								x[kk] = vec3d(0, 0, 0);
-								v[kk] = 0.0;
-								for (int jj = 0; jj < 8; ++jj)
-								{
-									x[kk] += ex[jj] * h[jj];
-									v[kk] += ev[jj] * h[jj];
-								}
-							}																					
-
-							// calculate the case of the element
-							int ncase = 0;
-							for (int k = 0; k < 8; ++k)
-								if (norm*x[k] >= ref) ncase |= (1 << k);
-
-							// loop over faces
-							int* pf = LUT[ncase];
-							int ne = 0;
-							for (int l = 0; l < 5; l++)
-							{
-								if (*pf == -1) break;
-
-								// calculate nodal positions
-								vec3d r[3];
-								float tex[3], w1, w2, w;
-								for (int k = 0; k < 3; k++)
-								{
-									int n1 = ET_HEX[pf[k]][0];
-									int n2 = ET_HEX[pf[k]][1];
-
-									w1 = norm * x[n1];
-									w2 = norm * x[n2];
-
-									if (w2 != w1)
-										w = (ref - w1) / (w2 - w1);
-									else
-										w = 0.f;
-
-									float f = v[n1] * (1 - w) + v[n2] * w;
-
-									r[k] = x[n1] * (1 - w) + x[n2] * w;
-									tex[k] = f;
-								}
-
-								GLSlice::FACE face;
-								face.mat = n;
-								face.r[0] = r[0];
-								face.r[1] = r[1];
-								face.r[2] = r[2];
-								face.tex[0] = tex[0];
-								face.tex[1] = tex[1];
-								face.tex[2] = tex[2];
-								face.bactive = el.IsActive();
-
-								m_slice.AddFace(face);
-
-								pf += 3;
-							}
-						}
-					}
+					double d = norm * pm->Node(el.m_node[k]).r;
+					if (d < d0) d0 = d;
+					if (d > d1) d1 = d;
 				}
+				dmin[i] = ElementRangeIndex::RoundDown(d0);
+				dmax[i] = ElementRangeIndex::RoundUp(d1);
 			}
 		}
+		m_index[n].Build(dmin, dmax);
 	}
+
+	m_indexNormal = norm;
+	m_indexMesh = pm;
+	m_bupdateIndex = false;
 }
 
 void CGLPlaneCutPlot::AddFaces(FEPostMesh* pm)
@@ -1266,6 +1340,21 @@ bool CGLPlaneCutPlot::IsInsideClipRegion(const vec3d& r)
 	return true;
 }
 
+void CGLPlaneCutPlot::GetClipPlaneEquations(std::vector<double>& eq)
+{
+	eq.clear();
+	for (int i = 0; i < (int)m_clip.size(); ++i)
+	{
+		CGLPlaneCutPlot* pc = m_pcp[i];
+		if ((m_clip[i] != 0) && pc)
+		{
+			double a[4];
+			pc->GetNormalizedEquations(a);
+			eq.insert(eq.end(), a, a + 4);
+		}
+	}
+}
+
 class PlaneCutPlotSelection : public FESelection
 {
 public:	
@@ -28,6 +28,7 @@ SOFTWARE.*/
 #include "GLPlot.h"
 #include <FECore/FETransform.h>
 #include <GLLib/GLMesh.h>
+#include <PostLib/ElementRangeIndex.h>
 #include <vector>
 
 namespace Post {
@@ -61,6 +62,7 @@ class CGLPlaneCutPlot : public CGLPlot
 		FACE& Face(int i) { return m_Face[i]; }
 
 		void AddFace(FACE& f) { m_Face.push_back(f); }
+		void AddFaces(const std::vector<FACE>& f) { m_Face.insert(m_Face.end(), f.begin(), f.end()); }
 
 		int Edges() const { return (int) m_Edge.size(); }
 		EDGE& Edge(int i) { return m_Edge[i]; }
@@ -122,6 +124,8 @@ protected:
 	static int GetFreePlane();
 
 	void AddDomain(FEPostMesh* pm, int n);
+	int SliceElement(FEPostMesh* pm, FEElement_& el, int n, const vec3d& norm, double ref, int ndivs, std::vector<GLSlice::FACE>& faces);
+	void UpdateIndex(FEPostMesh* pm, const vec3d& norm);
 	void AddFaces(FEPostMesh* pm);
 
 	void UpdateTriMesh();
@@ -134,6 +138,9 @@ public:
 	static CGLPlaneCutPlot* GetClipPlane(int i);
 	static bool IsInsideClipRegion(const vec3d& r);
 
+	// get the equations (4 coefficients each) of the clip planes that are in use
+	static void GetClipPlaneEquations(std::vector<double>& eq);
+
 public:
 	bool	m_bshowplane;	// show the plane or not
 	bool	m_bcut_hidden;	// cut hidden materials
@@ -169,5 +176,14 @@ protected:
 	GLLineMesh	m_outlineMesh;	// for rendering the outline
 
 	bool	m_bupdateSlice; // update slice before rendering
+
+	// The solid elements of each domain, indexed by their distance range to the plane.
+	// This is only valid for the normal and mesh below and is rebuilt when the state changes.
+	std::vector<ElementRangeIndex>	m_index;
+	vec3d		m_indexNormal;
+	FEPostMesh*	m_indexMesh;
+	bool		m_bupdateIndex;
+
+	std::vector<FEElement_*>	m_cutElems;	// elements that are cut by the plane (the case is stored in m_ntag)
 };
 }
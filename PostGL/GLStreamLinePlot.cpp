@@ -167,7 +167,7 @@ void CGLStreamLinePlot::Update(int ntime, float dt, bool breset)
 		m_find->Init(bdisp ? 1 : 0);
 	}
 
-	if (m_map.States() == 0)
+	if (m_map.States() != pfem->GetStates())
 	{
 		int NS = pfem->GetStates();
 		int NN = pm->Nodes();
@@ -246,16 +246,39 @@ void CGLStreamLinePlot::Update(int ntime, float dt, bool breset)
 	UpdateMesh();
 }
 
-vec3f CGLStreamLinePlot::Velocity(const vec3f& r, bool& ok)
+vec3f CGLStreamLinePlot::Velocity(const vec3f& r, int& nelem, bool& ok)
 {
 	vec3f v(0.f, 0.f, 0.f);
 	vec3f ve[FSElement::MAX_NODES];
 	FEPostMesh& mesh = *GetModel()->GetActiveMesh();
-	int nelem;
 	double q[3];
-	if (m_find->FindElement(r, nelem, q))
+
+	// Stream lines move in small steps, so the point is usually still in the last
+	// element or in one of its neighbors. Only when that fails do we use the octree.
+	ok = false;
+	if (nelem >= 0)
+	{
+		FEElement_& el = mesh.ElementRef(nelem);
+		if (ProjectInsideElement(mesh, el, r, q)) ok = true;
+		else
+		{
+			int nf = el.Faces();
+			for (int i = 0; i < nf; ++i)
+			{
+				FEElement_* pe = mesh.ElementPtr(el.m_nbr[i]);
+				if (pe && ProjectInsideElement(mesh, *pe, r, q))
+				{
+					nelem = el.m_nbr[i];
+					ok = true;
+					break;
+				}
+			}
+		}
+	}
+	if (ok == false) ok = m_find->FindElement(r, nelem, q);
+
+	if (ok)
 	{
-		ok = true;
 		FEElement_& el = mesh.ElementRef(nelem);
 
 		int ne = el.Nodes();
@@ -263,7 +286,7 @@ vec3f CGLStreamLinePlot::Velocity(const vec3f& r, bool& ok)
 
 		v = el.eval(ve, q[0], q[1], q[2]);
 	}
-	else ok = false;
+	else nelem = -1;
 
 	return v;
 }
@@ -295,15 +318,15 @@ void CGLStreamLinePlot::UpdateStreamLines()
 	float R = box.GetMaxExtent();
 	float maxStep = m_inc*R;
 
-	// tag all elements
-	mesh.TagAllElements(0);
-
-	// use the same seed
-	srand(0);
-
-	// loop over all the surface facts
-	double q[3];
+	// find the seeds
+	struct SEED {
+		vec3f	r;		// seed position
+		vec3f	v;		// velocity at seed
+		int		elem;	// element that contains the seed
+	};
 	int NF = mesh.Faces();
+	vector<SEED> seed(NF);
+	vector<int> isSeed(NF, 0);
 #pragma omp parallel for shared (NF)
 	for (int i=0; i<NF; ++i)
 	{
@@ -325,81 +348,132 @@ void CGLStreamLinePlot::UpdateStreamLines()
 			for (int j = 0; j<nf; ++j) cf += to_vec3f(mesh.Node(f.n[j]).r);
 			cf /= nf;
 
-			// project the seed into the adjacent solid element
-			int nelem = f.m_elem[0].eid;
-			FEElement_* el = &mesh.ElementRef(nelem);
-			el->m_ntag = 1;
-			ProjectInsideReferenceElement(mesh, *el, cf, q);
-
-			double V = vf.Length();
-
-			// now, propagate the seed and form the stream line
-			StreamLine l;
-			l.Add(cf, V);
-
-			vec3f vc = vf;
+			seed[i].r = cf;
+			seed[i].v = vf;
+			seed[i].elem = f.m_elem[0].eid;
+			isSeed[i] = 1;
+		}
+	}
 
-			vec3f v[FSElement::MAX_NODES];
-			bool ok;
-			do
-			{
-				// make sure the velocity is not zero, otherwise we'll be stuck
-				double V = vc.Length();
-				if (V < 1e-5f) break;
-
-				// "time" increment
-				float dt =  maxStep / V;
-
-				// propagate the seed
-				// Euler's method
-//				cf += vc*dt;
-
-				// RK2 method
-/*				vec3f p = cf + vc*dt;
-				vec3f vp = Velocity(p, ok);
-				if (ok == false) break;
-				cf += (vc + vp)*(dt*0.5f);
-*/
-				// RK4
-				vec3f dr(0.f, 0.f, 0.f);
-				do
-				{
-					vec3f a = vc*dt;
-					vec3f b = Velocity(cf + a*0.5f, ok)*dt; if (ok == false) break;
-					vec3f c = Velocity(cf + b*0.5f, ok)*dt; if (ok == false) break;
-					vec3f d = Velocity(cf + c     , ok)*dt; if (ok == false) break;
-
-					dr = (a + b*2.f + c*2.f + d) / 6.0;
-					float DR = dr.Length();
-					if (DR > 2.0f*maxStep) dt *= 0.5f; else break;
-				}
-				while (1);
-				if (ok == false) break;
+	vector<SEED> seeds;
+	for (int i = 0; i < NF; ++i) if (isSeed[i]) seeds.push_back(seed[i]);
 
-				cf += dr;
+	// stream lines are independent, so we can integrate them in parallel
+	// (the lengths vary a lot, hence the dynamic schedule)
+	int NS = (int)seeds.size();
+	vector<StreamLine> lines(NS);
+#pragma omp parallel for schedule(dynamic)
+	for (int i = 0; i < NS; ++i)
+	{
+		SEED& s = seeds[i];
+		IntegrateStreamLine(lines[i], s.r, s.v, s.elem, maxStep, MAX_POINTS);
+	}
 
-				// add it to the stream line
-				l.Add(cf, V);
+	// only keep the lines that went somewhere (in seed order)
+	for (int i = 0; i < NS; ++i)
+	{
+		if (lines[i].Points() > 2) m_streamLines.push_back(lines[i]);
+	}
 
-				// if for some reason we're stuck, we'll set a max nr of points
-				if (l.Points() > MAX_POINTS) break;
+	// evaluate the color of stream lines
+	ColorStreamLines();
+}
 
-				// get velocity at new point
-				vc = Velocity(cf, ok);
-				if (ok == false) break;
+void CGLStreamLinePlot::IntegrateStreamLine(StreamLine& l, vec3f cf, vec3f vc, int nelem, float maxStep, int maxPoints)
+{
+	// Cash-Karp coefficients
+	const float b21 = 1.f/5.f;
+	const float b31 = 3.f/40.f, b32 = 9.f/40.f;
+	const float b41 = 3.f/10.f, b42 = -9.f/10.f, b43 = 6.f/5.f;
+	const float b51 = -11.f/54.f, b52 = 5.f/2.f, b53 = -70.f/27.f, b54 = 35.f/27.f;
+	const float b61 = 1631.f/55296.f, b62 = 175.f/512.f, b63 = 575.f/13824.f, b64 = 44275.f/110592.f, b65 = 253.f/4096.f;
+	const float c1 = 37.f/378.f, c3 = 250.f/621.f, c4 = 125.f/594.f, c6 = 512.f/1771.f;
+	const float d1 = c1 - 2825.f/27648.f, d3 = c3 - 18575.f/48384.f, d4 = c4 - 13525.f/55296.f, d5 = -277.f/14336.f, d6 = c6 - 0.25f;
+
+	// one Cash-Karp step of size dt from (cf, vc). Returns false when one of the
+	// stages falls outside the mesh.
+	auto step = [&](float dt, int& nel, vec3f& dr, float& err) {
+		bool ok;
+		vec3f k1 = vc*dt;
+		vec3f k2 = Velocity(cf + k1*b21, nel, ok)*dt; if (ok == false) return false;
+		vec3f k3 = Velocity(cf + k1*b31 + k2*b32, nel, ok)*dt; if (ok == false) return false;
+		vec3f k4 = Velocity(cf + k1*b41 + k2*b42 + k3*b43, nel, ok)*dt; if (ok == false) return false;
+		vec3f k5 = Velocity(cf + k1*b51 + k2*b52 + k3*b53 + k4*b54, nel, ok)*dt; if (ok == false) return false;
+		vec3f k6 = Velocity(cf + k1*b61 + k2*b62 + k3*b63 + k4*b64 + k5*b65, nel, ok)*dt; if (ok == false) return false;
+
+		// fifth order solution and the difference with the embedded fourth order one
+		dr = k1*c1 + k3*c3 + k4*c4 + k6*c6;
+		err = (k1*d1 + k3*d3 + k4*d4 + k5*d5 + k6*d6).Length();
+		return true;
+	};
+
+	// allowed position error per step
+	const float tol = 1e-3f*maxStep;
+
+	// smallest step we'll take
+	const float minStep = 0.05f*maxStep;
+
+	l.Add(cf, vc.Length());
+
+	float V = vc.Length();
+	if (V < 1e-5f) return;
+
+	// "time" increment
+	float dt = maxStep / V;
+
+	while (l.Points() <= maxPoints)
+	{
+		// make sure the velocity is not zero, otherwise we'll be stuck
+		V = vc.Length();
+		if (V < 1e-5f) break;
+
+		// don't step further than the max step size
+		if (dt*V > maxStep) dt = maxStep / V;
+
+		// try steps until the error is acceptable
+		vec3f dr;
+		float err = 0.f;
+		int nel = nelem;
+		bool ok = true;
+		do
+		{
+			nel = nelem;
+			if (step(dt, nel, dr, err) == false)
+			{
+				// we probably left the domain, so try to get closer to the boundary
+				if (dt*V <= minStep) { ok = false; break; }
+				dt *= 0.5f;
 			}
-			while (1);
-
-			if (l.Points() > 2)
-#pragma omp critical
+			else if (((err <= tol) && (dr.Length() <= 2.f*maxStep)) || (dt*V <= minStep))
 			{
-				m_streamLines.push_back(l);
+				// accept the step, and grow the next one if the error allows it
+				float s = (err > 0.f ? 0.9f*pow(tol / err, 0.2f) : 5.f);
+				dt *= (s > 5.f ? 5.f : s);
+				break;
+			}
+			else
+			{
+				// reject and try a smaller step
+				float s = (err > 0.f ? 0.9f*pow(tol / err, 0.25f) : 0.5f);
+				if (s < 0.1f) s = 0.1f;
+				if (s > 0.5f) s = 0.5f;
+				dt *= s;
+				if (dt*V < minStep) dt = minStep / V;
 			}
 		}
-	}
+		while (1);
+		if (ok == false) break;
 
-	// evaluate the color of stream lines
-	ColorStreamLines();
+		cf += dr;
+
+		// get velocity at new point
+		nelem = nel;
+		vc = Velocity(cf, nelem, ok);
+		if (ok == false) break;
+
+		// add it to the stream line
+		l.Add(cf, V);
+	}
 }
 
 void CGLStreamLinePlot::ColorStreamLines()
@@ -112,7 +112,12 @@ public:
 
 protected:
 
-	vec3f Velocity(const vec3f& r, bool& ok);
+	// evaluate the velocity at r. On input nelem is the element that was last
+	// visited (or -1), on output the element that contains r.
+	vec3f Velocity(const vec3f& r, int& nelem, bool& ok);
+
+	// integrate a stream line from a seed point with adaptive RK45 (Cash-Karp)
+	void IntegrateStreamLine(StreamLine& l, vec3f r, vec3f v, int nelem, float maxStep, int maxPoints);
 
 	void UpdateMesh();
 
@@ -31,6 +31,7 @@ SOFTWARE.*/
 #include "GLModel.h"
 #include <stdlib.h>
 #include <GLLib/glx.h>
+#include "GLPlaneCutPlot.h"
 using namespace Post;
 
 REGISTER_CLASS(GLTensorPlot, CLASS_PLOT, "tensor", 0);
@@ -95,6 +96,9 @@ GLTensorPlot::GLTensorPlot()
 	m_range.mintype = RANGE_DYNAMIC;
 	m_range.valid = false;
 
+	m_glyphType = -1;
+	m_bupdateGlyphs = true;
+
 	GLLegendBar* bar = new GLLegendBar(&m_Col, 0, 0, 600, 100, GLLegendBar::ORIENT_HORIZONTAL);
 	bar->align(GLW_ALIGN_BOTTOM | GLW_ALIGN_HCENTER);
 	bar->copy_label(szname);
@@ -153,6 +157,8 @@ bool GLTensorPlot::UpdateData(bool bsave)
 		{
 			for (int i = 0; i<m_map.States(); ++i) m_map.SetTag(i, -1);
 		}
+
+		m_bupdateGlyphs = true;
 	}
 	else
 	{
@@ -211,7 +217,7 @@ void GLTensorPlot::Update(int ntime, float dt, bool breset)
 	FEPostMesh* pm = mdl->GetActiveMesh();
 	FEPostModel* pfem = mdl->GetFSModel();
 
-	if (m_map.States() == 0)
+	if (m_map.States() != pfem->GetStates())
 	{
 		int NS = pfem->GetStates();
 
@@ -419,6 +425,8 @@ void GLTensorPlot::Update(int ntime, float dt, bool breset)
 
 	// copy nodal values
 	m_val = m_map.State(ntime);
+
+	m_bupdateGlyphs = true;
 }
 
 static double frand() { return (double)rand() / (double)RAND_MAX; }
@@ -429,6 +437,30 @@ void GLTensorPlot::Render(CGLContext& rc)
 
 	if (m_ntensor == 0) return;
 
+	float fmax = 1.f, fmin = 0.f;
+	if (m_ncol != Glyph_Col_Solid)
+	{
+		fmax = m_range.max;
+		fmin = m_range.min;
+	}
+	GetLegendBar()->SetRange(fmin, fmax);
+
+	// the glyphs only need to be rebuilt when the data, the settings, or the clip planes change
+	vector<double> clip;
+	if (AllowClipping()) CGLPlaneCutPlot::GetClipPlaneEquations(clip);
+	if (m_bupdateGlyphs || (clip != m_glyphClip))
+	{
+		// The items that get a glyph depend on the state, the data field, the settings, and 
+		// the visibility. All of these flag an update (visibility changes update the model).
+		if (m_bupdateGlyphs)
+		{
+			m_glyphItems.clear();
+			SelectItems(m_glyphItems);
+		}
+		m_glyphClip = clip;
+		BuildGlyphs();
+	}
+
 	GLfloat ambient[] = { 0.1f,0.1f,0.1f,1.f };
 	GLfloat specular[] = { 0.0f,0.0f,0.0f,1 };
 	GLfloat emission[] = { 0,0,0,1 };
@@ -441,22 +473,7 @@ void GLTensorPlot::Render(CGLContext& rc)
 	//	glMateriali(GL_FRONT_AND_BACK, GL_SHININESS, 32);
 
 	// store attributes
-	glPushAttrib(GL_LIGHTING_BIT);
-
-	// create the cylinder object
-	glEnable(GL_LIGHTING);
-	GLUquadricObj* pglyph = gluNewQuadric();
-	gluQuadricNormals(pglyph, GLU_SMOOTH);
-
-	CGLModel* mdl = GetModel();
-	FEPostModel* ps = mdl->GetFSModel();
-
-	srand(m_seed);
-
-	FEPostModel* pfem = mdl->GetFSModel();
-	FEPostMesh* pm = mdl->GetActiveMesh();
-
-	float scale = 0.02f*m_scale*pfem->GetBoundingBox().Radius();
+	glPushAttrib(GL_ENABLE_BIT | GL_LIGHTING_BIT);
 
 	if (m_nglyph == Glyph_Line) glDisable(GL_LIGHTING);
 	else
@@ -464,7 +481,6 @@ void GLTensorPlot::Render(CGLContext& rc)
 		glEnable(GL_LIGHTING);
 		glEnable(GL_COLOR_MATERIAL);
 		glColorMaterial(GL_FRONT_AND_BACK, GL_AMBIENT_AND_DIFFUSE);
-		glColor3ub(m_gcl.r, m_gcl.g, m_gcl.b);
 
 		GLfloat dif[] = { 1.f, 1.f, 1.f, 1.f };
 		GLfloat amb[] = { 0.1f, 0.1f, 0.1f, 1.f };
@@ -473,6 +489,24 @@ void GLTensorPlot::Render(CGLContext& rc)
 		glLightfv(GL_LIGHT0, GL_AMBIENT, amb);
 	}
 
+	// render all glyphs
+	m_glyph.Render();
+
+	// restore attributes
+	glPopAttrib();
+
+	glColorMaterial(GL_FRONT_AND_BACK, GL_AMBIENT_AND_DIFFUSE);
+}
+
+// find the items (elements or nodes) that will be rendered
+void GLTensorPlot::SelectItems(vector<int>& items)
+{
+	CGLModel* mdl = GetModel();
+	FEPostModel* ps = mdl->GetFSModel();
+	FEPostMesh* pm = mdl->GetActiveMesh();
+
+	srand(m_seed);
+
 	if (IS_ELEM_FIELD(m_ntensor))
 	{
 		pm->TagAllElements(0);
@@ -496,54 +530,10 @@ void GLTensorPlot::Render(CGLContext& rc)
 			}
 		}
 
-		float auto_scale = 1.f;
-		if (m_bautoscale)
-		{
-			float Lmax = 0.f;
-			for (int i = 0; i < pm->Elements(); ++i)
-			{
-				for (int j = 0; j < 3; ++j)
-				{
-					float L = fabs(m_val[i].l[j]);
-					if (L > Lmax) Lmax = L;
-				}
-			}
-			if (Lmax == 0.f) Lmax = 1.f;
-			auto_scale = 1.f / Lmax;
-		}
-
-		CColorMap& map = ColorMapManager::GetColorMap(m_Col.GetColorMap());
-		float fmax = 1.f, fmin = 0.f;
-		if (m_ncol != Glyph_Col_Solid)
-		{
-			fmax = m_range.max;
-			fmin = m_range.min;
-		}
-
-		GetLegendBar()->SetRange(fmin, fmax);
-
-		if (fmax == fmin) fmax++;
-
 		for (int i = 0; i < pm->Elements(); ++i)
 		{
 			FEElement_& elem = pm->ElementRef(i);
-			if ((frand() <= m_dens) && elem.m_ntag)
-			{
-				vec3d r = pm->ElementCenter(elem);
-
-				TENSOR& t = m_val[i];
-
-				if (m_ncol != Glyph_Col_Solid)
-				{
-					float w = (t.f - fmin) / (fmax - fmin);
-					GLColor c = map.map(w);
-					glColor3ub(c.r, c.g, c.b);
-				}
-
-				glTranslatef(r.x, r.y, r.z);
-				RenderGlyphs(t, scale*auto_scale, pglyph);
-				glTranslatef(-r.x, -r.y, -r.z);
-			}
+			if ((frand() <= m_dens) && elem.m_ntag) items.push_back(i);
 		}
 	}
 	else
@@ -570,197 +560,149 @@ void GLTensorPlot::Render(CGLContext& rc)
 			}
 		}
 
-		float auto_scale = 1.f;
-		if (m_bautoscale)
-		{
-			float Lmax = 0.f;
-			for (int i = 0; i < pm->Nodes(); ++i)
-			{
-				for (int j = 0; j < 3; ++j)
-				{
-					float L = fabs(m_val[i].l[j]);
-					if (L > Lmax) Lmax = L;
-				}
-			}
-			if (Lmax == 0.f) Lmax = 1.f;
-			auto_scale = 1.f / Lmax;
-		}
-
-		CColorMap& map = ColorMapManager::GetColorMap(m_Col.GetColorMap());
-		float fmax = 1.f, fmin = 0.f;
-		if (m_ncol != Glyph_Col_Solid)
-		{
-			fmax = m_range.max;
-			fmin = m_range.min;
-		}
-		GetLegendBar()->SetRange(fmin, fmax);
-
-		if (fmax == fmin) fmax++;
-
-		if (m_nglyph == Glyph_Line) glDisable(GL_LIGHTING);
-
-		glx::glcolor(m_gcl);
-
 		for (int i = 0; i < pm->Nodes(); ++i)
 		{
 			FSNode& node = pm->Node(i);
-			if ((frand() <= m_dens) && node.m_ntag)
-			{
-				vec3d r = node.r;
-
-				TENSOR& t = m_val[i];
-
-				if (m_ncol != Glyph_Col_Solid)
-				{
-					float w = (t.f  - fmin)/ (fmax - fmin);
-					GLColor c = map.map(w);
-					glx::glcolor(c);
-				}
-
-				glx::translate(r);
-				RenderGlyphs(t, scale*auto_scale, pglyph);
-				glx::translate(-r);
-			}
+			if ((frand() <= m_dens) && node.m_ntag) items.push_back(i);
 		}
 	}
-
-	gluDeleteQuadric(pglyph);
-
-	// restore attributes
-	glPopAttrib();
-
-	glColorMaterial(GL_FRONT_AND_BACK, GL_AMBIENT_AND_DIFFUSE);
 }
 
-void GLTensorPlot::RenderGlyphs(TENSOR& t, float scale, GLUquadricObj* glyph)
+// create the glyph geometry for the current glyph type
+void GLTensorPlot::UpdateGlyphGeometry()
 {
+	m_glyph.ClearGlyph();
 	switch (m_nglyph)
 	{
-	case Glyph_Arrow : RenderArrows(t, scale, glyph); break;
-	case Glyph_Line  : RenderLines (t, scale, glyph); break;
-	case Glyph_Sphere: RenderSphere(t, scale, glyph); break;
-	case Glyph_Box   : RenderBox   (t, scale, glyph); break;
+	case Glyph_Arrow:
+		m_glyph.AddCylinder(0.05f, 0.05f, 0.f, 0.9f, 5);
+		m_glyph.AddCylinder(0.15f, 0.f, 0.81f, 1.01f, 10);
+		break;
+	case Glyph_Line:
+		m_glyph.AddLine(vec3f(0.f, 0.f, 0.f), vec3f(0.f, 0.f, 1.f));
+		break;
+	case Glyph_Sphere:
+		m_glyph.AddSphere(1.f, 16, 16);
+		break;
+	case Glyph_Box:
+		m_glyph.AddBox(0.5f, 0.5f, 0.5f);
+		break;
 	}
+	m_glyphType = m_nglyph;
 }
 
-void GLTensorPlot::RenderArrows(GLTensorPlot::TENSOR& t, float scale, GLUquadricObj* pglyph)
+// build the glyph instances for the selected items
+void GLTensorPlot::BuildGlyphs()
 {
-	GLColor c[3];
-	c[0] = GLColor(255, 0, 0);
-	c[1] = GLColor(0, 255, 0);
-	c[2] = GLColor(0, 0, 255);
+	m_bupdateGlyphs = false;
+
+	CGLModel* mdl = GetModel();
+	FEPostModel* pfem = mdl->GetFSModel();
+	FEPostMesh* pm = mdl->GetActiveMesh();
+
+	if (m_glyphType != m_nglyph) UpdateGlyphGeometry();
+
+	bool belem = IS_ELEM_FIELD(m_ntensor);
+
+	float scale = 0.02f*m_scale*pfem->GetBoundingBox().Radius();
 
-	for (int i = 0; i<3; ++i)
+	if (m_bautoscale)
 	{
-		glPushMatrix();
-
-		float L = (m_bnormalize ? scale : scale*t.l[i]);
-		float l0 = L*.9;
-		float l1 = L*.2;
-		float r0 = L*0.05;
-		float r1 = L*0.15;
-
-		vec3f v = t.r[i];
-		quatd q = quatd(vec3d(0,0,1), to_vec3d(v));
-		float w = q.GetAngle();
-		if (fabs(w) > 1e-6)
+		int items = (belem ? pm->Elements() : pm->Nodes());
+		float Lmax = 0.f;
+		for (int i = 0; i < items; ++i)
 		{
-			vec3d p = q.GetVector();
-			if (p.Length() > 1e-6) glRotated(w * 180 / PI, p.x, p.y, p.z);
+			for (int j = 0; j < 3; ++j)
+			{
+				float L = fabs(m_val[i].l[j]);
+				if (L > Lmax) Lmax = L;
+			}
 		}
+		if (Lmax == 0.f) Lmax = 1.f;
+		scale /= Lmax;
+	}
 
-		glColor3ub(c[i].r, c[i].g, c[i].b);
-		gluCylinder(pglyph, r0, r0, l0, 5, 1);
-		glTranslatef(0.f, 0.f, (float)l0*0.9f);
-		gluCylinder(pglyph, r1, 0, l1, 10, 1);
-
-		glPopMatrix();
+	CColorMap& map = ColorMapManager::GetColorMap(m_Col.GetColorMap());
+	float fmax = 1.f, fmin = 0.f;
+	if (m_ncol != Glyph_Col_Solid)
+	{
+		fmax = m_range.max;
+		fmin = m_range.min;
 	}
-}
+	if (fmax == fmin) fmax++;
 
-void GLTensorPlot::RenderLines(GLTensorPlot::TENSOR& t, float scale, GLUquadricObj* pglyph)
-{
-	GLColor c[3];
-	c[0] = GLColor(255, 0, 0);
-	c[1] = GLColor(0, 255, 0);
-	c[2] = GLColor(0, 0, 255);
+	// the arrow and line glyphs have a separate instance for each direction
+	const GLColor axisCol[3] = { GLColor(255, 0, 0), GLColor(0, 255, 0), GLColor(0, 0, 255) };
+	bool baxes = ((m_nglyph == Glyph_Arrow) || (m_nglyph == Glyph_Line));
 
-	for (int i = 0; i<3; ++i)
+	int N = (int)m_glyphItems.size();
+	vector<GLGlyphMesh::Instance> inst(3 * N);
+	vector<char> ok(3 * N, 0);
+#pragma omp parallel for
+	for (int i = 0; i < N; ++i)
 	{
-		glPushMatrix();
+		int n = m_glyphItems[i];
+		vec3f r = (belem ? to_vec3f(pm->ElementCenter(pm->ElementRef(n))) : to_vec3f(pm->Node(n).r));
 
-		float L = (m_bnormalize ? scale : scale*t.l[i]);
+		TENSOR t = m_val[n];
 
-		vec3f v = t.r[i];
-		quatd q = quatd(vec3d(0, 0, 1), to_vec3d(v));
-		float w = q.GetAngle();
-		if (fabs(w) > 1e-6)
+		if (baxes)
 		{
-			vec3d p = q.GetVector();
-			if (p.Length() > 1e-6) glRotatef(w * 180 / PI, p.x, p.y, p.z);
+			for (int j = 0; j < 3; ++j)
+			{
+				float L = (m_bnormalize ? scale : scale*t.l[j]);
+				if ((L == 0.f) || (t.r[j].Length() == 0.f)) continue;
+
+				GLGlyphMesh::Instance& g = inst[3 * i + j];
+				g.r = r;
+				g.c = axisCol[j];
+				g.SetZAxis(t.r[j]);
+				if (m_nglyph == Glyph_Line) { g.s[0] = g.s[1] = 1.f; g.s[2] = L; }
+				else g.s[0] = g.s[1] = g.s[2] = L;
+				ok[3 * i + j] = 1;
+			}
 		}
+		else
+		{
+			if (scale <= 0.f) continue;
 
-		glx::glcolor(c[i]);
-		glx::drawLine(0, 0, 0, 0, 0, L);
+			float smax = 0.f;
+			float sx = fabs(t.l[0]); if (sx > smax) smax = sx;
+			float sy = fabs(t.l[1]); if (sy > smax) smax = sy;
+			float sz = fabs(t.l[2]); if (sz > smax) smax = sz;
+			if (smax < 1e-7f) continue;
 
-		glPopMatrix();
+			if (sx < 0.1*smax) sx = 0.1f*smax;
+			if (sy < 0.1*smax) sy = 0.1f*smax;
+			if (sz < 0.1*smax) sz = 0.1f*smax;
+
+			GLGlyphMesh::Instance& g = inst[3 * i];
+			g.r = r;
+			if (m_ncol != Glyph_Col_Solid)
+			{
+				float w = (t.f - fmin) / (fmax - fmin);
+				g.c = map.map(w);
+				g.c.a = 255;
+			}
+			else g.c = GLColor(m_gcl.r, m_gcl.g, m_gcl.b);
+
+			g.e[0] = t.r[0];
+			g.e[1] = t.r[1];
+			g.e[2] = t.r[2];
+			g.s[0] = scale*sx;
+			g.s[1] = scale*sy;
+			g.s[2] = scale*sz;
+			ok[3 * i] = 1;
+		}
 	}
-}
 
-void GLTensorPlot::RenderSphere(TENSOR& t, float scale, GLUquadricObj* glyph)
-{
-	if (scale <= 0.f) return;
-
-	float smax = 0.f;
-	float sx = fabs(t.l[0]); if (sx > smax) smax = sx;
-	float sy = fabs(t.l[1]); if (sy > smax) smax = sy;
-	float sz = fabs(t.l[2]); if (sz > smax) smax = sz;
-	if (smax < 1e-7f) return;
-
-	if (sx < 0.1*smax) sx = 0.1f*smax;
-	if (sy < 0.1*smax) sy = 0.1f*smax;
-	if (sz < 0.1*smax) sz = 0.1f*smax;
-
-	glPushMatrix();
-	vec3f* e = t.r;
-	vec3f n = e[0] ^ e[1];
-	if (n*e[2] < 0) e[2] = -e[2];
-	GLfloat m[4][4] = {0};
-	m[3][3] = 1.f;
-	m[0][0] = e[0].x; m[0][1] = e[0].y; m[0][2] = e[0].z;
-	m[1][0] = e[1].x; m[1][1] = e[1].y; m[1][2] = e[1].z;
-	m[2][0] = e[2].x; m[2][1] = e[2].y; m[2][2] = e[2].z;
-	glMultMatrixf(&m[0][0]);
-
-	glScalef(scale*sx, scale*sy, scale*sz);
-	gluSphere(glyph, 1.f, 16, 16);
-	glPopMatrix();
-}
+	// remove the unused instances
+	int m = 0;
+	for (int i = 0; i < 3 * N; ++i)
+	{
+		if (ok[i]) inst[m++] = inst[i];
+	}
+	inst.resize(m);
 
-void GLTensorPlot::RenderBox(TENSOR& t, float scale, GLUquadricObj* glyph)
-{
-	if (scale <= 0.f) return;
-
-	float smax = 0.f;
-	float sx = fabs(t.l[0]); if (sx > smax) smax = sx;
-	float sy = fabs(t.l[1]); if (sy > smax) smax = sy;
-	float sz = fabs(t.l[2]); if (sz > smax) smax = sz;
-	if (smax < 1e-7f) return;
-
-	if (sx < 0.1*smax) sx = 0.1f*smax;
-	if (sy < 0.1*smax) sy = 0.1f*smax;
-	if (sz < 0.1*smax) sz = 0.1f*smax;
-
-	glPushMatrix();
-	vec3f* e = t.r;
-	GLfloat m[4][4] = { 0 };
-	m[3][3] = 1.f;
-	m[0][0] = e[0].x; m[0][1] = e[0].y; m[0][2] = e[0].z;
-	m[1][0] = e[1].x; m[1][1] = e[1].y; m[1][2] = e[1].z;
-	m[2][0] = e[2].x; m[2][1] = e[2].y; m[2][2] = e[2].z;
-	glMultMatrixf(&m[0][0]);
-
-	glScalef(scale*sx, scale*sy, scale*sz);
-	glx::drawBox(0.5, 0.5, 0.5);
-	glPopMatrix();
+	m_glyph.Build(inst, m_glyphClip);
 }
@@ -27,11 +27,7 @@ SOFTWARE.*/
 #pragma once
 #include "GLPlot.h"
 #include <GLWLib/GLWidget.h>
-#ifdef __APPLE__
-    #include <OpenGL/GLU.h>
-#else
-    #include <GL/glu.h>
-#endif
+#include <GLLib/GLGlyphMesh.h>
 
 namespace Post {
 
@@ -73,6 +69,8 @@ public:
 
 	CColorTexture* GetColorMap();
 
+	void UpdateTexture() override { m_Col.UpdateTexture(); m_bupdateGlyphs = true; }
+
 	void Update(int ntime, float dt, bool breset) override;
 
 	bool UpdateData(bool bsave = true) override;
@@ -84,36 +82,34 @@ public:
 	int GetVectorMethod() const { return m_nmethod; }
 	void SetVectorMethod(int m);
 
-	void SetScaleFactor(float g) { m_scale = g; }
+	void SetScaleFactor(float g) { m_scale = g; m_bupdateGlyphs = true; }
 	double GetScaleFactor() { return m_scale; }
 
-	void SetDensity(float d) { m_dens = d; }
+	void SetDensity(float d) { m_dens = d; m_bupdateGlyphs = true; }
 	double GetDensity() { return m_dens; }
 
 	bool ShowHidden() const { return m_bshowHidden; }
-	void ShowHidden(bool b) { m_bshowHidden = b; }
+	void ShowHidden(bool b) { m_bshowHidden = b; m_bupdateGlyphs = true; }
 
 	int GetGlyphType() { return m_nglyph; }
-	void SetGlyphType(int ntype) { m_nglyph = ntype; }
+	void SetGlyphType(int ntype) { m_nglyph = ntype; m_bupdateGlyphs = true; }
 
 	int GetColorType() { return m_ncol; }
-	void SetColorType(int ntype) { m_ncol = ntype; }
+	void SetColorType(int ntype) { m_ncol = ntype; m_bupdateGlyphs = true; }
 
 	GLColor GetGlyphColor() { return m_gcl; }
-	void SetGlyphColor(GLColor c) { m_gcl = c; }
+	void SetGlyphColor(GLColor c) { m_gcl = c; m_bupdateGlyphs = true; }
 
 	bool GetAutoScale() { return m_bautoscale; }
-	void SetAutoScale(bool b) { m_bautoscale = b; }
+	void SetAutoScale(bool b) { m_bautoscale = b; m_bupdateGlyphs = true; }
 
 	bool GetNormalize() { return m_bnormalize; }
-	void SetNormalize(bool b) { m_bnormalize = b; }
+	void SetNormalize(bool b) { m_bnormalize = b; m_bupdateGlyphs = true; }
 
 protected:
-	void RenderGlyphs(TENSOR& t, float scale, GLUquadricObj* glyph);
-	void RenderArrows(TENSOR& t, float scale, GLUquadricObj* glyph);
-	void RenderLines(TENSOR& t, float scale, GLUquadricObj* glyph);
-	void RenderSphere(TENSOR& t, float scale, GLUquadricObj* glyph);
-	void RenderBox(TENSOR& t, float scale, GLUquadricObj* glyph);
+	void SelectItems(vector<int>& items);
+	void UpdateGlyphGeometry();
+	void BuildGlyphs();
 
 	void Update() override;
 
@@ -144,5 +140,11 @@ protected:
 	int		m_lastTime;
 	float	m_lastDt;
 	int		m_lastCol;
+
+	GLGlyphMesh		m_glyph;			// the glyphs of all rendered tensors
+	int				m_glyphType;		// glyph type of the glyph geometry
+	vector<int>		m_glyphItems;		// items for which the glyphs were built
+	vector<double>	m_glyphClip;		// clip planes for which the glyphs were built
+	bool			m_bupdateGlyphs;	// the glyphs need to be rebuilt
 };
 }
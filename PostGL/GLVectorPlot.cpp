@@ -31,6 +31,7 @@ SOFTWARE.*/
 #include "GLWLib/GLWidgetManager.h"
 #include <PostGL/GLModel.h>
 #include <GLLib/glx.h>
+#include "GLPlaneCutPlot.h"
 using namespace Post;
 
 //////////////////////////////////////////////////////////////////////
@@ -93,6 +94,9 @@ CGLVectorPlot::CGLVectorPlot()
 	m_usr[0] = 0.0;
 	m_usr[1] = 1.0;
 
+	m_glyphType = -1;
+	m_bupdateGlyphs = true;
+
 	GLLegendBar* bar = new GLLegendBar(&m_Col, 0, 0, 120, 500);
 	bar->align(GLW_ALIGN_BOTTOM | GLW_ALIGN_HCENTER);
 	bar->SetOrientation(GLLegendBar::ORIENT_HORIZONTAL);
@@ -135,6 +139,7 @@ bool CGLVectorPlot::UpdateData(bool bsave)
 		}
 
 		if (oldvec != m_nvec) Update();
+		m_bupdateGlyphs = true;
 	}
 	else
 	{
@@ -164,6 +169,22 @@ void CGLVectorPlot::Render(CGLContext& rc)
 {
 	if (m_nvec == -1) return;
 
+	// the glyphs only need to be rebuilt when the data, the settings, or the clip planes change
+	vector<double> clip;
+	if (AllowClipping()) CGLPlaneCutPlot::GetClipPlaneEquations(clip);
+	if (m_bupdateGlyphs || (clip != m_glyphClip))
+	{
+		// The items that get a glyph depend on the state, the data field, the settings, and 
+		// the visibility. All of these flag an update (visibility changes update the model).
+		if (m_bupdateGlyphs)
+		{
+			m_glyphItems.clear();
+			SelectItems(m_glyphItems);
+		}
+		m_glyphClip = clip;
+		BuildGlyphs();
+	}
+
 	GLfloat ambient[] = {0.1f,0.1f,0.1f,1.f};
 	GLfloat specular[] = {0.0f,0.0f,0.0f,1};
 	GLfloat emission[] = {0,0,0,1};
@@ -178,38 +199,6 @@ void CGLVectorPlot::Render(CGLContext& rc)
 	// store attributes
 	glPushAttrib(GL_ENABLE_BIT | GL_LIGHTING_BIT);
 
-	// create the cylinder object
-	glEnable(GL_LIGHTING);
-	GLUquadricObj* pglyph = gluNewQuadric();
-	gluQuadricNormals(pglyph, GLU_SMOOTH);
-
-	CGLModel* mdl = GetModel();
-	FEPostModel* ps = mdl->GetFSModel();
-
-	srand(m_seed);
-
-	FEPostModel* pfem = mdl->GetFSModel();
-	FEPostMesh* pm = mdl->GetActiveMesh();
-
-	// calculate scale factor for rendering
-	m_fscale = 0.02f*m_scale*pfem->GetBoundingBox().Radius();
-
-	// calculate auto-scale factor
-	if (m_bautoscale)
-	{
-		float autoscale = 1.f;
-		float Lmax = 0.f;
-		for (int i = 0; i<(int)m_val.size(); ++i)
-		{
-			float L = m_val[i].Length();
-			if (L > Lmax) Lmax = L;
-		}
-		if (Lmax == 0.f) Lmax = 1.f;
-		autoscale = 1.f / Lmax;
-
-		m_fscale *= autoscale;
-	}
-
 	if (m_nglyph == GLYPH_LINE) glDisable(GL_LIGHTING);
 	else
 	{
@@ -222,6 +211,24 @@ void CGLVectorPlot::Render(CGLContext& rc)
 		glLightfv(GL_LIGHT0, GL_AMBIENT, dif);
 	}
 
+	// render all glyphs
+	m_glyph.Render();
+
+	// restore attributes
+	glPopAttrib();
+
+	glColorMaterial(GL_FRONT_AND_BACK, GL_AMBIENT_AND_DIFFUSE);
+}
+
+// find the items (elements, faces, or nodes) that will be rendered
+void CGLVectorPlot::SelectItems(vector<int>& items)
+{
+	CGLModel* mdl = GetModel();
+	FEPostModel* ps = mdl->GetFSModel();
+	FEPostMesh* pm = mdl->GetActiveMesh();
+
+	srand(m_seed);
+
 	if (IS_ELEM_FIELD(m_nvec))
 	{
 		pm->TagAllElements(0);
@@ -245,16 +252,10 @@ void CGLVectorPlot::Render(CGLContext& rc)
 			}
 		}
 
-		// render the vectors at the elements' centers
 		for (int i = 0; i < pm->Elements(); ++i)
 		{
 			FEElement_& elem = pm->ElementRef(i);
-			if ((frand() <= m_dens) && elem.m_ntag)
-			{
-				vec3f r = to_vec3f(pm->ElementCenter(elem));
-				vec3f v = m_val[i];
-				RenderVector(r, v, pglyph);
-			}
+			if ((frand() <= m_dens) && elem.m_ntag) items.push_back(i);
 		}
 	}
 	else if (IS_FACE_FIELD(m_nvec))
@@ -284,16 +285,10 @@ void CGLVectorPlot::Render(CGLContext& rc)
 			}
 		}
 
-		// render the vectors at the face's center
 		for (int i = 0; i < pm->Faces(); ++i)
 		{
 			FSFace& face = pm->Face(i);
-			if ((frand() <= m_dens) && face.m_ntag)
-			{
-				vec3f r = to_vec3f(pm->FaceCenter(face));
-				vec3f v = m_val[i];
-				RenderVector(r, v, pglyph);
-			}
+			if ((frand() <= m_dens) && face.m_ntag) items.push_back(i);
 		}
 	}
 	else if (IS_NODE_FIELD(m_nvec))
@@ -323,104 +318,146 @@ void CGLVectorPlot::Render(CGLContext& rc)
 		for (int i = 0; i < pm->Nodes(); ++i)
 		{
 			FSNode& node = pm->Node(i);
-			if ((frand() <= m_dens) && node.m_ntag)
-			{
-				vec3f r = to_vec3f(node.r);
-
-				vec3f v = m_val[i];
-
-				RenderVector(r, v, pglyph);
-			}
+			if ((frand() <= m_dens) && node.m_ntag) items.push_back(i);
 		}
 	}
+}
 
-	gluDeleteQuadric(pglyph);
-
-	// restore attributes
-	glPopAttrib();
-
-	glColorMaterial(GL_FRONT_AND_BACK, GL_AMBIENT_AND_DIFFUSE);
+// create the glyph geometry for the current glyph type
+void CGLVectorPlot::UpdateGlyphGeometry()
+{
+	// The geometry is defined for a unit vector. The instances scale 
+	// it with the vector length and the aspect ratio.
+	m_glyph.ClearGlyph();
+	switch (m_nglyph)
+	{
+	case GLYPH_ARROW:
+		m_glyph.AddCylinder(0.05f, 0.05f, 0.f, 0.9f, 5);
+		m_glyph.AddCylinder(0.15f, 0.f, 0.81f, 1.01f, 10);
+		break;
+	case GLYPH_CONE:
+		m_glyph.AddCylinder(0.15f, 0.f, 0.f, 0.9f, 10);
+		break;
+	case GLYPH_CYLINDER:
+		m_glyph.AddCylinder(0.15f, 0.15f, 0.f, 0.9f, 10);
+		break;
+	case GLYPH_SPHERE:
+		m_glyph.AddSphere(0.15f, 10, 5);
+		break;
+	case GLYPH_BOX:
+		m_glyph.AddBox(0.05f, 0.05f, 0.05f);
+		break;
+	case GLYPH_LINE:
+		m_glyph.AddLine(vec3f(0.f, 0.f, 0.f), vec3f(0.f, 0.f, 1.f));
+		break;
+	}
+	m_glyphType = m_nglyph;
 }
 
-void CGLVectorPlot::RenderVector(const vec3f& r, vec3f v, GLUquadric* pglyph)
+// build the glyph instances for the selected items
+void CGLVectorPlot::BuildGlyphs()
 {
-	float L = v.Length();
-	if (L == 0.f) return;
+	m_bupdateGlyphs = false;
 
-	CColorMap& map = ColorMapManager::GetColorMap(m_Col.GetColorMap());
+	CGLModel* mdl = GetModel();
+	FEPostModel* pfem = mdl->GetFSModel();
+	FEPostMesh* pm = mdl->GetActiveMesh();
+
+	if (m_glyphType != m_nglyph) UpdateGlyphGeometry();
+
+	// calculate scale factor for rendering
+	m_fscale = 0.02f*m_scale*pfem->GetBoundingBox().Radius();
+
+	// calculate auto-scale factor
+	if (m_bautoscale)
+	{
+		float autoscale = 1.f;
+		float Lmax = 0.f;
+		for (int i = 0; i<(int)m_val.size(); ++i)
+		{
+			float L = m_val[i].Length();
+			if (L > Lmax) Lmax = L;
+		}
+		if (Lmax == 0.f) Lmax = 1.f;
+		autoscale = 1.f / Lmax;
+
+		m_fscale *= autoscale;
+	}
 
+	CColorMap& map = ColorMapManager::GetColorMap(m_Col.GetColorMap());
 	float fmin = m_crng.x;
 	float fmax = m_crng.y;
 
-	float f = (L - fmin) / (fmax - fmin);
-	GLColor col = map.map(f);
-	v.Normalize();
+	int ntype = 0;
+	if      (IS_ELEM_FIELD(m_nvec)) ntype = 1;
+	else if (IS_FACE_FIELD(m_nvec)) ntype = 2;
 
-	switch (m_ncol)
-	{
-	case GLYPH_COL_LENGTH:
-		glColor3ub(col.r, col.g, col.b);
-		break;
-	case GLYPH_COL_ORIENT:
+	int N = (int)m_glyphItems.size();
+	vector<GLGlyphMesh::Instance> inst(N);
+	vector<char> ok(N, 0);
+#pragma omp parallel for
+	for (int i = 0; i < N; ++i)
 	{
-		GLdouble r = fabs(v.x);
-		GLdouble g = fabs(v.y);
-		GLdouble b = fabs(v.z);
-		glColor3d(r, g, b);
-	}
-	break;
-	case GLYPH_COL_SOLID:
-	default:
-		glColor3ub(m_gcl.r, m_gcl.g, m_gcl.b);
-	}
+		int n = m_glyphItems[i];
+		vec3f v = m_val[n];
+		float L = v.Length();
+		if (L == 0.f) continue;
+
+		GLGlyphMesh::Instance& g = inst[i];
+		switch (ntype)
+		{
+		case 1: g.r = to_vec3f(pm->ElementCenter(pm->ElementRef(n))); break;
+		case 2: g.r = to_vec3f(pm->FaceCenter(pm->Face(n))); break;
+		default:
+			g.r = to_vec3f(pm->Node(n).r);
+		}
 
-	if (m_bnorm) L = 1;
+		float f = (L - fmin) / (fmax - fmin);
+		v.Normalize();
 
-	L *= m_fscale;
-	float l0 = L*.9;
-	float l1 = L*.2;
-	float r0 = L*0.05*m_ar;
-	float r1 = L*0.15*m_ar;
+		switch (m_ncol)
+		{
+		case GLYPH_COL_LENGTH:
+			g.c = map.map(f);
+			g.c.a = 255;
+			break;
+		case GLYPH_COL_ORIENT:
+			g.c = GLColor((uint8_t)(255.f*fabs(v.x)), (uint8_t)(255.f*fabs(v.y)), (uint8_t)(255.f*fabs(v.z)));
+			break;
+		case GLYPH_COL_SOLID:
+		default:
+			g.c = GLColor(m_gcl.r, m_gcl.g, m_gcl.b);
+		}
 
-	glPushMatrix();
+		if (m_bnorm) L = 1;
+		L *= m_fscale;
 
-	glTranslatef(r.x, r.y, r.z);
-	quatd q;
-	vec3d V = to_vec3d(v);
-	if (V * vec3d(0, 0, 1) == -1.0) q = quatd(PI, vec3d(1, 0, 0));
-	else q = quatd(vec3d(0, 0, 1), to_vec3d(v));
-	float w = q.GetAngle();
-	if (fabs(w) > 1e-6)
-	{
-		vec3d p = q.GetVector();
-		if (p.Length() > 1e-6) glRotated(w * 180 / PI, p.x, p.y, p.z);
-		else glRotated(w * 180 / PI, 1, 0, 0);
+		g.SetZAxis(v);
+		switch (m_nglyph)
+		{
+		case GLYPH_LINE:
+			g.s[0] = g.s[1] = 1.f; g.s[2] = L;
+			break;
+		case GLYPH_SPHERE:
+		case GLYPH_BOX:
+			g.s[0] = g.s[1] = g.s[2] = L*m_ar;
+			break;
+		default:
+			g.s[0] = g.s[1] = L*m_ar; g.s[2] = L;
+		}
+
+		ok[i] = 1;
 	}
 
-	switch (m_nglyph)
+	// remove the zero-length vectors
+	int m = 0;
+	for (int i = 0; i < N; ++i)
 	{
-	case GLYPH_ARROW:
-		gluCylinder(pglyph, r0, r0, l0, 5, 1);
-		glTranslatef(0.f, 0.f, (float)l0*0.9f);
-		gluCylinder(pglyph, r1, 0, l1, 10, 1);
-		break;
-	case GLYPH_CONE:
-		gluCylinder(pglyph, r1, 0, l0, 10, 1);
-		break;
-	case GLYPH_CYLINDER:
-		gluCylinder(pglyph, r1, r1, l0, 10, 1);
-		break;
-	case GLYPH_SPHERE:
-		gluSphere(pglyph, r1, 10, 5);
-		break;
-	case GLYPH_BOX:
-		glx::drawBox(r0, r0, r0);
-		break;
-	case GLYPH_LINE:
-		glx::drawLine(0, 0, 0, 0, 0, L);
+		if (ok[i]) inst[m++] = inst[i];
 	}
+	inst.resize(m);
 
-	glPopMatrix();
+	m_glyph.Build(inst, m_glyphClip);
 }
 
 void CGLVectorPlot::SetVectorField(int ntype) 
@@ -460,8 +497,8 @@ void CGLVectorPlot::Update(int ntime, float dt, bool breset)
 	int N = pfem->GetStates();
 	if (N == 0) return;
 
-	// allocate buffers if needed
-	if (m_map.States() == 0)
+	// allocate buffers if needed (states may have been appended)
+	if (m_map.States() != pfem->GetStates())
 	{
 		// nr of states
 		int NS = pfem->GetStates();
@@ -557,6 +594,8 @@ void CGLVectorPlot::Update(int ntime, float dt, bool breset)
 	// update the color bar's range
 	GLLegendBar* bar = GetLegendBar();
 	bar->SetRange(m_crng.x, m_crng.y);
+
+	m_bupdateGlyphs = true;
 }
 
 void CGLVectorPlot::UpdateState(int nstate)
@@ -26,8 +26,7 @@ SOFTWARE.*/
 
 #pragma once
 #include "GLPlot.h"
-
-class GLUquadric;
+#include <GLLib/GLGlyphMesh.h>
 
 namespace Post {
 
@@ -74,38 +73,38 @@ public:
 
 	void Render(CGLContext& rc) override;
 
-	void SetScaleFactor(float g) { m_scale = g; }
+	void SetScaleFactor(float g) { m_scale = g; m_bupdateGlyphs = true; }
 	double GetScaleFactor() { return m_scale; }
 
-	void SetDensity(float d) { m_dens = d; }
+	void SetDensity(float d) { m_dens = d; m_bupdateGlyphs = true; }
 	double GetDensity() { return m_dens; }
 
 	int GetVectorField() { return m_nvec; }
 	void SetVectorField(int ntype);
 
 	int GetGlyphType() { return m_nglyph; }
-	void SetGlyphType(int ntype) { m_nglyph = ntype; }
+	void SetGlyphType(int ntype) { m_nglyph = ntype; m_bupdateGlyphs = true; }
 
 	int GetColorType() { return m_ncol; }
-	void SetColorType(int ntype) { m_ncol = ntype; }
+	void SetColorType(int ntype) { m_ncol = ntype; m_bupdateGlyphs = true; }
 
 	GLColor GetGlyphColor() { return m_gcl; }
-	void SetGlyphColor(GLColor c) { m_gcl = c; }
+	void SetGlyphColor(GLColor c) { m_gcl = c; m_bupdateGlyphs = true; }
 
 	bool NormalizeVectors() { return m_bnorm; }
-	void NormalizeVectors(bool b) { m_bnorm = b; }
+	void NormalizeVectors(bool b) { m_bnorm = b; m_bupdateGlyphs = true; }
 
 	bool GetAutoScale() { return m_bautoscale; }
-	void SetAutoScale(bool b) { m_bautoscale = b; }
+	void SetAutoScale(bool b) { m_bautoscale = b; m_bupdateGlyphs = true; }
 
 	bool ShowHidden() const { return m_bshowHidden; }
-	void ShowHidden(bool b) { m_bshowHidden = b; }
+	void ShowHidden(bool b) { m_bshowHidden = b; m_bupdateGlyphs = true; }
 
 	CColorTexture* GetColorMap() { return &m_Col; }
 
 	void Update(int ntime, float dt, bool breset) override;
 
-	void UpdateTexture() override { m_Col.UpdateTexture(); }
+	void UpdateTexture() override { m_Col.UpdateTexture(); m_bupdateGlyphs = true; }
 
 	bool UpdateData(bool bsave = true) override;
 
@@ -114,8 +113,9 @@ public:
 	void Activate(bool b) override;
 
 private:
-	// render a vector n at position r
-	void RenderVector(const vec3f& r, vec3f v, GLUquadric* pglyph);
+	void SelectItems(vector<int>& items);
+	void UpdateGlyphGeometry();
+	void BuildGlyphs();
 
 	void UpdateState(int nstate);
 
@@ -152,5 +152,11 @@ protected:
 	vec2f			m_staticRange;
 
 	float			m_fscale;	// total scale factor for rendering
+
+	GLGlyphMesh		m_glyph;			// the glyphs of all rendered vectors
+	int				m_glyphType;		// glyph type of the glyph geometry
+	vector<int>		m_glyphItems;		// items for which the glyphs were built
+	vector<double>	m_glyphClip;		// clip planes for which the glyphs were built
+	bool			m_bupdateGlyphs;	// the glyphs need to be rebuilt
 };
 }
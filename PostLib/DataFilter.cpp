@@ -33,14 +33,48 @@ SOFTWARE.*/
 using namespace Post;
 using namespace std;
 
-bool Post::DataScale(FEPostModel& fem, int nfield, double scale)
+//-----------------------------------------------------------------------------
+// Calls f(n) for all states n. The states are processed in parallel, so f may
+// only modify data of state n. f returns false if the filter cannot be applied,
+// in which case the remaining states are skipped. The task (optional) receives 
+// progress updates and can cancel the operation. Returns false on failure or
+// when canceled.
+template <class F> static bool forEachState(FEPostModel& fem, DataFilterTask* task, F f)
+{
+	int NS = fem.GetStates();
+	int ndone = 0;
+	bool bok = true;
+#pragma omp parallel for schedule(dynamic)
+	for (int n = 0; n < NS; ++n)
+	{
+		// we can't break out of a parallel loop, so skip the remaining states instead
+		bool bskip;
+#pragma omp critical (forEachState)
+		bskip = ((bok == false) || (task && task->IsCanceled()));
+		if (bskip) continue;
+
+		bool b = f(n);
+
+#pragma omp critical (forEachState)
+		{
+			if (b == false) bok = false;
+			ndone++;
+			if (task) task->UpdateProgress(ndone, NS);
+		}
+	}
+
+	if (task && task->IsCanceled()) return false;
+	return bok;
+}
+
+bool Post::DataScale(FEPostModel& fem, int nfield, double scale, DataFilterTask* task)
 {
 	Post::FEPostMesh& mesh = *fem.GetFEMesh(0);
 	float fscale = (float) scale;
 	// loop over all states
 	int NN = mesh.Nodes();
 	int ndata = FIELD_CODE(nfield);
-	for (int i = 0; i<fem.GetStates(); ++i)
+	return forEachState(fem, task, [&](int i)
 	{
 		FEState& s = *fem.GetState(i);
 		FEMeshData& d = s.m_Data[ndata];
@@ -53,24 +87,28 @@ bool Post::DataScale(FEPostModel& fem, int nfield, double scale)
 			case DATA_SCALAR:
 			{
 				FENodeData<float>* pf = dynamic_cast< FENodeData<float>* >(&d);
+				if (pf == nullptr) return false;
 				for (int n = 0; n<NN; ++n) { float& v = (*pf)[n]; v *= fscale; }
 			}
 			break;
 			case DATA_VEC3:
 			{
 				FENodeData<vec3f>* pv = dynamic_cast< FENodeData<vec3f>* >(&d);
+				if (pv == nullptr) return false;
 				for (int n = 0; n<NN; ++n) { vec3f& v = (*pv)[n]; v *= fscale; }
 			}
 			break;
 			case DATA_MAT3S:
 			{
 				FENodeData<mat3fs>* pv = dynamic_cast< FENodeData<mat3fs>* >(&d);
+				if (pv == nullptr) return false;
 				for (int n = 0; n<NN; ++n) { mat3fs& v = (*pv)[n]; v *= fscale; }
 			}
 			break;
 			case DATA_MAT3:
 			{
 				FENodeData<mat3f>* pv = dynamic_cast< FENodeData<mat3f>* >(&d);
+				if (pv == nullptr) return false;
 				for (int n = 0; n<NN; ++n) { mat3f& v = (*pv)[n]; v *= fscale; }
 			}
 			break;
@@ -320,17 +358,13 @@ bool Post::DataScale(FEPostModel& fem, int nfield, double scale)
 				break;
 			}
 		}
-		else 
-		{
-			break; 
-		}
-	}
 
-	return true;
+		return true;
+	});
 }
 
 //-----------------------------------------------------------------------------
-bool Post::DataScaleVec3(FEPostModel& fem, int nfield, vec3d scale)
+bool Post::DataScaleVec3(FEPostModel& fem, int nfield, vec3d scale, DataFilterTask* task)
 {
 	Post::FEPostMesh& mesh = *fem.GetFEMesh(0);
 
@@ -339,7 +373,7 @@ bool Post::DataScaleVec3(FEPostModel& fem, int nfield, vec3d scale)
 	// loop over all states
 	int NN = mesh.Nodes();
 	int ndata = FIELD_CODE(nfield);
-	for (int i = 0; i < fem.GetStates(); ++i)
+	return forEachState(fem, task, [&](int i)
 	{
 		FEState& s = *fem.GetState(i);
 		FEMeshData& d = s.m_Data[ndata];
@@ -352,6 +386,7 @@ bool Post::DataScaleVec3(FEPostModel& fem, int nfield, vec3d scale)
 			case DATA_VEC3:
 			{
 				FENodeData<vec3f>* pv = dynamic_cast<FENodeData<vec3f>*>(&d);
+				if (pv == nullptr) return false;
 				for (int n = 0; n < NN; ++n) 
 				{ 
 					vec3f& v = (*pv)[n]; 
@@ -487,22 +522,18 @@ bool Post::DataScaleVec3(FEPostModel& fem, int nfield, vec3d scale)
 				break;
 			}
 		}
-		else
-		{
-			break;
-		}
-	}
 
-	return true;
+		return true;
+	});
 }
 
 //-----------------------------------------------------------------------------
 // Apply a smoothing step operation on data
-bool DataSmoothStep(FEPostModel& fem, int nfield, double theta)
+bool DataSmoothStep(FEPostModel& fem, int nfield, double theta, DataFilterTask* task)
 {
 	// loop over all states
 	int ndata = FIELD_CODE(nfield);
-	for (int n = 0; n<fem.GetStates(); ++n)
+	return forEachState(fem, task, [&](int n)
 	{
 		FEState& s = *fem.GetState(n);
 		Post::FEPostMesh& mesh = *s.GetFEMesh();
@@ -517,7 +548,9 @@ bool DataSmoothStep(FEPostModel& fem, int nfield, double theta)
 			{
 				vector<float> D; D.assign(NN, 0.f);
 				vector<int> tag; tag.assign(NN, 0);
-				Post::FENodeData<float>& data = dynamic_cast< Post::FENodeData<float>& >(d);
+				Post::FENodeData<float>* pd = dynamic_cast< Post::FENodeData<float>* >(&d);
+				if (pd == nullptr) return false;
+				Post::FENodeData<float>& data = *pd;
 
 				// evaluate the average value of the neighbors
 				int NE = mesh.Elements();
@@ -549,7 +582,9 @@ bool DataSmoothStep(FEPostModel& fem, int nfield, double theta)
 			{
 				vector<vec3f> D; D.assign(NN, vec3f(0.f, 0.f, 0.f));
 				vector<int> tag; tag.assign(NN, 0);
-				Post::FENodeData<vec3f>& data = dynamic_cast< Post::FENodeData<vec3f>& >(d);
+				Post::FENodeData<vec3f>* pd = dynamic_cast< Post::FENodeData<vec3f>* >(&d);
+				if (pd == nullptr) return false;
+				Post::FENodeData<vec3f>& data = *pd;
 
 				// evaluate the average value of the neighbors
 				int NE = mesh.Elements();
@@ -592,20 +627,19 @@ bool DataSmoothStep(FEPostModel& fem, int nfield, double theta)
 				vector<int> tag; tag.assign(NE, 0);
 				Post::FEElementData<float, DATA_ITEM>& data = dynamic_cast< Post::FEElementData<float, DATA_ITEM>& >(d);
 
-				for (int i=0; i<NE; ++i) mesh.ElementRef(i).m_ntag = i;
-
 				// evaluate the average value of the neighbors
+				// (m_nbr stores element indices, so we don't need to tag the elements)
 				for (int i=0; i<NE; ++i)
 				{
 					FEElement_& el = mesh.ElementRef(i);
 					int nf = el.Faces();
 					for (int j=0; j<nf; ++j)
 					{
-						FEElement_* pj = mesh.ElementPtr(el.m_nbr[j]);
-						if (pj && (data.active(pj->m_ntag)))
+						int nj = el.m_nbr[j];
+						if ((nj >= 0) && (nj < NE) && data.active(nj))
 						{
 							float f;
-							data.eval(pj->m_ntag, &f);
+							data.eval(nj, &f);
 							D[i] += f;
 							tag[i]++;
 						}
@@ -626,18 +660,19 @@ bool DataSmoothStep(FEPostModel& fem, int nfield, double theta)
 					}
 			}
 		}
-	}
-
-	return true;
+		return true;
+	});
 }
 
 //-----------------------------------------------------------------------------
 // Apply a smoothing operation on data
-bool Post::DataSmooth(FEPostModel& fem, int nfield, double theta, int niters)
+bool Post::DataSmooth(FEPostModel& fem, int nfield, double theta, int niters, DataFilterTask* task)
 {
+	if (task) task->SetPasses(niters);
 	for (int n = 0; n<niters; ++n) 
 	{
-		if (DataSmoothStep(fem, nfield, theta) == false) return false;
+		if (DataSmoothStep(fem, nfield, theta, task) == false) return false;
+		if (task) task->NextPass();
 	}
 
 	return true;
@@ -652,7 +687,7 @@ double flt_div(double d, double s) { return d/s; }
 double flt_err(double d, double s) { return fabs(d - s); }
 
 //-----------------------------------------------------------------------------
-bool Post::DataArithmetic(FEPostModel& fem, int nfield, int nop, int noperand)
+bool Post::DataArithmetic(FEPostModel& fem, int nfield, int nop, int noperand, DataFilterTask* task)
 {
 	int ndst = FIELD_CODE(nfield);
 	int nsrc = FIELD_CODE(noperand);
@@ -660,7 +695,7 @@ bool Post::DataArithmetic(FEPostModel& fem, int nfield, int nop, int noperand)
 	Post::FEPostMesh& mesh = *fem.GetFEMesh(0);
 
 	// loop over all states
-	for (int n = 0; n<fem.GetStates(); ++n)
+	return forEachState(fem, task, [&](int n)
 	{
 		FEState& state = *fem.GetState(n);
 		FEMeshData& d = state.m_Data[ndst];
@@ -687,6 +722,7 @@ bool Post::DataArithmetic(FEPostModel& fem, int nfield, int nop, int noperand)
 
 				FENodeData<float>*   pd = dynamic_cast<FENodeData  <float>*>(&d);
 				FENodeData_T<float>* ps = dynamic_cast<FENodeData_T<float>*>(&s);
+				if ((pd == nullptr) || (ps == nullptr)) return false;
 				int N = pd->size();
 				for (int i = 0; i<N; ++i) { float v; ps->eval(i, &v); (*pd)[i] = (float)f((*pd)[i], v); }
 			}
@@ -696,6 +732,7 @@ bool Post::DataArithmetic(FEPostModel& fem, int nfield, int nop, int noperand)
 				{
 					FENodeData<vec3f>* pd = dynamic_cast<FENodeData<vec3f>*>(&d);
 					FENodeData_T<vec3f>* ps = dynamic_cast<FENodeData_T<vec3f>*>(&s);
+					if ((pd == nullptr) || (ps == nullptr)) return false;
 					int N = pd->size();
 					switch (nop)
 					{
@@ -707,6 +744,7 @@ bool Post::DataArithmetic(FEPostModel& fem, int nfield, int nop, int noperand)
 				{
 					FENodeData<vec3f>* pd = dynamic_cast<FENodeData<vec3f>*>(&d);
 					FENodeData_T<float>* ps = dynamic_cast<FENodeData_T<float>*>(&s);
+					if ((pd == nullptr) || (ps == nullptr)) return false;
 					int N = pd->size();
 					switch (nop)
 					{
@@ -843,19 +881,18 @@ bool Post::DataArithmetic(FEPostModel& fem, int nfield, int nop, int noperand)
 		{
 			return false;
 		}
-	}
-
-	return true;
+		return true;
+	});
 }
 
 //-----------------------------------------------------------------------------
-bool Post::DataGradient(FEPostModel& fem, int vecField, int sclField, int config)
+bool Post::DataGradient(FEPostModel& fem, int vecField, int sclField, int config, DataFilterTask* task)
 {
 	int nvec = FIELD_CODE(vecField);
 	int nscl = FIELD_CODE(sclField);
 
 	// loop over all the states
-	for (int n=0; n<fem.GetStates(); ++n)
+	return forEachState(fem, task, [&](int n)
 	{
 		FEState& state = *fem.GetState(n);
 		FEMeshData& v = state.m_Data[nvec];
@@ -997,9 +1034,8 @@ bool Post::DataGradient(FEPostModel& fem, int vecField, int sclField, int config
 			if (tag[i] > 0) G[i] /= (float) tag[i];
 			(*pv)[i] = G[i];
 		}
-	}
-
-	return true;
+		return true;
+	});
 }
 
 //-----------------------------------------------------------------------------
@@ -1348,8 +1384,8 @@ bool Post::DataFractionalAnsisotropy(FEPostModel& fem, int scalarField, int tens
 }
 
 //-----------------------------------------------------------------------------
-// convert between formats
-ModelDataField* Post::DataConvert(FEPostModel& fem, ModelDataField* dataField, int newClass, int newFormat, const std::string& name)
+// create the field that stores the result of a format conversion
+ModelDataField* Post::DataConvertField(FEPostModel& fem, ModelDataField* dataField, int newClass, int newFormat)
 {
 	if (dataField == nullptr) return nullptr;
 
@@ -1358,26 +1394,63 @@ ModelDataField* Post::DataConvert(FEPostModel& fem, ModelDataField* dataField, i
 	int nfmt = dataField->Format();
 
 	if (newFormat == nfmt) return nullptr;
+	if (nclass != ELEM_DATA) return nullptr;
+
+	if (newClass == ELEM_DATA)
+	{
+		if (ntype != DATA_SCALAR) return nullptr;
+		if ((nfmt == DATA_ITEM) && (newFormat == DATA_NODE)) return new FEDataField_T<FEElementData<float, DATA_NODE> >(&fem, EXPORT_DATA);
+		if ((nfmt == DATA_NODE) && (newFormat == DATA_ITEM)) return new FEDataField_T<FEElementData<float, DATA_ITEM> >(&fem, EXPORT_DATA);
+		if ((nfmt == DATA_MULT) && (newFormat == DATA_ITEM)) return new FEDataField_T<FEElementData<float, DATA_ITEM> >(&fem, EXPORT_DATA);
+		if ((nfmt == DATA_MULT) && (newFormat == DATA_NODE)) return new FEDataField_T<FEElementData<float, DATA_NODE> >(&fem, EXPORT_DATA);
+	}
+	else if (newClass == NODE_DATA)
+	{
+		switch (ntype)
+		{
+		case DATA_SCALAR: 
+			if ((nfmt == DATA_ITEM) || (nfmt == DATA_NODE) || (nfmt == DATA_MULT)) return new FEDataField_T<FENodeData<float> >(&fem, EXPORT_DATA);
+			break;
+		case DATA_VEC3 : if (nfmt == DATA_ITEM) return new FEDataField_T<FENodeData<vec3f > >(&fem, EXPORT_DATA); break;
+		case DATA_MAT3S: if (nfmt == DATA_ITEM) return new FEDataField_T<FENodeData<mat3fs> >(&fem, EXPORT_DATA); break;
+		case DATA_MAT3 : if (nfmt == DATA_ITEM) return new FEDataField_T<FENodeData<mat3f > >(&fem, EXPORT_DATA); break;
+		default:
+			break;
+		}
+	}
+
+	return nullptr;
+}
+
+//-----------------------------------------------------------------------------
+// convert between formats
+bool Post::DataConvert(FEPostModel& fem, ModelDataField* dataField, ModelDataField* newField, DataFilterTask* task)
+{
+	if ((dataField == nullptr) || (newField == nullptr)) return false;
+
+	int nclass = dataField->DataClass();
+	DATA_TYPE ntype = dataField->Type();
+	int nfmt = dataField->Format();
+
+	int newClass = newField->DataClass();
+	int newFormat = newField->Format();
 
 	Post::FEPostMesh& mesh = *fem.GetFEMesh(0);
 
-	ModelDataField* newField = nullptr;
+	bool bok = false;
 	if (ntype == DATA_SCALAR)
 	{
 		if ((nclass == ELEM_DATA) && (newClass == ELEM_DATA))
 		{
 			if ((nfmt == DATA_ITEM) && (newFormat == DATA_NODE))
 			{
-				newField = new FEDataField_T<FEElementData<float, DATA_NODE> >(&fem, EXPORT_DATA);
-				fem.AddDataField(newField, name);
-
 				int nold = dataField->GetFieldID(); nold = FIELD_CODE(nold);
 				int nnew = newField->GetFieldID(); nnew = FIELD_CODE(nnew);
 
 				int NN = mesh.Nodes();
 				int NE = mesh.Elements();
 
-				for (int n = 0; n < fem.GetStates(); ++n)
+				bok = forEachState(fem, task, [&](int n)
 				{
 					FEState* state = fem.GetState(n);
 
@@ -1422,20 +1495,18 @@ ModelDataField* Post::DataConvert(FEPostModel& fem, ModelDataField* dataField, i
 						}
 						pnew->add(d, e, l, el.Nodes());
 					}
-				}
+					return true;
+				});
 			}
 			else if ((nfmt == DATA_NODE) && (newFormat == DATA_ITEM))
 			{
-				newField = new FEDataField_T<FEElementData<float, DATA_ITEM> >(&fem, EXPORT_DATA);
-				fem.AddDataField(newField, name);
-
 				int nold = dataField->GetFieldID(); nold = FIELD_CODE(nold);
 				int nnew = newField->GetFieldID(); nnew = FIELD_CODE(nnew);
 
 				int NN = mesh.Nodes();
 				int NE = mesh.Elements();
 
-				for (int n = 0; n < fem.GetStates(); ++n)
+				bok = forEachState(fem, task, [&](int n)
 				{
 					FEState* state = fem.GetState(n);
 
@@ -1459,20 +1530,18 @@ ModelDataField* Post::DataConvert(FEPostModel& fem, ModelDataField* dataField, i
 							pnew->add(i, avg);
 						}
 					}
-				}
+					return true;
+				});
 			}
 			else if ((nfmt == DATA_MULT) && (newFormat == DATA_ITEM))
 			{
-				newField = new FEDataField_T<FEElementData<float, DATA_ITEM> >(&fem, EXPORT_DATA);
-				fem.AddDataField(newField, name);
-
 				int nold = dataField->GetFieldID(); nold = FIELD_CODE(nold);
 				int nnew = newField->GetFieldID(); nnew = FIELD_CODE(nnew);
 
 				int NN = mesh.Nodes();
 				int NE = mesh.Elements();
 
-				for (int n = 0; n < fem.GetStates(); ++n)
+				bok = forEachState(fem, task, [&](int n)
 				{
 					FEState* state = fem.GetState(n);
 
@@ -1498,20 +1567,18 @@ ModelDataField* Post::DataConvert(FEPostModel& fem, ModelDataField* dataField, i
 							pnew->add(i, avg);
 						}
 					}
-				}
+					return true;
+				});
 			}
 			else if ((nfmt == DATA_MULT) && (newFormat == DATA_NODE))
 			{
-				newField = new FEDataField_T<FEElementData<float, DATA_NODE> >(&fem, EXPORT_DATA);
-				fem.AddDataField(newField, name);
-
 				int nold = dataField->GetFieldID(); nold = FIELD_CODE(nold);
 				int nnew = newField->GetFieldID(); nnew = FIELD_CODE(nnew);
 
 				int NN = mesh.Nodes();
 				int NE = mesh.Elements();
 
-				for (int n = 0; n < fem.GetStates(); ++n)
+				bok = forEachState(fem, task, [&](int n)
 				{
 					FEState* state = fem.GetState(n);
 
@@ -1573,7 +1640,8 @@ ModelDataField* Post::DataConvert(FEPostModel& fem, ModelDataField* dataField, i
 					// TODO: This will only work if all elements have the same nr of nodes!!
 					int ne = mesh.Element(elem[0]).Nodes();
 					pnew->add(nodeData, elem, index, ne);
-				}
+					return true;
+				});
 			}
 		}
 		else if ((nclass == ELEM_DATA) && (newClass == NODE_DATA))
@@ -1583,13 +1651,10 @@ ModelDataField* Post::DataConvert(FEPostModel& fem, ModelDataField* dataField, i
 
 			if (nfmt == DATA_ITEM)
 			{
-				newField = new FEDataField_T<FENodeData<float> >(&fem, EXPORT_DATA);
-				fem.AddDataField(newField, name);
-
 				int nold = dataField->GetFieldID(); nold = FIELD_CODE(nold);
 				int nnew = newField->GetFieldID(); nnew = FIELD_CODE(nnew);
 
-				for (int n = 0; n < fem.GetStates(); ++n)
+				bok = forEachState(fem, task, [&](int n)
 				{
 					FEState* state = fem.GetState(n);
 
@@ -1620,17 +1685,15 @@ ModelDataField* Post::DataConvert(FEPostModel& fem, ModelDataField* dataField, i
 					}
 
 					for (int i = 0; i < NN; ++i) (*pnew)[i] = data[i];
-				}
+					return true;
+				});
 			}
 			else if (nfmt == DATA_NODE)
 			{
-				newField = new FEDataField_T<FENodeData<float> >(&fem, EXPORT_DATA);
-				fem.AddDataField(newField, name);
-
 				int nold = dataField->GetFieldID(); nold = FIELD_CODE(nold);
 				int nnew = newField->GetFieldID(); nnew = FIELD_CODE(nnew);
 
-				for (int n = 0; n < fem.GetStates(); ++n)
+				bok = forEachState(fem, task, [&](int n)
 				{
 					FEState* state = fem.GetState(n);
 
@@ -1661,17 +1724,15 @@ ModelDataField* Post::DataConvert(FEPostModel& fem, ModelDataField* dataField, i
 					}
 
 					for (int i = 0; i < NN; ++i) (*pnew)[i] = data[i];
-				}
+					return true;
+				});
 			}
 			else if (nfmt == DATA_MULT)
 			{
-				newField = new FEDataField_T<FENodeData<float> >(&fem, EXPORT_DATA);
-				fem.AddDataField(newField, name);
-
 				int nold = dataField->GetFieldID(); nold = FIELD_CODE(nold);
 				int nnew = newField->GetFieldID(); nnew = FIELD_CODE(nnew);
 
-				for (int n = 0; n < fem.GetStates(); ++n)
+				bok = forEachState(fem, task, [&](int n)
 				{
 					FEState* state = fem.GetState(n);
 
@@ -1702,7 +1763,8 @@ ModelDataField* Post::DataConvert(FEPostModel& fem, ModelDataField* dataField, i
 					}
 
 					for (int i = 0; i < NN; ++i) (*pnew)[i] = data[i];
-				}
+					return true;
+				});
 			}
 		}
 	}
@@ -1715,13 +1777,10 @@ ModelDataField* Post::DataConvert(FEPostModel& fem, ModelDataField* dataField, i
 
 			if (nfmt == DATA_ITEM)
 			{
-				newField = new FEDataField_T<FENodeData<vec3f> >(&fem, EXPORT_DATA);
-				fem.AddDataField(newField, name);
-
 				int nold = dataField->GetFieldID(); nold = FIELD_CODE(nold);
 				int nnew = newField->GetFieldID(); nnew = FIELD_CODE(nnew);
 
-				for (int n = 0; n < fem.GetStates(); ++n)
+				bok = forEachState(fem, task, [&](int n)
 				{
 					FEState* state = fem.GetState(n);
 
@@ -1752,7 +1811,8 @@ ModelDataField* Post::DataConvert(FEPostModel& fem, ModelDataField* dataField, i
 					}
 
 					for (int i = 0; i < NN; ++i) (*pnew)[i] = data[i];
-				}
+					return true;
+				});
 			}
 		}
 	}
@@ -1765,13 +1825,10 @@ ModelDataField* Post::DataConvert(FEPostModel& fem, ModelDataField* dataField, i
 
 			if (nfmt == DATA_ITEM)
 			{
-				newField = new FEDataField_T<FENodeData<mat3fs> >(&fem, EXPORT_DATA);
-				fem.AddDataField(newField, name);
-
 				int nold = dataField->GetFieldID(); nold = FIELD_CODE(nold);
 				int nnew = newField->GetFieldID(); nnew = FIELD_CODE(nnew);
 
-				for (int n = 0; n < fem.GetStates(); ++n)
+				bok = forEachState(fem, task, [&](int n)
 				{
 					FEState* state = fem.GetState(n);
 
@@ -1802,7 +1859,8 @@ ModelDataField* Post::DataConvert(FEPostModel& fem, ModelDataField* dataField, i
 					}
 
 					for (int i = 0; i < NN; ++i) (*pnew)[i] = data[i];
-				}
+					return true;
+				});
 			}
 		}
 	}
@@ -1815,13 +1873,10 @@ ModelDataField* Post::DataConvert(FEPostModel& fem, ModelDataField* dataField, i
 
 			if (nfmt == DATA_ITEM)
 			{
-				newField = new FEDataField_T<FENodeData<mat3f> >(&fem, EXPORT_DATA);
-				fem.AddDataField(newField, name);
-
 				int nold = dataField->GetFieldID(); nold = FIELD_CODE(nold);
 				int nnew = newField->GetFieldID(); nnew = FIELD_CODE(nnew);
 
-				for (int n = 0; n < fem.GetStates(); ++n)
+				bok = forEachState(fem, task, [&](int n)
 				{
 					FEState* state = fem.GetState(n);
 
@@ -1852,11 +1907,13 @@ ModelDataField* Post::DataConvert(FEPostModel& fem, ModelDataField* dataField, i
 					}
 
 					for (int i = 0; i < NN; ++i) (*pnew)[i] = data[i];
-				}
+					return true;
+				});
 			}
 		}
 	}
-	return newField;
+
+	return bok;
 }
 
 ModelDataField* Post::DataEigenTensor(FEPostModel& fem, ModelDataField* dataField, const std::string& name)
@@ -1908,9 +1965,27 @@ ModelDataField* Post::DataEigenTensor(FEPostModel& fem, ModelDataField* dataFiel
 	return newField;
 }
 
-ModelDataField* Post::DataTimeRate(FEPostModel& fem, ModelDataField* dataField, const std::string& name)
+//-----------------------------------------------------------------------------
+// create the field that stores the time rate of a data field
+ModelDataField* Post::DataTimeRateField(FEPostModel& fem, ModelDataField* dataField)
 {
 	if (dataField == nullptr) return nullptr;
+	if (dataField->DataClass() != NODE_DATA) return nullptr;
+
+	switch (dataField->Type())
+	{
+	case DATA_SCALAR: return new FEDataField_T<FENodeData<float> >(&fem, EXPORT_DATA);
+	case DATA_VEC3  : return new FEDataField_T<FENodeData<vec3f> >(&fem, EXPORT_DATA);
+	default:
+		break;
+	}
+	return nullptr;
+}
+
+//-----------------------------------------------------------------------------
+bool Post::DataTimeRate(FEPostModel& fem, ModelDataField* dataField, ModelDataField* newField, DataFilterTask* task)
+{
+	if ((dataField == nullptr) || (newField == nullptr)) return false;
 
 	int nclass = dataField->DataClass();
 	DATA_TYPE ntype = dataField->Type();
@@ -1918,18 +1993,15 @@ ModelDataField* Post::DataTimeRate(FEPostModel& fem, ModelDataField* dataField,
 
 	Post::FEPostMesh& mesh = *fem.GetFEMesh(0);
 
-	ModelDataField* newField = 0;
+	bool bok = false;
 	if (nclass == NODE_DATA)
 	{
 		if (ntype == DATA_SCALAR)
 		{
-			newField = new FEDataField_T<FENodeData<float> >(&fem, EXPORT_DATA);
-			fem.AddDataField(newField, name);
-
 			int nold = dataField->GetFieldID(); nold = FIELD_CODE(nold);
 			int nnew = newField->GetFieldID(); nnew = FIELD_CODE(nnew);
 
-			for (int n = 0; n < fem.GetStates(); ++n)
+			bok = forEachState(fem, task, [&](int n)
 			{
 				Post::FENodeData<float>& vt = dynamic_cast<FENodeData<float>&>(fem.GetState(n)->m_Data[nnew]);
 				if (n == 0)
@@ -1961,17 +2033,15 @@ ModelDataField* Post::DataTimeRate(FEPostModel& fem, ModelDataField* dataField,
 						vt[i] = dvdt;
 					}
 				}
-			}
+				return true;
+			});
 		}
 		else if (ntype == DATA_VEC3)
 		{
-			newField = new FEDataField_T<FENodeData<vec3f> >(&fem, EXPORT_DATA);
-			fem.AddDataField(newField, name);
-
 			int nold = dataField->GetFieldID(); nold = FIELD_CODE(nold);
 			int nnew = newField->GetFieldID(); nnew = FIELD_CODE(nnew);
 
-			for (int n = 0; n < fem.GetStates(); ++n)
+			bok = forEachState(fem, task, [&](int n)
 			{
 				Post::FENodeData<vec3f>& vt = dynamic_cast<FENodeData<vec3f>&>(fem.GetState(n)->m_Data[nnew]);
 				if (n == 0)
@@ -2003,9 +2073,10 @@ ModelDataField* Post::DataTimeRate(FEPostModel& fem, ModelDataField* dataField,
 						vt[i] = dvdt;
 					}
 				}
-			}
+				return true;
+			});
 		}
 	}
 
-	return newField;
+	return bok;
 }
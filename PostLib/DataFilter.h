@@ -27,6 +27,7 @@ SOFTWARE.*/
 #pragma once
 #include <string>
 #include <FSCore/math3d.h>
+#include <FSCore/FSThreadedTask.h>
 
 namespace Post {
 
@@ -36,23 +37,51 @@ class ModelDataField;
 // Forward declaration of FEPostModel class
 class FEPostModel;
 
+//-----------------------------------------------------------------------------
+// Progress and cancellation for the data filters below. The filters process
+// the states in parallel and report the fraction of states that are done. 
+// Filters that make several passes over the states (e.g. smoothing) divide 
+// the progress range between the passes.
+class DataFilterTask : public FSThreadedTask
+{
+public:
+	DataFilterTask() : m_pass(0), m_passes(1) {}
+
+	// set the number of passes over the states
+	void SetPasses(int n) { m_passes = (n > 0 ? n : 1); m_pass = 0; }
+
+	// move on to the next pass
+	void NextPass() { m_pass++; }
+
+	// report that ndone out of ntotal states of the current pass are processed
+	void UpdateProgress(int ndone, int ntotal)
+	{
+		double f = (ntotal > 0 ? (double)ndone / (double)ntotal : 1.0);
+		setProgress(100.0*(m_pass + f) / m_passes);
+	}
+
+private:
+	int	m_pass;
+	int	m_passes;
+};
+
 //-----------------------------------------------------------------------------
 // Scale data by facor
-bool DataScale(FEPostModel& fem, int nfield, double scale);
-bool DataScaleVec3(FEPostModel& fem, int nfield, vec3d scale);
+bool DataScale(FEPostModel& fem, int nfield, double scale, DataFilterTask* task = nullptr);
+bool DataScaleVec3(FEPostModel& fem, int nfield, vec3d scale, DataFilterTask* task = nullptr);
 
 //-----------------------------------------------------------------------------
 // Apply a smoothing operation on data
-bool DataSmooth(FEPostModel& fem, int nfield, double theta, int niters);
+bool DataSmooth(FEPostModel& fem, int nfield, double theta, int niters, DataFilterTask* task = nullptr);
 
 //-----------------------------------------------------------------------------
 // Apply a smoothing operation on data
-bool DataArithmetic(FEPostModel& fem, int nfield, int nop, int noperand);
+bool DataArithmetic(FEPostModel& fem, int nfield, int nop, int noperand, DataFilterTask* task = nullptr);
 
 //-----------------------------------------------------------------------------
 // Calculate the gradient of a scale field
 // (set config to 0 for material, to 1 for spatial gradient)
-bool DataGradient(FEPostModel& fem, int vecField, int sclField, int config = 1);
+bool DataGradient(FEPostModel& fem, int vecField, int sclField, int config = 1, DataFilterTask* task = nullptr);
 
 //-----------------------------------------------------------------------------
 // Calculate the fractional anisotropy of a tensor field
@@ -64,11 +93,18 @@ ModelDataField* DataComponent(FEPostModel& fem, ModelDataField* dataField, int n
 
 //-----------------------------------------------------------------------------
 // convert between formats
-ModelDataField* DataConvert(FEPostModel& fem, ModelDataField* dataField, int newClass, int newFormat, const std::string& name);
+// DataConvertField creates the (empty) field for the result, or returns nullptr if the 
+// conversion is not supported. The field must be added to the model before calling DataConvert.
+ModelDataField* DataConvertField(FEPostModel& fem, ModelDataField* dataField, int newClass, int newFormat);
+bool DataConvert(FEPostModel& fem, ModelDataField* dataField, ModelDataField* newField, DataFilterTask* task = nullptr);
 
 //-----------------------------------------------------------------------------
 ModelDataField* DataEigenTensor(FEPostModel& fem, ModelDataField* dataField, const std::string& name);
 
 //-----------------------------------------------------------------------------
-ModelDataField* DataTimeRate(FEPostModel& fem, ModelDataField* dataField, const std::string& name);
+// Calculate the time rate of a nodal field
+// DataTimeRateField creates the (empty) field for the result, which must be added 
+// to the model before calling DataTimeRate.
+ModelDataField* DataTimeRateField(FEPostModel& fem, ModelDataField* dataField);
+bool DataTimeRate(FEPostModel& fem, ModelDataField* dataField, ModelDataField* newField, DataFilterTask* task = nullptr);
 }
@@ -161,7 +161,7 @@ void VectorMap::Gradient(int ntime, std::vector<float> &v)
 	// "normalize" the gradients
 	for (i=0; i<mesh.Nodes(); i++)
 	{
-		const std::vector<NodeElemRef>& nel = mesh.NodeElemList(i);
+		FSItemRange<NodeElemRef> nel = mesh.NodeElemList(i);
 		if (!nel.empty()) G[i] /= (float) nel.size();
 		G[i] *= -1;
 	}
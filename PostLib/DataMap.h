@@ -41,7 +41,7 @@ public:
 
 	int States() { return (int)m_Data.size(); }
 	std::vector<T>& State(int n) { return m_Data[n]; }
-	int GetTag(int n) { return m_tag[n]; }
+	int GetTag(int n) { assert((n >= 0) && (n < (int)m_tag.size())); return m_tag[n]; }
 	void SetTag(int n, int ntag) { m_tag[n] = ntag; }
 	void SetTags(int n)
 	{
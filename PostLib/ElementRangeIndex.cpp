@@ -0,0 +1,122 @@
+/*This file is part of the FEBio Studio source code and is licensed under the MIT license
+listed below.
+
+See Copyright-FEBio-Studio.txt for details.
+
+Copyright (c) 2021 University of Utah, The Trustees of Columbia University in
+the City of New York, and others.
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.*/
+
+
+#include "stdafx.h"
+#include "ElementRangeIndex.h"
+#include <algorithm>
+#include <cmath>
+using namespace Post;
+
+ElementRangeIndex::ElementRangeIndex()
+{
+}
+
+void ElementRangeIndex::Clear()
+{
+	m_item.clear();
+	m_min.clear();
+	m_max.clear();
+	m_blockMax.clear();
+}
+
+void ElementRangeIndex::Build(const std::vector<float>& vmin, const std::vector<float>& vmax)
+{
+	Clear();
+
+	// only add items with a valid range
+	int N = (int)vmin.size();
+	m_item.reserve(N);
+	for (int i = 0; i < N; ++i)
+	{
+		if (vmin[i] <= vmax[i]) m_item.push_back(i);
+	}
+
+	// sort by min value
+	std::sort(m_item.begin(), m_item.end(), [&](int a, int b) {
+		return (vmin[a] < vmin[b]) || ((vmin[a] == vmin[b]) && (a < b));
+	});
+
+	int M = (int)m_item.size();
+	m_min.resize(M);
+	m_max.resize(M);
+#pragma omp parallel for
+	for (int i = 0; i < M; ++i)
+	{
+		m_min[i] = vmin[m_item[i]];
+		m_max[i] = vmax[m_item[i]];
+	}
+
+	int NB = (M + BLOCK_SIZE - 1) / BLOCK_SIZE;
+	m_blockMax.resize(NB);
+#pragma omp parallel for
+	for (int i = 0; i < NB; ++i)
+	{
+		int n0 = i * BLOCK_SIZE;
+		int n1 = std::min(n0 + (int)BLOCK_SIZE, M);
+		float vm = m_max[n0];
+		for (int j = n0 + 1; j < n1; ++j) vm = std::max(vm, m_max[j]);
+		m_blockMax[i] = vm;
+	}
+}
+
+void ElementRangeIndex::Find(double v, std::vector<int>& items) const
+{
+	items.clear();
+
+	// all items beyond this point have vmin > v
+	int M = (int)(std::upper_bound(m_min.begin(), m_min.end(), v, [](double a, float b) { return a < b; }) - m_min.begin());
+
+	int NB = (M + BLOCK_SIZE - 1) / BLOCK_SIZE;
+	for (int i = 0; i < NB; ++i)
+	{
+		if (m_blockMax[i] >= v)
+		{
+			int n0 = i * BLOCK_SIZE;
+			int n1 = std::min(n0 + (int)BLOCK_SIZE, M);
+			for (int j = n0; j < n1; ++j)
+			{
+				if (m_max[j] >= v) items.push_back(m_item[j]);
+			}
+		}
+	}
+
+	std::sort(items.begin(), items.end());
+}
+
+float ElementRangeIndex::RoundDown(double v)
+{
+	float f = (float)v;
+	if ((double)f > v) f = std::nextafter(f, -HUGE_VALF);
+	return f;
+}
+
+float ElementRangeIndex::RoundUp(double v)
+{
+	float f = (float)v;
+	if ((double)f < v) f = std::nextafter(f, HUGE_VALF);
+	return f;
+}
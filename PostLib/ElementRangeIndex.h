@@ -0,0 +1,67 @@
+/*This file is part of the FEBio Studio source code and is licensed under the MIT license
+listed below.
+
+See Copyright-FEBio-Studio.txt for details.
+
+Copyright (c) 2021 University of Utah, The Trustees of Columbia University in
+the City of New York, and others.
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.*/
+
+
+#pragma once
+#include <vector>
+
+namespace Post {
+
+//-----------------------------------------------------------------------------
+// This class stores a value range [vmin, vmax] for each item (e.g. the range of the
+// nodal values of an element) and is used to quickly find the items whose range 
+// contains a given value. The items are sorted by their minimum value and grouped
+// in blocks, for which the maximum value is stored. A query then only needs to 
+// visit the blocks that can contain items with the value. 
+class ElementRangeIndex
+{
+	enum { BLOCK_SIZE = 64 };
+
+public:
+	ElementRangeIndex();
+
+	// Build the index. Items for which vmin > vmax are never returned.
+	void Build(const std::vector<float>& vmin, const std::vector<float>& vmax);
+
+	void Clear();
+
+	bool IsEmpty() const { return m_item.empty(); }
+
+	// Find all items for which vmin <= v <= vmax. The items are returned in ascending order.
+	void Find(double v, std::vector<int>& items) const;
+
+public:
+	// rounds a double range to a float range that contains it
+	static float RoundDown(double v);
+	static float RoundUp(double v);
+
+private:
+	std::vector<int>	m_item;		// item indices, sorted by min value
+	std::vector<float>	m_min;		// min value (in sorted order)
+	std::vector<float>	m_max;		// max value (in sorted order)
+	std::vector<float>	m_blockMax;	// max value of each block
+};
+}
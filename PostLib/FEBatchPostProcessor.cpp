@@ -0,0 +1,348 @@
+/*This file is part of the FEBio Studio source code and is licensed under the MIT license
+listed below.
+
+See Copyright-FEBio-Studio.txt for details.
+
+Copyright (c) 2023 University of Utah, The Trustees of Columbia University in
+the City of New York, and others.
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.*/
+#include "stdafx.h"
+#include "FEBatchPostProcessor.h"
+#include "FEPostModel.h"
+#include "FEDataManager.h"
+#include "FEVTKExport.h"
+#include "DataFilter.h"
+#include "constants.h"
+#include <XPLTLib/xpltFileReader.h>
+#include <stdlib.h>
+#include <ctype.h>
+using namespace Post;
+using namespace std;
+
+FEBatchPostProcessor::FEBatchPostProcessor()
+{
+	m_blastOnly = false;
+	m_bcsv = false;
+	m_bvtk = false;
+}
+
+void FEBatchPostProcessor::PrintUsage()
+{
+	printf("usage: FEBioStudio -batch [options] file1.xplt [file2.xplt ...]\n");
+	printf("options:\n");
+	printf("  -states <list>   states to process, e.g. 1,5,10-20 or last (default: all)\n");
+	printf("  -field <name>    data field to evaluate. This can also be the name of a component,\n");
+	printf("                   e.g. \"X - displacement\". This option can be repeated.\n");
+	printf("  -scale <name> <factor> [-name <new name>]\n");
+	printf("                   scale a data field (the result is stored in <name>_flt by default)\n");
+	printf("  -smooth <name> <theta> <iterations> [-name <new name>]\n");
+	printf("                   smooth a data field (the result is stored in <name>_flt by default)\n");
+	printf("  -csv             write the evaluated fields to CSV files\n");
+	printf("  -vtk             write the selected states to VTK files\n");
+	printf("  -o <folder>      output folder (default: folder of the plot file)\n");
+}
+
+// parse a list of states, e.g. 1,5,10-20 (one-based)
+static bool parse_state_list(const char* sz, vector<int>& states)
+{
+	states.clear();
+	while (sz && *sz)
+	{
+		char* szend = nullptr;
+		int n0 = (int)strtol(sz, &szend, 10);
+		if (szend == sz) return false;
+		int n1 = n0;
+		sz = szend;
+		if (*sz == '-')
+		{
+			++sz;
+			n1 = (int)strtol(sz, &szend, 10);
+			if (szend == sz) return false;
+			sz = szend;
+		}
+		if ((n0 < 1) || (n1 < n0)) return false;
+		for (int i = n0; i <= n1; ++i) states.push_back(i - 1);
+
+		if (*sz == ',') ++sz;
+		else if (*sz != 0) return false;
+	}
+	return (states.empty() == false);
+}
+
+bool FEBatchPostProcessor::ParseCommandLine(int argc, char* argv[])
+{
+	for (int i = 0; i < argc; ++i)
+	{
+		const char* sz = argv[i];
+		if (strcmp(sz, "-states") == 0)
+		{
+			if (i + 1 >= argc) return errf("Missing value for -states");
+			const char* szl = argv[++i];
+			if (strcmp(szl, "last") == 0) m_blastOnly = true;
+			else if (parse_state_list(szl, m_states) == false) return errf("Invalid state list: %s", szl);
+		}
+		else if (strcmp(sz, "-field") == 0)
+		{
+			if (i + 1 >= argc) return errf("Missing value for -field");
+			AddField(argv[++i]);
+		}
+		else if ((strcmp(sz, "-scale") == 0) || (strcmp(sz, "-smooth") == 0))
+		{
+			Filter flt;
+			flt.ntype = (strcmp(sz, "-scale") == 0 ? FILTER_SCALE : FILTER_SMOOTH);
+			int nparams = (flt.ntype == FILTER_SCALE ? 1 : 2);
+			if (i + 1 + nparams >= argc) return errf("Missing values for %s", sz);
+			flt.field = argv[++i];
+			for (int j = 0; j < nparams; ++j) flt.param[j] = atof(argv[++i]);
+			// the name of the new field must be given explicitly, since any other
+			// argument that follows could be a plot file
+			flt.newName = flt.field + "_flt";
+			if ((i + 1 < argc) && (strcmp(argv[i + 1], "-name") == 0))
+			{
+				if (i + 2 >= argc) return errf("Missing value for -name");
+				flt.newName = argv[i + 2];
+				i += 2;
+			}
+			AddFilter(flt);
+		}
+		else if (strcmp(sz, "-csv") == 0) m_bcsv = true;
+		else if (strcmp(sz, "-vtk") == 0) m_bvtk = true;
+		else if (strcmp(sz, "-o") == 0)
+		{
+			if (i + 1 >= argc) return errf("Missing value for -o");
+			m_outDir = argv[++i];
+		}
+		else if (sz[0] == '-') return errf("Unknown option: %s", sz);
+		else AddFile(sz);
+	}
+
+	if (m_files.empty()) return errf("No plot files specified.");
+	if (m_bcsv && m_fields.empty()) return errf("No fields specified for CSV output.");
+	if ((m_bcsv == false) && (m_bvtk == false)) return errf("No output requested.");
+
+	return true;
+}
+
+bool FEBatchPostProcessor::Run()
+{
+	int nfailed = 0;
+	for (size_t i = 0; i < m_files.size(); ++i)
+	{
+		const string& fileName = m_files[i];
+		printf("Processing %s ...\n", fileName.c_str());
+		if (ProcessFile(fileName) == false)
+		{
+			fprintf(stderr, "ERROR: %s\n", GetErrorString().c_str());
+			ClearErrors();
+			nfailed++;
+		}
+	}
+
+	printf("%d of %d files processed successfully.\n", (int)m_files.size() - nfailed, (int)m_files.size());
+	return (nfailed == 0);
+}
+
+bool FEBatchPostProcessor::ProcessFile(const std::string& fileName)
+{
+	FEPostModel fem;
+	xpltFileReader reader(&fem);
+	if (m_blastOnly) reader.SetReadStateFlag(XPLT_READ_LAST_STATE_ONLY);
+	else if (m_states.empty() == false)
+	{
+		reader.SetReadStateFlag(XPLT_READ_STATES_FROM_LIST);
+		reader.SetReadStatesList(m_states);
+	}
+
+	if (reader.Load(fileName.c_str()) == false)
+	{
+		return errf("Failed reading file %s:\n%s", fileName.c_str(), reader.GetErrorString().c_str());
+	}
+	if (fem.GetStates() == 0) return errf("No states were read from %s", fileName.c_str());
+
+	// apply data filters
+	for (const Filter& flt : m_filters)
+	{
+		if (ApplyFilter(fem, flt) == false) return false;
+	}
+
+	// write the fields
+	if (m_bcsv)
+	{
+		for (const string& field : m_fields)
+		{
+			int nfield = FindField(fem, field);
+			if (nfield < 0) return errf("Data field \"%s\" not found in %s", field.c_str(), fileName.c_str());
+
+			// build a file name that can be used on all platforms
+			string postFix = "_" + field;
+			for (char& c : postFix) if (!isalnum((unsigned char)c) && (c != '_') && (c != '-')) c = '_';
+			string csvFile = OutputFileName(fileName, postFix + ".csv");
+			if (ExportCSV(fem, nfield, csvFile) == false) return false;
+			printf("  %s\n", csvFile.c_str());
+		}
+	}
+
+	if (m_bvtk)
+	{
+		string vtkFile = OutputFileName(fileName, ".vtk");
+		if (ExportVTK(fem, vtkFile) == false) return false;
+		printf("  %s\n", vtkFile.c_str());
+	}
+
+	return true;
+}
+
+bool FEBatchPostProcessor::ApplyFilter(FEPostModel& fem, const Filter& flt)
+{
+	FEDataManager& dm = *fem.GetDataManager();
+	int n = dm.FindDataField(flt.field);
+	if (n < 0) return errf("Data field \"%s\" not found", flt.field.c_str());
+
+	ModelDataField* pdf = *dm.DataField(n);
+	ModelDataField* newData = fem.CreateCachedCopy(pdf, flt.newName.c_str());
+	if (newData == nullptr) return errf("Failed to copy data field \"%s\"", flt.field.c_str());
+
+	bool bret = false;
+	switch (flt.ntype)
+	{
+	case FILTER_SCALE : bret = DataScale(fem, newData->GetFieldID(), flt.param[0]); break;
+	case FILTER_SMOOTH: bret = DataSmooth(fem, newData->GetFieldID(), flt.param[0], (int)flt.param[1]); break;
+	}
+	if (bret == false) return errf("Failed to apply filter to data field \"%s\"", flt.field.c_str());
+
+	return true;
+}
+
+int FEBatchPostProcessor::FindField(FEPostModel& fem, const std::string& name)
+{
+	FEDataManager& dm = *fem.GetDataManager();
+
+	// first, see if this is the name of a data field
+	int n = dm.FindDataField(name);
+	if (n >= 0) return (*dm.DataField(n))->GetFieldID();
+
+	// see if it is the name of a component
+	for (int i = 0; i < dm.DataFields(); ++i)
+	{
+		ModelDataField* pd = *dm.DataField(i);
+		int nc = pd->components(TENSOR_SCALAR);
+		for (int j = 0; j < nc; ++j)
+		{
+			if (pd->componentName(j, TENSOR_SCALAR) == name) return pd->GetFieldID() + j;
+		}
+	}
+
+	return -1;
+}
+
+std::string FEBatchPostProcessor::OutputFileName(const std::string& fileName, const std::string& postFix)
+{
+	// strip the extension
+	string base = fileName;
+	size_t ext = base.rfind('.');
+	size_t sep = base.find_last_of("/\\");
+	if ((ext != string::npos) && ((sep == string::npos) || (ext > sep))) base.erase(ext);
+
+	// replace the folder
+	if (m_outDir.empty() == false)
+	{
+		if (sep != string::npos) base = base.substr(sep + 1);
+		char c = m_outDir.back();
+		base = m_outDir + ((c == '/') || (c == '\\') ? "" : "/") + base;
+	}
+
+	return base + postFix;
+}
+
+// Writes the values of a field in CSV format. Each row contains the values of an item 
+// (node, face, or element) for all states. 
+bool FEBatchPostProcessor::ExportCSV(FEPostModel& fem, int nfield, const std::string& fileName)
+{
+	FEPostMesh& mesh = *fem.GetFEMesh(0);
+	int NS = fem.GetStates();
+
+	int items = 0;
+	if      (IS_NODE_FIELD(nfield)) items = mesh.Nodes();
+	else if (IS_FACE_FIELD(nfield)) items = mesh.Faces();
+	else if (IS_ELEM_FIELD(nfield)) items = mesh.Elements();
+	else return errf("Unsupported field type.");
+
+	// Evaluate the field for all states. The states can be evaluated 
+	// independently, so we do this in parallel.
+	vector< vector<float> > val(NS, vector<float>(items, 0.f));
+#pragma omp parallel for schedule(dynamic)
+	for (int n = 0; n < NS; ++n)
+	{
+		vector<float>& v = val[n];
+		float data[FSElement::MAX_NODES] = { 0.f };
+		if (IS_NODE_FIELD(nfield))
+		{
+			NODEDATA nd;
+			for (int i = 0; i < items; ++i)
+			{
+				fem.EvaluateNode(i, n, nfield, nd);
+				v[i] = nd.m_val;
+			}
+		}
+		else if (IS_FACE_FIELD(nfield))
+		{
+			for (int i = 0; i < items; ++i)
+			{
+				float f = 0.f;
+				if (fem.EvaluateFace(i, n, nfield, data, f)) v[i] = f;
+			}
+		}
+		else
+		{
+			for (int i = 0; i < items; ++i)
+			{
+				float f = 0.f;
+				if (fem.EvaluateElement(i, n, nfield, data, f)) v[i] = f;
+			}
+		}
+	}
+
+	FILE* fp = fopen(fileName.c_str(), "wt");
+	if (fp == nullptr) return errf("Failed to create file %s", fileName.c_str());
+
+	// the header contains the state times
+	fprintf(fp, "id");
+	for (int n = 0; n < NS; ++n) fprintf(fp, ",%g", fem.GetState(n)->m_time);
+	fprintf(fp, "\n");
+
+	for (int i = 0; i < items; ++i)
+	{
+		fprintf(fp, "%d", i + 1);
+		for (int n = 0; n < NS; ++n) fprintf(fp, ",%g", val[n][i]);
+		fprintf(fp, "\n");
+	}
+	fclose(fp);
+
+	return true;
+}
+
+bool FEBatchPostProcessor::ExportVTK(FEPostModel& fem, const std::string& fileName)
+{
+	FEVTKExport vtk;
+	vtk.ExportAllStates(true);
+	vtk.WriteSeriesFile(true);
+	if (vtk.Save(fem, fileName.c_str()) == false) return errf("Failed writing VTK file %s", fileName.c_str());
+	return true;
+}
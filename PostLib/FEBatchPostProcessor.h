@@ -0,0 +1,103 @@
+/*This file is part of the FEBio Studio source code and is licensed under the MIT license
+listed below.
+
+See Copyright-FEBio-Studio.txt for details.
+
+Copyright (c) 2023 University of Utah, The Trustees of Columbia University in
+the City of New York, and others.
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.*/
+#pragma once
+#include <FSCore/FSThreadedTask.h>
+#include <vector>
+#include <string>
+
+namespace Post {
+
+class FEPostModel;
+
+//-----------------------------------------------------------------------------
+// This class runs post-processing jobs without the GUI. Each plot file is loaded,
+// the data filters are applied, and the requested fields are evaluated over the 
+// selected states and written to CSV and/or VTK files. The fields are evaluated
+// for all selected states in parallel. 
+class FEBatchPostProcessor : public FSThreadedTask
+{
+public:
+	enum FilterType { FILTER_SCALE, FILTER_SMOOTH };
+
+	struct Filter
+	{
+		int			ntype;		// filter type
+		std::string	field;		// name of the data field to filter
+		std::string	newName;	// name of the filtered data field
+		double		param[2];	// filter parameters (scale: factor; smooth: theta, iterations)
+	};
+
+public:
+	FEBatchPostProcessor();
+
+	// process the command line options (i.e. everything after the -batch flag)
+	bool ParseCommandLine(int argc, char* argv[]);
+
+	// print the command line options
+	static void PrintUsage();
+
+	// process all files
+	bool Run();
+
+public:
+	void AddFile(const std::string& fileName) { m_files.push_back(fileName); }
+	void AddField(const std::string& fieldName) { m_fields.push_back(fieldName); }
+	void AddFilter(const Filter& flt) { m_filters.push_back(flt); }
+
+	// set the list of states to process (zero-based, empty for all states)
+	void SetStates(const std::vector<int>& states) { m_states = states; }
+
+	// only process the last state
+	void LastStateOnly(bool b) { m_blastOnly = b; }
+
+	void SetOutputFolder(const std::string& folder) { m_outDir = folder; }
+
+	void WriteCSV(bool b) { m_bcsv = b; }
+	void WriteVTK(bool b) { m_bvtk = b; }
+
+private:
+	bool ProcessFile(const std::string& fileName);
+	bool ApplyFilter(FEPostModel& fem, const Filter& flt);
+	bool ExportCSV(FEPostModel& fem, int nfield, const std::string& fileName);
+	bool ExportVTK(FEPostModel& fem, const std::string& fileName);
+
+	// find the field code of a data field or one of its components
+	int FindField(FEPostModel& fem, const std::string& name);
+
+	// get the output file name, given the input file name and a postfix
+	std::string OutputFileName(const std::string& fileName, const std::string& postFix);
+
+private:
+	std::vector<std::string>	m_files;	// plot files to process
+	std::vector<std::string>	m_fields;	// fields to evaluate
+	std::vector<Filter>			m_filters;	// data filters to apply
+	std::vector<int>			m_states;	// states to process (all if empty)
+	std::string					m_outDir;	// output folder (same folder as plot file if empty)
+	bool	m_blastOnly;	// only process the last state
+	bool	m_bcsv;		// write CSV files
+	bool	m_bvtk;		// write VTK files
+};
+}
@@ -0,0 +1,284 @@
+/*This file is part of the FEBio Studio source code and is licensed under the MIT license
+listed below.
+
+See Copyright-FEBio-Studio.txt for details.
+
+Copyright (c) 2021 University of Utah, The Trustees of Columbia University in
+the City of New York, and others.
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.*/
+
+#include "stdafx.h"
+#include "FEDataCache.h"
+#include "FEPostModel.h"
+#include "FEMeshData_T.h"
+#include "constants.h"
+using namespace Post;
+
+#ifdef WIN32
+#define fseek64 _fseeki64
+#define ftell64 _ftelli64
+#else
+#define fseek64 fseeko
+#define ftell64 ftello
+#endif
+
+// file identifier ("FSDC") and version
+static const uint32_t CACHE_MAGIC   = 0x43445346;
+static const uint32_t CACHE_VERSION = 1;
+
+//-----------------------------------------------------------------------------
+template <typename T> static bool cache_write(FILE* fp, const T& v) { return (fwrite(&v, sizeof(T), 1, fp) == 1); }
+template <typename T> static bool cache_read (FILE* fp, T& v) { return (fread(&v, sizeof(T), 1, fp) == 1); }
+
+static bool cache_write(FILE* fp, const std::string& s)
+{
+	int32_t n = (int32_t)s.size();
+	return cache_write(fp, n) && ((n == 0) || (fwrite(s.data(), 1, n, fp) == (size_t)n));
+}
+
+static bool cache_read(FILE* fp, std::string& s)
+{
+	int32_t n = 0;
+	if ((cache_read(fp, n) == false) || (n < 0)) return false;
+	s.resize(n);
+	return (n == 0) || (fread(&s[0], 1, n, fp) == (size_t)n);
+}
+
+//-----------------------------------------------------------------------------
+FEDataCache::FEDataCache(FEPostModel* fem) : m_fem(fem)
+{
+	m_fp = nullptr;
+}
+
+FEDataCache::~FEDataCache()
+{
+	Close();
+}
+
+//-----------------------------------------------------------------------------
+std::string FEDataCache::CacheFileName(const std::string& plotFile)
+{
+	return plotFile + ".fsdc";
+}
+
+//-----------------------------------------------------------------------------
+// FNV-1a hash of the field name and filter definition
+uint64_t FEDataCache::FieldKey(const std::string& name, const std::string& filter)
+{
+	uint64_t h = 14695981039346656037ULL;
+	std::string s = name + '\n' + filter;
+	for (size_t i = 0; i < s.size(); ++i)
+	{
+		h ^= (unsigned char)s[i];
+		h *= 1099511628211ULL;
+	}
+	return h;
+}
+
+//-----------------------------------------------------------------------------
+bool FEDataCache::Write(const std::string& cacheFile, int64_t srcSize, int64_t srcTime)
+{
+	Close();
+
+	FEPostMesh* mesh = m_fem->GetFEMesh(0);
+	if (mesh == nullptr) return false;
+
+	// collect the derived fields
+	std::vector<ModelDataField*> fields;
+	FEDataManager& dm = *m_fem->GetDataManager();
+	for (int i = 0; i < dm.DataFields(); ++i)
+	{
+		ModelDataField* pdf = *dm.DataField(i);
+		if (pdf && pdf->IsDerived()) fields.push_back(pdf);
+	}
+
+	// don't leave a stale cache around if there is nothing to store
+	if (fields.empty())
+	{
+		remove(cacheFile.c_str());
+		return true;
+	}
+
+	FILE* fp = fopen(cacheFile.c_str(), "wb");
+	if (fp == nullptr) return false;
+
+	// write the header
+	int32_t nfields = 0;
+	bool bok = cache_write(fp, CACHE_MAGIC) && cache_write(fp, CACHE_VERSION) &&
+		cache_write(fp, srcSize) && cache_write(fp, srcTime) &&
+		cache_write(fp, (int32_t)mesh->Nodes()) && cache_write(fp, (int32_t)mesh->Elements()) &&
+		cache_write(fp, (int32_t)mesh->Faces()) && cache_write(fp, (int32_t)m_fem->GetStates());
+	int64_t countPos = ftell64(fp);
+	bok = bok && cache_write(fp, nfields);
+
+	// write the fields
+	for (size_t i = 0; bok && (i < fields.size()); ++i)
+	{
+		int64_t pos = ftell64(fp);
+		if (WriteField(fp, fields[i])) nfields++;
+		else
+		{
+			// this field's data can't be cached, so overwrite it with the next one
+			bok = (fseek64(fp, pos, SEEK_SET) == 0);
+		}
+	}
+
+	// update the field count
+	bok = bok && (fseek64(fp, countPos, SEEK_SET) == 0) && cache_write(fp, nfields);
+	fclose(fp);
+
+	if ((bok == false) || (nfields == 0))
+	{
+		remove(cacheFile.c_str());
+		return bok;
+	}
+
+	return true;
+}
+
+//-----------------------------------------------------------------------------
+bool FEDataCache::WriteField(FILE* fp, ModelDataField* pdf)
+{
+	int ndata = FIELD_CODE(pdf->GetFieldID());
+
+	if (cache_write(fp, FieldKey(pdf->GetName(), pdf->GetFilterDefinition())) == false) return false;
+	if (cache_write(fp, pdf->GetName()) == false) return false;
+	if (cache_write(fp, pdf->GetFilterDefinition()) == false) return false;
+	if (cache_write(fp, (int32_t)pdf->DataClass()) == false) return false;
+	if (cache_write(fp, (int32_t)pdf->Type()) == false) return false;
+	if (cache_write(fp, (int32_t)pdf->Format()) == false) return false;
+	if (cache_write(fp, (uint32_t)pdf->Flags()) == false) return false;
+
+	// the size of the state data, so that readers can skip over it
+	int64_t sizePos = ftell64(fp), size = 0;
+	if (cache_write(fp, size) == false) return false;
+
+	FEDataCacheStream ar(fp, true);
+	for (int n = 0; n < m_fem->GetStates(); ++n)
+	{
+		FEState& state = *m_fem->GetState(n);
+		if (ndata >= state.m_Data.size()) return false;
+		if (state.m_Data[ndata].SerializeCache(ar) == false) return false;
+	}
+
+	int64_t endPos = ftell64(fp);
+	size = endPos - sizePos - (int64_t)sizeof(size);
+	return (fseek64(fp, sizePos, SEEK_SET) == 0) && cache_write(fp, size) && (fseek64(fp, endPos, SEEK_SET) == 0);
+}
+
+//-----------------------------------------------------------------------------
+bool FEDataCache::Open(const std::string& cacheFile, int64_t srcSize, int64_t srcTime)
+{
+	Close();
+
+	FEPostMesh* mesh = m_fem->GetFEMesh(0);
+	if (mesh == nullptr) return false;
+
+	m_fp = fopen(cacheFile.c_str(), "rb");
+	if (m_fp == nullptr) return false;
+
+	// read and validate the header
+	uint32_t magic = 0, version = 0;
+	int64_t size = 0, time = 0;
+	int32_t nodes = 0, elems = 0, faces = 0, states = 0, nfields = 0;
+	bool bok = cache_read(m_fp, magic) && cache_read(m_fp, version) &&
+		cache_read(m_fp, size) && cache_read(m_fp, time) &&
+		cache_read(m_fp, nodes) && cache_read(m_fp, elems) && cache_read(m_fp, faces) && 
+		cache_read(m_fp, states) && cache_read(m_fp, nfields);
+
+	if ((bok == false) || (magic != CACHE_MAGIC) || (version != CACHE_VERSION) ||
+		(size != srcSize) || (time != srcTime) ||
+		(nodes != mesh->Nodes()) || (elems != mesh->Elements()) || (faces != mesh->Faces()) ||
+		(states != m_fem->GetStates()))
+	{
+		Close();
+		return false;
+	}
+
+	// build the index of the fields in this file
+	for (int i = 0; i < nfields; ++i)
+	{
+		Entry e;
+		std::string filter;
+		int32_t nclass, ntype, nfmt;
+		int64_t size;
+		if ((cache_read(m_fp, e.key) && cache_read(m_fp, e.name) && cache_read(m_fp, filter) &&
+			cache_read(m_fp, nclass) && cache_read(m_fp, ntype) && cache_read(m_fp, nfmt) && 
+			cache_read(m_fp, e.flags) && cache_read(m_fp, size)) == false) { Close(); return false; }
+		e.nclass = nclass;
+		e.ntype = ntype;
+		e.nfmt = nfmt;
+		e.offset = ftell64(m_fp);
+		m_entry.push_back(e);
+
+		// skip the state data
+		if (fseek64(m_fp, e.offset + size, SEEK_SET) != 0) { Close(); return false; }
+	}
+
+	return true;
+}
+
+//-----------------------------------------------------------------------------
+ModelDataField* FEDataCache::ReadField(const std::string& name, const std::string& filter)
+{
+	if (m_fp == nullptr) return nullptr;
+
+	uint64_t key = FieldKey(name, filter);
+	for (size_t i = 0; i < m_entry.size(); ++i)
+	{
+		Entry& e = m_entry[i];
+		if ((e.key != key) || (e.name != name)) continue;
+
+		// create the field
+		ModelDataField* pdf = createCachedDataField(m_fem, (DATA_CLASS)e.nclass, (DATA_TYPE)e.ntype, (DATA_FORMAT)e.nfmt, e.flags);
+		if (pdf == nullptr) return nullptr;
+		pdf->SetFilterDefinition(filter);
+		m_fem->AddDataField(pdf, name);
+
+		// read the data
+		bool bok = (fseek64(m_fp, e.offset, SEEK_SET) == 0);
+		int ndata = FIELD_CODE(pdf->GetFieldID());
+		FEDataCacheStream ar(m_fp, false);
+		for (int n = 0; bok && (n < m_fem->GetStates()); ++n)
+		{
+			FEState& state = *m_fem->GetState(n);
+			bok = state.m_Data[ndata].SerializeCache(ar);
+		}
+
+		if (bok == false)
+		{
+			m_fem->DeleteDataField(pdf);
+			delete pdf;
+			return nullptr;
+		}
+
+		return pdf;
+	}
+
+	return nullptr;
+}
+
+//-----------------------------------------------------------------------------
+void FEDataCache::Close()
+{
+	if (m_fp) fclose(m_fp);
+	m_fp = nullptr;
+	m_entry.clear();
+}
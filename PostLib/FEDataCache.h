@@ -0,0 +1,116 @@
+/*This file is part of the FEBio Studio source code and is licensed under the MIT license
+listed below.
+
+See Copyright-FEBio-Studio.txt for details.
+
+Copyright (c) 2021 University of Utah, The Trustees of Columbia University in
+the City of New York, and others.
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.*/
+
+#pragma once
+#include <stdio.h>
+#include <stdint.h>
+#include <string>
+#include <vector>
+
+namespace Post {
+
+class FEPostModel;
+class ModelDataField;
+
+//-----------------------------------------------------------------------------
+// Reads or writes the arrays of mesh data to a binary file.
+class FEDataCacheStream
+{
+public:
+	FEDataCacheStream(FILE* fp, bool bsave) : m_fp(fp), m_bsave(bsave) {}
+
+	bool IsSaving() const { return m_bsave; }
+
+	template <typename T> bool serialize(std::vector<T>& v)
+	{
+		int64_t n = (int64_t)v.size();
+		if (m_bsave)
+		{
+			if (fwrite(&n, sizeof(n), 1, m_fp) != 1) return false;
+			return (n == 0) || (fwrite(v.data(), sizeof(T), (size_t)n, m_fp) == (size_t)n);
+		}
+		else
+		{
+			if ((fread(&n, sizeof(n), 1, m_fp) != 1) || (n < 0)) return false;
+			v.resize((size_t)n);
+			return (n == 0) || (fread(v.data(), sizeof(T), (size_t)n, m_fp) == (size_t)n);
+		}
+	}
+
+private:
+	FILE*	m_fp;
+	bool	m_bsave;
+};
+
+//-----------------------------------------------------------------------------
+// The derived data cache stores the data of derived fields (i.e. fields that
+// were created with a data filter) in a sidecar file next to the plot file.
+// Each field is identified by a key that is calculated from its name and its
+// filter definition. The cache is only valid if the size and modification time
+// of the plot file did not change since the cache was written.
+class FEDataCache
+{
+	struct Entry
+	{
+		uint64_t	key;
+		std::string	name;
+		int			nclass, ntype, nfmt;
+		unsigned int	flags;
+		int64_t		offset;	// file offset of state data
+	};
+
+public:
+	FEDataCache(FEPostModel* fem);
+	~FEDataCache();
+
+	// the name of the cache file for a plot file
+	static std::string CacheFileName(const std::string& plotFile);
+
+	// calculate the key of a field
+	static uint64_t FieldKey(const std::string& name, const std::string& filter);
+
+	// write the data of all derived fields of the model
+	bool Write(const std::string& cacheFile, int64_t srcSize, int64_t srcTime);
+
+	// open the cache file for reading. Returns false if the cache does not exist or is stale.
+	bool Open(const std::string& cacheFile, int64_t srcSize, int64_t srcTime);
+
+	// Create a field and read its data from the cache. Returns nullptr if the 
+	// field is not in the cache.
+	ModelDataField* ReadField(const std::string& name, const std::string& filter);
+
+	void Close();
+
+private:
+	bool WriteField(FILE* fp, ModelDataField* pdf);
+
+private:
+	FEPostModel*		m_fem;
+	FILE*				m_fp;
+	std::vector<Entry>	m_entry;
+};
+
+} // namespace Post
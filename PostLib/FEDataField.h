@@ -98,6 +98,12 @@ public:
 
 	FEPostModel* GetModel() { return m_fem; }
 
+	// Fields that were created by a data filter store a description of the 
+	// filter. These fields can be stored in the derived data cache.
+	void SetFilterDefinition(const std::string& s) { m_filter = s; }
+	const std::string& GetFilterDefinition() const { return m_filter; }
+	bool IsDerived() const { return (m_filter.empty() == false); }
+
 public:
 	void SetUnits(const char* sz);
 	const char* GetUnits() const;
@@ -112,6 +118,7 @@ protected:
 
 	int				m_arraySize;	//!< data size for arrays
 	std::vector<string>	m_arrayNames;	//!< (optional) names of array components
+	std::string		m_filter;		//!< filter definition (derived fields only)
 
 	FEPostModel*	m_fem;
 };
@@ -28,6 +28,8 @@ SOFTWARE.*/
 #include "FEKinemat.h"
 #include <PostLib/FEMeshData_T.h>
 #include <PostLib/FEPostModel.h>
+#include <PostLib/constants.h>
+#include <memory>
 using namespace Post;
 using namespace std;
 
@@ -129,13 +131,70 @@ bool FEKinemat::ReadKine(const char* szfile)
 	return true;
 }
 
+//-----------------------------------------------------------------------------
+// Kinematics data shared by all states. 
+struct FEKinematData
+{
+	std::vector<vec3d>				r0;		// initial nodal coordinates
+	std::vector<int>				part;	// part (i.e. material) each node belongs to (or -1)
+	std::vector<FEKinemat::STATE>	frame;	// rigid transforms of each model state
+};
+
+//-----------------------------------------------------------------------------
+// Displacement data of a kinematics state. Instead of storing the displacement
+// of each node, it is evaluated from the rigid body transform of the node's part.
+class FEKinematDisplacement : public Post::FENodeData_T<vec3f>
+{
+public:
+	FEKinematDisplacement(FEState* state, ModelDataField* pdf, std::shared_ptr<FEKinematData> data) : Post::FENodeData_T<vec3f>(state, pdf), m_data(data) {}
+
+	void eval(int n, vec3f* pv) override
+	{
+		(*pv) = vec3f(0.f, 0.f, 0.f);
+
+		// the state times are the frame numbers
+		int nframe = (int)(m_state->m_time + 0.5f);
+		if ((nframe < 0) || (nframe >= (int)m_data->frame.size())) return;
+
+		FEKinemat::STATE& s = m_data->frame[nframe];
+		int m = m_data->part[n];
+		if ((m < 0) || (m >= (int)s.D.size())) return;
+
+		const vec3d& r0 = m_data->r0[n];
+		(*pv) = to_vec3f(s.D[m].apply(r0) - r0);
+	}
+
+private:
+	std::shared_ptr<FEKinematData>	m_data;
+};
+
+class FEKinematDisplacementField : public ModelDataField
+{
+public:
+	FEKinematDisplacementField(FEPostModel* fem, std::shared_ptr<FEKinematData> data) : ModelDataField(fem, DATA_VEC3, DATA_ITEM, NODE_DATA, EXPORT_DATA), m_data(data) {}
+
+	ModelDataField* Clone() const override
+	{
+		FEKinematDisplacementField* pd = new FEKinematDisplacementField(m_fem, m_data);
+		pd->SetName(GetName());
+		return pd;
+	}
+
+	Post::FEMeshData* CreateData(FEState* pstate) override
+	{
+		return new FEKinematDisplacement(pstate, this, m_data);
+	}
+
+private:
+	std::shared_ptr<FEKinematData>	m_data;
+};
+
 //-----------------------------------------------------------------------------
 bool FEKinemat::BuildStates(Post::FEPostModel* pfem)
 {
 	if (pfem == nullptr) return false;
 	Post::FEPostModel& fem = *pfem;
 
-	// add the first state
 	Post::FEPostMesh& mesh = *fem.GetFEMesh(0);
 	int NMAT = fem.Materials();
 	int NN = mesh.Nodes();
@@ -145,73 +204,60 @@ bool FEKinemat::BuildStates(Post::FEPostModel* pfem)
 	FEDataManager* pdm = fem.GetDataManager();
 	int N = pdm->DataFields();
 	FEDataFieldPtr pt = pdm->FirstDataField();
-	int ND = -1;
+	ModelDataField* pdisp = nullptr;
 	for (int i=0; i<N; ++i, ++pt)
 	{
 		 if ((*pt)->GetName() == "Displacement")
 		 {
-			 ND = i;
+			 pdisp = *pt;
 			 break;
 		 }
 	}
-	if (ND == -1) return false;
-
-	// get the initial coordinates
-	vector<vec3d> r0(NN);
-	for (int i=0; i<NN; ++i) r0[i] = to_vec3d(fem.NodePosition(i, 0));
+	if (pdisp == nullptr) return false;
 
 	int NS = (int)m_State.size();
 	if (m_n0 >= NS) return false;
 	if (m_n1 - m_n0 +1 > NS) m_n1 = NS - 1;
-	float t = 0.f;
-	for (int ns = m_n0; ns <= m_n1; ns += m_ni, t += 1.f)
+
+	// get the initial coordinates and find the part of each node
+	std::shared_ptr<FEKinematData> data = std::make_shared<FEKinematData>();
+	data->r0.resize(NN);
+	for (int i=0; i<NN; ++i) data->r0[i] = to_vec3d(fem.NodePosition(i, 0));
+
+	data->part.assign(NN, -1);
+	for (int i=0; i<NE; ++i)
 	{
-		STATE& s = m_State[ns];
-
-		// create a new state
-		FEState* ps = 0;
-		if (t == 0.f) ps = fem.GetState(0);
-		else {
-			try {
-				ps = new FEState(t, &fem, fem.GetFEMesh(0));
-				fem.AddState(ps);
-			}
-			catch (...)
-			{
-				return false;
-			}
+		FEElement_& e = mesh.ElementRef(i);
+		int m = e.m_MatID;
+		if ((m < 0) || (m >= NMAT)) continue;
+		int ne = e.Nodes();
+		for (int j=0; j<ne; ++j)
+		{
+			int& pn = data->part[e.m_node[j]];
+			if (m > pn) pn = m;
 		}
+	}
 
-		// get the displacement field
-		Post::FENodeData<vec3f>& d = dynamic_cast<Post::FENodeData<vec3f>&>(ps->m_Data[ND]);
+	// collect the transforms of the states we'll create
+	for (int ns = m_n0; ns <= m_n1; ns += m_ni) data->frame.push_back(m_State[ns]);
 
-		for (int i=0; i<NN; ++i) d[i] = vec3f(0.f, 0.f, 0.f);
+	// replace the displacement field with one that evaluates the kinematics
+	fem.DeleteDataField(pdisp);
+	delete pdisp;
+	fem.AddDataField(new FEKinematDisplacementField(&fem, data), "Displacement");
+	fem.SetDisplacementField(BUILD_FIELD(NODE_DATA, pdm->DataFields() - 1, 0));
 
-		int N = NMAT;
-		if ((int)s.D.size() < NMAT) N = (int)s.D.size();
-		for (int n=0; n<N; ++n)
+	// create the remaining states
+	int nframes = (int)data->frame.size();
+	for (int n = 1; n < nframes; ++n)
+	{
+		try {
+			FEState* ps = new FEState((float) n, &fem, fem.GetFEMesh(0));
+			fem.AddState(ps);
+		}
+		catch (...)
 		{
-			KINE& kine = s.D[n];
-			for (int i=0; i<NN; ++i) mesh.Node(i).m_ntag = 0;
-			for (int i=0; i<NE; ++i)
-			{
-				FEElement_& e = mesh.ElementRef(i);
-				if (e.m_MatID == n)
-				{
-					int ne = e.Nodes();
-					for (int j=0; j<ne; ++j) mesh.Node(e.m_node[j]).m_ntag = 1;
-				}
-			}
-
-			for (int i=0; i<NN; ++i)
-			{
-				FSNode& nd = mesh.Node(i);
-				if (nd.m_ntag == 1)
-				{
-					const vec3d& r0_i = r0[i];
-					d[i] = to_vec3f(kine.apply(r0_i) - r0_i);
-				}
-			}
+			return false;
 		}
 	}
 	fem.UpdateBoundingBox();
@@ -34,7 +34,11 @@ namespace Post {
 }
 
 //-----------------------------------------------------------------------------
-//! This class implements a tool to apply kinematics data to a model
+//! This class implements a tool to apply kinematics data to a model.
+//! The displacement field only stores the rigid transforms of each part and
+//! evaluates the nodal displacements from these when needed. Note that each 
+//! state still has its own node, edge, face and element buffers (e.g. nodal
+//! positions, visibility flags and shell thicknesses), as for any other model.
 class FEKinemat
 {
 public:
@@ -1435,7 +1435,7 @@ void Curvature::level(int n, int l, set<int>& nl1)
 		for (it = nl1.begin(); it != nl1.end(); ++it)
 		{
 			// get the node-face list
-			const vector<NodeFaceRef>& nfl = pmesh->NodeFaceList(*it);
+			FSItemRange<NodeFaceRef> nfl = pmesh->NodeFaceList(*it);
 			int NF = nfl.size();
 
 			// add the other nodes
@@ -1454,7 +1454,7 @@ void Curvature::level(int n, int l, set<int>& nl1)
 		for (it = nl1.begin(); it != nl1.end(); ++it)
 		{
 			// get the node-face list
-			const vector<NodeFaceRef>& nfl = pmesh->NodeFaceList(*it);
+			FSItemRange<NodeFaceRef> nfl = pmesh->NodeFaceList(*it);
 			int NF = nfl.size();
 
 			// add the other nodes
@@ -1513,7 +1513,7 @@ float Curvature::nodal_curvature(int n, int measure)
 	vec3f r0 = pfem->NodePosition(n, ntime);
 
 	// get the node-face list
-	const vector<NodeFaceRef>& nfl = pmesh->NodeFaceList(n);
+	FSItemRange<NodeFaceRef> nfl = pmesh->NodeFaceList(n);
 	int NF = nfl.size();
 
 	// estimate surface normal
@@ -1578,7 +1578,7 @@ void PrincCurvatureVector::level(int n, int l, set<int>& nl1)
 		for (it = nl1.begin(); it != nl1.end(); ++it)
 		{
 			// get the node-face list
-			const vector<NodeFaceRef>& nfl = pmesh->NodeFaceList(*it);
+			FSItemRange<NodeFaceRef> nfl = pmesh->NodeFaceList(*it);
 			int NF = nfl.size();
 
 			// add the other nodes
@@ -1597,7 +1597,7 @@ void PrincCurvatureVector::level(int n, int l, set<int>& nl1)
 		for (it = nl1.begin(); it != nl1.end(); ++it)
 		{
 			// get the node-face list
-			const vector<NodeFaceRef>& nfl = pmesh->NodeFaceList(*it);
+			FSItemRange<NodeFaceRef> nfl = pmesh->NodeFaceList(*it);
 			int NF = nfl.size();
 
 			// add the other nodes
@@ -1656,7 +1656,7 @@ vec3f PrincCurvatureVector::nodal_curvature(int n, int m)
 	vec3f r0 = pfem->NodePosition(n, ntime);
 
 	// get the node-face list
-	const vector<NodeFaceRef>& nfl = pmesh->NodeFaceList(n);
+	FSItemRange<NodeFaceRef> nfl = pmesh->NodeFaceList(n);
 	int NF = nfl.size();
 
 	// estimate surface normal
@@ -34,6 +34,7 @@ namespace Post {
 class FEPostModel;
 class FEState;
 class FEPostMesh;
+class FEDataCacheStream;
 
 //-----------------------------------------------------------------------------
 enum Data_Tensor_Type {
@@ -60,6 +61,10 @@ public:
 
 	FEPostModel* GetFSModel();
 
+	// read or write the stored data (used by the derived data cache).
+	// Returns false if the data is not stored in arrays.
+	virtual bool SerializeCache(FEDataCacheStream& ar) { return false; }
+
 protected:
 	FEState*	m_state;
 	DATA_TYPE	m_ntype;
@@ -30,6 +30,7 @@ SOFTWARE.*/
 #include "FEState.h"
 #include "FEPostMesh.h"
 #include "FEDataField.h"
+#include "FEDataCache.h"
 #include <set>
 //using namespace std;
 
@@ -124,6 +125,7 @@ public:
 	FENodeData(FEState* state, ModelDataField* pdf) : FENodeData_T<T>(state, pdf) { m_data.resize(state->GetFEMesh()->Nodes()); }
 	void eval(int n, T* pv) { (*pv) = m_data[n]; }
 	void copy(FENodeData<T>& d) { m_data = d.m_data; }
+	bool SerializeCache(FEDataCacheStream& ar) override { return ar.serialize(m_data); }
 
 	int size() const { return (int) m_data.size(); }
 	T& operator [] (int n) { return m_data[n]; }
@@ -201,6 +203,7 @@ public:
 	void eval(int n, T* pv) { (*pv) = m_data[m_face[n]]; }
 	bool active(int n) { return (m_face[n] >= 0); }
 	void copy(FEFaceData<T, DATA_ITEM>& d) { m_data = d.m_data; m_face = d.m_face; }
+	bool SerializeCache(FEDataCacheStream& ar) override { return ar.serialize(m_data) && ar.serialize(m_face); }
 	bool add(int n, const T& d)
 	{ 
 		if ((n < 0) || (n >= m_face.size())) return false;
@@ -234,6 +237,7 @@ public:
 	void eval(int n, T* pv) { (*pv) = m_data[m_face[n]]; }
 	bool active(int n) { return (m_face[n] >= 0); }
 	void copy(FEFaceData<T,DATA_ITEM>& d) { m_data = d.m_data; }
+	bool SerializeCache(FEDataCacheStream& ar) override { return ar.serialize(m_data) && ar.serialize(m_face); }
 	bool add(std::vector<int>& item, const T& v)
 	{ 
 		int m = (int) m_data.size(); 
@@ -276,6 +280,7 @@ public:
 	}
 	bool active(int n) { return (m_face[n] >= 0); }
 	void copy(FEFaceData<T,DATA_MULT>& d) { m_data = d.m_data; m_face = d.m_face; }
+	bool SerializeCache(FEDataCacheStream& ar) override { return ar.serialize(m_data) && ar.serialize(m_face); }
 	bool add(int n, T* d, int m) 
 	{ 
 		if (m_face[n] >= 0) 
@@ -318,6 +323,7 @@ public:
 	}
 	bool active(int n) { return (m_face[2*n] >= 0); }
 	void copy(FEFaceData<T,DATA_NODE>& d) { m_data = d.m_data; m_indx = d.m_indx; }
+	bool SerializeCache(FEDataCacheStream& ar) override { return ar.serialize(m_data) && ar.serialize(m_face) && ar.serialize(m_indx); }
 	void add(std::vector<T>& data, std::vector<int>& face, std::vector<int>& index, std::vector<int>& nf)
 	{
 		int n0 = (int)m_data.size();
@@ -516,6 +522,7 @@ public:
 	void eval(int n, T* pv) { assert(m_elem[n] >= 0); (*pv) = m_data[m_elem[n]]; }
 	void set(int n, const T& v) { assert(m_elem[n] >= 0); m_data[m_elem[n]] = v; }
 	void copy(FEElementData<T, DATA_ITEM>& d) { m_elem = d.m_elem; m_data = d.m_data; }
+	bool SerializeCache(FEDataCacheStream& ar) override { return ar.serialize(m_data) && ar.serialize(m_elem); }
 	bool active(int n) { return (m_elem.empty() == false) && (m_elem[n] >= 0); }
 	void add(int n, const T& v)
 	{ 
@@ -546,6 +553,7 @@ public:
 	}
 	void eval(int n, T* pv) { assert(m_elem[n] >= 0); (*pv) = m_data[m_elem[n]]; }
 	void copy(FEElementData<T, DATA_REGION>& d) { m_data = d.m_data; }
+	bool SerializeCache(FEDataCacheStream& ar) override { return ar.serialize(m_data) && ar.serialize(m_elem); }
 	bool active(int n) { return (m_elem.empty() == false) && (m_elem[n] >= 0); }
 	void add(std::vector<int>& item, const T& v)
 	{ 
@@ -601,6 +609,7 @@ public:
 	}
 	bool active(int n) { return (m_elem.empty() == false) && (m_elem[2 * n + 1] > 0); }
 	void copy(FEElementData<T, DATA_MULT>& d) { m_data = d.m_data; m_elem = d.m_elem; }
+	bool SerializeCache(FEDataCacheStream& ar) override { return ar.serialize(m_data) && ar.serialize(m_elem); }
 	void add(int n, int m, T* d) 
 	{ 
 		if (m_elem[2*n] == -1)
@@ -645,6 +654,7 @@ public:
 	}
 	bool active(int n) { return (m_elem.empty() == false) && (m_elem[2 * n] >= 0); }
 	void copy(FEElementData<T, DATA_NODE>& d) { m_data = d.m_data; m_indx = d.m_indx; m_elem = d.m_elem; }
+	bool SerializeCache(FEDataCacheStream& ar) override { return ar.serialize(m_data) && ar.serialize(m_elem) && ar.serialize(m_indx); }
 	void add(std::vector<T>& d, std::vector<int>& e, std::vector<int>& l, int ne)
 	{ 
 		int n0 = (int) m_data.size();
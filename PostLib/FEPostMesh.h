@@ -58,7 +58,7 @@ public:
 	//! clean mesh and all data
 	void ClearAll();
 
-	const std::vector<NodeElemRef>& NodeElemList(int n) const { return m_NEL.ElementList(n); }
+	FSItemRange<NodeElemRef> NodeElemList(int n) const { return m_NEL.ElementList(n); }
 
 public:
 	// --- G E O M E T R Y ---
@@ -641,11 +641,13 @@ void FEPostModel::InsertState(FEState *ps, float f)
 }
 
 //-----------------------------------------------------------------------------
+// Only data stored in arrays is copied. Data that is evaluated on the fly 
+// (e.g. kinematics displacements) is evaluated by the cloned field.
 template <typename Type> void copy_node_data(FEMeshData& d, FEMeshData& s)
 {
-	FENodeData<Type>& dt = dynamic_cast<FENodeData<Type>&>(d);
-	FENodeData<Type>& st = dynamic_cast<FENodeData<Type>&>(s);
-	dt.copy(st);
+	FENodeData<Type>* pd = dynamic_cast<FENodeData<Type>*>(&d);
+	FENodeData<Type>* ps = dynamic_cast<FENodeData<Type>*>(&s);
+	if (pd && ps) pd->copy(*ps);
 }
 
 //-----------------------------------------------------------------------------
@@ -764,48 +766,42 @@ ModelDataField* FEPostModel::CopyDataField(ModelDataField* pd, const char* sznew
 }
 
 //-----------------------------------------------------------------------------
-ModelDataField* createCachedDataField(ModelDataField* pd)
+ModelDataField* createCachedDataField(FEPostModel* fem, DATA_CLASS nclass, DATA_TYPE ntype, DATA_FORMAT nfmt, unsigned int flag)
 {
-	Post::FEPostModel* fem = pd->GetModel();
-
-	DATA_CLASS nclass = pd->DataClass();
-	DATA_TYPE ntype = pd->Type();
-	DATA_FORMAT nfmt = pd->Format();
-
 	ModelDataField* newField = 0;
 	if (nclass == NODE_DATA)
 	{
-		if      (ntype == DATA_SCALAR ) newField = new FEDataField_T<FENodeData<float > >(fem);
-		else if (ntype == DATA_VEC3  ) newField = new FEDataField_T<FENodeData<vec3f > >(fem);
-		else if (ntype == DATA_MAT3  ) newField = new FEDataField_T<FENodeData<mat3f > >(fem);
-		else if (ntype == DATA_MAT3S ) newField = new FEDataField_T<FENodeData<mat3fs> >(fem);
-		else if (ntype == DATA_MAT3SD) newField = new FEDataField_T<FENodeData<mat3fd> >(fem);
+		if      (ntype == DATA_SCALAR ) newField = new FEDataField_T<FENodeData<float > >(fem, flag);
+		else if (ntype == DATA_VEC3  ) newField = new FEDataField_T<FENodeData<vec3f > >(fem, flag);
+		else if (ntype == DATA_MAT3  ) newField = new FEDataField_T<FENodeData<mat3f > >(fem, flag);
+		else if (ntype == DATA_MAT3S ) newField = new FEDataField_T<FENodeData<mat3fs> >(fem, flag);
+		else if (ntype == DATA_MAT3SD) newField = new FEDataField_T<FENodeData<mat3fd> >(fem, flag);
 		else assert(false);
 	}
 	else if (nclass == ELEM_DATA)
 	{
 		if (ntype == DATA_SCALAR)
 		{
-			if      (nfmt == DATA_NODE  ) newField = new FEDataField_T<FEElementData<float, DATA_NODE  > >(fem);
-			else if (nfmt == DATA_ITEM  ) newField = new FEDataField_T<FEElementData<float, DATA_ITEM  > >(fem);
-			else if (nfmt == DATA_MULT  ) newField = new FEDataField_T<FEElementData<float, DATA_MULT  > >(fem);
-			else if (nfmt == DATA_REGION) newField = new FEDataField_T<FEElementData<float, DATA_REGION> >(fem);
+			if      (nfmt == DATA_NODE  ) newField = new FEDataField_T<FEElementData<float, DATA_NODE  > >(fem, flag);
+			else if (nfmt == DATA_ITEM  ) newField = new FEDataField_T<FEElementData<float, DATA_ITEM  > >(fem, flag);
+			else if (nfmt == DATA_MULT  ) newField = new FEDataField_T<FEElementData<float, DATA_MULT  > >(fem, flag);
+			else if (nfmt == DATA_REGION) newField = new FEDataField_T<FEElementData<float, DATA_REGION> >(fem, flag);
 			else assert(false);
 		}
 		else if (ntype == DATA_VEC3)
 		{
-			if      (nfmt == DATA_NODE  ) newField = new FEDataField_T<FEElementData<vec3f, DATA_NODE  > >(fem);
-			else if (nfmt == DATA_ITEM  ) newField = new FEDataField_T<FEElementData<vec3f, DATA_ITEM  > >(fem);
-			else if (nfmt == DATA_MULT  ) newField = new FEDataField_T<FEElementData<vec3f, DATA_MULT  > >(fem);
-			else if (nfmt == DATA_REGION) newField = new FEDataField_T<FEElementData<vec3f, DATA_REGION> >(fem);
+			if      (nfmt == DATA_NODE  ) newField = new FEDataField_T<FEElementData<vec3f, DATA_NODE  > >(fem, flag);
+			else if (nfmt == DATA_ITEM  ) newField = new FEDataField_T<FEElementData<vec3f, DATA_ITEM  > >(fem, flag);
+			else if (nfmt == DATA_MULT  ) newField = new FEDataField_T<FEElementData<vec3f, DATA_MULT  > >(fem, flag);
+			else if (nfmt == DATA_REGION) newField = new FEDataField_T<FEElementData<vec3f, DATA_REGION> >(fem, flag);
 			else assert(false);
 		}
 		else if (ntype == DATA_MAT3S)
 		{
-			if      (nfmt == DATA_NODE  ) newField = new FEDataField_T<FEElementData<mat3fs, DATA_NODE  > >(fem);
-			else if (nfmt == DATA_ITEM  ) newField = new FEDataField_T<FEElementData<mat3fs, DATA_ITEM  > >(fem);
-			else if (nfmt == DATA_MULT  ) newField = new FEDataField_T<FEElementData<mat3fs, DATA_MULT  > >(fem);
-			else if (nfmt == DATA_REGION) newField = new FEDataField_T<FEElementData<mat3fs, DATA_REGION> >(fem);
+			if      (nfmt == DATA_NODE  ) newField = new FEDataField_T<FEElementData<mat3fs, DATA_NODE  > >(fem, flag);
+			else if (nfmt == DATA_ITEM  ) newField = new FEDataField_T<FEElementData<mat3fs, DATA_ITEM  > >(fem, flag);
+			else if (nfmt == DATA_MULT  ) newField = new FEDataField_T<FEElementData<mat3fs, DATA_MULT  > >(fem, flag);
+			else if (nfmt == DATA_REGION) newField = new FEDataField_T<FEElementData<mat3fs, DATA_REGION> >(fem, flag);
 			else assert(false);
 		}
 		else assert(false);
@@ -814,26 +810,26 @@ ModelDataField* createCachedDataField(ModelDataField* pd)
 	{
 		if (ntype == DATA_SCALAR)
 		{
-			if      (nfmt == DATA_NODE  ) newField = new FEDataField_T<FEFaceData<float, DATA_NODE  > >(fem);
-			else if (nfmt == DATA_ITEM  ) newField = new FEDataField_T<FEFaceData<float, DATA_ITEM  > >(fem);
-			else if (nfmt == DATA_MULT  ) newField = new FEDataField_T<FEFaceData<float, DATA_MULT  > >(fem);
-			else if (nfmt == DATA_REGION) newField = new FEDataField_T<FEFaceData<float, DATA_REGION> >(fem);
+			if      (nfmt == DATA_NODE  ) newField = new FEDataField_T<FEFaceData<float, DATA_NODE  > >(fem, flag);
+			else if (nfmt == DATA_ITEM  ) newField = new FEDataField_T<FEFaceData<float, DATA_ITEM  > >(fem, flag);
+			else if (nfmt == DATA_MULT  ) newField = new FEDataField_T<FEFaceData<float, DATA_MULT  > >(fem, flag);
+			else if (nfmt == DATA_REGION) newField = new FEDataField_T<FEFaceData<float, DATA_REGION> >(fem, flag);
 			else assert(false);
 		}
 		else if (ntype == DATA_VEC3)
 		{
-			if      (nfmt == DATA_NODE  ) newField = new FEDataField_T<FEFaceData<vec3f, DATA_NODE  > >(fem);
-			else if (nfmt == DATA_ITEM  ) newField = new FEDataField_T<FEFaceData<vec3f, DATA_ITEM  > >(fem);
-			else if (nfmt == DATA_MULT  ) newField = new FEDataField_T<FEFaceData<vec3f, DATA_MULT  > >(fem);
-			else if (nfmt == DATA_REGION) newField = new FEDataField_T<FEFaceData<vec3f, DATA_REGION> >(fem);
+			if      (nfmt == DATA_NODE  ) newField = new FEDataField_T<FEFaceData<vec3f, DATA_NODE  > >(fem, flag);
+			else if (nfmt == DATA_ITEM  ) newField = new FEDataField_T<FEFaceData<vec3f, DATA_ITEM  > >(fem, flag);
+			else if (nfmt == DATA_MULT  ) newField = new FEDataField_T<FEFaceData<vec3f, DATA_MULT  > >(fem, flag);
+			else if (nfmt == DATA_REGION) newField = new FEDataField_T<FEFaceData<vec3f, DATA_REGION> >(fem, flag);
 			else assert(false);
 		}
 		else if (ntype == DATA_MAT3S)
 		{
-			if      (nfmt == DATA_NODE  ) newField = new FEDataField_T<FEFaceData<mat3fs, DATA_NODE  > >(fem);
-			else if (nfmt == DATA_ITEM  ) newField = new FEDataField_T<FEFaceData<mat3fs, DATA_ITEM  > >(fem);
-			else if (nfmt == DATA_MULT  ) newField = new FEDataField_T<FEFaceData<mat3fs, DATA_MULT  > >(fem);
-			else if (nfmt == DATA_REGION) newField = new FEDataField_T<FEFaceData<mat3fs, DATA_REGION> >(fem);
+			if      (nfmt == DATA_NODE  ) newField = new FEDataField_T<FEFaceData<mat3fs, DATA_NODE  > >(fem, flag);
+			else if (nfmt == DATA_ITEM  ) newField = new FEDataField_T<FEFaceData<mat3fs, DATA_ITEM  > >(fem, flag);
+			else if (nfmt == DATA_MULT  ) newField = new FEDataField_T<FEFaceData<mat3fs, DATA_MULT  > >(fem, flag);
+			else if (nfmt == DATA_REGION) newField = new FEDataField_T<FEFaceData<mat3fs, DATA_REGION> >(fem, flag);
 			else assert(false);
 		}
 		else assert(false);
@@ -844,6 +840,12 @@ ModelDataField* createCachedDataField(ModelDataField* pd)
 	return newField;
 }
 
+//-----------------------------------------------------------------------------
+ModelDataField* createCachedDataField(ModelDataField* pd)
+{
+	return createCachedDataField(pd->GetModel(), pd->DataClass(), pd->Type(), pd->Format());
+}
+
 //-----------------------------------------------------------------------------
 template <typename T> void cached_copy_node_data(FEMeshData& dst, FEMeshData& src, int NN)
 {
@@ -319,4 +319,9 @@ protected:
 
 	static FEPostModel*	m_pThis;
 };
+
+//-----------------------------------------------------------------------------
+// create a data field that stores its data in arrays
+ModelDataField* createCachedDataField(FEPostModel* fem, DATA_CLASS nclass, DATA_TYPE ntype, DATA_FORMAT nfmt, unsigned int flag = 0);
+
 } // namespace Post
@@ -636,9 +636,9 @@ bool FEVTKExport::FillNodeDataArray(vector<float>& val, Post::FEMeshData& meshDa
 	}
 	else if (ntype == DATA_VEC3)
 	{
-		FENodeData<vec3f>& data = dynamic_cast<FENodeData<vec3f>&>(meshData);
+		FENodeData_T<vec3f>& data = dynamic_cast<FENodeData_T<vec3f>&>(meshData);
 		val.assign(NN*3, 0.f);
-		for (int i=0; i<NN; ++i) write_data(val, i, data[i]);
+		for (int i=0; i<NN; ++i) { vec3f v; data.eval(i, &v); write_data(val, i, v); }
 	}
 	else if (ntype == DATA_MAT3S)
 	{
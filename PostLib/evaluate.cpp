@@ -29,6 +29,7 @@ SOFTWARE.*/
 #include "FEMeshData_T.h"
 #include <MeshLib/MeshMetrics.h>
 #include <MeshLib/MeshTools.h>
+#include <FSCore/CallTracer.h>
 using namespace Post;
 using namespace std;
 
@@ -213,6 +214,8 @@ bool FEPostModel::Evaluate(int nfield, int ntime, bool breset)
 	// make sure that we have to reevaluate
 	if ((state.m_nField != nfield) || breset)
 	{
+		TRACE("FEPostModel::Evaluate");
+
 		// store the field variable
 		state.m_nField = nfield;
 
@@ -366,7 +369,7 @@ void FEPostModel::EvalFaceField(int ntime, int nfield)
 		for (i=0; i<mesh->Nodes(); ++i)
 		{
 			NODEDATA& node = state.m_NODE[i];
-			const vector<NodeFaceRef>& nfl = mesh->NodeFaceList(i);
+			FSItemRange<NodeFaceRef> nfl = mesh->NodeFaceList(i);
 			node.m_val = 0.f; 
 			node.m_ntag = 0;
 			int n = 0;
@@ -439,7 +442,7 @@ void FEPostModel::EvalElemField(int ntime, int nfield)
 		state.m_NODE[i].m_ntag = 0;
 		if (node.IsEnabled())
 		{
-			const vector<NodeElemRef>& nel = mesh->NodeElemList(i);
+			FSItemRange<NodeElemRef> nel = mesh->NodeElemList(i);
 			int m = (int) nel.size(), n=0;
 			float val = 0.f;
 			for (int j=0; j<m; ++j)
@@ -828,7 +831,7 @@ void FEPostModel::EvaluateNode(int n, int ntime, int nfield, NODEDATA& d)
 	else if (IS_FACE_FIELD(nfield))
 	{
 		// we take the average of the adjacent face values
-		const vector<NodeFaceRef>& nfl = mesh->NodeFaceList(n);
+		FSItemRange<NodeFaceRef> nfl = mesh->NodeFaceList(n);
 		if (!nfl.empty())
 		{
 			int nf = (int)nfl.size(), n = 0;
@@ -847,7 +850,7 @@ void FEPostModel::EvaluateNode(int n, int ntime, int nfield, NODEDATA& d)
 	else if (IS_ELEM_FIELD(nfield))
 	{
 		// we take the average of the elements that contain this element
-		const vector<NodeElemRef>& nel = mesh->NodeElemList(n);
+		FSItemRange<NodeElemRef> nel = mesh->NodeElemList(n);
 		float data[FSElement::MAX_NODES] = {0.f}, val;
 		int ne = (int)nel.size(), n = 0;
 		if (!nel.empty())
@@ -2076,7 +2079,7 @@ vec3f FEPostModel::EvaluateNodeVector(int n, int ntime, int nvec)
 	else if (IS_ELEM_FIELD(nvec))
 	{
 		// we take the average of the elements that contain this element
-		const vector<NodeElemRef>& nel = mesh->NodeElemList(n);
+		FSItemRange<NodeElemRef> nel = mesh->NodeElemList(n);
 		if (!nel.empty())
 		{
 			int n = 0;
@@ -2097,7 +2100,7 @@ vec3f FEPostModel::EvaluateNodeVector(int n, int ntime, int nvec)
 	else if (IS_FACE_FIELD(nvec))
 	{
 		// we take the average of the elements that contain this element
-		const vector<NodeFaceRef>& nfl = mesh->NodeFaceList(n);
+		FSItemRange<NodeFaceRef> nfl = mesh->NodeFaceList(n);
 		if (!nfl.empty())
 		{
 			int n = 0;
@@ -2399,7 +2402,7 @@ mat3f FEPostModel::EvaluateNodeTensor(int n, int ntime, int nten, int ntype)
 	else 
 	{
 		// we take the average of the elements that contain this element
-		const vector<NodeElemRef>& nel = mesh->NodeElemList(n);
+		FSItemRange<NodeElemRef> nel = mesh->NodeElemList(n);
 		if (!nel.empty())
 		{
 			for (int i=0; i<(int) nel.size(); ++i) m += EvaluateElemTensor(nel[i].eid, ntime, nten, ntype);
@@ -32,18 +32,6 @@ SOFTWARE.*/
 #include <zlib.h>
 #endif
 
-#ifdef WIN32
-typedef __int64 off_type;
-#endif
-
-#ifdef LINUX // same for Linux and Mac OS X
-typedef off_t off_type;
-#endif
-
-#ifdef __APPLE__ // same for Linux and Mac OS X
-typedef off_t off_type;
-#endif
-
 #ifdef WIN32
 #define ftell64(a)     _ftelli64(a)
 #define fseek64(a,b,c) _fseeki64(a,b,c)
@@ -59,6 +47,64 @@ typedef off_t off_type;
 #define fseek64(a,b,c) fseeko(a,b,c)
 #endif
 
+//////////////////////////////////////////////////////////////////////
+// xpltChunkBuffer
+//////////////////////////////////////////////////////////////////////
+
+void xpltChunkBuffer::BeginChunk(unsigned int id)
+{
+	// write the chunk ID and reserve space for the size
+	size_t n = m_buf.size();
+	m_buf.resize(n + 2 * sizeof(unsigned int));
+	memcpy(&m_buf[n], &id, sizeof(unsigned int));
+	m_chunk.push_back(n);
+}
+
+void xpltChunkBuffer::EndChunk()
+{
+	assert(m_chunk.empty() == false);
+	size_t n = m_chunk.back(); m_chunk.pop_back();
+
+	// the size of a branch includes the headers of its children
+	unsigned int nsize = (unsigned int)(m_buf.size() - n - 2 * sizeof(unsigned int));
+	memcpy(&m_buf[n + sizeof(unsigned int)], &nsize, sizeof(unsigned int));
+}
+
+void xpltChunkBuffer::WriteLeaf(unsigned int nid, const void* pd, size_t nsize)
+{
+	size_t n = m_buf.size();
+	m_buf.resize(n + 2 * sizeof(unsigned int) + nsize);
+	unsigned int ns = (unsigned int)nsize;
+	memcpy(&m_buf[n], &nid, sizeof(unsigned int));
+	memcpy(&m_buf[n + sizeof(unsigned int)], &ns, sizeof(unsigned int));
+	if (nsize > 0) memcpy(&m_buf[n + 2 * sizeof(unsigned int)], pd, nsize);
+}
+
+bool xpltChunkBuffer::Compress()
+{
+	assert(m_chunk.empty());
+#ifdef HAVE_ZLIB
+	// Each compressed chunk is a separate zlib stream, which is what
+	// xpltArchive::DecompressChunk expects.
+	uLong srcSize = (uLong)m_buf.size();
+	uLongf dstSize = compressBound(srcSize);
+	std::vector<char> out(dstSize);
+	int ret = compress2((Bytef*)&out[0], &dstSize, (const Bytef*)data(), srcSize, Z_DEFAULT_COMPRESSION);
+	if (ret != Z_OK) return false;
+	out.resize(dstSize);
+	m_buf.swap(out);
+	return true;
+#else
+	return false;
+#endif
+}
+
+void xpltChunkBuffer::Clear()
+{
+	m_buf.clear();
+	m_chunk.clear();
+}
+
 //////////////////////////////////////////////////////////////////////
 // xpltArchive
 //////////////////////////////////////////////////////////////////////
@@ -170,6 +216,20 @@ void xpltArchive::Flush()
 }
 
 
+bool xpltArchive::WriteBuffer(const xpltChunkBuffer& buf)
+{
+	// make sure all chunks were flushed
+	assert(im.m_pRoot == 0);
+	if (im.m_fp == 0) return false;
+	if (buf.size() == 0) return true;
+
+	im.m_fp->BeginStreaming();
+	im.m_fp->Write((void*)buf.data(), sizeof(char), buf.size());
+	im.m_fp->EndStreaming();
+
+	return true;
+}
+
 bool xpltArchive::Create(const char* szfile)
 {
 	// attempt to create the file
@@ -334,6 +394,53 @@ bool xpltArchive::DecompressChunk(unsigned int& nid, unsigned int& nsize)
 	return false;
 }
 
+off_type xpltArchive::Tell()
+{
+	assert(im.m_Chunk.empty());
+	off_type pos = ftell64(im.m_fp->FilePtr());
+#ifdef HAVE_ZLIB
+	// the decompression stream may have read ahead
+	if (im.m_ncompress) pos -= im.strm.avail_in;
+#endif
+	return pos;
+}
+
+bool xpltArchive::Seek(off_type pos)
+{
+	// clear the chunk stack
+	while (im.m_Chunk.empty() == false)
+	{
+		CHUNK* pc = im.m_Chunk.top(); im.m_Chunk.pop();
+		delete pc;
+	}
+
+	// delete the buffer (this can still be allocated after a failed read)
+	if (im.m_buf) delete[] im.m_buf;
+	im.m_buf = 0;
+	im.m_pdata = 0;
+	im.m_bufsize = 0;
+	im.m_bend = false;
+
+	// discard any buffered compressed input
+#ifdef HAVE_ZLIB
+	im.strm.avail_in = 0;
+	im.strm.next_in = Z_NULL;
+#endif
+
+	// this also clears the end-of-file flag, so that data that was 
+	// appended since the last read becomes visible.
+	return (fseek64(im.m_fp->FilePtr(), pos, SEEK_SET) == 0);
+}
+
+off_type xpltArchive::FileSize()
+{
+	FILE* fp = im.m_fp->FilePtr();
+	off_type pos = ftell64(fp);
+	fseek64(fp, 0, SEEK_END);
+	off_type size = ftell64(fp);
+	fseek64(fp, pos, SEEK_SET);
+	return size;
+}
 
 bool xpltArchive::Append(const char* szfile)
 {
@@ -31,6 +31,70 @@ SOFTWARE.*/
 #include <FSCore/math3d.h>
 #include <FSCore/Archive.h>
 
+#ifdef WIN32
+typedef __int64 off_type;
+#endif
+
+#ifdef LINUX // same for Linux and Mac OS X
+typedef off_t off_type;
+#endif
+
+#ifdef __APPLE__ // same for Linux and Mac OS X
+typedef off_t off_type;
+#endif
+
+//-----------------------------------------------------------------------------
+// Serializes chunks directly into a contiguous memory buffer, using the same
+// layout as the output archive. This allows chunks (e.g. states) to be 
+// assembled and compressed independently before they are written to file. 
+class xpltChunkBuffer
+{
+public:
+	xpltChunkBuffer() {}
+
+	// begin a chunk
+	void BeginChunk(unsigned int id);
+
+	// end a chunk
+	void EndChunk();
+
+	template <typename T> void WriteChunk(unsigned int nid, T& o)
+	{
+		WriteLeaf(nid, &o, sizeof(T));
+	}
+
+	template <typename T> void WriteChunk(unsigned int nid, T* po, int n)
+	{
+		WriteLeaf(nid, po, sizeof(T) * n);
+	}
+
+	template <typename T> void WriteChunk(unsigned int nid, std::vector<T>& a)
+	{
+		WriteLeaf(nid, (a.empty() ? nullptr : &a[0]), sizeof(T) * a.size());
+	}
+
+	void WriteData(int nid, std::vector<float>& data)
+	{
+		WriteChunk(nid, data);
+	}
+
+	// compress the buffer. This requires that all chunks are closed.
+	bool Compress();
+
+	// clear the buffer
+	void Clear();
+
+	const char* data() const { return (m_buf.empty() ? nullptr : &m_buf[0]); }
+	size_t size() const { return m_buf.size(); }
+
+private:
+	void WriteLeaf(unsigned int nid, const void* pd, size_t nsize);
+
+private:
+	std::vector<char>	m_buf;		// the data buffer
+	std::vector<size_t>	m_chunk;	// offsets of open chunks
+};
+
 //-----------------------------------------------------------------------------
 // Input archive
 class xpltArchive  
@@ -92,6 +156,9 @@ public:
 		WriteChunk(nid, data);
 	}
 
+	// write the contents of a chunk buffer to file
+	bool WriteBuffer(const xpltChunkBuffer& buf);
+
 protected:
 	void AddChild(OChunk* c);
 
@@ -164,6 +231,18 @@ public: // reading
 
 	bool DecompressChunk(unsigned int& nid, unsigned int& nsize);
 
+	// Get the file position of the next master chunk. This is only meaningful
+	// in between master chunks and accounts for compressed input that was 
+	// already buffered but not yet used. 
+	off_type Tell();
+
+	// Reset the read state and move the file position to the start of a master
+	// chunk (usually a value returned by Tell).
+	bool Seek(off_type pos);
+
+	// get the current size of the file
+	off_type FileSize();
+
 protected:
 	Imp& im;
 };
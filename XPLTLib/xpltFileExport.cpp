@@ -28,6 +28,8 @@ SOFTWARE.*/
 #include "xpltFileExport.h"
 #include <PostLib/FEPostModel.h>
 #include <PostLib/FEMeshData_T.h>
+#include <algorithm>
+#include <atomic>
 using namespace Post;
 using namespace std;
 
@@ -60,14 +62,29 @@ xpltFileExport::xpltFileExport()
 {
 	m_szerr[0] = 0;
 	m_ncompress = 0;
+	m_stride = 1;
+	m_btime = false;
+	m_tmin = m_tmax = 0.0;
+	m_bfields = false;
 }
 
 bool xpltFileExport::error(const char* sz)
 {
+	// states are written in parallel, so protect the error message
+#pragma omp critical (xplt_export_error)
 	strcpy(m_szerr, sz);
 	return false;
 }
 
+//-----------------------------------------------------------------------------
+// see if a data field should be exported
+bool xpltFileExport::ExportField(int n, ModelDataField& data) const
+{
+	if ((data.Flags() & EXPORT_DATA) == 0) return false;
+	if (m_bfields == false) return true;
+	return (std::find(m_fields.begin(), m_fields.end(), n) != m_fields.end());
+}
+
 bool xpltFileExport::Save(FEPostModel& fem, const char* szfile)
 {
 	m_szerr[0] = 0;
@@ -82,18 +99,11 @@ bool xpltFileExport::Save(FEPostModel& fem, const char* szfile)
 		return false;
 	}
 
-	// set compression option
-	m_ar.SetCompression(m_ncompress);
-
 	// write the state data
-	int NS = fem.GetStates();
-	for (int i=0; i<NS; ++i)
+	if (WriteStates(fem) == false)
 	{
-		if (WriteState(fem, *fem.GetState(i)) == false)
-		{
-			m_ar.Close();
-			return false;
-		}
+		m_ar.Close();
+		return false;
 	}
 
 	// don't forget to close
@@ -102,6 +112,57 @@ bool xpltFileExport::Save(FEPostModel& fem, const char* szfile)
 	return true;
 }
 
+//----------------------------------------------------------------------------
+// Write the selected states. States are serialized (and compressed) in parallel
+// into separate buffers, which are then written to file in order.
+bool xpltFileExport::WriteStates(FEPostModel& fem)
+{
+	// figure out which states to export
+	vector<int> states;
+	int NS = fem.GetStates();
+	int n = 0;
+	for (int i = 0; i < NS; ++i)
+	{
+		double t = fem.GetState(i)->m_time;
+		if (m_btime && ((t < m_tmin) || (t > m_tmax))) continue;
+		if ((n++ % m_stride) == 0) states.push_back(i);
+	}
+
+	// bok is also read outside the ordered section, so it needs to be atomic
+	std::atomic<bool> bok(true);
+	int N = (int)states.size();
+#pragma omp parallel for ordered schedule(dynamic, 1)
+	for (int i = 0; i < N; ++i)
+	{
+		xpltChunkBuffer buf;
+		bool ok = bok;
+		bool compressed = true;
+		if (ok)
+		{
+			ok = WriteState(fem, *fem.GetState(states[i]), buf);
+			if (ok && m_ncompress)
+			{
+				ok = compressed = buf.Compress();
+			}
+		}
+
+		// report errors in order (and from one thread at a time)
+#pragma omp ordered
+		{
+			if (compressed == false) error("Failed compressing state data");
+
+			if (ok && bok)
+			{
+				bok = m_ar.WriteBuffer(buf);
+				if (bok == false) error("Failed writing state data");
+			}
+			else bok = false;
+		}
+	}
+
+	return bok;
+}
+
 //----------------------------------------------------------------------------
 // Write the root section of the file
 bool xpltFileExport::WriteRoot(FEPostModel& fem)
@@ -178,7 +239,7 @@ bool xpltFileExport::WriteDictionary(FEPostModel& fem)
 	for (int i=0; i<NDATA; ++i, ++pd)
 	{
 		ModelDataField& data = *(*pd);
-		if ((data.DataClass() == NODE_DATA) && (data.Flags() & EXPORT_DATA)) m_nodeData++;
+		if ((data.DataClass() == NODE_DATA) && ExportField(i, data)) m_nodeData++;
 	}
 
 	if (m_nodeData > 0)
@@ -189,7 +250,7 @@ bool xpltFileExport::WriteDictionary(FEPostModel& fem)
 			for (int i=0; i<NDATA; ++i, ++pd)
 			{
 				ModelDataField& data = *(*pd);
-				if ((data.DataClass() == NODE_DATA) && (data.Flags() & EXPORT_DATA))
+				if ((data.DataClass() == NODE_DATA) && ExportField(i, data))
 					if (WriteDataField(data) == false) return false;
 			}
 		}
@@ -202,7 +263,7 @@ bool xpltFileExport::WriteDictionary(FEPostModel& fem)
 	for (int i=0; i<NDATA; ++i, ++pd)
 	{
 		ModelDataField& data = *(*pd);
-		if ((data.DataClass() == ELEM_DATA) && (data.Flags() & EXPORT_DATA)) m_elemData++;
+		if ((data.DataClass() == ELEM_DATA) && ExportField(i, data)) m_elemData++;
 	}
 
 	if (m_elemData > 0)
@@ -213,7 +274,7 @@ bool xpltFileExport::WriteDictionary(FEPostModel& fem)
 			for (int i=0; i<NDATA; ++i, ++pd)
 			{
 				ModelDataField& data = *(*pd);
-				if ((data.DataClass() == ELEM_DATA) && (data.Flags() & EXPORT_DATA))
+				if ((data.DataClass() == ELEM_DATA) && ExportField(i, data))
 					if (WriteDataField(data) == false) return false;
 			}
 		}
@@ -226,7 +287,7 @@ bool xpltFileExport::WriteDictionary(FEPostModel& fem)
 	for (int i=0; i<NDATA; ++i, ++pd)
 	{
 		ModelDataField& data = *(*pd);
-		if ((data.DataClass() == FACE_DATA) && (data.Flags() & EXPORT_DATA)) m_faceData++;
+		if ((data.DataClass() == FACE_DATA) && ExportField(i, data)) m_faceData++;
 	}
 
 	if (m_faceData > 0)
@@ -237,7 +298,7 @@ bool xpltFileExport::WriteDictionary(FEPostModel& fem)
 			for (int i=0; i<NDATA; ++i, ++pd)
 			{
 				ModelDataField& data = *(*pd);
-				if ((data.DataClass() == FACE_DATA) && (data.Flags() & EXPORT_DATA))
+				if ((data.DataClass() == FACE_DATA) && ExportField(i, data))
 					if (WriteDataField(data) == false) return false;
 			}
 		}
@@ -504,59 +565,59 @@ bool xpltFileExport::WriteSurfaceSection(Post::FEPostMesh& mesh)
 }
 
 //-----------------------------------------------------------------------------
-bool xpltFileExport::WriteState(FEPostModel& fem, FEState& state)
+bool xpltFileExport::WriteState(FEPostModel& fem, FEState& state, xpltChunkBuffer& ar)
 {
-	m_ar.BeginChunk(PLT_STATE);
+	ar.BeginChunk(PLT_STATE);
 	{
 		// state header
-		m_ar.BeginChunk(PLT_STATE_HEADER);
+		ar.BeginChunk(PLT_STATE_HEADER);
 		{
 			float f = (float) state.m_time;
-			m_ar.WriteChunk(PLT_STATE_HDR_TIME, f);
+			ar.WriteChunk(PLT_STATE_HDR_TIME, f);
 		}
-		m_ar.EndChunk();
+		ar.EndChunk();
 
-		m_ar.BeginChunk(PLT_STATE_DATA);
+		ar.BeginChunk(PLT_STATE_DATA);
 		{
 			// Node Data
 			if (m_nodeData)
 			{
-				m_ar.BeginChunk(PLT_NODE_DATA);
+				ar.BeginChunk(PLT_NODE_DATA);
 				{
-					if (WriteNodeData(fem, state) == false) return false;
+					if (WriteNodeData(fem, state, ar) == false) return false;
 				}
-				m_ar.EndChunk();
+				ar.EndChunk();
 			}
 
 			// Element Data
 			if (m_elemData)
 			{
-				m_ar.BeginChunk(PLT_ELEMENT_DATA);
+				ar.BeginChunk(PLT_ELEMENT_DATA);
 				{
-					if (WriteElemData(fem, state) == false) return false;
+					if (WriteElemData(fem, state, ar) == false) return false;
 				}
-				m_ar.EndChunk();
+				ar.EndChunk();
 			}
 
 			// surface data
 			if (m_faceData)
 			{
-				m_ar.BeginChunk(PLT_FACE_DATA);
+				ar.BeginChunk(PLT_FACE_DATA);
 				{
-					if (WriteFaceData(fem, state) == false) return false;
+					if (WriteFaceData(fem, state, ar) == false) return false;
 				}
-				m_ar.EndChunk();
+				ar.EndChunk();
 			}
 		}
-		m_ar.EndChunk();
+		ar.EndChunk();
 	}
-	m_ar.EndChunk();
+	ar.EndChunk();
 
 	return true;
 }
 
 //-----------------------------------------------------------------------------
-bool xpltFileExport::WriteNodeData(FEPostModel& fem, FEState& state)
+bool xpltFileExport::WriteNodeData(FEPostModel& fem, FEState& state, xpltChunkBuffer& ar)
 {
 	FEDataManager& DM = *fem.GetDataManager();
 	FEDataFieldPtr pd = DM.FirstDataField();
@@ -568,25 +629,25 @@ bool xpltFileExport::WriteNodeData(FEPostModel& fem, FEState& state)
 	for (int n=0; n<NDATA; ++n, ++pd)
 	{
 		ModelDataField& data = *(*pd);
-		if ((data.DataClass() == NODE_DATA) && (data.Flags() & EXPORT_DATA))
+		if ((data.DataClass() == NODE_DATA) && ExportField(n, data))
 		{
 			FEMeshData& meshData = state.m_Data[n];
-			m_ar.BeginChunk(PLT_STATE_VARIABLE);
+			ar.BeginChunk(PLT_STATE_VARIABLE);
 			{
-				m_ar.WriteChunk(PLT_STATE_VAR_ID, nid); nid++;
+				ar.WriteChunk(PLT_STATE_VAR_ID, nid); nid++;
 
-				m_ar.BeginChunk(PLT_STATE_VAR_DATA);
+				ar.BeginChunk(PLT_STATE_VAR_DATA);
 				{
 					// value array
 					vector<float> val;
 					if (FillNodeDataArray(val, meshData) == false) return false;
 
 					// write the value array
-					if (val.empty() == false) m_ar.WriteChunk(0, val);
+					if (val.empty() == false) ar.WriteChunk(0, val);
 				}
-				m_ar.EndChunk();
+				ar.EndChunk();
 			}
-			m_ar.EndChunk();
+			ar.EndChunk();
 		}
 	}
 
@@ -594,7 +655,7 @@ bool xpltFileExport::WriteNodeData(FEPostModel& fem, FEState& state)
 }
 
 //-----------------------------------------------------------------------------
-bool xpltFileExport::WriteElemData(FEPostModel& fem, FEState& state)
+bool xpltFileExport::WriteElemData(FEPostModel& fem, FEState& state, xpltChunkBuffer& ar)
 {
 	FEDataManager& DM = *fem.GetDataManager();
 	FEDataFieldPtr pd = DM.FirstDataField();
@@ -605,15 +666,15 @@ bool xpltFileExport::WriteElemData(FEPostModel& fem, FEState& state)
 	for (int n=0; n<NDATA; ++n, ++pd)
 	{
 		ModelDataField& data = *(*pd);
-		if ((data.DataClass() == ELEM_DATA) && (data.Flags() & EXPORT_DATA))
+		if ((data.DataClass() == ELEM_DATA) && ExportField(n, data))
 		{
 			FEMeshData& data = state.m_Data[n];
-			m_ar.BeginChunk(PLT_STATE_VARIABLE);
+			ar.BeginChunk(PLT_STATE_VARIABLE);
 			{
-				m_ar.WriteChunk(PLT_STATE_VAR_ID, nid); nid++;
+				ar.WriteChunk(PLT_STATE_VAR_ID, nid); nid++;
 
 				vector<float> val;
-				m_ar.BeginChunk(PLT_STATE_VAR_DATA);
+				ar.BeginChunk(PLT_STATE_VAR_DATA);
 				{
 					int ND = mesh.ElemSets();
 					for (int i=0; i<ND; ++i)
@@ -622,12 +683,12 @@ bool xpltFileExport::WriteElemData(FEPostModel& fem, FEState& state)
 
 						if (FillElemDataArray(val, data, part) == false) return false;
 
-						if (val.empty() == false) m_ar.WriteData(i+1, val);
+						if (val.empty() == false) ar.WriteData(i+1, val);
 					}
 				}
-				m_ar.EndChunk();
+				ar.EndChunk();
 			}
-			m_ar.EndChunk();
+			ar.EndChunk();
 		}
 	}
 
@@ -635,7 +696,7 @@ bool xpltFileExport::WriteElemData(FEPostModel& fem, FEState& state)
 }
 
 //-----------------------------------------------------------------------------
-bool xpltFileExport::WriteFaceData(FEPostModel& fem, FEState& state)
+bool xpltFileExport::WriteFaceData(FEPostModel& fem, FEState& state, xpltChunkBuffer& ar)
 {
 	FEDataManager& DM = *fem.GetDataManager();
 	FEDataFieldPtr pd = DM.FirstDataField();
@@ -646,15 +707,15 @@ bool xpltFileExport::WriteFaceData(FEPostModel& fem, FEState& state)
 	for (int n=0; n<NDATA; ++n, ++pd)
 	{
 		ModelDataField& data = *(*pd);
-		if ((data.DataClass() == FACE_DATA) && (data.Flags() & EXPORT_DATA))
+		if ((data.DataClass() == FACE_DATA) && ExportField(n, data))
 		{
 			FEMeshData& data = state.m_Data[n];
-			m_ar.BeginChunk(PLT_STATE_VARIABLE);
+			ar.BeginChunk(PLT_STATE_VARIABLE);
 			{
-				m_ar.WriteChunk(PLT_STATE_VAR_ID, nid); nid++;
+				ar.WriteChunk(PLT_STATE_VAR_ID, nid); nid++;
 
 				vector<float> val;
-				m_ar.BeginChunk(PLT_STATE_VAR_DATA);
+				ar.BeginChunk(PLT_STATE_VAR_DATA);
 				{
 					int NS = mesh.Surfaces();
 					for (int i=0; i<NS; ++i)
@@ -663,12 +724,12 @@ bool xpltFileExport::WriteFaceData(FEPostModel& fem, FEState& state)
 
 						if (FillFaceDataArray(val, data, surf) == false) return false;
 
-						if (val.empty() == false) m_ar.WriteData(i+1, val);
+						if (val.empty() == false) ar.WriteData(i+1, val);
 					}
 				}
-				m_ar.EndChunk();
+				ar.EndChunk();
 			}
-			m_ar.EndChunk();
+			ar.EndChunk();
 		}
 	}
 
@@ -718,9 +779,9 @@ bool xpltFileExport::FillNodeDataArray(vector<float>& val, Post::FEMeshData& mes
 	}
 	else if (ntype == DATA_VEC3)
 	{
-		FENodeData<vec3f>& data = dynamic_cast<FENodeData<vec3f>&>(meshData);
+		FENodeData_T<vec3f>& data = dynamic_cast<FENodeData_T<vec3f>&>(meshData);
 		val.assign(NN*3, 0.f);
-		for (int i=0; i<NN; ++i) write_data(val, i, data[i]);
+		for (int i=0; i<NN; ++i) { vec3f v; data.eval(i, &v); write_data(val, i, v); }
 	}
 	else if (ntype == DATA_MAT3S)
 	{
@@ -156,6 +156,16 @@ public:
 	// set the compression flag
 	void SetCompression(bool b) { m_ncompress = (b ? 1 : 0); }
 
+	// only export every n-th state (of the states in the time range)
+	void SetStateStride(int n) { m_stride = (n < 1 ? 1 : n); }
+
+	// only export states with a time value in the range [tmin, tmax]
+	void SetTimeRange(double tmin, double tmax) { m_tmin = tmin; m_tmax = tmax; m_btime = true; }
+
+	// set the data fields to export (indices into the data manager's list)
+	// If this is not called, all fields marked for export are written.
+	void SetDataFields(const std::vector<int>& fields) { m_fields = fields; m_bfields = true; }
+
 protected:
 	bool WriteRoot(FEPostModel& fem);
 	bool WriteHeader    (FEPostModel& fem);
@@ -170,10 +180,13 @@ protected:
 
 	bool WritePart(FEPostMesh& m, MeshDomain& part);
 
-	bool WriteState(FEPostModel& fem, FEState& state);
-	bool WriteNodeData(FEPostModel& fem, FEState& state);
-	bool WriteElemData(FEPostModel& fem, FEState& state);
-	bool WriteFaceData(FEPostModel& fem, FEState& state);
+	bool WriteStates(FEPostModel& fem);
+	bool WriteState(FEPostModel& fem, FEState& state, xpltChunkBuffer& ar);
+	bool WriteNodeData(FEPostModel& fem, FEState& state, xpltChunkBuffer& ar);
+	bool WriteElemData(FEPostModel& fem, FEState& state, xpltChunkBuffer& ar);
+	bool WriteFaceData(FEPostModel& fem, FEState& state, xpltChunkBuffer& ar);
+
+	bool ExportField(int n, ModelDataField& data) const;
 
 	bool FillNodeDataArray(std::vector<float>& val, FEMeshData& data);
 	bool FillElemDataArray(std::vector<float>& val, FEMeshData& data, FSElemSet& part);
@@ -188,6 +201,13 @@ private:
 	int			m_faceData;
 	int			m_ncompress;
 
+	// export options
+	int			m_stride;
+	bool		m_btime;
+	double		m_tmin, m_tmax;
+	bool		m_bfields;
+	std::vector<int>	m_fields;
+
 	char		m_szerr[256];
 };
 }
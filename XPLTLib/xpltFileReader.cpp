@@ -30,6 +30,7 @@ SOFTWARE.*/
 #include "xpltReader2.h"
 #include "xpltReader3.h"
 #include <PostLib/FEPostModel.h>
+#include <FSCore/CallTracer.h>
 
 xpltParser::xpltParser(xpltFileReader* xplt) : m_xplt(xplt), m_ar(xplt->GetArchive())
 {
@@ -59,21 +60,38 @@ int xpltParser::FileVersion() const
 xpltFileReader::xpltFileReader(Post::FEPostModel* fem) : FEFileReader(fem)
 {
 	m_xplt = 0;
+	m_fs = nullptr;
+	m_bfollow = false;
 	m_read_state_flag = XPLT_READ_ALL_STATES;
 }
 
 xpltFileReader::~xpltFileReader()
 {
+	CloseFile();
+	delete m_xplt;
+}
+
+void xpltFileReader::CloseFile()
+{
+	m_ar.Close();
+	Close();
+	delete m_fs;
+	m_fs = nullptr;
 }
 
 bool xpltFileReader::Load(const char* szfile)
 {
+	TRACE("xpltFileReader::Load");
+
+	// close the file if we were still following it
+	CloseFile();
+
 	// open the file
 	if (Open(szfile, "rb") == false) return errf("Failed opening file.");
 
 	// attach the file to the archive
-	FileStream fs(m_fp, false);
-	if (m_ar.Open(&fs) == false) return errf("This is not a valid XPLT file.");
+	m_fs = new FileStream(m_fp, false);
+	if (m_ar.Open(m_fs) == false) return errf("This is not a valid XPLT file.");
 
 	// open the root chunk (no compression for this sectio)
 	m_ar.SetCompression(0);
@@ -112,9 +130,8 @@ bool xpltFileReader::Load(const char* szfile)
 	// load the rest of the file
 	bool bret = m_xplt->Load(*m_fem);
 
-	// clean up
-	m_ar.Close();
-	Close();
+	// clean up (in follow mode we keep the file open)
+	if ((bret == false) || (m_bfollow == false)) CloseFile();
 
 	if (m_xplt->warnings() > 0)
 	{
@@ -135,6 +152,35 @@ bool xpltFileReader::Load(const char* szfile)
 }
 
 
+//-----------------------------------------------------------------------------
+bool xpltFileReader::IsFollowing() const
+{
+	return (m_bfollow && m_fp && m_xplt);
+}
+
+//-----------------------------------------------------------------------------
+int xpltFileReader::ReadNewStates()
+{
+	if (IsFollowing() == false) return -1;
+
+	int newStates = 0;
+	if (m_xplt->ReadNewStates(*m_fem, newStates) == false)
+	{
+		// we can't continue, so close the file
+		CloseFile();
+		return -1;
+	}
+
+	return newStates;
+}
+
+//-----------------------------------------------------------------------------
+void xpltFileReader::StopFollowing()
+{
+	m_bfollow = false;
+	CloseFile();
+}
+
 //-----------------------------------------------------------------------------
 bool xpltFileReader::ReadHeader()
 {
@@ -52,6 +52,10 @@ public:
 
 	virtual bool Load(Post::FEPostModel& fem) = 0;
 
+	// Read the states that were appended to the file since the last read. 
+	// This is only supported by parsers that can follow a file.
+	virtual bool ReadNewStates(Post::FEPostModel& fem, int& newStates) { return false; }
+
 	bool errf(const char* sz);
 
 	void addWarning(int n);
@@ -110,6 +114,21 @@ public:
 	int GetReadStateFlag() const { return m_read_state_flag; }
 	std::vector<int> GetReadStates() const { return m_state_list; }
 
+	// In follow mode the file is kept open after loading so that states
+	// that are appended later (e.g. by a running job) can be read in.
+	void SetFollowMode(bool b) { m_bfollow = b; }
+	bool GetFollowMode() const { return m_bfollow; }
+
+	// returns true if the file is still open for reading new states
+	bool IsFollowing() const;
+
+	// Read any new states that were written to the file. Returns the number
+	// of states added to the model, or -1 on error.
+	int ReadNewStates();
+
+	// stop following the file and close it
+	void StopFollowing();
+
 public:
 	xpltArchive& GetArchive() { return m_ar; }
 
@@ -120,10 +139,14 @@ public:
 protected:
 	bool ReadHeader();
 
+	void CloseFile();
+
 private:
 	xpltParser*		m_xplt;
 	xpltArchive		m_ar;
+	FileStream*		m_fs;
 	HEADER			m_hdr;
+	bool			m_bfollow;	//!< keep file open for reading new states
 
 	// Options
 	int			m_read_state_flag;	//!< flag setting option for reading states
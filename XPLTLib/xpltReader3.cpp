@@ -31,6 +31,7 @@ SOFTWARE.*/
 #include <PostLib/FEState.h>
 #include <PostLib/FEPostMesh.h>
 #include <PostLib/FEPostModel.h>
+#include <FSCore/CallTracer.h>
 
 using namespace Post;
 using namespace std;
@@ -137,6 +138,8 @@ XpltReader3::XpltReader3(xpltFileReader* xplt) : xpltParser(xplt)
 {
 	m_pstate = 0;
 	m_mesh = 0;
+	m_stateOffset = 0;
+	m_fileSize = 0;
 }
 
 XpltReader3::~XpltReader3()
@@ -161,6 +164,8 @@ void XpltReader3::Clear()
 //-----------------------------------------------------------------------------
 bool XpltReader3::Load(FEPostModel& fem)
 {
+	TRACE("XpltReader3::Load");
+
 	// make sure all data is cleared
 	Clear();
 
@@ -193,6 +198,7 @@ bool XpltReader3::Load(FEPostModel& fem)
 	// read the state sections (these could be compressed)
 	const xpltFileReader::HEADER& hdr = m_xplt->GetHeader();
 	m_ar.SetCompression(hdr.ncompression);
+	m_stateOffset = m_ar.Tell();
 	int read_state_flag = m_xplt->GetReadStateFlag();
 	int nstate = 0;
 	try{
@@ -242,6 +248,9 @@ bool XpltReader3::Load(FEPostModel& fem)
 				break;
 			}
 
+			// this section was read completely
+			m_stateOffset = m_ar.Tell();
+
 			++nstate;
 		}
 		if (read_state_flag == XPLT_READ_LAST_STATE_ONLY) { fem.AddState(m_pstate); m_pstate = 0; }
@@ -251,11 +260,90 @@ bool XpltReader3::Load(FEPostModel& fem)
 		errf("An unknown exception has occurred.\nNot all data was read in.");
 	}
 
+	// In follow mode we keep the dictionary and mesh info, since we'll need it
+	// for reading the states that are still to be written. The last section may 
+	// only have been partially written, so we go back to the end of the last
+	// complete one.
+	if (m_xplt->GetFollowMode())
+	{
+		if (m_pstate) { delete m_pstate; m_pstate = 0; }
+		m_fileSize = m_ar.FileSize();
+		m_ar.Seek(m_stateOffset);
+		return true;
+	}
+
 	Clear();
 
 	return true;
 }
 
+//-----------------------------------------------------------------------------
+// Reads the state sections that were appended to the file since the last read.
+// Sections that are not completely written yet are left for the next call.
+bool XpltReader3::ReadNewStates(FEPostModel& fem, int& newStates)
+{
+	TRACE("XpltReader3::ReadNewStates");
+
+	newStates = 0;
+
+	// nothing to do if the file did not grow
+	off_type fileSize = m_ar.FileSize();
+	if (fileSize == m_fileSize) return true;
+	if (fileSize < m_stateOffset) return errf("The plot file was truncated.");
+	m_fileSize = fileSize;
+
+	// start reading after the last complete section
+	if (m_ar.Seek(m_stateOffset) == false) return false;
+
+	// note that only the "converged states" filter makes sense here
+	bool convergedOnly = (m_xplt->GetReadStateFlag() == XPLT_READ_ALL_CONVERGED_STATES);
+	try {
+		while (m_ar.OpenChunk() == xpltArchive::IO_OK)
+		{
+			int nid = m_ar.GetChunkID();
+			if (nid == PLT_STATE)
+			{
+				if (m_pstate) { delete m_pstate; m_pstate = 0; }
+				if (ReadStateSection(fem) == false) return false;
+			}
+			else if (nid == PLT_MESH)
+			{
+				if (ReadMesh(fem) == false) return errf("Error while reading mesh section.");
+			}
+			else return errf("Error while reading state data.");
+			m_ar.CloseChunk();
+
+			// clear end-flag
+			if (m_ar.OpenChunk() != xpltArchive::IO_END) break;
+
+			// this section was read completely
+			m_stateOffset = m_ar.Tell();
+
+			if (m_pstate)
+			{
+				if ((convergedOnly == false) || (m_pstate->m_status == 0))
+				{
+					fem.AddState(m_pstate);
+					newStates++;
+				}
+				else delete m_pstate;
+				m_pstate = 0;
+			}
+		}
+	}
+	catch (...)
+	{
+		return errf("An unknown exception has occurred.");
+	}
+
+	// a partially written section may have been read, so go back to the end 
+	// of the last complete one.
+	if (m_pstate) { delete m_pstate; m_pstate = 0; }
+	m_ar.Seek(m_stateOffset);
+
+	return true;
+}
+
 //-----------------------------------------------------------------------------
 bool XpltReader3::ReadRootSection(FEPostModel& fem)
 {
@@ -898,6 +986,8 @@ void XpltReader3::CreateMaterials(FEPostModel& fem)
 //-----------------------------------------------------------------------------
 bool XpltReader3::ReadMesh(FEPostModel &fem)
 {
+	TRACE("XpltReader3::ReadMesh");
+
 	// clear the current XMesh
 	m_xmesh.Clear();
 
@@ -1568,6 +1658,8 @@ bool XpltReader3::BuildMesh(FEPostModel &fem)
 //-----------------------------------------------------------------------------
 bool XpltReader3::ReadStateSection(FEPostModel& fem)
 {
+	TRACE("XpltReader3::ReadStateSection");
+
 	// get the mesh
 	Post::FEPostMesh& mesh = *GetCurrentMesh();
 
@@ -373,6 +373,8 @@ public:
 
 	bool Load(Post::FEPostModel& fem);
 
+	bool ReadNewStates(Post::FEPostModel& fem, int& newStates) override;
+
 protected:
 	bool ReadRootSection(Post::FEPostModel& fem);
 	bool ReadStateSection(Post::FEPostModel& fem);
@@ -442,4 +444,7 @@ protected:
 
 	Post::FEState*	m_pstate;	//!< last read state section
 	Post::FEPostMesh*	m_mesh;		//!< current mesh
+
+	off_type	m_stateOffset;	//!< file position after the last complete state section
+	off_type	m_fileSize;		//!< file size at the last read of new states
 };